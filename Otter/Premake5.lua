@@ -311,8 +311,9 @@ function AddProjects(groupName, folders)
 			kind "ConsoleApp"
 			-- Language (we are using MSVC)
 			language "C++"
-			-- C++ version (we are using the c++17 standard)
-			cppdialect "C++17"
+			-- C++ version (we need c++20 for the coroutines in Gameplay/Scheduler.h, which this
+			-- version of premake calls latest)
+			cppdialect "C++latest"
 			-- Sets RuntimLibrary to MultiThreaded (non DLL version for static linking)
 			staticruntime "on"
 
@@ -366,7 +367,8 @@ function AddProjects(groupName, folders)
 			-- Link to the dependencies and modules
 			links(ProjLinks)
 
-		    buildoptions { "/bigobj" }
+		    -- c++latest turns on MSVC's strict conformance mode, which we don't pass yet
+		    buildoptions { "/bigobj", "/permissive" }
 
 			-- This filters for our windows builds
 			filter "system:windows"
@@ -253,6 +253,19 @@ namespace nou
 			glDrawArrays((int)m_drawMode, 0, m_len);
 		}
 
+		//Draws several copies of our "thing" in one go.
+		//The vertex shader can tell them apart with gl_InstanceID.
+		void DrawInstanced(GLsizei instanceCount)
+		{
+			if (instanceCount == 0)
+				return;
+
+			m_len = m_vbos.begin()->second->Length();
+
+			glBindVertexArray(m_id);
+			glDrawArraysInstanced((int)m_drawMode, 0, m_len, instanceCount);
+		}
+
 		void DrawElements(const std::vector<GLuint>& indices, size_t count)
 		{
 			if (count == 0)
@@ -0,0 +1,47 @@
+/*
+skinned.vert
+Skinning vertex shader.
+Blends each vertex between up to 4 joints of its instance's palette, then
+passes world vertex position, transformed normal direction, and UV coordinates
+to the fragment shader, the same as texturedlit.vert.
+Instances are read from the palette ring (see Animations/Skinning.h), laid out
+as [model, normal, joint matrices...], instanceStride matrices apart.
+*/
+
+#version 430 core
+
+layout(std430, binding = 0) readonly buffer Palettes
+{
+    mat4 palettes[];
+};
+
+uniform mat4 viewproj;
+uniform int instanceBase;
+uniform int instanceStride;
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec2 inUV;
+layout(location = 3) in vec4 inJoints;
+layout(location = 4) in vec4 inWeights;
+
+layout(location = 0) out vec4 outPos;
+layout(location = 1) out vec3 outNorm;
+layout(location = 2) out vec2 outUV;
+
+void main()
+{
+    int base = instanceBase + gl_InstanceID * instanceStride;
+    mat4 model = palettes[base];
+    mat3 normal = mat3(palettes[base + 1]);
+
+    ivec4 joints = ivec4(inJoints) + base + 2;
+    mat4 skin = (inWeights.x * palettes[joints.x] + inWeights.y * palettes[joints.y]) +
+                (inWeights.z * palettes[joints.z] + inWeights.w * palettes[joints.w]);
+
+    outNorm = normal * (mat3(skin) * inNorm);
+    outPos = model * (skin * vec4(inPos, 1.0f));
+    outUV = inUV;
+
+    gl_Position = viewproj * outPos;
+}
@@ -0,0 +1,527 @@
+/*
+AnimationSampler.cpp
+Compressed animation clips, and a sampler for playing them back quickly.
+*/
+
+#include "Animations/AnimationSampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define ANIM_SAMPLER_SSE
+#include <immintrin.h>
+#endif
+
+namespace nou
+{
+	//Each of the 3 smallest components is stored in 15 bits, and the
+	//index of the dropped one goes in the top bits of the first two.
+	static const float QUAT_RANGE = 0.70710678f;
+	static const float QUAT_SCALE = 32767.0f;
+	static const float UNIT_SCALE = 65535.0f;
+
+	static uint16_t Quantize(float value, float min, float extent, float scale)
+	{
+		float norm = (extent > 0.0f) ? (value - min) / extent : 0.0f;
+		norm = std::clamp(norm, 0.0f, 1.0f);
+		return static_cast<uint16_t>(norm * scale + 0.5f);
+	}
+
+	CompressedAnim::Track::Track()
+	{
+		jointInd = 0;
+		type = TrackType::ROTATION;
+		keyCount = 0;
+		offset = 0;
+		rangeMin = glm::vec3(0.0f);
+		rangeExtent = glm::vec3(0.0f);
+	}
+
+	CompressedAnim::CompressedAnim()
+	{
+		m_duration = 0.0f;
+		m_rotationTracks = 0;
+	}
+
+	CompressedAnim::CompressedAnim(const SkeletalAnim& anim)
+		: CompressedAnim()
+	{
+		Compress(anim);
+	}
+
+	void CompressedAnim::Compress(const SkeletalAnim& anim)
+	{
+		m_duration = anim.duration;
+		m_tracks.clear();
+		m_data.clear();
+
+		//Work out how big everything is first, so we only allocate once.
+		size_t keyTotal = 0;
+		size_t trackTotal = 0;
+
+		for (const JointAnim& joint : anim.data)
+		{
+			size_t rotKeys = std::min<size_t>(joint.rotFrames, std::min(joint.rotTimes.size(), joint.rotKeys.size()));
+			size_t posKeys = std::min<size_t>(joint.posFrames, std::min(joint.posTimes.size(), joint.posKeys.size()));
+
+			keyTotal += rotKeys + posKeys;
+			trackTotal += (rotKeys > 0 ? 1 : 0) + (posKeys > 0 ? 1 : 0);
+		}
+
+		m_tracks.reserve(trackTotal);
+		m_data.reserve(keyTotal * 4);
+
+		//Rotations go first, so the sampler can blend them in one run.
+		for (const JointAnim& joint : anim.data)
+		{
+			uint32_t count = static_cast<uint32_t>(std::min<size_t>(joint.rotFrames, std::min(joint.rotTimes.size(), joint.rotKeys.size())));
+
+			if (count == 0)
+				continue;
+
+			Track track;
+			track.jointInd = joint.jointInd;
+			track.type = TrackType::ROTATION;
+			track.keyCount = count;
+			track.offset = static_cast<uint32_t>(m_data.size());
+
+			for (uint32_t k = 0; k < count; ++k)
+				m_data.push_back(Quantize(joint.rotTimes[k], 0.0f, m_duration, UNIT_SCALE));
+
+			for (uint32_t k = 0; k < count; ++k)
+			{
+				uint16_t packed[3];
+				PackRotation(joint.rotKeys[k], packed);
+				m_data.insert(m_data.end(), packed, packed + 3);
+			}
+
+			m_tracks.push_back(track);
+		}
+
+		m_rotationTracks = m_tracks.size();
+
+		for (const JointAnim& joint : anim.data)
+		{
+			uint32_t count = static_cast<uint32_t>(std::min<size_t>(joint.posFrames, std::min(joint.posTimes.size(), joint.posKeys.size())));
+
+			if (count == 0)
+				continue;
+
+			Track track;
+			track.jointInd = joint.jointInd;
+			track.type = TrackType::POSITION;
+			track.keyCount = count;
+			track.offset = static_cast<uint32_t>(m_data.size());
+
+			glm::vec3 min = joint.posKeys[0];
+			glm::vec3 max = joint.posKeys[0];
+
+			for (uint32_t k = 1; k < count; ++k)
+			{
+				min = glm::min(min, joint.posKeys[k]);
+				max = glm::max(max, joint.posKeys[k]);
+			}
+
+			track.rangeMin = min;
+			track.rangeExtent = max - min;
+
+			for (uint32_t k = 0; k < count; ++k)
+				m_data.push_back(Quantize(joint.posTimes[k], 0.0f, m_duration, UNIT_SCALE));
+
+			for (uint32_t k = 0; k < count; ++k)
+			{
+				for (int c = 0; c < 3; ++c)
+					m_data.push_back(Quantize(joint.posKeys[k][c], min[c], track.rangeExtent[c], UNIT_SCALE));
+			}
+
+			m_tracks.push_back(track);
+		}
+	}
+
+	void CompressedAnim::Assign(float duration, const Track* tracks, size_t trackCount,
+		const uint16_t* data, size_t dataCount)
+	{
+		m_duration = duration;
+		m_tracks.assign(tracks, tracks + trackCount);
+		m_data.assign(data, data + dataCount);
+
+		m_rotationTracks = 0;
+
+		for (const Track& track : m_tracks)
+		{
+			if (track.type == TrackType::ROTATION)
+				++m_rotationTracks;
+		}
+	}
+
+	float CompressedAnim::GetDuration() const
+	{
+		return m_duration;
+	}
+
+	const std::vector<CompressedAnim::Track>& CompressedAnim::GetTracks() const
+	{
+		return m_tracks;
+	}
+
+	size_t CompressedAnim::GetRotationTrackCount() const
+	{
+		return m_rotationTracks;
+	}
+
+	const std::vector<uint16_t>& CompressedAnim::GetData() const
+	{
+		return m_data;
+	}
+
+	size_t CompressedAnim::GetMemoryUsage() const
+	{
+		return sizeof(CompressedAnim) + m_tracks.capacity() * sizeof(Track) + m_data.capacity() * sizeof(uint16_t);
+	}
+
+	const uint16_t* CompressedAnim::GetTimes(const Track& track) const
+	{
+		return &m_data[track.offset];
+	}
+
+	glm::quat CompressedAnim::GetRotation(const Track& track, uint32_t key) const
+	{
+		return UnpackRotation(&m_data[track.offset + track.keyCount + key * 3]);
+	}
+
+	glm::vec3 CompressedAnim::GetPosition(const Track& track, uint32_t key) const
+	{
+		const uint16_t* packed = &m_data[track.offset + track.keyCount + key * 3];
+
+		return track.rangeMin + track.rangeExtent *
+			glm::vec3(packed[0], packed[1], packed[2]) * (1.0f / UNIT_SCALE);
+	}
+
+	float CompressedAnim::ToTimeUnits(float time) const
+	{
+		return (m_duration > 0.0f) ? time / m_duration * UNIT_SCALE : 0.0f;
+	}
+
+	void CompressedAnim::PackRotation(const glm::quat& rotation, uint16_t* out)
+	{
+		glm::quat q = glm::normalize(rotation);
+
+		int largest = 0;
+
+		for (int i = 1; i < 4; ++i)
+		{
+			if (std::abs(q[i]) > std::abs(q[largest]))
+				largest = i;
+		}
+
+		//q and -q are the same rotation, so we can always make the
+		//dropped component positive and rebuild it with a square root.
+		float sign = (q[largest] < 0.0f) ? -1.0f : 1.0f;
+
+		int c = 0;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+
+			out[c++] = Quantize(q[i] * sign, -QUAT_RANGE, 2.0f * QUAT_RANGE, QUAT_SCALE);
+		}
+
+		out[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+		out[1] |= static_cast<uint16_t>((largest & 1) << 15);
+	}
+
+	glm::quat CompressedAnim::UnpackRotation(const uint16_t* packed)
+	{
+		int largest = ((packed[0] >> 15) << 1) | (packed[1] >> 15);
+
+		float small[3];
+		float sum = 0.0f;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			small[c] = (packed[c] & 0x7FFF) * (2.0f * QUAT_RANGE / QUAT_SCALE) - QUAT_RANGE;
+			sum += small[c] * small[c];
+		}
+
+		glm::quat result;
+		int c = 0;
+
+		for (int i = 0; i < 4; ++i)
+			result[i] = (i == largest) ? std::sqrt(std::max(0.0f, 1.0f - sum)) : small[c++];
+
+		return result;
+	}
+
+	AnimSampler::AnimSampler(const CompressedAnim& anim, const Skeleton& skeleton)
+		: m_anim(anim)
+	{
+		m_timer = 0.0f;
+
+		const std::vector<CompressedAnim::Track>& tracks = m_anim.GetTracks();
+
+		m_cursors.resize(tracks.size(), 0);
+		m_trackValid.resize(tracks.size(), 1);
+
+		//A clip made for another skeleton can have tracks for joints we
+		//don't have. Those are never sampled or written out.
+		for (size_t i = 0; i < tracks.size(); ++i)
+		{
+			if (tracks[i].jointInd < 0 || static_cast<size_t>(tracks[i].jointInd) >= skeleton.m_joints.size())
+			{
+				m_trackValid[i] = 0;
+				printf("Animation track %zu is for joint %d, but the skeleton only has %zu joints, skipping it.\n",
+					i, tracks[i].jointInd, skeleton.m_joints.size());
+			}
+		}
+
+		m_trackActive = m_trackValid;
+
+		size_t padded = (tracks.size() + 3) & ~static_cast<size_t>(3);
+
+		for (std::vector<float>* lane : { &m_ax, &m_ay, &m_az, &m_aw, &m_bx, &m_by, &m_bz, &m_bw, &m_t })
+			lane->resize(padded, 0.0f);
+
+		//Joints without a track stay in their base pose.
+		m_pos.resize(skeleton.m_joints.size());
+		m_rotation.resize(skeleton.m_joints.size());
+
+		for (size_t i = 0; i < skeleton.m_joints.size(); ++i)
+		{
+			m_pos[i] = skeleton.m_joints[i].m_basePos;
+			m_rotation[i] = skeleton.m_joints[i].m_baseRotation;
+		}
+	}
+
+	void AnimSampler::Update(float deltaTime)
+	{
+		Advance(deltaTime);
+		Sample();
+	}
+
+	void AnimSampler::Advance(float deltaTime)
+	{
+		float duration = m_anim.GetDuration();
+
+		m_timer += deltaTime;
+
+		if (duration > 0.0f && (m_timer > duration || m_timer < 0.0f))
+		{
+			m_timer = std::fmod(m_timer, duration);
+
+			if (m_timer < 0.0f)
+				m_timer += duration;
+		}
+	}
+
+	void AnimSampler::Seek(float time)
+	{
+		m_timer = 0.0f;
+		Update(time);
+	}
+
+	void AnimSampler::Sample()
+	{
+		const std::vector<CompressedAnim::Track>& tracks = m_anim.GetTracks();
+		const float time = m_anim.ToTimeUnits(m_timer);
+
+		//Find and unpack the keys on either side of our time for every track.
+		for (size_t i = 0; i < tracks.size(); ++i)
+		{
+			if (!m_trackActive[i])
+				continue;
+
+			const CompressedAnim::Track& track = tracks[i];
+			const uint16_t* times = m_anim.GetTimes(track);
+
+			uint32_t cur = FindKey(times, track.keyCount, m_cursors[i], time);
+			uint32_t next = std::min(cur + 1, track.keyCount - 1);
+			m_cursors[i] = cur;
+
+			float span = static_cast<float>(times[next]) - static_cast<float>(times[cur]);
+			m_t[i] = (span > 0.0f) ? std::clamp((time - times[cur]) / span, 0.0f, 1.0f) : 0.0f;
+
+			if (track.type == CompressedAnim::TrackType::ROTATION)
+			{
+				glm::quat a = m_anim.GetRotation(track, cur);
+				glm::quat b = m_anim.GetRotation(track, next);
+
+				m_ax[i] = a.x; m_ay[i] = a.y; m_az[i] = a.z; m_aw[i] = a.w;
+				m_bx[i] = b.x; m_by[i] = b.y; m_bz[i] = b.z; m_bw[i] = b.w;
+			}
+			else
+			{
+				glm::vec3 a = m_anim.GetPosition(track, cur);
+				glm::vec3 b = m_anim.GetPosition(track, next);
+
+				m_ax[i] = a.x; m_ay[i] = a.y; m_az[i] = a.z; m_aw[i] = 0.0f;
+				m_bx[i] = b.x; m_by[i] = b.y; m_bz[i] = b.z; m_bw[i] = 0.0f;
+			}
+		}
+
+		size_t rotEnd = m_anim.GetRotationTrackCount();
+		size_t i = 0;
+
+#ifdef ANIM_SAMPLER_SSE
+		//nlerp 4 rotation tracks at a time. We take the short way around by
+		//flipping b when it's on the other side of the hypersphere from a.
+		//Any partial group at the end is picked up by the scalar loop.
+		for (; i + 4 <= rotEnd; i += 4)
+		{
+			__m128 ax = _mm_loadu_ps(&m_ax[i]), ay = _mm_loadu_ps(&m_ay[i]), az = _mm_loadu_ps(&m_az[i]), aw = _mm_loadu_ps(&m_aw[i]);
+			__m128 bx = _mm_loadu_ps(&m_bx[i]), by = _mm_loadu_ps(&m_by[i]), bz = _mm_loadu_ps(&m_bz[i]), bw = _mm_loadu_ps(&m_bw[i]);
+			__m128 t = _mm_loadu_ps(&m_t[i]);
+
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+			__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+			bx = _mm_xor_ps(bx, flip); by = _mm_xor_ps(by, flip); bz = _mm_xor_ps(bz, flip); bw = _mm_xor_ps(bw, flip);
+
+			__m128 x = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), t));
+			__m128 y = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), t));
+			__m128 z = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), t));
+			__m128 w = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), t));
+
+			__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+			__m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(len2, _mm_set1_ps(1e-12f))));
+
+			float rx[4], ry[4], rz[4], rw[4];
+			_mm_storeu_ps(rx, _mm_mul_ps(x, inv));
+			_mm_storeu_ps(ry, _mm_mul_ps(y, inv));
+			_mm_storeu_ps(rz, _mm_mul_ps(z, inv));
+			_mm_storeu_ps(rw, _mm_mul_ps(w, inv));
+
+			for (int l = 0; l < 4; ++l)
+			{
+				if (m_trackValid[i + l])
+					m_rotation[tracks[i + l].jointInd] = glm::quat(rw[l], rx[l], ry[l], rz[l]);
+			}
+		}
+#endif
+
+		for (; i < rotEnd; ++i)
+		{
+			if (!m_trackValid[i])
+				continue;
+
+			glm::quat a(m_aw[i], m_ax[i], m_ay[i], m_az[i]);
+			glm::quat b(m_bw[i], m_bx[i], m_by[i], m_bz[i]);
+
+			if (glm::dot(a, b) < 0.0f)
+				b = -b;
+
+			m_rotation[tracks[i].jointInd] = glm::normalize(a * (1.0f - m_t[i]) + b * m_t[i]);
+		}
+
+#ifdef ANIM_SAMPLER_SSE
+		//Positions start wherever the rotations left off, so realign to a
+		//group of 4 before going wide.
+		for (; i < tracks.size() && (i & 3) != 0; ++i)
+		{
+			if (m_trackValid[i])
+				m_pos[tracks[i].jointInd] = glm::mix(glm::vec3(m_ax[i], m_ay[i], m_az[i]), glm::vec3(m_bx[i], m_by[i], m_bz[i]), m_t[i]);
+		}
+
+		for (; i + 4 <= tracks.size(); i += 4)
+		{
+			__m128 t = _mm_loadu_ps(&m_t[i]);
+			__m128 ax = _mm_loadu_ps(&m_ax[i]), ay = _mm_loadu_ps(&m_ay[i]), az = _mm_loadu_ps(&m_az[i]);
+
+			float rx[4], ry[4], rz[4];
+			_mm_storeu_ps(rx, _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_bx[i]), ax), t)));
+			_mm_storeu_ps(ry, _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_by[i]), ay), t)));
+			_mm_storeu_ps(rz, _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_bz[i]), az), t)));
+
+			for (int l = 0; l < 4; ++l)
+			{
+				if (m_trackValid[i + l])
+					m_pos[tracks[i + l].jointInd] = glm::vec3(rx[l], ry[l], rz[l]);
+			}
+		}
+#endif
+
+		for (; i < tracks.size(); ++i)
+		{
+			if (m_trackValid[i])
+				m_pos[tracks[i].jointInd] = glm::mix(glm::vec3(m_ax[i], m_ay[i], m_az[i]), glm::vec3(m_bx[i], m_by[i], m_bz[i]), m_t[i]);
+		}
+	}
+
+	void AnimSampler::Apply(Skeleton& skeleton) const
+	{
+		//Indices of output match joint indices.
+		for (size_t i = 0; i < m_pos.size() && i < skeleton.m_joints.size(); ++i)
+		{
+			Joint& joint = skeleton.m_joints[i];
+			joint.m_pos = m_pos[i];
+			joint.m_rotation = m_rotation[i];
+		}
+	}
+
+	void AnimSampler::SetActiveJoints(const std::vector<uint8_t>& active)
+	{
+		const std::vector<CompressedAnim::Track>& tracks = m_anim.GetTracks();
+
+		for (size_t i = 0; i < tracks.size(); ++i)
+		{
+			size_t joint = static_cast<size_t>(tracks[i].jointInd);
+			m_trackActive[i] = (m_trackValid[i] && (active.empty() || (joint < active.size() && active[joint]))) ? 1 : 0;
+		}
+	}
+
+	float AnimSampler::GetTime() const
+	{
+		return m_timer;
+	}
+
+	float AnimSampler::GetDuration() const
+	{
+		return m_anim.GetDuration();
+	}
+
+	const std::vector<glm::vec3>& AnimSampler::GetPositions() const
+	{
+		return m_pos;
+	}
+
+	const std::vector<glm::quat>& AnimSampler::GetRotations() const
+	{
+		return m_rotation;
+	}
+
+	uint32_t AnimSampler::FindKey(const uint16_t* times, uint32_t keyCount, uint32_t cursor, float time) const
+	{
+		if (keyCount < 2)
+			return 0;
+
+		uint32_t last = keyCount - 2;
+		cursor = std::min(cursor, last);
+
+		//Most of the time we're still between the same two keys, or have
+		//just stepped over to the next (or previous, in reverse) one.
+		if (times[cursor] <= time)
+		{
+			if (cursor == last || time < times[cursor + 1])
+				return cursor;
+
+			if (cursor + 1 == last || time < times[cursor + 2])
+				return cursor + 1;
+		}
+		else if (cursor > 0 && times[cursor - 1] <= time)
+		{
+			return cursor - 1;
+		}
+		else if (cursor == 0)
+		{
+			//Before the first key.
+			return 0;
+		}
+
+		//We've jumped somewhere else in the clip.
+		const uint16_t* found = std::upper_bound(times, times + keyCount, time);
+		uint32_t key = static_cast<uint32_t>(found - times);
+
+		return (key == 0) ? 0 : std::min(key - 1, last);
+	}
+}
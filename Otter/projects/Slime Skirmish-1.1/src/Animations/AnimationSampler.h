@@ -0,0 +1,151 @@
+/*
+AnimationSampler.h
+Compressed animation clips, and a sampler for playing them back quickly.
+*/
+
+#pragma once
+#include "Animations/Animation.h"
+#include <cstdint>
+#include <vector>
+
+namespace nou
+{
+	//An animation clip with every track packed into one contiguous buffer.
+	//Key times, positions and rotations are all quantized to 16 bits:
+	//times across the clip's duration, positions across the bounds of
+	//their track, and rotations with the "smallest three" method (we drop
+	//the largest component and rebuild it from the other three).
+	//A key takes 8 bytes instead of the 20 or 16 used by JointAnim.
+	class CompressedAnim
+	{
+	public:
+
+		enum class TrackType : uint8_t
+		{
+			ROTATION,
+			POSITION
+		};
+
+		struct Track
+		{
+			int jointInd;
+			TrackType type;
+			uint32_t keyCount;
+			//Where the track starts in our buffer. The key times come first,
+			//followed by 3 values for each key.
+			uint32_t offset;
+
+			//Bounds of the position keys, which they are quantized across.
+			glm::vec3 rangeMin;
+			glm::vec3 rangeExtent;
+
+			Track();
+		};
+
+		CompressedAnim();
+		CompressedAnim(const SkeletalAnim& anim);
+		~CompressedAnim() = default;
+
+		//Replace our contents with a compressed copy of an animation.
+		void Compress(const SkeletalAnim& anim);
+		//Replace our contents with tracks and keys that were already
+		//compressed, e.g., read back from a cooked file. Rotation tracks
+		//have to come before position tracks, like Compress leaves them.
+		void Assign(float duration, const Track* tracks, size_t trackCount,
+			const uint16_t* data, size_t dataCount);
+
+		float GetDuration() const;
+		//Our tracks, with all rotation tracks before all position tracks.
+		const std::vector<Track>& GetTracks() const;
+		size_t GetRotationTrackCount() const;
+		//Every track's key times and values, packed one after another.
+		const std::vector<uint16_t>& GetData() const;
+		//Total bytes used by our keys and track table.
+		size_t GetMemoryUsage() const;
+
+		//The key times for a track, in 16 bit units across the clip's duration.
+		const uint16_t* GetTimes(const Track& track) const;
+		glm::quat GetRotation(const Track& track, uint32_t key) const;
+		glm::vec3 GetPosition(const Track& track, uint32_t key) const;
+
+		//Convert a time in seconds to the units key times are stored in.
+		float ToTimeUnits(float time) const;
+
+		//Smallest three quaternion packing, exposed so it can be tested.
+		static void PackRotation(const glm::quat& rotation, uint16_t* out);
+		static glm::quat UnpackRotation(const uint16_t* packed);
+
+	protected:
+
+		float m_duration;
+		size_t m_rotationTracks;
+
+		std::vector<Track> m_tracks;
+		std::vector<uint16_t> m_data;
+	};
+
+	//Plays back a compressed clip for one skeleton.
+	//Each track keeps a cursor on the key it used last time, so playing
+	//forwards or backwards only ever has to step to a neighbouring key.
+	//Anything further away (e.g., seeking, or a long frame) falls back to
+	//a binary search. Once the keys are found, every joint is blended at
+	//once in a SIMD loop (4 tracks at a time where SSE is available).
+	//Rotations use nlerp rather than slerp, which is indistinguishable
+	//at the spacing keys are sampled at.
+	class AnimSampler
+	{
+	public:
+
+		AnimSampler(const CompressedAnim& anim, const Skeleton& skeleton);
+		~AnimSampler() = default;
+
+		//Move our timer along and sample the clip, wrapping around its duration.
+		//A negative deltaTime plays the clip in reverse.
+		void Update(float deltaTime);
+		//Move our timer along without sampling, e.g., for frames we don't need
+		//a pose on.
+		void Advance(float deltaTime);
+		//Jump to a time in the clip and sample it.
+		void Seek(float time);
+		//Sample the clip at our current time.
+		void Sample();
+		//Apply the sampled pose to a skeleton.
+		void Apply(Skeleton& skeleton) const;
+
+		//Only sample tracks for joints flagged in active (indexed by joint).
+		//The rest keep whatever they were last sampled at. Pass an empty
+		//list to go back to sampling everything.
+		void SetActiveJoints(const std::vector<uint8_t>& active);
+
+		float GetTime() const;
+		float GetDuration() const;
+		//The sampled pose, with one entry per joint in the skeleton.
+		const std::vector<glm::vec3>& GetPositions() const;
+		const std::vector<glm::quat>& GetRotations() const;
+
+	protected:
+
+		const CompressedAnim& m_anim;
+		float m_timer;
+
+		//Which key each track sampled last time.
+		std::vector<uint32_t> m_cursors;
+		//Whether we're sampling each track.
+		std::vector<uint8_t> m_trackActive;
+		//Whether each track's joint is in the skeleton we were made for.
+		std::vector<uint8_t> m_trackValid;
+
+		//The two keys around our time for each track, plus how far we are
+		//between them, laid out so that 4 tracks can be blended at once.
+		//Padded to a multiple of 4.
+		std::vector<float> m_ax, m_ay, m_az, m_aw;
+		std::vector<float> m_bx, m_by, m_bz, m_bw;
+		std::vector<float> m_t;
+
+		std::vector<glm::vec3> m_pos;
+		std::vector<glm::quat> m_rotation;
+
+		//Find the key before our time in a track, starting from its cursor.
+		uint32_t FindKey(const uint16_t* times, uint32_t keyCount, uint32_t cursor, float time) const;
+	};
+}
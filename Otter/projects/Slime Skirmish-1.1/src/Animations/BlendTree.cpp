@@ -0,0 +1,565 @@
+/*
+BlendTree.cpp
+Blend trees for combining animation clips, and a player that runs one
+for a character with crossfades and level of detail.
+*/
+
+#include "Animations/BlendTree.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+
+namespace nou
+{
+	//Children with less weight than this aren't worth evaluating.
+	static const float MIN_BLEND_WEIGHT = 0.01f;
+
+	static std::vector<AnimLODLevel> s_lodLevels =
+	{
+		{ 15.0f, 1, 1.0f, false },
+		{ 30.0f, 2, 1.0f, true },
+		{ 60.0f, 4, 0.5f, true },
+		{ FLT_MAX, 8, 0.25f, true }
+	};
+
+	//Players can be updated on the thread pool, so these are atomic.
+	static std::atomic<uint32_t> s_posesEvaluated(0);
+	static std::atomic<uint32_t> s_posesInterpolated(0);
+	static std::atomic<uint32_t> s_posesSkipped(0);
+	static std::atomic<uint32_t> s_clipsSampled(0);
+	static std::atomic<uint32_t> s_blends(0);
+	static std::atomic<uint64_t> s_jointsEvaluated(0);
+
+	ClipNode::ClipNode(const CompressedAnim& anim, const Skeleton& skeleton)
+		: m_sampler(anim, skeleton)
+	{
+		m_speed = 1.0f;
+	}
+
+	void ClipNode::SetSpeed(float speed)
+	{
+		m_speed = speed;
+	}
+
+	float ClipNode::GetSpeed() const
+	{
+		return m_speed;
+	}
+
+	AnimSampler& ClipNode::GetSampler()
+	{
+		return m_sampler;
+	}
+
+	void ClipNode::Update(float deltaTime)
+	{
+		m_sampler.Advance(deltaTime * m_speed);
+	}
+
+	void ClipNode::Evaluate(BlendContext& context, LocalPose& out)
+	{
+		m_sampler.Sample();
+		context.clipsSampled++;
+
+		//The sampler works in the original skeleton's order.
+		const std::vector<glm::vec3>& pos = m_sampler.GetPositions();
+		const std::vector<glm::quat>& rotation = m_sampler.GetRotations();
+
+		for (size_t i = 0; i < context.jointCount; ++i)
+		{
+			int joint = context.layout->ToOriginal(static_cast<int>(i));
+			out.pos[i] = pos[joint];
+			out.rotation[i] = rotation[joint];
+		}
+	}
+
+	void ClipNode::SetJointLimit(const SkeletonLayout& layout, size_t jointCount)
+	{
+		if (jointCount >= layout.GetJointCount())
+		{
+			m_active.clear();
+		}
+		else
+		{
+			m_active.resize(layout.GetJointCount());
+
+			for (size_t i = 0; i < m_active.size(); ++i)
+				m_active[i] = (static_cast<size_t>(layout.ToSorted(static_cast<int>(i))) < jointCount) ? 1 : 0;
+		}
+
+		m_sampler.SetActiveJoints(m_active);
+	}
+
+	Blend1DNode::Blend1DNode()
+	{
+		m_parameter = 0.0f;
+	}
+
+	void Blend1DNode::AddChild(float position, std::unique_ptr<BlendNode> child)
+	{
+		auto it = std::upper_bound(m_children.begin(), m_children.end(), position,
+			[](float value, const Child& other) { return value < other.position; });
+
+		m_children.insert(it, { position, std::move(child) });
+	}
+
+	void Blend1DNode::SetParameter(float parameter)
+	{
+		m_parameter = parameter;
+	}
+
+	float Blend1DNode::GetParameter() const
+	{
+		return m_parameter;
+	}
+
+	void Blend1DNode::Update(float deltaTime)
+	{
+		for (Child& child : m_children)
+			child.node->Update(deltaTime);
+	}
+
+	void Blend1DNode::Evaluate(BlendContext& context, LocalPose& out)
+	{
+		if (m_children.empty())
+		{
+			PoseOps::CopyBase(*context.layout, out, context.jointCount);
+			return;
+		}
+
+		//Find the pair of children we're between.
+		size_t next = 0;
+
+		while (next < m_children.size() && m_children[next].position <= m_parameter)
+			++next;
+
+		if (next == 0 || next == m_children.size())
+		{
+			m_children[next == 0 ? 0 : next - 1].node->Evaluate(context, out);
+			return;
+		}
+
+		const Child& a = m_children[next - 1];
+		const Child& b = m_children[next];
+
+		float span = b.position - a.position;
+		float t = (span > 0.0f) ? (m_parameter - a.position) / span : 0.0f;
+
+		if (t < MIN_BLEND_WEIGHT)
+		{
+			a.node->Evaluate(context, out);
+			return;
+		}
+
+		if (t > 1.0f - MIN_BLEND_WEIGHT)
+		{
+			b.node->Evaluate(context, out);
+			return;
+		}
+
+		PooledPose other(context.jointCount);
+
+		a.node->Evaluate(context, out);
+		b.node->Evaluate(context, *other);
+
+		PoseOps::Blend(out, *other, t, nullptr, out, context.jointCount);
+		context.blends++;
+	}
+
+	void Blend1DNode::SetJointLimit(const SkeletonLayout& layout, size_t jointCount)
+	{
+		for (Child& child : m_children)
+			child.node->SetJointLimit(layout, jointCount);
+	}
+
+	Blend2DNode::Blend2DNode()
+	{
+		m_parameter = glm::vec2(0.0f);
+	}
+
+	void Blend2DNode::AddChild(const glm::vec2& position, std::unique_ptr<BlendNode> child)
+	{
+		m_children.push_back({ position, std::move(child) });
+		m_weights.resize(m_children.size());
+	}
+
+	void Blend2DNode::SetParameter(const glm::vec2& parameter)
+	{
+		m_parameter = parameter;
+	}
+
+	const glm::vec2& Blend2DNode::GetParameter() const
+	{
+		return m_parameter;
+	}
+
+	void Blend2DNode::Update(float deltaTime)
+	{
+		for (Child& child : m_children)
+			child.node->Update(deltaTime);
+	}
+
+	void Blend2DNode::Evaluate(BlendContext& context, LocalPose& out)
+	{
+		if (m_children.empty())
+		{
+			PoseOps::CopyBase(*context.layout, out, context.jointCount);
+			return;
+		}
+
+		float total = 0.0f;
+
+		for (size_t i = 0; i < m_children.size(); ++i)
+		{
+			glm::vec2 offset = m_parameter - m_children[i].position;
+			float dist2 = glm::dot(offset, offset);
+
+			//Sitting right on a child means it gets everything.
+			if (dist2 < 1e-8f)
+			{
+				m_children[i].node->Evaluate(context, out);
+				return;
+			}
+
+			m_weights[i] = 1.0f / dist2;
+			total += m_weights[i];
+		}
+
+		//Drop children that barely contribute, then fold in the rest one
+		//at a time. Blending by w / (sum so far) gives each child its share.
+		float kept = 0.0f;
+
+		for (float& weight : m_weights)
+		{
+			weight /= total;
+
+			if (weight < MIN_BLEND_WEIGHT)
+				weight = 0.0f;
+
+			kept += weight;
+		}
+
+		//Only possible with a huge number of children.
+		if (kept <= 0.0f)
+		{
+			m_children[0].node->Evaluate(context, out);
+			return;
+		}
+
+		PooledPose other(context.jointCount);
+		float accumulated = 0.0f;
+
+		for (size_t i = 0; i < m_children.size(); ++i)
+		{
+			float weight = m_weights[i] / kept;
+
+			if (weight <= 0.0f)
+				continue;
+
+			if (accumulated == 0.0f)
+			{
+				m_children[i].node->Evaluate(context, out);
+			}
+			else
+			{
+				m_children[i].node->Evaluate(context, *other);
+				PoseOps::Blend(out, *other, weight / (accumulated + weight), nullptr, out, context.jointCount);
+				context.blends++;
+			}
+
+			accumulated += weight;
+		}
+	}
+
+	void Blend2DNode::SetJointLimit(const SkeletonLayout& layout, size_t jointCount)
+	{
+		for (Child& child : m_children)
+			child.node->SetJointLimit(layout, jointCount);
+	}
+
+	LayerNode::LayerNode(std::unique_ptr<BlendNode> base, std::unique_ptr<BlendNode> layer, Mode mode)
+		: m_base(std::move(base)), m_layer(std::move(layer))
+	{
+		m_mode = mode;
+		m_weight = 1.0f;
+	}
+
+	void LayerNode::SetWeight(float weight)
+	{
+		m_weight = std::clamp(weight, 0.0f, 1.0f);
+	}
+
+	float LayerNode::GetWeight() const
+	{
+		return m_weight;
+	}
+
+	void LayerNode::SetMask(const SkeletonLayout& layout, const std::vector<float>& jointWeights)
+	{
+		if (jointWeights.empty())
+		{
+			m_mask.clear();
+			return;
+		}
+
+		m_mask.assign(layout.GetJointCount(), 0.0f);
+
+		for (size_t i = 0; i < jointWeights.size() && i < m_mask.size(); ++i)
+			m_mask[layout.ToSorted(static_cast<int>(i))] = jointWeights[i];
+	}
+
+	void LayerNode::Update(float deltaTime)
+	{
+		m_base->Update(deltaTime);
+		m_layer->Update(deltaTime);
+	}
+
+	void LayerNode::Evaluate(BlendContext& context, LocalPose& out)
+	{
+		m_base->Evaluate(context, out);
+
+		if (m_weight <= 0.0f)
+			return;
+
+		PooledPose layer(context.jointCount);
+		m_layer->Evaluate(context, *layer);
+
+		const float* mask = m_mask.empty() ? nullptr : m_mask.data();
+
+		if (m_mode == Mode::OVERRIDE)
+		{
+			PoseOps::Blend(out, *layer, m_weight, mask, out, context.jointCount);
+		}
+		else
+		{
+			PoseOps::Add(out, *layer, context.layout->GetBasePositions(), context.layout->GetBaseRotations(),
+				m_weight, mask, out, context.jointCount);
+		}
+
+		context.blends++;
+	}
+
+	void LayerNode::SetJointLimit(const SkeletonLayout& layout, size_t jointCount)
+	{
+		m_base->SetJointLimit(layout, jointCount);
+		m_layer->SetJointLimit(layout, jointCount);
+	}
+
+	AnimPlayer::AnimPlayer(std::unique_ptr<BlendNode> root)
+		: m_root(std::move(root))
+	{
+		m_fadeTime = 0.0f;
+		m_fadeTimer = 0.0f;
+
+		m_updateInterval = 1;
+		m_jointFraction = 1.0f;
+		m_interpolate = false;
+
+		//Nothing has been limited yet, so the first update sets this up.
+		m_jointLimit = SIZE_MAX;
+		m_appliedJoints = 0;
+
+		m_framesSinceUpdate = 0;
+		m_hasPose = false;
+	}
+
+	void AnimPlayer::Play(std::unique_ptr<BlendNode> root, float fadeTime)
+	{
+		if (fadeTime > 0.0f)
+		{
+			m_fadingOut = std::move(m_root);
+			m_fadeTime = fadeTime;
+			m_fadeTimer = 0.0f;
+		}
+		else
+			m_fadingOut = nullptr;
+
+		m_root = std::move(root);
+
+		//Make sure the new tree gets limited on the next update.
+		m_jointLimit = SIZE_MAX;
+	}
+
+	BlendNode& AnimPlayer::GetRoot()
+	{
+		return *m_root;
+	}
+
+	void AnimPlayer::SetLOD(int updateInterval, float jointFraction, bool interpolate)
+	{
+		m_updateInterval = std::max(updateInterval, 1);
+		m_jointFraction = std::clamp(jointFraction, 0.0f, 1.0f);
+		m_interpolate = interpolate;
+	}
+
+	void AnimPlayer::SetLOD(const AnimLODLevel& level)
+	{
+		SetLOD(level.updateInterval, level.jointFraction, level.interpolate);
+	}
+
+	void AnimPlayer::SetLODFromView(float distance, bool visible)
+	{
+		SetLODFromView(distance, visible, s_lodLevels);
+	}
+
+	void AnimPlayer::SetLODFromView(float distance, bool visible, const std::vector<AnimLODLevel>& levels)
+	{
+		if (levels.empty())
+			return;
+
+		if (!visible)
+		{
+			const AnimLODLevel& last = levels.back();
+			SetLOD(last.updateInterval, last.jointFraction, false);
+			return;
+		}
+
+		for (const AnimLODLevel& level : levels)
+		{
+			if (distance <= level.distance)
+			{
+				SetLOD(level);
+				return;
+			}
+		}
+
+		SetLOD(levels.back());
+	}
+
+	void AnimPlayer::SetLODLevels(const std::vector<AnimLODLevel>& levels)
+	{
+		s_lodLevels = levels;
+	}
+
+	const std::vector<AnimLODLevel>& AnimPlayer::GetLODLevels()
+	{
+		return s_lodLevels;
+	}
+
+	void AnimPlayer::Update(float deltaTime, const SkeletonLayout& layout, SkeletonPose& pose)
+	{
+		//Time always moves, even if we won't be looking at the result.
+		m_root->Update(deltaTime);
+
+		if (m_fadingOut != nullptr)
+		{
+			m_fadingOut->Update(deltaTime);
+			m_fadeTimer += deltaTime;
+
+			if (m_fadeTimer >= m_fadeTime)
+				m_fadingOut = nullptr;
+		}
+
+		size_t jointCount = layout.GetJointCount();
+		size_t limit = std::max<size_t>(1, static_cast<size_t>(std::ceil(m_jointFraction * jointCount)));
+		limit = std::min(limit, jointCount);
+
+		if (limit != m_jointLimit)
+		{
+			m_root->SetJointLimit(layout, limit);
+
+			if (m_fadingOut != nullptr)
+				m_fadingOut->SetJointLimit(layout, limit);
+
+			//Anything we stored for joints we weren't animating is stale.
+			m_jointLimit = limit;
+			m_hasPose = false;
+		}
+
+		if (m_to.GetJointCount() < jointCount)
+		{
+			m_from.Resize(jointCount);
+			m_to.Resize(jointCount);
+		}
+
+		++m_framesSinceUpdate;
+
+		BlendContext context = { &layout, limit, 0, 0 };
+
+		if (!m_hasPose || m_framesSinceUpdate >= m_updateInterval)
+		{
+			std::swap(m_from, m_to);
+			Evaluate(context, m_to);
+
+			if (!m_hasPose)
+				PoseOps::Copy(m_to, m_from, limit);
+
+			m_framesSinceUpdate = 0;
+			m_hasPose = true;
+
+			//We're one update behind while interpolating, so show the pose
+			//we're coming from.
+			Apply(layout, (m_interpolate && m_updateInterval > 1) ? m_from : m_to, pose);
+
+			s_posesEvaluated++;
+			s_clipsSampled += context.clipsSampled;
+			s_blends += context.blends;
+			s_jointsEvaluated += limit;
+		}
+		else if (m_interpolate)
+		{
+			PooledPose between(jointCount);
+
+			float t = static_cast<float>(m_framesSinceUpdate) / static_cast<float>(m_updateInterval);
+			PoseOps::Blend(m_from, m_to, t, nullptr, *between, limit);
+
+			Apply(layout, *between, pose);
+
+			s_posesInterpolated++;
+			s_blends++;
+			s_jointsEvaluated += limit;
+		}
+		else
+			s_posesSkipped++;
+	}
+
+	AnimFrameStats AnimPlayer::CollectFrameStats()
+	{
+		AnimFrameStats stats;
+		stats.posesEvaluated = s_posesEvaluated.exchange(0);
+		stats.posesInterpolated = s_posesInterpolated.exchange(0);
+		stats.posesSkipped = s_posesSkipped.exchange(0);
+		stats.clipsSampled = s_clipsSampled.exchange(0);
+		stats.blends = s_blends.exchange(0);
+		stats.jointsEvaluated = s_jointsEvaluated.exchange(0);
+
+		return stats;
+	}
+
+	void AnimPlayer::Evaluate(BlendContext& context, LocalPose& out)
+	{
+		m_root->Evaluate(context, out);
+
+		if (m_fadingOut == nullptr)
+			return;
+
+		//Crossfade from the old tree to the new one.
+		PooledPose old(context.jointCount);
+		m_fadingOut->Evaluate(context, *old);
+
+		float t = std::clamp(m_fadeTimer / m_fadeTime, 0.0f, 1.0f);
+		PoseOps::Blend(*old, out, t, nullptr, out, context.jointCount);
+		context.blends++;
+	}
+
+	void AnimPlayer::Apply(const SkeletonLayout& layout, const LocalPose& local, SkeletonPose& pose)
+	{
+		std::copy(local.pos.begin(), local.pos.begin() + m_jointLimit, pose.pos.begin());
+		std::copy(local.rotation.begin(), local.rotation.begin() + m_jointLimit, pose.rotation.begin());
+
+		//Joints we've stopped animating go back to their base pose.
+		if (m_appliedJoints > m_jointLimit)
+		{
+			const std::vector<glm::vec3>& basePos = layout.GetBasePositions();
+			const std::vector<glm::quat>& baseRotation = layout.GetBaseRotations();
+
+			std::copy(basePos.begin() + m_jointLimit, basePos.begin() + m_appliedJoints, pose.pos.begin() + m_jointLimit);
+			std::copy(baseRotation.begin() + m_jointLimit, baseRotation.begin() + m_appliedJoints, pose.rotation.begin() + m_jointLimit);
+		}
+
+		m_appliedJoints = m_jointLimit;
+
+		FK::Solve(layout, pose);
+	}
+}
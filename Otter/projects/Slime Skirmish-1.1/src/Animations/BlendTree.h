@@ -0,0 +1,258 @@
+/*
+BlendTree.h
+Blend trees for combining animation clips, and a player that runs one
+for a character with crossfades and level of detail.
+*/
+
+#pragma once
+#include "Animations/AnimationSampler.h"
+#include "Animations/PoseBlend.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nou
+{
+	//Passed down through a blend tree while it's evaluated.
+	struct BlendContext
+	{
+		const SkeletonLayout* layout;
+		//How many joints we need, in the layout's sorted order.
+		size_t jointCount;
+
+		//Tallied up for AnimFrameStats.
+		uint32_t clipsSampled;
+		uint32_t blends;
+	};
+
+	//A node in a blend tree. Each node belongs to one character, since
+	//clips keep track of their own playback time.
+	class BlendNode
+	{
+	public:
+
+		virtual ~BlendNode() = default;
+
+		//Move time along. This is called every frame, even on frames where
+		//LOD means we won't be evaluating a pose.
+		virtual void Update(float deltaTime) = 0;
+		//Write the pose for our current time into out.
+		virtual void Evaluate(BlendContext& context, LocalPose& out) = 0;
+		//Only bother with the first jointCount joints of a layout from now on.
+		virtual void SetJointLimit(const SkeletonLayout& layout, size_t jointCount) = 0;
+	};
+
+	//Plays a single compressed clip.
+	class ClipNode : public BlendNode
+	{
+	public:
+
+		ClipNode(const CompressedAnim& anim, const Skeleton& skeleton);
+		virtual ~ClipNode() = default;
+
+		void SetSpeed(float speed);
+		float GetSpeed() const;
+		AnimSampler& GetSampler();
+
+		virtual void Update(float deltaTime) override;
+		virtual void Evaluate(BlendContext& context, LocalPose& out) override;
+		virtual void SetJointLimit(const SkeletonLayout& layout, size_t jointCount) override;
+
+	protected:
+
+		AnimSampler m_sampler;
+		float m_speed;
+		//Which joints the sampler needs to bother with.
+		std::vector<uint8_t> m_active;
+	};
+
+	//Blends between children placed along a line, e.g., idle, walk and run
+	//placed at their movement speeds. Only the two children on either side
+	//of the parameter are evaluated.
+	class Blend1DNode : public BlendNode
+	{
+	public:
+
+		Blend1DNode();
+		virtual ~Blend1DNode() = default;
+
+		void AddChild(float position, std::unique_ptr<BlendNode> child);
+		void SetParameter(float parameter);
+		float GetParameter() const;
+
+		virtual void Update(float deltaTime) override;
+		virtual void Evaluate(BlendContext& context, LocalPose& out) override;
+		virtual void SetJointLimit(const SkeletonLayout& layout, size_t jointCount) override;
+
+	protected:
+
+		struct Child
+		{
+			float position;
+			std::unique_ptr<BlendNode> node;
+		};
+
+		//Kept sorted by position.
+		std::vector<Child> m_children;
+		float m_parameter;
+	};
+
+	//Blends between children placed on a plane, e.g., strafing directions.
+	//Children are weighted by inverse squared distance to the parameter,
+	//and children with hardly any weight are skipped.
+	class Blend2DNode : public BlendNode
+	{
+	public:
+
+		Blend2DNode();
+		virtual ~Blend2DNode() = default;
+
+		void AddChild(const glm::vec2& position, std::unique_ptr<BlendNode> child);
+		void SetParameter(const glm::vec2& parameter);
+		const glm::vec2& GetParameter() const;
+
+		virtual void Update(float deltaTime) override;
+		virtual void Evaluate(BlendContext& context, LocalPose& out) override;
+		virtual void SetJointLimit(const SkeletonLayout& layout, size_t jointCount) override;
+
+	protected:
+
+		struct Child
+		{
+			glm::vec2 position;
+			std::unique_ptr<BlendNode> node;
+		};
+
+		std::vector<Child> m_children;
+		std::vector<float> m_weights;
+		glm::vec2 m_parameter;
+	};
+
+	//Puts one pose on top of another, optionally only on some joints
+	//(e.g., an attack on the upper body while the legs keep running).
+	class LayerNode : public BlendNode
+	{
+	public:
+
+		enum class Mode
+		{
+			//Blend towards the layer.
+			OVERRIDE,
+			//Add the layer's difference from the skeleton's base pose.
+			ADDITIVE
+		};
+
+		LayerNode(std::unique_ptr<BlendNode> base, std::unique_ptr<BlendNode> layer, Mode mode);
+		virtual ~LayerNode() = default;
+
+		void SetWeight(float weight);
+		float GetWeight() const;
+		//Per joint weights for the layer, indexed by joint in the original
+		//skeleton. An empty list applies the layer to every joint.
+		void SetMask(const SkeletonLayout& layout, const std::vector<float>& jointWeights);
+
+		virtual void Update(float deltaTime) override;
+		virtual void Evaluate(BlendContext& context, LocalPose& out) override;
+		virtual void SetJointLimit(const SkeletonLayout& layout, size_t jointCount) override;
+
+	protected:
+
+		std::unique_ptr<BlendNode> m_base;
+		std::unique_ptr<BlendNode> m_layer;
+		Mode m_mode;
+		float m_weight;
+		//In sorted order.
+		std::vector<float> m_mask;
+	};
+
+	//A level of detail for animation, picked by distance to the camera.
+	struct AnimLODLevel
+	{
+		//Used up to this far from the camera.
+		float distance;
+		//Evaluate the blend tree every this many frames.
+		int updateInterval;
+		//How much of the skeleton to animate. Joints are sorted by depth,
+		//so this drops the ends of the hierarchy (fingers, etc.) first.
+		float jointFraction;
+		//Interpolate between evaluated poses on the frames in between.
+		//Otherwise the pose holds still until the next update.
+		bool interpolate;
+	};
+
+	//What animation did over a frame, summed across every player.
+	struct AnimFrameStats
+	{
+		//Players that evaluated their blend tree.
+		uint32_t posesEvaluated;
+		//Players that interpolated between old poses instead.
+		uint32_t posesInterpolated;
+		//Players that did nothing, thanks to LOD.
+		uint32_t posesSkipped;
+		uint32_t clipsSampled;
+		uint32_t blends;
+		//Joints that were animated (not counting FK).
+		uint64_t jointsEvaluated;
+	};
+
+	//Runs a blend tree for one character. Handles crossfading to a new tree
+	//and animation LOD, and writes the result into the character's pose.
+	class AnimPlayer
+	{
+	public:
+
+		AnimPlayer(std::unique_ptr<BlendNode> root);
+		~AnimPlayer() = default;
+
+		//Switch to a new blend tree, crossfading over fadeTime seconds.
+		void Play(std::unique_ptr<BlendNode> root, float fadeTime = 0.0f);
+		BlendNode& GetRoot();
+
+		void SetLOD(int updateInterval, float jointFraction, bool interpolate);
+		void SetLOD(const AnimLODLevel& level);
+		//Pick one of the LOD levels from our distance to the camera.
+		//Off-screen characters use the last level, without interpolation.
+		//This reads the shared LOD levels, so it should only be called on
+		//the main thread. Workers pass in a copy taken there instead.
+		void SetLODFromView(float distance, bool visible);
+		void SetLODFromView(float distance, bool visible, const std::vector<AnimLODLevel>& levels);
+
+		//The LOD levels SetLODFromView picks from, closest first. These
+		//aren't synchronized, so only touch them on the main thread.
+		static void SetLODLevels(const std::vector<AnimLODLevel>& levels);
+		static const std::vector<AnimLODLevel>& GetLODLevels();
+
+		//Move along, and update the pose (running FK) if LOD says so.
+		void Update(float deltaTime, const SkeletonLayout& layout, SkeletonPose& pose);
+
+		//Totals since the last call, which resets them. Call once a frame.
+		static AnimFrameStats CollectFrameStats();
+
+	protected:
+
+		std::unique_ptr<BlendNode> m_root;
+		//The tree we're crossfading away from, if any.
+		std::unique_ptr<BlendNode> m_fadingOut;
+		float m_fadeTime;
+		float m_fadeTimer;
+
+		int m_updateInterval;
+		float m_jointFraction;
+		bool m_interpolate;
+
+		//How many joints our trees are limited to, and how many we last
+		//wrote into the pose.
+		size_t m_jointLimit;
+		size_t m_appliedJoints;
+
+		//The last two poses we evaluated. Between updates we interpolate
+		//from one to the other, which keeps us one update behind.
+		LocalPose m_from;
+		LocalPose m_to;
+		int m_framesSinceUpdate;
+		bool m_hasPose;
+
+		void Evaluate(BlendContext& context, LocalPose& out);
+		void Apply(const SkeletonLayout& layout, const LocalPose& local, SkeletonPose& pose);
+	};
+}
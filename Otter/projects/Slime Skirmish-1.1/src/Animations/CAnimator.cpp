@@ -11,24 +11,105 @@ that we intend the class for use as a component with the ENTT framework.
 
 #include "Animations/CAnimator.h"
 #include "Animations/CSkinnedMeshRenderer.h"
+#include "NOU/CCamera.h"
+#include "Utils/ThreadPool.h"
+#include <cmath>
+
+//How many animators each thread pool chunk updates.
+#define ANIMATOR_BATCH_GRAIN_SIZE 8
 
 namespace nou
 {
 	CAnimator::CAnimator(Entity& owner, const SkeletalAnim& anim)
 	{
 		m_owner = &owner;
+		m_ownedAnim = std::make_unique<CompressedAnim>(anim);
+		m_autoLOD = true;
+		m_radius = 1.5f;
 
 		CSkinnedMeshRenderer& rend = m_owner->Get<CSkinnedMeshRenderer>();
-		m_clip = std::make_unique<SkeletalAnimClip>(anim, rend.GetSkeleton());
+		m_player = std::make_unique<AnimPlayer>(std::make_unique<ClipNode>(*m_ownedAnim, rend.GetSkeleton()));
+	}
+
+	CAnimator::CAnimator(Entity& owner, const CompressedAnim& anim)
+	{
+		m_owner = &owner;
+		m_autoLOD = true;
+		m_radius = 1.5f;
+
+		CSkinnedMeshRenderer& rend = m_owner->Get<CSkinnedMeshRenderer>();
+		m_player = std::make_unique<AnimPlayer>(std::make_unique<ClipNode>(anim, rend.GetSkeleton()));
+	}
+
+	CAnimator::CAnimator(Entity& owner, std::unique_ptr<BlendNode> root)
+	{
+		m_owner = &owner;
+		m_autoLOD = true;
+		m_radius = 1.5f;
+		m_player = std::make_unique<AnimPlayer>(std::move(root));
+	}
+
+	void CAnimator::Play(std::unique_ptr<BlendNode> root, float fadeTime)
+	{
+		m_player->Play(std::move(root), fadeTime);
+	}
+
+	AnimPlayer& CAnimator::GetPlayer()
+	{
+		return *m_player;
+	}
+
+	void CAnimator::SetAutoLOD(bool autoLOD, float radius)
+	{
+		m_autoLOD = autoLOD;
+		m_radius = radius;
 	}
 
 	void CAnimator::Update(float deltaTime)
+	{
+		Update(deltaTime, AnimPlayer::GetLODLevels());
+	}
+
+	void CAnimator::Update(float deltaTime, const std::vector<AnimLODLevel>& lodLevels)
 	{
 		CSkinnedMeshRenderer& rend = m_owner->Get<CSkinnedMeshRenderer>();
-		Skeleton& skeleton = rend.GetSkeleton();
 
-		m_clip->Update(deltaTime, skeleton);
-		m_clip->Apply(skeleton);
-		skeleton.DoFK();
+		if (m_autoLOD)
+			UpdateLOD(lodLevels);
+
+		m_player->Update(deltaTime, rend.GetLayout(), rend.GetPose());
+	}
+
+	void CAnimator::UpdateLOD(const std::vector<AnimLODLevel>& lodLevels)
+	{
+		if (CCamera::current == nullptr)
+			return;
+
+		glm::vec3 pos = glm::vec3(m_owner->transform.GetGlobal()[3]);
+		glm::vec3 camPos = glm::vec3(CCamera::current->transform.GetGlobal()[3]);
+
+		//A rough check against the view frustum in clip space, padded by
+		//our radius so we don't freeze while partly on-screen.
+		glm::vec4 clip = CCamera::current->Get<CCamera>().GetVP() * glm::vec4(pos, 1.0f);
+		float extent = clip.w + m_radius;
+
+		bool visible = clip.w > -m_radius &&
+			std::abs(clip.x) <= extent && std::abs(clip.y) <= extent && std::abs(clip.z) <= extent;
+
+		m_player->SetLODFromView(glm::length(pos - camPos), visible, lodLevels);
+	}
+
+	void CAnimator::UpdateBatch(CAnimator* const* animators, size_t count, float deltaTime)
+	{
+		//Every animator only touches its own sampler and pose, so they
+		//can all run at once. The LOD levels are copied here, on the
+		//calling thread, so changing them can't race with the workers.
+		const std::vector<AnimLODLevel> lodLevels = AnimPlayer::GetLODLevels();
+
+		ThreadPool::ParallelFor(count, ANIMATOR_BATCH_GRAIN_SIZE, [animators, deltaTime, &lodLevels](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				animators[i]->Update(deltaTime, lodLevels);
+		});
 	}
 }
\ No newline at end of file
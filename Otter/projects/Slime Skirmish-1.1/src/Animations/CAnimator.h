@@ -12,6 +12,8 @@ that we intend the class for use as a component with the ENTT framework.
 #pragma once
 #include "NOU/Entity.h"
 #include "Animations/Animation.h"
+#include "Animations/AnimationSampler.h"
+#include "Animations/BlendTree.h"
 
 namespace nou
 {
@@ -19,17 +21,47 @@ namespace nou
 	{
 	public:
 
+		//Compresses the clip for this animator.
 		CAnimator(Entity& owner, const SkeletalAnim& anim);
+		//Play a clip that has already been compressed, which can be
+		//shared between any number of animators.
+		CAnimator(Entity& owner, const CompressedAnim& anim);
+		//Play a blend tree built for our renderer's skeleton.
+		CAnimator(Entity& owner, std::unique_ptr<BlendNode> root);
 		virtual ~CAnimator() = default;
 
 		CAnimator(CAnimator&&) = default;
 		CAnimator& operator=(CAnimator&&) = default;
 
+		//Switch to a new blend tree, crossfading over fadeTime seconds.
+		void Play(std::unique_ptr<BlendNode> root, float fadeTime = 0.0f);
+		AnimPlayer& GetPlayer();
+
+		//Pick our LOD from the current camera on every update, treating us
+		//as a sphere of the given radius for checking if we're on-screen.
+		//Turn this off to set the LOD yourself through GetPlayer().
+		void SetAutoLOD(bool autoLOD, float radius = 1.5f);
+
+		//Evaluate our blend tree (if LOD says so) and run FK on our
+		//renderer's pose.
 		void Update(float deltaTime);
 
+		//Update many animators at once, spread across the thread pool.
+		static void UpdateBatch(CAnimator* const* animators, size_t count, float deltaTime);
+
 	protected:
 
 		Entity* m_owner;
-		std::unique_ptr<SkeletalAnimClip> m_clip;
+		//Only set if we compressed the clip ourselves.
+		std::unique_ptr<CompressedAnim> m_ownedAnim;
+		std::unique_ptr<AnimPlayer> m_player;
+
+		bool m_autoLOD;
+		float m_radius;
+
+		//Players can be updated on the thread pool, so they're handed the
+		//LOD levels rather than reading the shared ones.
+		void Update(float deltaTime, const std::vector<AnimLODLevel>& lodLevels);
+		void UpdateLOD(const std::vector<AnimLODLevel>& lodLevels);
 	};
 }
@@ -10,7 +10,10 @@ that we intend the class for use as a component with the ENTT framework.
 */
 
 #include "Animations/CSkinnedMeshRenderer.h"
+#include "Animations/Skinning.h"
 #include "NOU/CCamera.h"
+#include "Logging.h"
+#include <algorithm>
 
 namespace nou
 {
@@ -20,6 +23,7 @@ namespace nou
 		m_owner = &owner;
 		m_mat = &mat;
 		m_vao = std::make_unique<VertexArray>();
+		m_mesh = nullptr;
 		m_skeleton = std::make_unique<Skeleton>();
 
 		SetMesh(mesh);
@@ -30,6 +34,16 @@ namespace nou
 		return *m_skeleton;
 	}
 
+	const SkeletonLayout& CSkinnedMeshRenderer::GetLayout() const
+	{
+		return *m_layout;
+	}
+
+	SkeletonPose& CSkinnedMeshRenderer::GetPose()
+	{
+		return m_pose;
+	}
+
 	void CSkinnedMeshRenderer::SetMesh(const SkinnedMesh& mesh)
 	{
 		const VertexBuffer* vbo;
@@ -43,22 +57,138 @@ namespace nou
 		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
 			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
 
+		if ((vbo = mesh.GetVBO(Mesh::Attrib::JOINT_INFLUENCE)) != nullptr)
+			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::JOINT_INFLUENCE);
+
+		if ((vbo = mesh.GetVBO(Mesh::Attrib::SKIN_WEIGHT)) != nullptr)
+			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::SKIN_WEIGHT);
+
+		m_mesh = &mesh;
+
 		//This will make a copy of the skeleton data from our base mesh.
 		*m_skeleton = mesh.m_skeleton;
+
+		//The flattened skeleton is shared, we only need our own pose.
+		m_layout = mesh.GetLayout();
+		m_pose.Reset(*m_layout);
+		FK::Solve(*m_layout, m_pose);
 	}
 
 	void CSkinnedMeshRenderer::Draw()
 	{
-		m_mat->Use();
+		CSkinnedMeshRenderer* self = this;
+		DrawInstances(&self, 1);
+	}
+
+	void CSkinnedMeshRenderer::DrawBatch(CSkinnedMeshRenderer* const* renderers, size_t count)
+	{
+		//Rendering only happens on the main thread, so we can keep this around.
+		static std::vector<CSkinnedMeshRenderer*> sorted;
+
+		sorted.assign(renderers, renderers + count);
+		std::sort(sorted.begin(), sorted.end(), [](const CSkinnedMeshRenderer* a, const CSkinnedMeshRenderer* b)
+		{
+			if (a->m_mesh != b->m_mesh)
+				return a->m_mesh < b->m_mesh;
+
+			return a->m_mat < b->m_mat;
+		});
+
+		size_t start = 0;
+
+		while (start < sorted.size())
+		{
+			size_t end = start + 1;
+
+			while (end < sorted.size() && sorted[end]->m_mesh == sorted[start]->m_mesh &&
+				sorted[end]->m_mat == sorted[start]->m_mat)
+			{
+				++end;
+			}
+
+			DrawInstances(&sorted[start], end - start);
+			start = end;
+		}
+	}
+
+	void CSkinnedMeshRenderer::DrawInstances(CSkinnedMeshRenderer* const* renderers, size_t count)
+	{
+		if (count == 0)
+			return;
+
+		CSkinnedMeshRenderer& first = *renderers[0];
+		const SkeletonLayout& layout = *first.m_layout;
+		PaletteRing& ring = PaletteRing::Get();
+
+		//Each instance sends its model and normal matrices, then its palette.
+		size_t stride = layout.GetJointCount() + 2;
+		size_t perDraw = ring.GetSegmentSize() / stride;
+
+		if (perDraw == 0)
+		{
+			//This runs every frame, so only complain the first time.
+			static bool warned = false;
+
+			if (!warned)
+			{
+				LOG_WARN("Skeleton with {} joints is too big for the palette ring, skipping its draws.", layout.GetJointCount());
+				warned = true;
+			}
+
+			return;
+		}
+
+		first.m_mat->Use();
+
+		const ShaderProgram* shader = ShaderProgram::Current();
+		shader->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
+		shader->SetUniform("instanceStride", static_cast<int>(stride));
+
+		for (size_t start = 0; start < count; start += perDraw)
+		{
+			size_t instances = std::min(perDraw, count - start);
+
+			//Everything for one draw goes in one allocation, so the ring never
+			//moves on while a draw still needs the segment it's leaving.
+			GLuint base;
+			glm::mat4* out = ring.Allocate(instances * stride, base);
+
+			for (size_t i = 0; i < instances; ++i)
+			{
+				const CSkinnedMeshRenderer& renderer = *renderers[start + i];
+				auto& transform = renderer.m_owner->transform;
+
+				out[0] = transform.GetGlobal();
+				out[1] = glm::mat4(transform.GetNormal());
+				Skinning::WritePalette(layout, renderer.m_pose, out + 2);
+
+				out += stride;
+			}
+
+			ring.Flush();
+			shader->SetUniform("instanceBase", static_cast<int>(base));
+
+			first.m_vao->DrawInstanced(static_cast<GLsizei>(instances));
+		}
+	}
+
+	void CSkinnedMeshRenderer::SkinVertices(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals) const
+	{
+		const std::vector<glm::vec3>& verts = m_mesh->GetVerts();
+		const std::vector<glm::vec3>& norms = m_mesh->GetNormals();
+		const std::vector<glm::vec4>& joints = m_mesh->GetJointInfluences();
+		const std::vector<glm::vec4>& weights = m_mesh->GetSkinWeights();
+
+		size_t count = std::min(verts.size(), std::min(joints.size(), weights.size()));
+		bool hasNormals = norms.size() >= count;
 
-		auto& transform = m_owner->transform;
+		std::vector<glm::mat4> palette(m_layout->GetJointCount());
+		Skinning::WritePalette(*m_layout, m_pose, palette.data());
 
-		//In addition to what we usually send (model, viewprojection, and normal matrix),
-		//we'll eventually be sending our joint matrices as well.
-		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
-		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
-		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
+		positions.resize(count);
+		normals.resize(hasNormals ? count : 0);
 
-		m_vao->Draw();
+		Skinning::SkinVertices(palette.data(), verts.data(), hasNormals ? norms.data() : nullptr,
+			joints.data(), weights.data(), count, positions.data(), hasNormals ? normals.data() : nullptr);
 	}
 }
\ No newline at end of file
@@ -12,7 +12,9 @@ that we intend the class for use as a component with the ENTT framework.
 #pragma once
 #include "NOU/CMeshRenderer.h"
 #include "Animations/SkinnedMesh.h"
+#include "Animations/SkeletonPose.h"
 #include <memory>
+#include <vector>
 
 namespace nou
 {
@@ -27,12 +29,31 @@ namespace nou
 		CSkinnedMeshRenderer& operator=(CSkinnedMeshRenderer&&) = default;
 
 		Skeleton& GetSkeleton();
+		const SkeletonLayout& GetLayout() const;
+		//Our animated pose, with the skinning palette from the last FK pass.
+		SkeletonPose& GetPose();
 
 		void SetMesh(const SkinnedMesh& mesh);
+		//Draws with our palette on the GPU. Our material needs a shader
+		//that does skinning (e.g., skinned.vert).
 		virtual void Draw();
 
+		//Draw many renderers at once. Renderers that share a mesh and
+		//material are drawn together with one instanced draw call.
+		static void DrawBatch(CSkinnedMeshRenderer* const* renderers, size_t count);
+
+		//Skin our mesh on the CPU with our current pose, giving the same
+		//vertices (before the model transform) as the skinning shader.
+		void SkinVertices(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals) const;
+
 	protected:
 
+		const SkinnedMesh* m_mesh;
 		std::unique_ptr<Skeleton> m_skeleton;
+		std::shared_ptr<SkeletonLayout> m_layout;
+		SkeletonPose m_pose;
+
+		//Draw a run of renderers that all share our mesh and material.
+		static void DrawInstances(CSkinnedMeshRenderer* const* renderers, size_t count);
 	};
 }
\ No newline at end of file
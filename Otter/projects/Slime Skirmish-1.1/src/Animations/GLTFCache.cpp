@@ -0,0 +1,622 @@
+/*
+GLTFCache.cpp
+Cooked binary copies of glTF skinned meshes and animations. The first
+import parses the glTF file as usual and writes out a cooked copy, and
+later loads memory map that instead of parsing JSON and base64 again.
+*/
+
+#include "Animations/GLTFCache.h"
+#include "NOU/GLTFLoader.h"
+#include "Utils/AssetPack.h"
+
+#include "tiny_gltf.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace nou::GLTF
+{
+	const std::string COOKED_CACHE_DIR = "anim_cache";
+
+	//Bump this whenever the layout below changes, so old files get recooked.
+	static const uint32_t COOKED_VERSION = 2;
+	static const char COOKED_MAGIC[4] = { 'N', 'S', 'K', 'N' };
+
+	enum CookedFlags : uint32_t
+	{
+		COOKED_HAS_MESH = 1,
+		COOKED_HAS_ANIM = 2,
+		COOKED_FLIP_UV_Y = 4
+	};
+
+	//Everything in a cooked file is found through its header. Sections
+	//start on 16 byte boundaries, so they can be read straight out of the
+	//mapping.
+	struct CookedHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t flags;
+		uint32_t vertexCount;
+
+		//Size and modification time of the glTF file we were cooked from.
+		uint64_t sourceSize;
+		int64_t sourceTime;
+
+		uint32_t jointCount;
+		int32_t rootInd;
+		uint32_t childCount;
+		uint32_t nameBytes;
+
+		float duration;
+		uint32_t trackCount;
+		uint32_t keyCount;
+		//Joints in the skin the clip was exported against, tracks index into these.
+		uint32_t animJointCount;
+
+		uint64_t vertexOffset;
+		uint64_t jointOffset;
+		uint64_t childOffset;
+		uint64_t nameOffset;
+		uint64_t trackOffset;
+		uint64_t keyOffset;
+		uint64_t fileSize;
+	};
+
+	//Vertices are interleaved, so reading them back is a single pass.
+	struct CookedVertex
+	{
+		float pos[3];
+		float normal[3];
+		float uv[2];
+		uint16_t joints[4];
+		float weights[4];
+	};
+
+	struct CookedJoint
+	{
+		float basePos[3];
+		//Stored xyzw.
+		float baseRotation[4];
+		float invBind[16];
+		//-1 for joints without a parent.
+		int32_t parentInd;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t firstChild;
+		uint32_t childCount;
+	};
+
+	//Matches CompressedAnim::Track, but with a fixed layout.
+	struct CookedTrack
+	{
+		int32_t jointInd;
+		uint32_t type;
+		uint32_t keyCount;
+		uint32_t offset;
+		float rangeMin[3];
+		float rangeExtent[3];
+	};
+
+	struct SourceStamp
+	{
+		bool exists;
+		uint64_t size;
+		int64_t time;
+	};
+
+	static SourceStamp GetSourceStamp(const std::string& filename)
+	{
+		SourceStamp stamp = { false, 0, 0 };
+		std::error_code error;
+
+		uintmax_t size = std::filesystem::file_size(filename, error);
+
+		if (error)
+			return stamp;
+
+		auto time = std::filesystem::last_write_time(filename, error);
+
+		if (error)
+			return stamp;
+
+		stamp.exists = true;
+		stamp.size = static_cast<uint64_t>(size);
+		stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+		return stamp;
+	}
+
+	static bool SectionFits(uint64_t offset, uint64_t count, size_t elementSize, uint64_t fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+
+	//Map a cooked file and make sure it's one we can use. Returns nullptr
+	//if it's missing, out of date, broken, or doesn't have what we need.
+	static MappedFile::Sptr OpenCooked(const std::string& filename, uint32_t required, bool flipUVY,
+		const CookedHeader*& header)
+	{
+		MappedFile::Sptr file = MappedFile::Open(GetCookedPath(filename, flipUVY));
+
+		if (file == nullptr || file->GetSize() < sizeof(CookedHeader))
+			return nullptr;
+
+		header = reinterpret_cast<const CookedHeader*>(file->GetData());
+
+		if (memcmp(header->magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0 ||
+			header->version != COOKED_VERSION || header->fileSize != file->GetSize())
+			return nullptr;
+
+		if ((header->flags & required) != required)
+			return nullptr;
+
+		if (((header->flags & COOKED_FLIP_UV_Y) != 0) != flipUVY)
+			return nullptr;
+
+		//If the glTF file isn't around anymore (e.g., a build that only
+		//ships cooked files), the cooked copy is all we've got.
+		SourceStamp stamp = GetSourceStamp(filename);
+
+		if (stamp.exists && (stamp.size != header->sourceSize || stamp.time != header->sourceTime))
+			return nullptr;
+
+		uint64_t size = header->fileSize;
+
+		if (!SectionFits(header->vertexOffset, header->vertexCount, sizeof(CookedVertex), size) ||
+			!SectionFits(header->jointOffset, header->jointCount, sizeof(CookedJoint), size) ||
+			!SectionFits(header->childOffset, header->childCount, sizeof(int32_t), size) ||
+			!SectionFits(header->nameOffset, header->nameBytes, sizeof(char), size) ||
+			!SectionFits(header->trackOffset, header->trackCount, sizeof(CookedTrack), size) ||
+			!SectionFits(header->keyOffset, header->keyCount, sizeof(uint16_t), size))
+			return nullptr;
+
+		return file;
+	}
+
+	static bool ReadMesh(const CookedHeader& header, const uint8_t* data, SkinnedMesh& mesh)
+	{
+		const CookedVertex* vertices = reinterpret_cast<const CookedVertex*>(data + header.vertexOffset);
+		const CookedJoint* joints = reinterpret_cast<const CookedJoint*>(data + header.jointOffset);
+		const int32_t* children = reinterpret_cast<const int32_t*>(data + header.childOffset);
+		const char* names = reinterpret_cast<const char*>(data + header.nameOffset);
+
+		//Check the tables point at each other properly before we trust them.
+		for (uint32_t i = 0; i < header.jointCount; ++i)
+		{
+			const CookedJoint& joint = joints[i];
+
+			if (joint.parentInd >= static_cast<int32_t>(header.jointCount) ||
+				joint.nameOffset > header.nameBytes || joint.nameLength > header.nameBytes - joint.nameOffset ||
+				joint.firstChild > header.childCount || joint.childCount > header.childCount - joint.firstChild)
+				return false;
+		}
+
+		for (uint32_t i = 0; i < header.childCount; ++i)
+		{
+			if (children[i] < 0 || children[i] >= static_cast<int32_t>(header.jointCount))
+				return false;
+		}
+
+		if (header.rootInd < 0 || header.rootInd >= static_cast<int32_t>(header.jointCount))
+			return false;
+
+		//DoFK recurses down the child lists, so every joint has to be reached
+		//from the root exactly once. A cycle would never bottom out.
+		std::vector<uint8_t> visited(header.jointCount, 0);
+		std::vector<int32_t> pending = { header.rootInd };
+		visited[header.rootInd] = 1;
+
+		while (!pending.empty())
+		{
+			const CookedJoint& joint = joints[pending.back()];
+			pending.pop_back();
+
+			for (uint32_t c = 0; c < joint.childCount; ++c)
+			{
+				int32_t child = children[joint.firstChild + c];
+
+				if (visited[child])
+					return false;
+
+				visited[child] = 1;
+				pending.push_back(child);
+			}
+		}
+
+		size_t count = header.vertexCount;
+
+		//The skinning palette is indexed straight with these.
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				if (vertices[i].joints[c] >= header.jointCount)
+					return false;
+			}
+		}
+
+		std::vector<glm::vec3> verts(count);
+		std::vector<glm::vec3> normals(count);
+		std::vector<glm::vec2> uvs(count);
+		std::vector<glm::vec4> influences(count);
+		std::vector<glm::vec4> weights(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const CookedVertex& vertex = vertices[i];
+
+			verts[i] = glm::vec3(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+			normals[i] = glm::vec3(vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+			uvs[i] = glm::vec2(vertex.uv[0], vertex.uv[1]);
+			influences[i] = glm::vec4(vertex.joints[0], vertex.joints[1], vertex.joints[2], vertex.joints[3]);
+			weights[i] = glm::vec4(vertex.weights[0], vertex.weights[1], vertex.weights[2], vertex.weights[3]);
+		}
+
+		mesh.SetVerts(verts);
+		mesh.SetNormals(normals);
+		mesh.SetUVs(uvs);
+		mesh.SetJointInfluences(influences);
+		mesh.SetSkinWeights(weights);
+
+		Skeleton& skeleton = mesh.m_skeleton;
+		skeleton.m_joints.clear();
+		skeleton.m_joints.resize(header.jointCount);
+		skeleton.m_rootInd = header.rootInd;
+
+		for (uint32_t i = 0; i < header.jointCount; ++i)
+		{
+			const CookedJoint& cooked = joints[i];
+			Joint& joint = skeleton.m_joints[i];
+
+			joint.m_owner = &skeleton;
+			joint.m_name.assign(names + cooked.nameOffset, cooked.nameLength);
+
+			joint.m_basePos = glm::vec3(cooked.basePos[0], cooked.basePos[1], cooked.basePos[2]);
+			joint.m_pos = joint.m_basePos;
+			joint.m_baseRotation = glm::quat(cooked.baseRotation[3],
+				cooked.baseRotation[0], cooked.baseRotation[1], cooked.baseRotation[2]);
+			joint.m_rotation = joint.m_baseRotation;
+			memcpy(&joint.m_invBind, cooked.invBind, sizeof(cooked.invBind));
+
+			joint.m_parent = cooked.parentInd >= 0;
+			joint.m_parentInd = joint.m_parent ? cooked.parentInd : 0;
+			joint.m_childrenInd.assign(children + cooked.firstChild,
+				children + cooked.firstChild + cooked.childCount);
+		}
+
+		skeleton.DoFK();
+		mesh.RebuildLayout();
+		return true;
+	}
+
+	static bool ReadAnimation(const CookedHeader& header, const uint8_t* data, CompressedAnim& anim)
+	{
+		const CookedTrack* cooked = reinterpret_cast<const CookedTrack*>(data + header.trackOffset);
+		const uint16_t* keys = reinterpret_cast<const uint16_t*>(data + header.keyOffset);
+
+		//Each key is a time followed by 3 values. The sampler blends all the
+		//rotation tracks in one run, so they have to come before any position
+		//tracks, the way Compress writes them.
+		bool seenPosition = false;
+
+		for (uint32_t i = 0; i < header.trackCount; ++i)
+		{
+			if (cooked[i].type == static_cast<uint32_t>(CompressedAnim::TrackType::POSITION))
+				seenPosition = true;
+			else if (seenPosition)
+				return false;
+
+			if (cooked[i].type > static_cast<uint32_t>(CompressedAnim::TrackType::POSITION) ||
+				cooked[i].jointInd < 0 || cooked[i].jointInd >= static_cast<int32_t>(header.animJointCount) ||
+				cooked[i].keyCount == 0 ||
+				cooked[i].offset > header.keyCount ||
+				cooked[i].keyCount > (header.keyCount - cooked[i].offset) / 4)
+				return false;
+		}
+
+		std::vector<CompressedAnim::Track> tracks(header.trackCount);
+
+		for (uint32_t i = 0; i < header.trackCount; ++i)
+		{
+			CompressedAnim::Track& track = tracks[i];
+
+			track.jointInd = cooked[i].jointInd;
+			track.type = static_cast<CompressedAnim::TrackType>(cooked[i].type);
+			track.keyCount = cooked[i].keyCount;
+			track.offset = cooked[i].offset;
+			track.rangeMin = glm::vec3(cooked[i].rangeMin[0], cooked[i].rangeMin[1], cooked[i].rangeMin[2]);
+			track.rangeExtent = glm::vec3(cooked[i].rangeExtent[0], cooked[i].rangeExtent[1], cooked[i].rangeExtent[2]);
+		}
+
+		anim.Assign(header.duration, tracks.data(), tracks.size(), keys, header.keyCount);
+		return true;
+	}
+
+	//Appends a section to a cooked file, starting on a 16 byte boundary.
+	static uint64_t AppendSection(std::vector<uint8_t>& buffer, const void* data, size_t size)
+	{
+		buffer.resize((buffer.size() + 15) & ~static_cast<size_t>(15));
+
+		uint64_t offset = buffer.size();
+
+		if (size > 0)
+		{
+			buffer.resize(buffer.size() + size);
+			memcpy(&buffer[offset], data, size);
+		}
+
+		return offset;
+	}
+
+	static bool WriteCooked(const std::string& filename, uint32_t flags,
+		const SkinnedMesh& mesh, const CompressedAnim& anim, uint32_t animJointCount)
+	{
+		CookedHeader header = {};
+		memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+		header.version = COOKED_VERSION;
+		header.flags = flags;
+
+		SourceStamp stamp = GetSourceStamp(filename);
+		header.sourceSize = stamp.size;
+		header.sourceTime = stamp.time;
+
+		std::vector<CookedVertex> vertices;
+		std::vector<CookedJoint> joints;
+		std::vector<int32_t> children;
+		std::string names;
+
+		if (flags & COOKED_HAS_MESH)
+		{
+			const std::vector<glm::vec3>& verts = mesh.GetVerts();
+			const std::vector<glm::vec3>& normals = mesh.GetNormals();
+			const std::vector<glm::vec2>& uvs = mesh.GetUVs();
+			const std::vector<glm::vec4>& influences = mesh.GetJointInfluences();
+			const std::vector<glm::vec4>& weights = mesh.GetSkinWeights();
+
+			vertices.resize(verts.size());
+
+			for (size_t i = 0; i < verts.size(); ++i)
+			{
+				CookedVertex& vertex = vertices[i];
+				memset(&vertex, 0, sizeof(CookedVertex));
+
+				memcpy(vertex.pos, &verts[i], sizeof(vertex.pos));
+
+				if (i < normals.size())
+					memcpy(vertex.normal, &normals[i], sizeof(vertex.normal));
+				if (i < uvs.size())
+					memcpy(vertex.uv, &uvs[i], sizeof(vertex.uv));
+				if (i < weights.size())
+					memcpy(vertex.weights, &weights[i], sizeof(vertex.weights));
+
+				if (i < influences.size())
+				{
+					for (int c = 0; c < 4; ++c)
+						vertex.joints[c] = static_cast<uint16_t>(influences[i][c]);
+				}
+			}
+
+			const Skeleton& skeleton = mesh.m_skeleton;
+			joints.resize(skeleton.m_joints.size());
+
+			for (size_t i = 0; i < skeleton.m_joints.size(); ++i)
+			{
+				const Joint& joint = skeleton.m_joints[i];
+				CookedJoint& cooked = joints[i];
+
+				memcpy(cooked.basePos, &joint.m_basePos, sizeof(cooked.basePos));
+				cooked.baseRotation[0] = joint.m_baseRotation.x;
+				cooked.baseRotation[1] = joint.m_baseRotation.y;
+				cooked.baseRotation[2] = joint.m_baseRotation.z;
+				cooked.baseRotation[3] = joint.m_baseRotation.w;
+				memcpy(cooked.invBind, &joint.m_invBind, sizeof(cooked.invBind));
+
+				cooked.parentInd = joint.m_parent ? joint.m_parentInd : -1;
+				cooked.nameOffset = static_cast<uint32_t>(names.size());
+				cooked.nameLength = static_cast<uint32_t>(joint.m_name.size());
+				cooked.firstChild = static_cast<uint32_t>(children.size());
+				cooked.childCount = static_cast<uint32_t>(joint.m_childrenInd.size());
+
+				names += joint.m_name;
+				children.insert(children.end(), joint.m_childrenInd.begin(), joint.m_childrenInd.end());
+			}
+
+			header.vertexCount = static_cast<uint32_t>(vertices.size());
+			header.jointCount = static_cast<uint32_t>(joints.size());
+			header.rootInd = skeleton.m_rootInd;
+			header.childCount = static_cast<uint32_t>(children.size());
+			header.nameBytes = static_cast<uint32_t>(names.size());
+		}
+
+		std::vector<CookedTrack> tracks;
+
+		if (flags & COOKED_HAS_ANIM)
+		{
+			for (const CompressedAnim::Track& track : anim.GetTracks())
+			{
+				CookedTrack cooked;
+				cooked.jointInd = track.jointInd;
+				cooked.type = static_cast<uint32_t>(track.type);
+				cooked.keyCount = track.keyCount;
+				cooked.offset = track.offset;
+				memcpy(cooked.rangeMin, &track.rangeMin, sizeof(cooked.rangeMin));
+				memcpy(cooked.rangeExtent, &track.rangeExtent, sizeof(cooked.rangeExtent));
+				tracks.push_back(cooked);
+			}
+
+			header.duration = anim.GetDuration();
+			header.trackCount = static_cast<uint32_t>(tracks.size());
+			header.keyCount = static_cast<uint32_t>(anim.GetData().size());
+			header.animJointCount = animJointCount;
+		}
+
+		//Lay the file out in memory, then write it in one go.
+		std::vector<uint8_t> buffer(sizeof(CookedHeader));
+
+		header.vertexOffset = AppendSection(buffer, vertices.data(), vertices.size() * sizeof(CookedVertex));
+		header.jointOffset = AppendSection(buffer, joints.data(), joints.size() * sizeof(CookedJoint));
+		header.childOffset = AppendSection(buffer, children.data(), children.size() * sizeof(int32_t));
+		header.nameOffset = AppendSection(buffer, names.data(), names.size());
+		header.trackOffset = AppendSection(buffer, tracks.data(), tracks.size() * sizeof(CookedTrack));
+		header.keyOffset = AppendSection(buffer, anim.GetData().data(),
+			(flags & COOKED_HAS_ANIM) ? anim.GetData().size() * sizeof(uint16_t) : 0);
+		header.fileSize = buffer.size();
+
+		memcpy(buffer.data(), &header, sizeof(CookedHeader));
+
+		std::error_code error;
+		std::filesystem::create_directories(COOKED_CACHE_DIR, error);
+
+		std::string path = GetCookedPath(filename, (flags & COOKED_FLIP_UV_Y) != 0);
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (!file || !file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size()))
+		{
+			printf("Failed to write cooked copy of %s to %s.\n", filename.c_str(), path.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	//Parse a glTF file the slow way, grabbing whatever mesh and animation
+	//it has. flags says which of the two we found, and animJointCount how
+	//many joints the clip's tracks can refer to.
+	static bool Import(const std::string& filename, bool flipUVY,
+		SkinnedMesh& mesh, CompressedAnim& anim, uint32_t& flags, uint32_t& animJointCount)
+	{
+		auto gltf = std::make_unique<tinygltf::Model>();
+
+		std::string err, warn;
+
+		if (!ParseGLTF(filename, *gltf, err, warn))
+		{
+			DumpErrorsAndWarnings(filename, err, warn);
+			return false;
+		}
+
+		flags = flipUVY ? COOKED_FLIP_UV_Y : 0;
+		animJointCount = 0;
+
+		//Plenty of files only have one or the other (e.g., clips exported
+		//on their own), so we only complain if we find neither.
+		std::string meshErr, animErr;
+		JointIndexLookup jointLookup;
+
+		if (ExtractGeometry(*gltf, mesh, flipUVY, meshErr, warn) &&
+			ExtractSkeleton(*gltf, mesh, jointLookup, meshErr, warn) &&
+			ExtractSkinWeights(*gltf, mesh, meshErr, warn))
+			flags |= COOKED_HAS_MESH;
+
+		SkeletalAnim raw;
+		JointIndexLookup animLookup;
+
+		if (ExtractJointLookup(*gltf, animLookup, animErr, warn) &&
+			ExtractSkeletalAnimation(*gltf, raw, animLookup, animErr, warn))
+		{
+			anim.Compress(raw);
+			animJointCount = static_cast<uint32_t>(animLookup.size());
+			flags |= COOKED_HAS_ANIM;
+		}
+
+		if (!(flags & (COOKED_HAS_MESH | COOKED_HAS_ANIM)))
+			err = meshErr + "\n" + animErr;
+
+		DumpErrorsAndWarnings(filename, err, warn);
+		return (flags & (COOKED_HAS_MESH | COOKED_HAS_ANIM)) != 0;
+	}
+
+	bool LoadSkinnedMeshCached(const std::string& filename, SkinnedMesh& mesh, bool flipUVY)
+	{
+		const CookedHeader* header = nullptr;
+		MappedFile::Sptr file = OpenCooked(filename, COOKED_HAS_MESH, flipUVY, header);
+
+		if (file != nullptr && ReadMesh(*header, file->GetData(), mesh))
+			return true;
+
+		//Let go of a broken cooked file before we overwrite it.
+		file = nullptr;
+
+		CompressedAnim anim;
+		uint32_t flags = 0;
+		uint32_t animJointCount = 0;
+
+		if (!Import(filename, flipUVY, mesh, anim, flags, animJointCount))
+			return false;
+
+		WriteCooked(filename, flags, mesh, anim, animJointCount);
+
+		if (!(flags & COOKED_HAS_MESH))
+		{
+			printf("No skinned mesh in %s.\n", filename.c_str());
+			return false;
+		}
+
+		printf("Loaded skinned mesh from %s and cooked it.\n", filename.c_str());
+		return true;
+	}
+
+	bool LoadAnimationCached(const std::string& filename, CompressedAnim& anim, bool flipUVY)
+	{
+		const CookedHeader* header = nullptr;
+		MappedFile::Sptr file = OpenCooked(filename, COOKED_HAS_ANIM, flipUVY, header);
+
+		if (file != nullptr && ReadAnimation(*header, file->GetData(), anim))
+			return true;
+
+		file = nullptr;
+
+		//Any mesh in the file gets cooked too, in case it's loaded later.
+		SkinnedMesh mesh;
+		uint32_t flags = 0;
+		uint32_t animJointCount = 0;
+
+		if (!Import(filename, flipUVY, mesh, anim, flags, animJointCount))
+			return false;
+
+		WriteCooked(filename, flags, mesh, anim, animJointCount);
+
+		if (!(flags & COOKED_HAS_ANIM))
+		{
+			printf("No skeletal animation in %s.\n", filename.c_str());
+			return false;
+		}
+
+		printf("Loaded animation clip from %s and cooked it.\n", filename.c_str());
+		return true;
+	}
+
+	std::string GetCookedPath(const std::string& filename, bool flipUVY)
+	{
+		//FNV-1a of the path, so files with the same name in different
+		//folders don't collide. The UV flip goes in too, so loading a mesh
+		//both ways doesn't keep recooking over the other copy.
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		for (char c : filename)
+			hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+
+		hash = (hash ^ (flipUVY ? 1u : 0u)) * 0x100000001b3ull;
+
+		char suffix[24];
+		snprintf(suffix, sizeof(suffix), "_%016llx.nskn", static_cast<unsigned long long>(hash));
+
+		std::string stem = std::filesystem::path(filename).stem().string();
+		return (std::filesystem::path(COOKED_CACHE_DIR) / (stem + suffix)).string();
+	}
+
+	bool Cook(const std::string& filename, bool flipUVY)
+	{
+		SkinnedMesh mesh;
+		CompressedAnim anim;
+		uint32_t flags = 0;
+		uint32_t animJointCount = 0;
+
+		if (!Import(filename, flipUVY, mesh, anim, flags, animJointCount))
+			return false;
+
+		return WriteCooked(filename, flags, mesh, anim, animJointCount);
+	}
+}
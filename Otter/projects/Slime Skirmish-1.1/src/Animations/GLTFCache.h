@@ -0,0 +1,38 @@
+/*
+GLTFCache.h
+Cooked binary copies of glTF skinned meshes and animations. The first
+import parses the glTF file as usual and writes out a cooked copy, and
+later loads memory map that instead of parsing JSON and base64 again.
+*/
+
+#pragma once
+#include "Animations/GLTFLoaderSkinning.h"
+#include "Animations/AnimationSampler.h"
+#include <string>
+
+namespace nou::GLTF
+{
+	//Where cooked files are written, relative to the working directory.
+	extern const std::string COOKED_CACHE_DIR;
+
+	//Load a skinned mesh, from its cooked copy if there's an up to date one.
+	//Otherwise the glTF file is loaded the slow way and cooked for next time.
+	bool LoadSkinnedMeshCached(const std::string& filename, SkinnedMesh& mesh,
+		bool flipUVY = true);
+
+	//Load a glTF file's animation straight into a compressed clip, from its
+	//cooked copy if there's an up to date one. flipUVY picks which cooked
+	//copy to use, pass the same value the file's mesh is loaded with so
+	//they share one.
+	bool LoadAnimationCached(const std::string& filename, CompressedAnim& anim,
+		bool flipUVY = true);
+
+	//The path of a glTF file's cooked copy. A cooked file holds whatever
+	//mesh and animation the glTF file had, so both loaders share it.
+	//Meshes loaded with and without flipUVY get separate copies.
+	std::string GetCookedPath(const std::string& filename, bool flipUVY = true);
+
+	//Parse a glTF file and (re)write its cooked copy, e.g., to cook
+	//assets ahead of time. Returns false if there was nothing to cook.
+	bool Cook(const std::string& filename, bool flipUVY = true);
+}
@@ -267,6 +267,7 @@ namespace nou::GLTF
 		}
 
 		skeleton.DoFK();
+		mesh.RebuildLayout();
 		return true;
 	}
 
@@ -378,6 +379,16 @@ namespace nou::GLTF
 			//IDENTIFIERS of those nodes. This means we no longer need
 			//to go through our joint lookup to convert the indices - 
 			//they're already following the same convention we use in NOU.
+			//They index the skinning palette directly, so anything outside
+			//the skeleton would read past the end of it.
+			size_t jointCount = mesh.m_skeleton.m_joints.size();
+
+			if (j0 >= jointCount || j1 >= jointCount || j2 >= jointCount || j3 >= jointCount)
+			{
+				err = "Joint influences refer to a joint outside of the skeleton.";
+				return false;
+			}
+
 			influences[i] = glm::vec4(j0, j1, j2, j3);
 
 			memcpy(&weights[i], &wtGetter.data[face * wtGetter.stride], sizeof(glm::vec4));
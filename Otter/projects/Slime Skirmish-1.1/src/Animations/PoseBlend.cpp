@@ -0,0 +1,240 @@
+/*
+PoseBlend.cpp
+Local pose buffers, a pool to recycle them, and the operations blend
+trees use to combine them.
+*/
+
+#include "Animations/PoseBlend.h"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define POSE_BLEND_SSE
+#include <immintrin.h>
+
+//The SSE blend reads rotations and positions as packed floats, so they
+//have to be laid out xyzw and xyz (GLM_FORCE_QUAT_DATA_WXYZ would break it).
+static_assert(sizeof(glm::quat) == 4 * sizeof(float) &&
+	offsetof(glm::quat, x) == 0 && offsetof(glm::quat, y) == sizeof(float) &&
+	offsetof(glm::quat, z) == 2 * sizeof(float) && offsetof(glm::quat, w) == 3 * sizeof(float),
+	"PoseOps::Blend expects glm::quat to be stored xyzw");
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "PoseOps::Blend expects glm::vec3 to be tightly packed");
+#endif
+
+namespace nou
+{
+	void LocalPose::Resize(size_t jointCount)
+	{
+		pos.resize(jointCount);
+		rotation.resize(jointCount);
+	}
+
+	size_t LocalPose::GetJointCount() const
+	{
+		return pos.size();
+	}
+
+	PosePool& PosePool::ForThisThread()
+	{
+		static thread_local PosePool pool;
+		return pool;
+	}
+
+	LocalPose* PosePool::Acquire(size_t jointCount)
+	{
+		LocalPose* pose;
+
+		if (m_free.empty())
+		{
+			m_poses.push_back(std::make_unique<LocalPose>());
+			pose = m_poses.back().get();
+		}
+		else
+		{
+			pose = m_free.back();
+			m_free.pop_back();
+		}
+
+		//Poses only ever grow, so once the pool has warmed up this never
+		//allocates.
+		if (pose->GetJointCount() < jointCount)
+			pose->Resize(jointCount);
+
+		return pose;
+	}
+
+	void PosePool::Release(LocalPose* pose)
+	{
+		m_free.push_back(pose);
+	}
+
+	size_t PosePool::GetCapacity() const
+	{
+		return m_poses.size();
+	}
+
+	PooledPose::PooledPose(size_t jointCount)
+	{
+		m_pose = PosePool::ForThisThread().Acquire(jointCount);
+	}
+
+	PooledPose::~PooledPose()
+	{
+		PosePool::ForThisThread().Release(m_pose);
+	}
+
+	LocalPose& PooledPose::operator*() const
+	{
+		return *m_pose;
+	}
+
+	LocalPose* PooledPose::operator->() const
+	{
+		return m_pose;
+	}
+
+	namespace PoseOps
+	{
+		static void BlendRange(const LocalPose& a, const LocalPose& b, float t, const float* weights,
+			LocalPose& out, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				float tj = (weights != nullptr) ? t * weights[i] : t;
+
+				glm::quat ra = a.rotation[i];
+				glm::quat rb = b.rotation[i];
+
+				if (glm::dot(ra, rb) < 0.0f)
+					rb = -rb;
+
+				out.rotation[i] = glm::normalize(ra * (1.0f - tj) + rb * tj);
+				out.pos[i] = a.pos[i] + (b.pos[i] - a.pos[i]) * tj;
+			}
+		}
+
+		void Copy(const LocalPose& src, LocalPose& out, size_t count)
+		{
+			std::copy(src.pos.begin(), src.pos.begin() + count, out.pos.begin());
+			std::copy(src.rotation.begin(), src.rotation.begin() + count, out.rotation.begin());
+		}
+
+		void CopyBase(const SkeletonLayout& layout, LocalPose& out, size_t count)
+		{
+			const std::vector<glm::vec3>& basePos = layout.GetBasePositions();
+			const std::vector<glm::quat>& baseRotation = layout.GetBaseRotations();
+
+			std::copy(basePos.begin(), basePos.begin() + count, out.pos.begin());
+			std::copy(baseRotation.begin(), baseRotation.begin() + count, out.rotation.begin());
+		}
+
+		void Blend(const LocalPose& a, const LocalPose& b, float t, const float* weights,
+			LocalPose& out, size_t count)
+		{
+			if (count == 0)
+				return;
+
+#ifdef POSE_BLEND_SSE
+			const float* ap = &a.pos[0].x;
+			const float* bp = &b.pos[0].x;
+			float* op = &out.pos[0].x;
+			const float* ar = &a.rotation[0].x;
+			const float* br = &b.rotation[0].x;
+			float* orot = &out.rotation[0].x;
+
+			size_t i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 tv = _mm_set1_ps(t);
+
+				if (weights != nullptr)
+					tv = _mm_mul_ps(tv, _mm_loadu_ps(weights + i));
+
+				//Quaternions are stored xyzw, one per register. Transposing
+				//4 of them gives us a register per component, like the sampler.
+				__m128 ax = _mm_loadu_ps(ar + i * 4), ay = _mm_loadu_ps(ar + i * 4 + 4);
+				__m128 az = _mm_loadu_ps(ar + i * 4 + 8), aw = _mm_loadu_ps(ar + i * 4 + 12);
+				__m128 bx = _mm_loadu_ps(br + i * 4), by = _mm_loadu_ps(br + i * 4 + 4);
+				__m128 bz = _mm_loadu_ps(br + i * 4 + 8), bw = _mm_loadu_ps(br + i * 4 + 12);
+				_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+				_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+				__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+				__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+				bx = _mm_xor_ps(bx, flip); by = _mm_xor_ps(by, flip); bz = _mm_xor_ps(bz, flip); bw = _mm_xor_ps(bw, flip);
+
+				__m128 x = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), tv));
+				__m128 y = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), tv));
+				__m128 z = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), tv));
+				__m128 w = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), tv));
+
+				__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+				__m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(len2, _mm_set1_ps(1e-12f))));
+				x = _mm_mul_ps(x, inv); y = _mm_mul_ps(y, inv); z = _mm_mul_ps(z, inv); w = _mm_mul_ps(w, inv);
+
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+				_mm_storeu_ps(orot + i * 4, x);
+				_mm_storeu_ps(orot + i * 4 + 4, y);
+				_mm_storeu_ps(orot + i * 4 + 8, z);
+				_mm_storeu_ps(orot + i * 4 + 12, w);
+
+				//4 positions are 12 floats, so they take 3 registers. Spread
+				//each joint's t across the 3 floats of its position to match.
+				float tj[4];
+				_mm_storeu_ps(tj, tv);
+
+				__m128 t0 = _mm_setr_ps(tj[0], tj[0], tj[0], tj[1]);
+				__m128 t1 = _mm_setr_ps(tj[1], tj[1], tj[2], tj[2]);
+				__m128 t2 = _mm_setr_ps(tj[2], tj[3], tj[3], tj[3]);
+
+				const float* pa = ap + i * 3;
+				const float* pb = bp + i * 3;
+				float* po = op + i * 3;
+
+				__m128 p0 = _mm_loadu_ps(pa), p1 = _mm_loadu_ps(pa + 4), p2 = _mm_loadu_ps(pa + 8);
+				__m128 q0 = _mm_loadu_ps(pb), q1 = _mm_loadu_ps(pb + 4), q2 = _mm_loadu_ps(pb + 8);
+
+				_mm_storeu_ps(po, _mm_add_ps(p0, _mm_mul_ps(_mm_sub_ps(q0, p0), t0)));
+				_mm_storeu_ps(po + 4, _mm_add_ps(p1, _mm_mul_ps(_mm_sub_ps(q1, p1), t1)));
+				_mm_storeu_ps(po + 8, _mm_add_ps(p2, _mm_mul_ps(_mm_sub_ps(q2, p2), t2)));
+			}
+
+			//Pick up the last few joints.
+			BlendRange(a, b, t, weights, out, i, count);
+#else
+			BlendRange(a, b, t, weights, out, 0, count);
+#endif
+		}
+
+		void BlendScalar(const LocalPose& a, const LocalPose& b, float t, const float* weights,
+			LocalPose& out, size_t count)
+		{
+			BlendRange(a, b, t, weights, out, 0, count);
+		}
+
+		void Add(const LocalPose& base, const LocalPose& additive,
+			const std::vector<glm::vec3>& referencePos, const std::vector<glm::quat>& referenceRotation,
+			float weight, const float* weights, LocalPose& out, size_t count)
+		{
+			const glm::quat identity(1.0f, 0.0f, 0.0f, 0.0f);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				float w = (weights != nullptr) ? weight * weights[i] : weight;
+
+				//The additive pose's offset from its reference, in the
+				//joint's local space.
+				glm::quat delta = glm::inverse(referenceRotation[i]) * additive.rotation[i];
+
+				if (delta.w < 0.0f)
+					delta = -delta;
+
+				delta = glm::normalize(identity * (1.0f - w) + delta * w);
+
+				out.rotation[i] = glm::normalize(base.rotation[i] * delta);
+				out.pos[i] = base.pos[i] + (additive.pos[i] - referencePos[i]) * w;
+			}
+		}
+	}
+}
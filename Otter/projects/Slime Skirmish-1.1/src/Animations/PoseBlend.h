@@ -0,0 +1,101 @@
+/*
+PoseBlend.h
+Local pose buffers, a pool to recycle them, and the operations blend
+trees use to combine them.
+*/
+
+#pragma once
+#include "Animations/SkeletonPose.h"
+#include <memory>
+#include <vector>
+
+namespace nou
+{
+	//Local transforms for a skeleton, in its layout's sorted order. Since
+	//parents come first, working on a smaller number of joints (for LOD)
+	//just means stopping early.
+	struct LocalPose
+	{
+		std::vector<glm::vec3> pos;
+		std::vector<glm::quat> rotation;
+
+		void Resize(size_t jointCount);
+		size_t GetJointCount() const;
+	};
+
+	//Hands out pose buffers for blending instead of allocating new ones
+	//every time. Each thread has its own pool, so animators can be
+	//updated on the thread pool without locking.
+	class PosePool
+	{
+	public:
+
+		PosePool() = default;
+		~PosePool() = default;
+
+		PosePool(const PosePool&) = delete;
+		PosePool& operator=(const PosePool&) = delete;
+
+		//The pool for the calling thread.
+		static PosePool& ForThisThread();
+
+		//Grab a pose with room for at least jointCount joints.
+		LocalPose* Acquire(size_t jointCount);
+		//Give a pose back to the pool.
+		void Release(LocalPose* pose);
+
+		//How many poses this pool has ever had to create.
+		size_t GetCapacity() const;
+
+	protected:
+
+		std::vector<std::unique_ptr<LocalPose>> m_poses;
+		std::vector<LocalPose*> m_free;
+	};
+
+	//A pose borrowed from this thread's pool for as long as it's in scope.
+	class PooledPose
+	{
+	public:
+
+		PooledPose(size_t jointCount);
+		~PooledPose();
+
+		PooledPose(const PooledPose&) = delete;
+		PooledPose& operator=(const PooledPose&) = delete;
+
+		LocalPose& operator*() const;
+		LocalPose* operator->() const;
+
+	protected:
+
+		LocalPose* m_pose;
+	};
+
+	namespace PoseOps
+	{
+		//Copy the first count joints of a pose.
+		void Copy(const LocalPose& src, LocalPose& out, size_t count);
+
+		//Copy the first count joints of a layout's base pose.
+		void CopyBase(const SkeletonLayout& layout, LocalPose& out, size_t count);
+
+		//out = a blended towards b by t, lerping positions and nlerping rotations.
+		//If weights isn't nullptr, each joint's t is scaled by its weight
+		//(e.g., to only blend the upper body). out can be the same as a or b.
+		//Does 4 joints at a time where SSE is available.
+		void Blend(const LocalPose& a, const LocalPose& b, float t, const float* weights,
+			LocalPose& out, size_t count);
+
+		//Plain scalar version of Blend, for checking results against.
+		void BlendScalar(const LocalPose& a, const LocalPose& b, float t, const float* weights,
+			LocalPose& out, size_t count);
+
+		//Add the difference between additive and reference on top of base,
+		//scaled by weight (and weights, if it isn't nullptr).
+		//out can be the same as base.
+		void Add(const LocalPose& base, const LocalPose& additive,
+			const std::vector<glm::vec3>& referencePos, const std::vector<glm::quat>& referenceRotation,
+			float weight, const float* weights, LocalPose& out, size_t count);
+	}
+}
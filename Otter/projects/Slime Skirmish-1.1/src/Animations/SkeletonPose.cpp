@@ -0,0 +1,178 @@
+/*
+SkeletonPose.cpp
+Flattened skeletons and poses, with forward kinematics as a single pass.
+*/
+
+#include "Animations/SkeletonPose.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+
+//How many poses each thread pool chunk solves.
+#define FK_BATCH_GRAIN_SIZE 8
+
+namespace nou
+{
+	SkeletonLayout::SkeletonLayout(const Skeleton& skeleton)
+	{
+		Build(skeleton);
+	}
+
+	void SkeletonLayout::Build(const Skeleton& skeleton)
+	{
+		const std::vector<Joint>& joints = skeleton.m_joints;
+		int count = static_cast<int>(joints.size());
+
+		//Sorting by depth puts every parent before its children. Depths
+		//are filled in by walking up until we find a joint we already know.
+		std::vector<int> depth(count, -1);
+		std::vector<int> chain;
+
+		for (int i = 0; i < count; ++i)
+		{
+			int cur = i;
+			chain.clear();
+
+			while (cur >= 0 && cur < count && depth[cur] < 0 && chain.size() <= static_cast<size_t>(count))
+			{
+				chain.push_back(cur);
+				cur = joints[cur].m_parent ? joints[cur].m_parentInd : -1;
+			}
+
+			int base = (cur >= 0 && cur < count && depth[cur] >= 0) ? depth[cur] : -1;
+
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+				depth[*it] = ++base;
+		}
+
+		m_toOriginal.resize(count);
+
+		for (int i = 0; i < count; ++i)
+			m_toOriginal[i] = i;
+
+		std::stable_sort(m_toOriginal.begin(), m_toOriginal.end(),
+			[&depth](int a, int b) { return depth[a] < depth[b]; });
+
+		m_toSorted.resize(count);
+
+		for (int i = 0; i < count; ++i)
+			m_toSorted[m_toOriginal[i]] = i;
+
+		m_parents.resize(count);
+		m_invBind.resize(count);
+		m_basePos.resize(count);
+		m_baseRotation.resize(count);
+		m_names.resize(count);
+
+		for (int i = 0; i < count; ++i)
+		{
+			const Joint& joint = joints[m_toOriginal[i]];
+			bool hasParent = joint.m_parent && joint.m_parentInd >= 0 && joint.m_parentInd < count;
+
+			m_parents[i] = hasParent ? m_toSorted[joint.m_parentInd] : -1;
+			m_invBind[i] = joint.m_invBind;
+			m_basePos[i] = joint.m_basePos;
+			m_baseRotation[i] = joint.m_baseRotation;
+			m_names[i] = joint.m_name;
+		}
+	}
+
+	size_t SkeletonLayout::GetJointCount() const
+	{
+		return m_parents.size();
+	}
+
+	const std::vector<int>& SkeletonLayout::GetParents() const
+	{
+		return m_parents;
+	}
+
+	const std::vector<glm::mat4>& SkeletonLayout::GetInverseBinds() const
+	{
+		return m_invBind;
+	}
+
+	const std::vector<glm::vec3>& SkeletonLayout::GetBasePositions() const
+	{
+		return m_basePos;
+	}
+
+	const std::vector<glm::quat>& SkeletonLayout::GetBaseRotations() const
+	{
+		return m_baseRotation;
+	}
+
+	const std::string& SkeletonLayout::GetName(int sortedInd) const
+	{
+		return m_names[sortedInd];
+	}
+
+	int SkeletonLayout::ToSorted(int jointInd) const
+	{
+		return m_toSorted[jointInd];
+	}
+
+	int SkeletonLayout::ToOriginal(int sortedInd) const
+	{
+		return m_toOriginal[sortedInd];
+	}
+
+	SkeletonPose::SkeletonPose(const SkeletonLayout& layout)
+	{
+		Reset(layout);
+	}
+
+	void SkeletonPose::Reset(const SkeletonLayout& layout)
+	{
+		pos = layout.GetBasePositions();
+		rotation = layout.GetBaseRotations();
+		global.assign(layout.GetJointCount(), glm::mat4(1.0f));
+		palette.assign(layout.GetJointCount(), glm::mat4(1.0f));
+	}
+
+	void SkeletonPose::SetLocal(const SkeletonLayout& layout,
+		const std::vector<glm::vec3>& positions,
+		const std::vector<glm::quat>& rotations)
+	{
+		size_t count = std::min(pos.size(), std::min(positions.size(), rotations.size()));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			int sorted = layout.ToSorted(static_cast<int>(i));
+			pos[sorted] = positions[i];
+			rotation[sorted] = rotations[i];
+		}
+	}
+
+	namespace FK
+	{
+		void Solve(const SkeletonLayout& layout, SkeletonPose& pose)
+		{
+			const std::vector<int>& parents = layout.GetParents();
+			const std::vector<glm::mat4>& invBind = layout.GetInverseBinds();
+			size_t count = parents.size();
+
+			//Parents come first, so their global transform is always ready
+			//by the time we get to their children.
+			for (size_t i = 0; i < count; ++i)
+			{
+				//Same as glm::translate(pos) * glm::toMat4(rotation), without
+				//multiplying through the identity.
+				glm::mat4 local = glm::mat4(glm::mat3_cast(glm::normalize(pose.rotation[i])));
+				local[3] = glm::vec4(pose.pos[i], 1.0f);
+
+				int parent = parents[i];
+				pose.global[i] = (parent >= 0) ? pose.global[parent] * local : local;
+				pose.palette[i] = pose.global[i] * invBind[i];
+			}
+		}
+
+		void SolveBatch(const SkeletonLayout& layout, SkeletonPose* const* poses, size_t count)
+		{
+			ThreadPool::ParallelFor(count, FK_BATCH_GRAIN_SIZE, [&layout, poses](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					Solve(layout, *poses[i]);
+			});
+		}
+	}
+}
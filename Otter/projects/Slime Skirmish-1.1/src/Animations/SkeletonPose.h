@@ -0,0 +1,90 @@
+/*
+SkeletonPose.h
+Flattened skeletons and poses, with forward kinematics as a single pass.
+*/
+
+#pragma once
+#include "Animations/SkinnedMesh.h"
+#include <string>
+#include <vector>
+
+namespace nou
+{
+	//The parts of a skeleton that never change, shared by every character
+	//using it. Joints are sorted so that parents always come before their
+	//children, which lets forward kinematics walk the joints in order
+	//instead of recursing through the hierarchy.
+	class SkeletonLayout
+	{
+	public:
+
+		SkeletonLayout() = default;
+		SkeletonLayout(const Skeleton& skeleton);
+		~SkeletonLayout() = default;
+
+		//Replace our contents with a flattened copy of a skeleton.
+		void Build(const Skeleton& skeleton);
+
+		size_t GetJointCount() const;
+
+		//Everything below is in sorted order.
+		//Parent of each joint, or -1 for roots.
+		const std::vector<int>& GetParents() const;
+		const std::vector<glm::mat4>& GetInverseBinds() const;
+		const std::vector<glm::vec3>& GetBasePositions() const;
+		const std::vector<glm::quat>& GetBaseRotations() const;
+		const std::string& GetName(int sortedInd) const;
+
+		//Convert between joint indices in the original skeleton and ours.
+		int ToSorted(int jointInd) const;
+		int ToOriginal(int sortedInd) const;
+
+	protected:
+
+		std::vector<int> m_parents;
+		std::vector<glm::mat4> m_invBind;
+		std::vector<glm::vec3> m_basePos;
+		std::vector<glm::quat> m_baseRotation;
+
+		std::vector<int> m_toSorted;
+		std::vector<int> m_toOriginal;
+
+		//Names are only needed for tools, so they're kept out of the way.
+		std::vector<std::string> m_names;
+	};
+
+	//The animated state of one character's skeleton, as flat arrays in
+	//the same order as its layout.
+	struct SkeletonPose
+	{
+		//Local transforms, filled in by animation.
+		std::vector<glm::vec3> pos;
+		std::vector<glm::quat> rotation;
+
+		//Outputs of forward kinematics.
+		std::vector<glm::mat4> global;
+		//Global * inverse bind, ready to send off for skinning.
+		std::vector<glm::mat4> palette;
+
+		SkeletonPose() = default;
+		SkeletonPose(const SkeletonLayout& layout);
+
+		//Resize for a layout and go back to its base pose.
+		void Reset(const SkeletonLayout& layout);
+		//Copy in local transforms indexed by the original skeleton's
+		//joints (e.g., from AnimSampler).
+		void SetLocal(const SkeletonLayout& layout,
+			const std::vector<glm::vec3>& positions,
+			const std::vector<glm::quat>& rotations);
+	};
+
+	namespace FK
+	{
+		//Compute global transforms and the skinning palette for a pose,
+		//in one pass over the joints.
+		void Solve(const SkeletonLayout& layout, SkeletonPose& pose);
+
+		//Solve many poses that share a layout, spread across the thread pool.
+		void SolveBatch(const SkeletonLayout& layout, SkeletonPose* const* poses, size_t count);
+	}
+}
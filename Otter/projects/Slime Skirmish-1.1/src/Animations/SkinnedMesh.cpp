@@ -7,6 +7,7 @@ Basic classes for managing the data associated with a skinned 3D model.
 */
 
 #include "Animations/SkinnedMesh.h"
+#include "Animations/SkeletonPose.h"
 
 #include "GLM/gtx/transform.hpp"
 
@@ -113,6 +114,11 @@ namespace nou
 		return m_joints[index];
 	}
 
+	SkinnedMesh::SkinnedMesh()
+	{
+		RebuildLayout();
+	}
+
 	void SkinnedMesh::SetJointInfluences(const std::vector<glm::vec4>& jointInfluences)
 	{
 		m_jointInfluences = jointInfluences;
@@ -124,4 +130,41 @@ namespace nou
 		m_skinWeights = skinWeights;
 		SetVBO(Attrib::SKIN_WEIGHT, 4, skinWeights);
 	}
+
+	void SkinnedMesh::RebuildLayout()
+	{
+		//A new layout rather than rebuilding in place, so renderers that
+		//picked up the old one keep a layout that matches their skeleton.
+		m_layout = std::make_shared<SkeletonLayout>(m_skeleton);
+	}
+
+	const std::shared_ptr<SkeletonLayout>& SkinnedMesh::GetLayout() const
+	{
+		return m_layout;
+	}
+
+	const std::vector<glm::vec3>& SkinnedMesh::GetVerts() const
+	{
+		return m_verts;
+	}
+
+	const std::vector<glm::vec3>& SkinnedMesh::GetNormals() const
+	{
+		return m_normals;
+	}
+
+	const std::vector<glm::vec2>& SkinnedMesh::GetUVs() const
+	{
+		return m_uvs;
+	}
+
+	const std::vector<glm::vec4>& SkinnedMesh::GetJointInfluences() const
+	{
+		return m_jointInfluences;
+	}
+
+	const std::vector<glm::vec4>& SkinnedMesh::GetSkinWeights() const
+	{
+		return m_skinWeights;
+	}
 }
\ No newline at end of file
@@ -10,11 +10,13 @@ Basic classes for managing the data associated with a skinned 3D model.
 #include "NOU/Mesh.h"
 #include "NOU/Transform.h"
 #include <vector>
+#include <memory>
 #include <iostream>
 
 namespace nou
 {
 	class Skeleton;
+	class SkeletonLayout;
 
 	class Joint
 	{
@@ -87,14 +89,31 @@ namespace nou
 
 		Skeleton m_skeleton;
 
-		SkinnedMesh() = default;
+		SkinnedMesh();
 		virtual ~SkinnedMesh() = default;
 
 		void SetJointInfluences(const std::vector<glm::vec4>& jointInfluences);
 		void SetSkinWeights(const std::vector<glm::vec4>& skinWeights);
 
+		//Rebuild the flattened copy of our skeleton. Call this whenever
+		//m_skeleton changes, the loaders do once they've filled it in.
+		void RebuildLayout();
+		//Flattened copy of our skeleton, shared by everything rendering this
+		//mesh. It's only ever built by RebuildLayout, never on the fly, so
+		//this is safe to call from worker threads.
+		const std::shared_ptr<SkeletonLayout>& GetLayout() const;
+
+		//The CPU copies of our vertex data, for skinning without a GPU.
+		const std::vector<glm::vec3>& GetVerts() const;
+		const std::vector<glm::vec3>& GetNormals() const;
+		const std::vector<glm::vec2>& GetUVs() const;
+		const std::vector<glm::vec4>& GetJointInfluences() const;
+		const std::vector<glm::vec4>& GetSkinWeights() const;
+
 	protected:
 
+		std::shared_ptr<SkeletonLayout> m_layout;
+
 		std::vector<glm::vec4> m_jointInfluences;
 		std::vector<glm::vec4> m_skinWeights;
 	};
@@ -0,0 +1,246 @@
+/*
+Skinning.cpp
+Joint palettes for GPU skinning, and a CPU fallback that skins vertices
+the same way as the skinning vertex shader.
+*/
+
+#include "Animations/Skinning.h"
+#include <algorithm>
+#include <memory>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SKINNING_SSE
+#include <immintrin.h>
+#endif
+
+namespace nou
+{
+	static std::unique_ptr<PaletteRing> s_ring;
+
+	PaletteRing::PaletteRing(size_t segmentSize, size_t segmentCount)
+	{
+		m_segmentSize = std::max<size_t>(segmentSize, 1);
+		m_segmentCount = std::max<size_t>(segmentCount, 1);
+		m_segment = 0;
+		m_head = 0;
+		m_flushed = 0;
+		m_mapped = nullptr;
+		m_fences.assign(m_segmentCount, nullptr);
+
+		GLsizeiptr size = static_cast<GLsizeiptr>(sizeof(glm::mat4) * m_segmentSize * m_segmentCount);
+
+		glGenBuffers(1, &m_id);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+
+		//With GL 4.4 we can keep the buffer mapped and write straight into it.
+		if (GLAD_GL_VERSION_4_4)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, flags | GL_DYNAMIC_STORAGE_BIT);
+			m_mapped = static_cast<glm::mat4*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, flags));
+		}
+		else
+			glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+		if (m_mapped == nullptr)
+			m_staging.resize(m_segmentSize * m_segmentCount);
+	}
+
+	PaletteRing::~PaletteRing()
+	{
+		for (GLsync fence : m_fences)
+		{
+			if (fence != nullptr)
+				glDeleteSync(fence);
+		}
+
+		if (m_mapped != nullptr)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		}
+
+		glDeleteBuffers(1, &m_id);
+	}
+
+	PaletteRing& PaletteRing::Get()
+	{
+		if (s_ring == nullptr)
+			s_ring = std::make_unique<PaletteRing>();
+
+		return *s_ring;
+	}
+
+	void PaletteRing::Release()
+	{
+		s_ring = nullptr;
+	}
+
+	glm::mat4* PaletteRing::Allocate(size_t count, GLuint& base)
+	{
+		if (count > m_segmentSize)
+			return nullptr;
+
+		if (m_head + count > m_segmentSize)
+			NextSegment();
+
+		size_t start = m_segment * m_segmentSize + m_head;
+		m_head += count;
+		base = static_cast<GLuint>(start);
+
+		return (m_mapped != nullptr) ? m_mapped + start : &m_staging[start];
+	}
+
+	void PaletteRing::Flush()
+	{
+		//Coherent mappings don't need anything from us, but staged
+		//matrices have to be uploaded.
+		if (m_mapped == nullptr && m_head > m_flushed)
+		{
+			size_t start = m_segment * m_segmentSize + m_flushed;
+
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+				static_cast<GLintptr>(start * sizeof(glm::mat4)),
+				static_cast<GLsizeiptr>((m_head - m_flushed) * sizeof(glm::mat4)),
+				&m_staging[start]);
+		}
+
+		m_flushed = m_head;
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, m_id);
+	}
+
+	size_t PaletteRing::GetSegmentSize() const
+	{
+		return m_segmentSize;
+	}
+
+	void PaletteRing::NextSegment()
+	{
+		Flush();
+
+		//Anything drawn from this segment has been submitted by now, so once
+		//this fence goes off the GPU is done with it.
+		if (m_fences[m_segment] != nullptr)
+			glDeleteSync(m_fences[m_segment]);
+
+		m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		m_segment = (m_segment + 1) % m_segmentCount;
+		m_head = 0;
+		m_flushed = 0;
+
+		GLsync& fence = m_fences[m_segment];
+
+		if (fence != nullptr)
+		{
+			GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+			while (result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(fence, 0, 1000000);
+
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	namespace Skinning
+	{
+		void WritePalette(const SkeletonLayout& layout, const SkeletonPose& pose, glm::mat4* out)
+		{
+			size_t count = std::min(layout.GetJointCount(), pose.palette.size());
+
+			for (size_t i = 0; i < count; ++i)
+				out[i] = pose.palette[layout.ToSorted(static_cast<int>(i))];
+		}
+
+		void SkinVertices(const glm::mat4* palette,
+			const glm::vec3* positions, const glm::vec3* normals,
+			const glm::vec4* joints, const glm::vec4* weights, size_t count,
+			glm::vec3* outPositions, glm::vec3* outNormals)
+		{
+#ifdef SKINNING_SSE
+			for (size_t i = 0; i < count; ++i)
+			{
+				const glm::vec4& joint = joints[i];
+				const glm::vec4& weight = weights[i];
+
+				const float* m0 = &palette[static_cast<int>(joint.x)][0][0];
+				const float* m1 = &palette[static_cast<int>(joint.y)][0][0];
+				const float* m2 = &palette[static_cast<int>(joint.z)][0][0];
+				const float* m3 = &palette[static_cast<int>(joint.w)][0][0];
+
+				__m128 w0 = _mm_set1_ps(weight.x);
+				__m128 w1 = _mm_set1_ps(weight.y);
+				__m128 w2 = _mm_set1_ps(weight.z);
+				__m128 w3 = _mm_set1_ps(weight.w);
+
+				//Blend the 4 joint matrices a column at a time.
+				__m128 col[4];
+
+				for (int c = 0; c < 4; ++c)
+				{
+					__m128 a = _mm_add_ps(_mm_mul_ps(w0, _mm_loadu_ps(m0 + c * 4)), _mm_mul_ps(w1, _mm_loadu_ps(m1 + c * 4)));
+					__m128 b = _mm_add_ps(_mm_mul_ps(w2, _mm_loadu_ps(m2 + c * 4)), _mm_mul_ps(w3, _mm_loadu_ps(m3 + c * 4)));
+					col[c] = _mm_add_ps(a, b);
+				}
+
+				const glm::vec3& p = positions[i];
+				__m128 pos = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(col[0], _mm_set1_ps(p.x)), _mm_mul_ps(col[1], _mm_set1_ps(p.y))),
+					_mm_add_ps(_mm_mul_ps(col[2], _mm_set1_ps(p.z)), col[3]));
+
+				float result[4];
+				_mm_storeu_ps(result, pos);
+				outPositions[i] = glm::vec3(result[0], result[1], result[2]);
+
+				if (normals != nullptr && outNormals != nullptr)
+				{
+					const glm::vec3& n = normals[i];
+					__m128 norm = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(col[0], _mm_set1_ps(n.x)), _mm_mul_ps(col[1], _mm_set1_ps(n.y))),
+						_mm_mul_ps(col[2], _mm_set1_ps(n.z)));
+
+					_mm_storeu_ps(result, norm);
+					outNormals[i] = glm::vec3(result[0], result[1], result[2]);
+				}
+			}
+#else
+			SkinVerticesScalar(palette, positions, normals, joints, weights, count, outPositions, outNormals);
+#endif
+		}
+
+		void SkinVerticesScalar(const glm::mat4* palette,
+			const glm::vec3* positions, const glm::vec3* normals,
+			const glm::vec4* joints, const glm::vec4* weights, size_t count,
+			glm::vec3* outPositions, glm::vec3* outNormals)
+		{
+			//Operations are grouped the same way as the SSE version, so the
+			//two give exactly the same results.
+			for (size_t i = 0; i < count; ++i)
+			{
+				const glm::vec4& joint = joints[i];
+				const glm::vec4& weight = weights[i];
+
+				const glm::mat4& m0 = palette[static_cast<int>(joint.x)];
+				const glm::mat4& m1 = palette[static_cast<int>(joint.y)];
+				const glm::mat4& m2 = palette[static_cast<int>(joint.z)];
+				const glm::mat4& m3 = palette[static_cast<int>(joint.w)];
+
+				glm::mat4 skin;
+
+				for (int c = 0; c < 4; ++c)
+					skin[c] = (weight.x * m0[c] + weight.y * m1[c]) + (weight.z * m2[c] + weight.w * m3[c]);
+
+				const glm::vec3& p = positions[i];
+				outPositions[i] = glm::vec3((skin[0] * p.x + skin[1] * p.y) + (skin[2] * p.z + skin[3]));
+
+				if (normals != nullptr && outNormals != nullptr)
+				{
+					const glm::vec3& n = normals[i];
+					outNormals[i] = glm::vec3((skin[0] * n.x + skin[1] * n.y) + skin[2] * n.z);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,94 @@
+/*
+Skinning.h
+Joint palettes for GPU skinning, and a CPU fallback that skins vertices
+the same way as the skinning vertex shader.
+*/
+
+#pragma once
+#include "Animations/SkeletonPose.h"
+#include "glad/glad.h"
+#include <vector>
+
+namespace nou
+{
+	//A shader storage buffer that skinned instances write their matrices
+	//into as they're drawn. Each instance takes [model, normal, palette...],
+	//so a whole batch of instances can be drawn from one buffer.
+	//The buffer is split into segments. When one fills up we fence it
+	//and move on, only waiting if the GPU is still reading the next one.
+	class PaletteRing
+	{
+	public:
+
+		//Where the skinning shader expects to find the buffer.
+		static const GLuint BINDING = 0;
+
+		PaletteRing(size_t segmentSize = 16384, size_t segmentCount = 3);
+		~PaletteRing();
+
+		PaletteRing(const PaletteRing&) = delete;
+		PaletteRing& operator=(const PaletteRing&) = delete;
+
+		//The ring shared by every skinned mesh renderer, created the first
+		//time it's asked for (so this needs a GL context).
+		static PaletteRing& Get();
+		//Delete the shared ring, before the GL context goes away.
+		static void Release();
+
+		//Reserve room for a number of matrices, and find out where they are
+		//in the buffer. Returns nullptr if there will never be enough room.
+		glm::mat4* Allocate(size_t count, GLuint& base);
+		//Make everything allocated so far visible to the GPU and bind the
+		//buffer for drawing.
+		void Flush();
+
+		//How many matrices fit in a segment.
+		size_t GetSegmentSize() const;
+
+	protected:
+
+		GLuint m_id;
+		size_t m_segmentSize;
+		size_t m_segmentCount;
+
+		//The segment we're writing to, and where in it.
+		size_t m_segment;
+		size_t m_head;
+		//Where the data we haven't flushed yet starts.
+		size_t m_flushed;
+
+		//The mapped buffer, if the driver lets us map it persistently.
+		//Otherwise we write into m_staging and upload it on Flush.
+		glm::mat4* m_mapped;
+		std::vector<glm::mat4> m_staging;
+
+		//One fence for each segment, set when we move off of it.
+		std::vector<GLsync> m_fences;
+
+		void NextSegment();
+	};
+
+	namespace Skinning
+	{
+		//Copy a pose's palette into the joint order of its original skeleton,
+		//which is how joint influences on the mesh are numbered.
+		void WritePalette(const SkeletonLayout& layout, const SkeletonPose& pose, glm::mat4* out);
+
+		//Skin vertices on the CPU with a palette from WritePalette, using the
+		//same math as skinned.vert (blend the weighted joint matrices, then
+		//transform). Does 4 components at a time where SSE is available.
+		//Normals can be nullptr if you only need positions. Joint indices
+		//aren't checked here, the loaders reject meshes whose influences
+		//point past the end of their skeleton.
+		void SkinVertices(const glm::mat4* palette,
+			const glm::vec3* positions, const glm::vec3* normals,
+			const glm::vec4* joints, const glm::vec4* weights, size_t count,
+			glm::vec3* outPositions, glm::vec3* outNormals);
+
+		//Plain scalar version of SkinVertices, for checking results against.
+		void SkinVerticesScalar(const glm::mat4* palette,
+			const glm::vec3* positions, const glm::vec3* normals,
+			const glm::vec4* joints, const glm::vec4* weights, size_t count,
+			glm::vec3* outPositions, glm::vec3* outNormals);
+	}
+}
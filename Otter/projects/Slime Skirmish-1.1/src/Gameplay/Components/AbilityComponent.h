@@ -26,6 +26,7 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static AbilityComponent::Sptr FromJson(const nlohmann::json& blob);
 	MAKE_TYPENAME(AbilityComponent);
+	MAKE_CLONEABLE(AbilityComponent);
 
 private:
 	AbilityType _type;
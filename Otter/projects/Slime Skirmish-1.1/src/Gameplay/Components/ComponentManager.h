@@ -103,6 +103,37 @@ namespace Gameplay {
 			return nullptr;
 		}
 
+		/// <summary>
+		/// Makes a copy of a component with a new GUID, and adds it to the global pools. The copy
+		/// is made with IComponent::Clone if the type supports it, or through it's JSON if not
+		/// </summary>
+		/// <param name="source">The component to copy</param>
+		/// <returns>The new component, which is not attached to a gameobject yet</returns>
+		static IComponent::Sptr Clone(const IComponent::Sptr& source) {
+			IComponent::Sptr result = source->Clone();
+
+			// No direct copy for this type, fall back to a round trip through JSON
+			if (result == nullptr) {
+				nlohmann::json blob = source->ToJson();
+				IComponent::SaveBaseJson(source, blob);
+				result = Load(source->ComponentTypeName(), blob);
+				if (result != nullptr) {
+					result->OverrideGUID(Guid::New());
+				}
+				return result;
+			}
+
+			result->OverrideGUID(Guid::New());
+			result->IsEnabled = source->IsEnabled;
+			result->_context = nullptr;
+			// Make sure the component knows it's own type
+			result->_realType = source->_realType;
+			result->_weakSelfPtr = result;
+			// Add the component to the global pools
+			_Components[result->_realType].push_back(result);
+			return result;
+		}
+
 		/// <summary>
 		/// 
 		/// </summary>
@@ -8,13 +8,20 @@ GuiPanel::GuiPanel() :
 	_borderRadius(-1),
 	_color(glm::vec4(1.0f)),
 	_texture(nullptr),
-	_transform(nullptr)
+	_transform(nullptr),
+	_geometry(),
+	_transformVersion(0),
+	_builtRadius(-1),
+	_builtTexture(nullptr)
 { }
 
 GuiPanel::~GuiPanel() = default;
 
 void GuiPanel::SetColor(const glm::vec4& color) {
-	_color = color;
+	if (color != _color) {
+		_color = color;
+		_geometry.MarkDirty();
+	}
 }
 
 const glm::vec4& GuiPanel::GetColor() const {
@@ -26,7 +33,10 @@ int GuiPanel::GetBorderRadius() const {
 }
 
 void GuiPanel::SetBorderRadius(int value) {
-	_borderRadius = value;
+	if (value != _borderRadius) {
+		_borderRadius = value;
+		_geometry.MarkDirty();
+	}
 }
 
 Texture2D::Sptr GuiPanel::GetTexture() const {
@@ -34,7 +44,10 @@ Texture2D::Sptr GuiPanel::GetTexture() const {
 }
 
 void GuiPanel::SetTexture(const Texture2D::Sptr& value) {
-	_texture = value;
+	if (value != _texture) {
+		_texture = value;
+		_geometry.MarkDirty();
+	}
 }
 
 void GuiPanel::Awake() {
@@ -47,11 +60,26 @@ void GuiPanel::Awake() {
 
 void GuiPanel::StartGUI() {
 	Texture2D::Sptr tex = _texture != nullptr ? _texture : GuiBatcher::GetDefaultTexture();
+	int radius = _borderRadius < 0 ? GuiBatcher::GetDefaultBorderRadius() : _borderRadius;
 
 	glm::vec2 min = _transform->GetMin();
 	glm::vec2 max = _transform->GetMax();
 
-	GuiBatcher::PushRect(min, max, _color, tex, _borderRadius < 0 ? GuiBatcher::GetDefaultBorderRadius() : _borderRadius);
+	// The defaults can change underneath us, so check what we'd actually draw with as well
+	if (_transform->GetVersion() != _transformVersion || tex.get() != _builtTexture || radius != _builtRadius) {
+		_geometry.MarkDirty();
+	}
+
+	if (_geometry.NeedsRebuild()) {
+		GuiBatcher::BeginGeometry(_geometry);
+		GuiBatcher::PushRect(min, max, _color, tex, radius);
+		GuiBatcher::EndGeometry();
+
+		_transformVersion = _transform->GetVersion();
+		_builtRadius = radius;
+		_builtTexture = tex.get();
+	}
+	GuiBatcher::PushGeometry(_geometry);
 
 	GuiBatcher::PushScissorRect(min, max);
 	GuiBatcher::PushModelTransform(_transform->GetLocalTransform());
@@ -64,8 +92,12 @@ void GuiPanel::FinishGUI() {
 
 void GuiPanel::RenderImGui()
 {
-	LABEL_LEFT(ImGui::ColorEdit4, "Color ", &_color.x);
-	LABEL_LEFT(ImGui::DragInt,    "Radius", &_borderRadius, 1, 0, 128);
+	if (LABEL_LEFT(ImGui::ColorEdit4, "Color ", &_color.x)) {
+		_geometry.MarkDirty();
+	}
+	if (LABEL_LEFT(ImGui::DragInt,    "Radius", &_borderRadius, 1, 0, 128)) {
+		_geometry.MarkDirty();
+	}
 }
 
 nlohmann::json GuiPanel::ToJson() const {
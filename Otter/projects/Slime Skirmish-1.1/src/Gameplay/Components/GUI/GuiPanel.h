@@ -2,6 +2,7 @@
 
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/GUI/RectTransform.h"
+#include "Graphics/GuiBatcher.h"
 
 /// <summary>
 /// Draws a textured background for UI components
@@ -58,4 +59,10 @@ protected:
 	glm::vec4       _color;
 
 	RectTransform::Sptr _transform;
+
+	// Our background quads, rebuilt only when something they depend on changes
+	GuiGeometry _geometry;
+	uint32_t    _transformVersion;
+	int         _builtRadius;
+	Texture2D*  _builtTexture;
 };
\ No newline at end of file
@@ -1,26 +1,31 @@
 #include "Gameplay/Components/GUI/GuiText.h"
-#include <locale>
-#include <codecvt>
+#include <cstring>
 #include "Graphics/GuiBatcher.h"
+#include "Graphics/TextLayout.h"
 #include "Utils/ImGuiHelper.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/Utf8.h"
 #include "Gameplay/GameObject.h"
 
-std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> StringConvert;
-
 GuiText::GuiText() :
 	IComponent(),
-	_text(LR"()"), // The LR and parenthesis tell us it's a unicode string (wide string)
+	_text(""),
 	_color(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)),
 	_font(nullptr),
 	_textSize(glm::vec2(0.0f)),
-	_textScale(1.0f)
+	_textScale(1.0f),
+	_geometry(),
+	_transformVersion(0),
+	_fontRevision(0)
 { }
 
 GuiText::~GuiText() = default;
 
 void GuiText::SetColor(const glm::vec4& color) {
-	_color = color;
+	if (color != _color) {
+		_color = color;
+		_geometry.MarkDirty();
+	}
 }
 
 const glm::vec4& GuiText::GetColor() const {
@@ -28,23 +33,28 @@ const glm::vec4& GuiText::GetColor() const {
 }
 
 const std::string& GuiText::GetText() const {
-	return StringConvert.to_bytes(_text);
+	return _text;
 }
 
 void GuiText::SetText(const std::string& value) {
-	SetTextUnicode(StringConvert.from_bytes(value));
+	// Text is often set every frame, so only re-measure when it actually changes
+	if (value == _text) {
+		return;
+	}
+	_text = value;
+	_Relayout();
 }
 
-const std::wstring& GuiText::GetTextUnicode() const {
-	return _text;
+std::wstring GuiText::GetTextUnicode() const {
+	std::wstring result;
+	Utf8::AppendWide(result, _text);
+	return result;
 }
 
 void GuiText::SetTextUnicode(const std::wstring& value) {
-	_text = value;
-	
-	if (_font != nullptr) {
-		_textSize = _font->MeausureString(_text, _textScale);
-	}
+	std::string utf8;
+	Utf8::Append(utf8, value);
+	SetText(utf8);
 }
 
 const float GuiText::GetTextScale() const {
@@ -52,7 +62,10 @@ const float GuiText::GetTextScale() const {
 }
 
 void GuiText::SetTextScale(float value) {
-	_textScale = value;
+	if (value != _textScale) {
+		_textScale = value;
+		_Relayout();
+	}
 }
 
 const Font::Sptr& GuiText::GetFont() const {
@@ -61,8 +74,15 @@ const Font::Sptr& GuiText::GetFont() const {
 
 void GuiText::SetFont(const Font::Sptr& font) {
 	_font = font;
+	_Relayout();
+}
+
+void GuiText::_Relayout() {
+	_geometry.MarkDirty();
+
+	// The layout gets cached, so building the geometry won't need to lay the text out again
 	if (_font != nullptr) {
-		_textSize = _font->MeausureString(_text, _textScale);
+		_textSize = TextLayoutCache::Get(_font, _text, _textScale).Size;
 	}
 }
 
@@ -77,29 +97,42 @@ void GuiText::Awake() {
 void GuiText::RenderGUI()
 {
 	if (_font != nullptr && ! _text.empty()) {
-		glm::vec2 position = _transform->GetSize() / 2.0f;
-		position -= _textSize / 2.0f;
-		GuiBatcher::RenderText(_text, _font, position, _color, _textScale);
+		// The font's revision changes as glyphs finish loading, or get evicted from its atlas
+		uint32_t fontRevision = _font->GetRevision();
+		if (_transform->GetVersion() != _transformVersion || fontRevision != _fontRevision) {
+			_geometry.MarkDirty();
+		}
+
+		if (_geometry.NeedsRebuild()) {
+			glm::vec2 position = _transform->GetSize() / 2.0f;
+			position -= _textSize / 2.0f;
+
+			GuiBatcher::BeginGeometry(_geometry);
+			GuiBatcher::RenderText(_text, _font, position, _color, _textScale);
+			GuiBatcher::EndGeometry();
+
+			_transformVersion = _transform->GetVersion();
+			_fontRevision = fontRevision;
+		}
+		GuiBatcher::PushGeometry(_geometry);
 	}
 }
 
 void GuiText::RenderImGui()
 {
 	static char buffer[4096];
-	std::string ascii = StringConvert.to_bytes(_text);
-	memcpy(buffer, ascii.data(), ascii.size());
+	size_t length = glm::min(_text.size(), sizeof(buffer) - 1);
+	memcpy(buffer, _text.data(), length);
+	buffer[length] = '\0';
 
 	if (LABEL_LEFT(ImGui::InputTextMultiline, "Text", buffer, 4096)) {
-		_text = StringConvert.from_bytes(buffer);
-		if (_font != nullptr) {
-			_textSize = _font->MeausureString(_text, _textScale);
-		}
+		SetText(buffer);
+	}
+	if (LABEL_LEFT(ImGui::ColorEdit4, "Color", &_color.x)) {
+		_geometry.MarkDirty();
 	}
-	LABEL_LEFT(ImGui::ColorEdit4, "Color", &_color.x);
 	if (LABEL_LEFT(ImGui::DragFloat, "Scale", &_textScale, 0.01f)) {
-		if (_font != nullptr) {
-			_textSize = _font->MeausureString(_text, _textScale);
-		}
+		_Relayout();
 	}
 }
 
@@ -115,8 +148,9 @@ nlohmann::json GuiText::ToJson() const {
 GuiText::Sptr GuiText::FromJson(const nlohmann::json& blob) {
 	GuiText::Sptr result = std::make_shared<GuiText>();
 	result->_color     = ParseJsonVec4(blob["color"]);
-	result->_textScale = JsonGet(blob, "text", 1.0f);
-	result->_text      = JsonGet<std::wstring>(blob, "text", LR"()");
+	result->_textScale = JsonGet(blob, "scale", 1.0f);
+	result->_text      = JsonGet<std::string>(blob, "text", "");
 	result->_font      = ResourceManager::Get<Font>(Guid(JsonGet<std::string>(blob, "font", "null")));
+	result->_Relayout();
 	return result;
 }
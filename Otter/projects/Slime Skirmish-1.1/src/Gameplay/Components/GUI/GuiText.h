@@ -2,6 +2,7 @@
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/GUI/RectTransform.h"
 #include "Graphics/Font.h"
+#include "Graphics/GuiBatcher.h"
 
 /// <summary>
 /// Renders text for UI components
@@ -25,20 +26,21 @@ public:
 	const glm::vec4& GetColor() const;
 
 	/// <summary>
-	/// Gets the ASCII string being rendered
+	/// Gets the UTF-8 string being rendered
 	/// </summary>
 	const std::string& GetText() const;
 	/// <summary>
-	/// Sets the ASCII text being rendered
+	/// Sets the UTF-8 text being rendered. The text is only laid out again if it
+	/// differs from the current text, so this is cheap to call every frame
 	/// </summary>
 	void SetText(const std::string& value);
 
 	/// <summary>
-	/// Gets the Unicode string being rendered
+	/// Gets a copy of the string being rendered as a wide string
 	/// </summary>
-	const std::wstring& GetTextUnicode() const;
+	std::wstring GetTextUnicode() const;
 	/// <summary>
-	/// Sets the Unicode text being rendered
+	/// Sets the text being rendered from a wide string
 	/// </summary>
 	void SetTextUnicode(const std::wstring& value);
 
@@ -75,11 +77,20 @@ public:
 	static GuiText::Sptr FromJson(const nlohmann::json& blob);
 
 protected:
-	std::wstring    _text;
+	// Stored as UTF-8, which is what the text layout cache works with
+	std::string     _text;
 	glm::vec4       _color;
 	Font::Sptr      _font;
 	glm::vec2       _textSize;
 	float           _textScale;
 
 	RectTransform::Sptr _transform;
+
+	// Our glyph quads, rebuilt only when the text, its placement, or the font's atlas changes
+	GuiGeometry _geometry;
+	uint32_t    _transformVersion;
+	uint32_t    _fontRevision;
+
+	// Marks our geometry dirty and re-measures the text
+	void _Relayout();
 };
\ No newline at end of file
@@ -12,7 +12,8 @@ RectTransform::RectTransform() :
 	_halfSize({0.5f, 0.5f}),
 	_rotation(0.0f),
 	_transform(glm::mat3(1.0f)),
-	_transformDirty(true)
+	_transformDirty(true),
+	_version(0)
 { }
 
 RectTransform::~RectTransform() = default;
@@ -21,8 +22,11 @@ const glm::vec2& RectTransform::GetPosition() const {
 	return _position;
 }
 void RectTransform::SetPosition(const glm::vec2& pos) {
-	_position = pos;
-	_transformDirty = true;
+	if (pos != _position) {
+		_position = pos;
+		_transformDirty = true;
+		_version++;
+	}
 }
 
 glm::vec2 RectTransform::GetMin() const {
@@ -35,6 +39,7 @@ void RectTransform::SetMin(const glm::vec2& value)
 	_halfSize = newSize / 2.0f;
 	_position = value + _halfSize;
 	_transformDirty = true;
+	_version++;
 }
 
 glm::vec2 RectTransform::GetMax() const {
@@ -45,17 +50,26 @@ void RectTransform::SetMax(const glm::vec2& value) {
 	_halfSize = newSize / 2.0f;
 	_position = value - _halfSize;
 	_transformDirty = true;
+	_version++;
 }
 
 glm::vec2 RectTransform::GetSize() const {
 	return _halfSize * 2.0f;
 }
 void RectTransform::SetSize(const glm::vec2& value) {
-	_halfSize = value * 2.0f;
+	if (value * 2.0f != _halfSize) {
+		_halfSize = value * 2.0f;
+		_transformDirty = true;
+		_version++;
+	}
 }
 
 void RectTransform::SetRotationDeg(float value) {
-	_rotation = glm::radians(value);
+	if (glm::radians(value) != _rotation) {
+		_rotation = glm::radians(value);
+		_transformDirty = true;
+		_version++;
+	}
 }
 
 float RectTransform::GetRotationDeg() const {
@@ -67,10 +81,20 @@ const glm::mat3& RectTransform::GetLocalTransform() const {
 	return _transform;
 }
 
+uint32_t RectTransform::GetVersion() const {
+	return _version;
+}
+
 void RectTransform::RenderImGui()
 {
-	_transformDirty |= LABEL_LEFT(ImGui::DragFloat2, "Position", &_position.x, 0.01f);
-	_transformDirty |= LABEL_LEFT(ImGui::DragFloat,  "Rotation", &_rotation, 0.1f);
+	if (LABEL_LEFT(ImGui::DragFloat2, "Position", &_position.x, 0.01f)) {
+		_transformDirty = true;
+		_version++;
+	}
+	if (LABEL_LEFT(ImGui::DragFloat, "Rotation", &_rotation, 0.1f)) {
+		_transformDirty = true;
+		_version++;
+	}
 	glm::vec2 temp = GetSize();
 	if (LABEL_LEFT(ImGui::DragFloat2, "Size    ", &temp.x, 0.1f)) {
 		SetSize(temp);
@@ -68,6 +68,12 @@ public:
 	/// </summary>
 	const glm::mat3& GetLocalTransform() const;
 
+	/// <summary>
+	/// Gets a counter that goes up whenever the bounds or rotation of this transform
+	/// actually change, GUI elements can compare it to see if they need rebuilding
+	/// </summary>
+	uint32_t GetVersion() const;
+
 public:
 	// Inherited from IComponent
 
@@ -84,6 +90,7 @@ protected:
 
 	mutable glm::mat3 _transform;
 	mutable bool _transformDirty;
+	uint32_t _version;
 
 	void __RecalcTransforms() const;
 };
\ No newline at end of file
@@ -112,6 +112,15 @@ namespace Gameplay {
 		/// </summary>
 		virtual std::string ComponentTypeName() const = 0;
 
+		/// <summary>
+		/// Copies this component's settings into a new component that isn't attached to
+		/// anything, used when cloning gameobjects. Runtime state (ex: bullet objects) should
+		/// not be copied. Returns nullptr by default, in which case the component is copied
+		/// through it's JSON instead. Components with no resources or pointers to other
+		/// components can use MAKE_CLONEABLE(Type) to copy themselves directly
+		/// </summary>
+		virtual IComponent::Sptr Clone() const { return nullptr; }
+
 		/// <summary>
 		/// Gets the gameobject that this component is attached to
 		/// </summary>
@@ -183,3 +192,8 @@ namespace Gameplay {
 #define MAKE_TYPENAME(T) \
 	inline virtual std::string ComponentTypeName() const { \
 		static std::string name = StringTools::SanitizeClassName(typeid(T).name()); return name; }
+
+// Implements IComponent::Clone with the component's copy constructor
+#define MAKE_CLONEABLE(T) \
+	inline virtual Gameplay::IComponent::Sptr Clone() const override { \
+		return std::make_shared<T>(*this); }
@@ -48,6 +48,7 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static RenderComponent::Sptr FromJson(const nlohmann::json& data);
 	MAKE_TYPENAME(RenderComponent);
+	MAKE_CLONEABLE(RenderComponent);
 
 protected:
 	// The object's mesh
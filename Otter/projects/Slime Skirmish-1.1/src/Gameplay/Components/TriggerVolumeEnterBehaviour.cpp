@@ -3,7 +3,8 @@
 #include "Gameplay/GameObject.h"
 
 TriggerVolumeEnterBehaviour::TriggerVolumeEnterBehaviour() :
-	IComponent()
+	IComponent(),
+	_playerInTrigger(false)
 { }
 TriggerVolumeEnterBehaviour::~TriggerVolumeEnterBehaviour() = default;
 
@@ -15,9 +16,14 @@ bool TriggerVolumeEnterBehaviour::GetTrigger(){
 	return _playerInTrigger;
 }
 
+Gameplay::Signal& TriggerVolumeEnterBehaviour::TriggerEntered() {
+	return _entered;
+}
+
 void TriggerVolumeEnterBehaviour::OnTriggerVolumeEntered(const std::shared_ptr<Gameplay::Physics::RigidBody>& body){
 	//LOG_INFO("Body has entered {} trigger volume: {}", GetGameObject()->Name, body->GetGameObject()->Name);
 	_playerInTrigger = true;
+	_entered.Fire();
 }
 
 void TriggerVolumeEnterBehaviour::OnTriggerVolumeLeaving(const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
@@ -31,6 +37,14 @@ nlohmann::json TriggerVolumeEnterBehaviour::ToJson() const {
 	return { };
 }
 
+Gameplay::IComponent::Sptr TriggerVolumeEnterBehaviour::Clone() const {
+	// Copies everything but the waiting tasks, see Signal. Whether the player is inside is runtime
+	// state that belongs to the original's trigger, so it doesn't carry over
+	TriggerVolumeEnterBehaviour::Sptr result = std::make_shared<TriggerVolumeEnterBehaviour>(*this);
+	result->_playerInTrigger = false;
+	return result;
+}
+
 TriggerVolumeEnterBehaviour::Sptr TriggerVolumeEnterBehaviour::FromJson(const nlohmann::json& blob) {
 	TriggerVolumeEnterBehaviour::Sptr result = std::make_shared<TriggerVolumeEnterBehaviour>();
 	return result;
@@ -1,5 +1,6 @@
 #pragma once
 #include "IComponent.h"
+#include "Gameplay/Scheduler.h"
 #include "Gameplay/Physics/TriggerVolume.h"
 #include "Gameplay/Components/RenderComponent.h"
 #include "Gameplay/Physics/TriggerVolume.h"
@@ -18,6 +19,11 @@ public:
 	void SetTrigger(bool change);
 	bool GetTrigger();
 
+	/// <summary>
+	/// Fired whenever a body enters the trigger, tasks can wait for it with co_await TriggerEntered()
+	/// </summary>
+	Gameplay::Signal& TriggerEntered();
+
 	// Inherited from IComponent
 
 	virtual void OnTriggerVolumeEntered(const std::shared_ptr<Gameplay::Physics::RigidBody>& body) override;
@@ -26,7 +32,10 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static TriggerVolumeEnterBehaviour::Sptr FromJson(const nlohmann::json& blob);
 	MAKE_TYPENAME(TriggerVolumeEnterBehaviour);
+	// Clones start outside of the trigger, whether or not the original is occupied
+	virtual Gameplay::IComponent::Sptr Clone() const override;
 
 protected:
 	bool _playerInTrigger;
+	Gameplay::Signal _entered;
 };
\ No newline at end of file
@@ -0,0 +1,638 @@
+#include "Gameplay/CrowdSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <btBulletCollisionCommon.h>
+
+#include "Logging.h"
+#include "Utils/ThreadPool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define CROWD_SYSTEM_SSE
+#include <immintrin.h>
+#endif
+
+// The number of 4 agent groups per thread pool chunk
+#define PARALLEL_GRAIN_SIZE 32
+// Squared distances smaller than this are treated as zero
+#define STEERING_EPSILON 1e-6f
+// Agents slower than this don't turn to face where they're going
+#define FACING_SPEED 0.05f
+
+namespace Gameplay {
+	// Everything the steering kernels need that is the same for every agent
+	struct SteeringParams {
+		float TargetX, TargetY;
+		float MaxForce;
+		// Squared, or FLT_MAX to always sense the target
+		float SenseRadius2;
+		float StopDistance;
+		float InvSlowingRadius;
+		float Dt;
+	};
+
+	// The agent arrays the steering kernels read and write
+	struct SteeringArrays {
+		float*         PosX;
+		float*         PosY;
+		float*         VelX;
+		float*         VelY;
+		const float*   MaxSpeed;
+		const int32_t* Behaviour;
+	};
+
+	static inline uint32_t HashCell(int32_t x, int32_t y, uint32_t mask) {
+		return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) & mask;
+	}
+
+	/// <summary>
+	/// Steers and moves a single agent. Push is the separation and avoidance, as a fraction of the agent's
+	/// top speed, and flow is the direction from the flow field, or zero to head straight for the target
+	/// </summary>
+	static void SteerScalar(size_t agent, const SteeringParams& params, const SteeringArrays& arrays, float pushX, float pushY, float flowX, float flowY) {
+		const float dx = params.TargetX - arrays.PosX[agent];
+		const float dy = params.TargetY - arrays.PosY[agent];
+		const float d2 = dx * dx + dy * dy;
+		const float dist = std::sqrt(std::max(d2, STEERING_EPSILON));
+		const float maxSpeed = arrays.MaxSpeed[agent];
+
+		// How fast we want to move towards the target, negative to move away
+		const SteeringBehaviour behaviour = (SteeringBehaviour)arrays.Behaviour[agent];
+		float speed = 0.0f;
+		if (d2 > STEERING_EPSILON && d2 < params.SenseRadius2) {
+			switch (behaviour) {
+				case SteeringBehaviour::Seek:   speed = maxSpeed; break;
+				case SteeringBehaviour::Flee:   speed = -maxSpeed; break;
+				case SteeringBehaviour::Arrive: speed = maxSpeed * std::min(std::max(dist - params.StopDistance, 0.0f) * params.InvSlowingRadius, 1.0f); break;
+				default: break;
+			}
+		}
+
+		// The flow field leads around walls, but fleeing agents just want to get away
+		float dirX = dx / dist, dirY = dy / dist;
+		if ((flowX != 0.0f || flowY != 0.0f) && behaviour != SteeringBehaviour::Flee) {
+			dirX = flowX;
+			dirY = flowY;
+		}
+
+		const float desiredX = dirX * speed + pushX * maxSpeed;
+		const float desiredY = dirY * speed + pushY * maxSpeed;
+
+		// Reynolds style steering, the change in velocity is limited so agents can't turn on the spot
+		const float steerX = desiredX - arrays.VelX[agent];
+		const float steerY = desiredY - arrays.VelY[agent];
+		const float steerScale = std::min(1.0f, params.MaxForce / std::sqrt(std::max(steerX * steerX + steerY * steerY, STEERING_EPSILON)));
+		float velX = arrays.VelX[agent] + steerX * steerScale * params.Dt;
+		float velY = arrays.VelY[agent] + steerY * steerScale * params.Dt;
+
+		const float speedScale = std::min(1.0f, maxSpeed / std::sqrt(std::max(velX * velX + velY * velY, STEERING_EPSILON)));
+		velX *= speedScale;
+		velY *= speedScale;
+
+		arrays.VelX[agent] = velX;
+		arrays.VelY[agent] = velY;
+		arrays.PosX[agent] += velX * params.Dt;
+		arrays.PosY[agent] += velY * params.Dt;
+	}
+
+	#ifdef CROWD_SYSTEM_SSE
+	/// <summary>
+	/// The same as SteerScalar for agents [first, first + 4), which must all be valid or padding
+	/// </summary>
+	static void SteerSse(size_t first, const SteeringParams& params, const SteeringArrays& arrays, const float* pushX, const float* pushY, const float* flowX, const float* flowY) {
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 epsilon = _mm_set1_ps(STEERING_EPSILON);
+		const __m128 dt = _mm_set1_ps(params.Dt);
+
+		__m128 posX = _mm_loadu_ps(&arrays.PosX[first]);
+		__m128 posY = _mm_loadu_ps(&arrays.PosY[first]);
+		__m128 velX = _mm_loadu_ps(&arrays.VelX[first]);
+		__m128 velY = _mm_loadu_ps(&arrays.VelY[first]);
+		const __m128 maxSpeed = _mm_loadu_ps(&arrays.MaxSpeed[first]);
+		const __m128i behaviour = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&arrays.Behaviour[first]));
+
+		const __m128 dx = _mm_sub_ps(_mm_set1_ps(params.TargetX), posX);
+		const __m128 dy = _mm_sub_ps(_mm_set1_ps(params.TargetY), posY);
+		const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		const __m128 dist = _mm_sqrt_ps(_mm_max_ps(d2, epsilon));
+
+		// Work out the speed for every behaviour, then pick each lane's with masks
+		const __m128 isSeek   = _mm_castsi128_ps(_mm_cmpeq_epi32(behaviour, _mm_set1_epi32((int32_t)SteeringBehaviour::Seek)));
+		const __m128 isFlee   = _mm_castsi128_ps(_mm_cmpeq_epi32(behaviour, _mm_set1_epi32((int32_t)SteeringBehaviour::Flee)));
+		const __m128 isArrive = _mm_castsi128_ps(_mm_cmpeq_epi32(behaviour, _mm_set1_epi32((int32_t)SteeringBehaviour::Arrive)));
+		const __m128 arriveSpeed = _mm_mul_ps(maxSpeed, _mm_min_ps(_mm_mul_ps(_mm_max_ps(_mm_sub_ps(dist, _mm_set1_ps(params.StopDistance)), zero), _mm_set1_ps(params.InvSlowingRadius)), one));
+		__m128 speed = _mm_or_ps(_mm_or_ps(
+			_mm_and_ps(isSeek, maxSpeed),
+			_mm_and_ps(isFlee, _mm_xor_ps(maxSpeed, _mm_set1_ps(-0.0f)))),
+			_mm_and_ps(isArrive, arriveSpeed));
+		const __m128 sensed = _mm_and_ps(_mm_cmpgt_ps(d2, epsilon), _mm_cmplt_ps(d2, _mm_set1_ps(params.SenseRadius2)));
+		speed = _mm_and_ps(speed, sensed);
+
+		const __m128 laneFlowX = _mm_loadu_ps(flowX);
+		const __m128 laneFlowY = _mm_loadu_ps(flowY);
+		const __m128 hasFlow = _mm_andnot_ps(isFlee, _mm_cmpneq_ps(_mm_add_ps(_mm_mul_ps(laneFlowX, laneFlowX), _mm_mul_ps(laneFlowY, laneFlowY)), zero));
+		const __m128 dirX = _mm_or_ps(_mm_and_ps(hasFlow, laneFlowX), _mm_andnot_ps(hasFlow, _mm_div_ps(dx, dist)));
+		const __m128 dirY = _mm_or_ps(_mm_and_ps(hasFlow, laneFlowY), _mm_andnot_ps(hasFlow, _mm_div_ps(dy, dist)));
+
+		const __m128 desiredX = _mm_add_ps(_mm_mul_ps(dirX, speed), _mm_mul_ps(_mm_loadu_ps(pushX), maxSpeed));
+		const __m128 desiredY = _mm_add_ps(_mm_mul_ps(dirY, speed), _mm_mul_ps(_mm_loadu_ps(pushY), maxSpeed));
+
+		const __m128 steerX = _mm_sub_ps(desiredX, velX);
+		const __m128 steerY = _mm_sub_ps(desiredY, velY);
+		const __m128 steerLen = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(steerX, steerX), _mm_mul_ps(steerY, steerY)), epsilon));
+		const __m128 steerScale = _mm_mul_ps(_mm_min_ps(one, _mm_div_ps(_mm_set1_ps(params.MaxForce), steerLen)), dt);
+		velX = _mm_add_ps(velX, _mm_mul_ps(steerX, steerScale));
+		velY = _mm_add_ps(velY, _mm_mul_ps(steerY, steerScale));
+
+		const __m128 velLen = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velY, velY)), epsilon));
+		const __m128 speedScale = _mm_min_ps(one, _mm_div_ps(maxSpeed, velLen));
+		velX = _mm_mul_ps(velX, speedScale);
+		velY = _mm_mul_ps(velY, speedScale);
+
+		_mm_storeu_ps(&arrays.VelX[first], velX);
+		_mm_storeu_ps(&arrays.VelY[first], velY);
+		_mm_storeu_ps(&arrays.PosX[first], _mm_add_ps(posX, _mm_mul_ps(velX, dt)));
+		_mm_storeu_ps(&arrays.PosY[first], _mm_add_ps(posY, _mm_mul_ps(velY, dt)));
+	}
+	#endif
+
+	CrowdSystem::CrowdSystem() :
+		_settings(),
+		_target(0.0f),
+		_obstacles(),
+		_count(0),
+		_cellSize(1.0f),
+		_cellMask(0)
+	{ }
+
+	CrowdSystem::~CrowdSystem() = default;
+
+	CrowdSystem::Settings& CrowdSystem::GetSettings() {
+		return _settings;
+	}
+
+	size_t CrowdSystem::AddAgent(const GameObject::Sptr& object, SteeringBehaviour behaviour) {
+		LOG_ASSERT(object != nullptr, "Cannot add an agent for a null object!");
+		const int existing = FindAgent(object.get());
+		if (existing >= 0) {
+			_behaviour[existing] = (int32_t)behaviour;
+			return (size_t)existing;
+		}
+		return _AddAgent(glm::vec2(object->GetPosition()), behaviour, object);
+	}
+
+	size_t CrowdSystem::AddAgent(const glm::vec3& position, SteeringBehaviour behaviour) {
+		return _AddAgent(glm::vec2(position), behaviour, nullptr);
+	}
+
+	void CrowdSystem::RemoveAgent(const GameObject* object) {
+		const int index = FindAgent(object);
+		if (index >= 0) {
+			_RemoveAt((size_t)index);
+		}
+	}
+
+	void CrowdSystem::Clear() {
+		_count = 0;
+		_lookup.clear();
+		_ResizeArrays();
+	}
+
+	int CrowdSystem::FindAgent(const GameObject* object) const {
+		auto it = _lookup.find(object);
+		return it != _lookup.end() ? (int)it->second : -1;
+	}
+
+	size_t CrowdSystem::GetAgentCount() const {
+		return _count;
+	}
+
+	void CrowdSystem::SetBehaviour(size_t agent, SteeringBehaviour behaviour) {
+		LOG_ASSERT(agent < _count, "Agent index out of range!");
+		_behaviour[agent] = (int32_t)behaviour;
+	}
+
+	SteeringBehaviour CrowdSystem::GetBehaviour(size_t agent) const {
+		LOG_ASSERT(agent < _count, "Agent index out of range!");
+		return (SteeringBehaviour)_behaviour[agent];
+	}
+
+	void CrowdSystem::SetMaxSpeed(size_t agent, float maxSpeed) {
+		LOG_ASSERT(agent < _count, "Agent index out of range!");
+		_maxSpeed[agent] = std::max(maxSpeed, 0.0f);
+	}
+
+	glm::vec2 CrowdSystem::GetPosition(size_t agent) const {
+		LOG_ASSERT(agent < _count, "Agent index out of range!");
+		return glm::vec2(_posX[agent], _posY[agent]);
+	}
+
+	glm::vec2 CrowdSystem::GetVelocity(size_t agent) const {
+		LOG_ASSERT(agent < _count, "Agent index out of range!");
+		return glm::vec2(_velX[agent], _velY[agent]);
+	}
+
+	void CrowdSystem::SetTarget(const glm::vec3& target) {
+		_target = glm::vec2(target);
+	}
+
+	const glm::vec2& CrowdSystem::GetTarget() const {
+		return _target;
+	}
+
+	void CrowdSystem::SetFlowField(const FlowField::Sptr& field) {
+		_flowField = field;
+	}
+
+	const FlowField::Sptr& CrowdSystem::GetFlowField() const {
+		return _flowField;
+	}
+
+	void CrowdSystem::AddObstacle(const glm::vec2& min, const glm::vec2& max) {
+		_obstacles.push_back({ glm::min(min, max), glm::max(min, max) });
+	}
+
+	void CrowdSystem::ClearObstacles() {
+		_obstacles.clear();
+	}
+
+	void CrowdSystem::SyncObstacles(btCollisionWorld* world, const glm::vec2& min, const glm::vec2& max, float minHeight, float maxHeight) {
+		_obstacles.clear();
+
+		const btCollisionObjectArray& objects = world->getCollisionObjectArray();
+		for (int ix = 0; ix < objects.size(); ix++) {
+			const btCollisionObject* object = objects[ix];
+			if (!object->isStaticOrKinematicObject() || (object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE)) {
+				continue;
+			}
+
+			btVector3 aabbMin, aabbMax;
+			object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+			if (aabbMax.z() < minHeight || aabbMin.z() > maxHeight ||
+				aabbMax.x() < min.x || aabbMax.y() < min.y || aabbMin.x() > max.x || aabbMin.y() > max.y) {
+				continue;
+			}
+			_obstacles.push_back({ glm::vec2(aabbMin.x(), aabbMin.y()), glm::vec2(aabbMax.x(), aabbMax.y()) });
+		}
+	}
+
+	void CrowdSystem::Update(float dt) {
+		if (dt <= 0.0f) {
+			return;
+		}
+
+		_SyncFromObjects();
+		if (_count == 0) {
+			return;
+		}
+
+		_BuildHash();
+
+		// Groups only ever write to their own agents, and neighbours are read from the sorted copy
+		// in the hash, so the groups can be steered in any order
+		const size_t numGroups = (_count + 3) / 4;
+		if (_settings.MultiThreaded) {
+			ThreadPool::ParallelFor(numGroups, PARALLEL_GRAIN_SIZE, [this, dt](size_t begin, size_t end) {
+				_SteerGroups(begin, end, dt);
+			});
+		} else {
+			_SteerGroups(0, numGroups, dt);
+		}
+
+		_WriteBack();
+	}
+
+	bool CrowdSystem::IsSimdSupported() {
+		#ifdef CROWD_SYSTEM_SSE
+		return true;
+		#else
+		return false;
+		#endif
+	}
+
+	size_t CrowdSystem::_AddAgent(const glm::vec2& position, SteeringBehaviour behaviour, const GameObject::Sptr& object) {
+		const size_t index = _count++;
+		_ResizeArrays();
+
+		_posX[index] = position.x;
+		_posY[index] = position.y;
+		_velX[index] = 0.0f;
+		_velY[index] = 0.0f;
+		_maxSpeed[index] = _settings.MaxSpeed;
+		_behaviour[index] = (int32_t)behaviour;
+		_objects[index] = object;
+		_rawObjects[index] = object.get();
+		_versions[index] = object != nullptr ? object->GetTransformVersion() : 0;
+		if (object != nullptr) {
+			_lookup[object.get()] = index;
+		}
+		return index;
+	}
+
+	void CrowdSystem::_RemoveAt(size_t index) {
+		if (_rawObjects[index] != nullptr) {
+			_lookup.erase(_rawObjects[index]);
+		}
+
+		// Swap the last agent into the hole so the arrays stay dense
+		const size_t last = _count - 1;
+		if (index != last) {
+			_posX[index] = _posX[last];
+			_posY[index] = _posY[last];
+			_velX[index] = _velX[last];
+			_velY[index] = _velY[last];
+			_maxSpeed[index] = _maxSpeed[last];
+			_behaviour[index] = _behaviour[last];
+			_objects[index] = std::move(_objects[last]);
+			_rawObjects[index] = _rawObjects[last];
+			_versions[index] = _versions[last];
+			if (_rawObjects[index] != nullptr) {
+				_lookup[_rawObjects[index]] = index;
+			}
+		}
+
+		_count--;
+		_ResizeArrays();
+	}
+
+	void CrowdSystem::_ResizeArrays() {
+		const size_t padded = (_count + 3) & ~(size_t)3;
+		_posX.resize(padded);
+		_posY.resize(padded);
+		_velX.resize(padded);
+		_velY.resize(padded);
+		_maxSpeed.resize(padded);
+		_behaviour.resize(padded);
+		_objects.resize(padded);
+		_rawObjects.resize(padded);
+		_versions.resize(padded);
+
+		// Padding agents have no speed, so the kernel leaves them where they are
+		for (size_t ix = _count; ix < padded; ix++) {
+			_posX[ix] = _posY[ix] = 0.0f;
+			_velX[ix] = _velY[ix] = 0.0f;
+			_maxSpeed[ix] = 0.0f;
+			_behaviour[ix] = (int32_t)SteeringBehaviour::Idle;
+			_objects[ix].reset();
+			_rawObjects[ix] = nullptr;
+			_versions[ix] = 0;
+		}
+	}
+
+	void CrowdSystem::_SyncFromObjects() {
+		// Backwards, so removing an agent only moves ones we've already looked at
+		for (size_t ix = _count; ix > 0; ix--) {
+			const size_t agent = ix - 1;
+			GameObject* object = _rawObjects[agent];
+			if (object == nullptr) {
+				continue;
+			}
+			if (_objects[agent].expired()) {
+				_RemoveAt(agent);
+				continue;
+			}
+
+			// Something other than us moved the object (ex: it was knocked back), start from where it is now
+			const uint32_t version = object->GetTransformVersion();
+			if (version != _versions[agent]) {
+				_posX[agent] = object->GetPosition().x;
+				_posY[agent] = object->GetPosition().y;
+				_versions[agent] = version;
+			}
+		}
+	}
+
+	void CrowdSystem::_BuildHash() {
+		_cellSize = std::max(_settings.SeparationRadius, 0.01f);
+
+		// Twice as many buckets as agents keeps collisions between unrelated cells rare
+		uint32_t numBuckets = 16;
+		while (numBuckets < _count * 2) {
+			numBuckets <<= 1;
+		}
+		_cellMask = numBuckets - 1;
+
+		// Counting sort by bucket. After the prefix sum each bucket holds it's end, and
+		// scattering backwards walks every bucket back down to it's start
+		const float invCellSize = 1.0f / _cellSize;
+		_agentCell.resize(_count);
+		_cellStart.assign(numBuckets + 1, 0);
+		for (size_t ix = 0; ix < _count; ix++) {
+			const int32_t cellX = (int32_t)std::floor(_posX[ix] * invCellSize);
+			const int32_t cellY = (int32_t)std::floor(_posY[ix] * invCellSize);
+			_agentCell[ix] = HashCell(cellX, cellY, _cellMask);
+			_cellStart[_agentCell[ix]]++;
+		}
+		for (uint32_t ix = 1; ix <= numBuckets; ix++) {
+			_cellStart[ix] += _cellStart[ix - 1];
+		}
+
+		_sortedX.resize(_count + 4);
+		_sortedY.resize(_count + 4);
+		for (size_t ix = _count; ix > 0; ix--) {
+			const size_t agent = ix - 1;
+			const uint32_t slot = --_cellStart[_agentCell[agent]];
+			_sortedX[slot] = _posX[agent];
+			_sortedY[slot] = _posY[agent];
+		}
+	}
+
+	void CrowdSystem::_SteerGroups(size_t begin, size_t end, float dt) {
+		SteeringParams params;
+		params.TargetX = _target.x;
+		params.TargetY = _target.y;
+		params.MaxForce = _settings.MaxForce;
+		params.SenseRadius2 = _settings.SenseRadius > 0.0f ? _settings.SenseRadius * _settings.SenseRadius : FLT_MAX;
+		params.StopDistance = _settings.StopDistance;
+		params.InvSlowingRadius = _settings.SlowingRadius > 0.0f ? 1.0f / _settings.SlowingRadius : FLT_MAX;
+		params.Dt = dt;
+
+		SteeringArrays arrays;
+		arrays.PosX = _posX.data();
+		arrays.PosY = _posY.data();
+		arrays.VelX = _velX.data();
+		arrays.VelY = _velY.data();
+		arrays.MaxSpeed = _maxSpeed.data();
+		arrays.Behaviour = _behaviour.data();
+
+		// The field is only swapped out on the main thread between updates, so it's safe to sample here
+		const FlowField* flowField = _flowField != nullptr && _flowField->IsReady() ? _flowField.get() : nullptr;
+
+		alignas(16) float pushX[4];
+		alignas(16) float pushY[4];
+		alignas(16) float flowX[4];
+		alignas(16) float flowY[4];
+		for (size_t group = begin; group < end; group++) {
+			const size_t first = group * 4;
+			for (size_t lane = 0; lane < 4; lane++) {
+				glm::vec2 push = glm::vec2(0.0f);
+				glm::vec2 flow = glm::vec2(0.0f);
+				if (first + lane < _count) {
+					push = _GetSeparation(first + lane) * _settings.SeparationWeight + _GetAvoidance(first + lane) * _settings.AvoidanceWeight;
+					// Leaves the flow at zero if the field has no direction here
+					if (flowField != nullptr) {
+						flowField->Sample(glm::vec2(_posX[first + lane], _posY[first + lane]), flow);
+					}
+				}
+				pushX[lane] = push.x;
+				pushY[lane] = push.y;
+				flowX[lane] = flow.x;
+				flowY[lane] = flow.y;
+			}
+
+			#ifdef CROWD_SYSTEM_SSE
+			if (_settings.UseSimd) {
+				SteerSse(first, params, arrays, pushX, pushY, flowX, flowY);
+				continue;
+			}
+			#endif
+			for (size_t lane = 0; lane < 4 && first + lane < _count; lane++) {
+				SteerScalar(first + lane, params, arrays, pushX[lane], pushY[lane], flowX[lane], flowY[lane]);
+			}
+		}
+	}
+
+	glm::vec2 CrowdSystem::_GetSeparation(size_t agent) const {
+		const float posX = _posX[agent];
+		const float posY = _posY[agent];
+		const float radius = _settings.SeparationRadius;
+		const float radius2 = radius * radius;
+		const float invRadius = 1.0f / _cellSize;
+
+		// The cells are as big as the separation radius, so every neighbour is in the 3x3 around us
+		const int32_t cellX = (int32_t)std::floor(posX / _cellSize);
+		const int32_t cellY = (int32_t)std::floor(posY / _cellSize);
+
+		glm::vec2 push = glm::vec2(0.0f);
+		#ifdef CROWD_SYSTEM_SSE
+		__m128 sumX = _mm_setzero_ps();
+		__m128 sumY = _mm_setzero_ps();
+		#endif
+
+		uint32_t visited[9];
+		int numVisited = 0;
+		for (int32_t offsetY = -1; offsetY <= 1; offsetY++) {
+			for (int32_t offsetX = -1; offsetX <= 1; offsetX++) {
+				// Two of our cells can land in the same bucket, don't count it's agents twice
+				const uint32_t bucket = HashCell(cellX + offsetX, cellY + offsetY, _cellMask);
+				if (std::find(visited, visited + numVisited, bucket) != visited + numVisited) {
+					continue;
+				}
+				visited[numVisited++] = bucket;
+
+				const uint32_t bucketEnd = _cellStart[bucket + 1];
+				uint32_t ix = _cellStart[bucket];
+				#ifdef CROWD_SYSTEM_SSE
+				if (_settings.UseSimd) {
+					// Bucket's agents are contiguous, so load 4 at a time and mask off the ones past the end
+					const __m128 x = _mm_set1_ps(posX);
+					const __m128 y = _mm_set1_ps(posY);
+					for (; ix < bucketEnd; ix += 4) {
+						const __m128i lanes = _mm_add_epi32(_mm_set1_epi32((int32_t)ix), _mm_setr_epi32(0, 1, 2, 3));
+						const __m128 inBucket = _mm_castsi128_ps(_mm_cmplt_epi32(lanes, _mm_set1_epi32((int32_t)bucketEnd)));
+
+						const __m128 dx = _mm_sub_ps(x, _mm_loadu_ps(&_sortedX[ix]));
+						const __m128 dy = _mm_sub_ps(y, _mm_loadu_ps(&_sortedY[ix]));
+						const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+						// Skips ourself, and anyone exactly on top of us since we can't tell which way to push
+						const __m128 inRange = _mm_and_ps(_mm_cmplt_ps(d2, _mm_set1_ps(radius2)), _mm_cmpgt_ps(d2, _mm_set1_ps(STEERING_EPSILON)));
+
+						// Push harder the closer they are, falling off to nothing at the radius
+						const __m128 dist = _mm_sqrt_ps(_mm_max_ps(d2, _mm_set1_ps(STEERING_EPSILON)));
+						__m128 weight = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(dist, _mm_set1_ps(invRadius))), dist);
+						weight = _mm_and_ps(weight, _mm_and_ps(inBucket, inRange));
+
+						sumX = _mm_add_ps(sumX, _mm_mul_ps(dx, weight));
+						sumY = _mm_add_ps(sumY, _mm_mul_ps(dy, weight));
+					}
+				}
+				#endif
+				for (; ix < bucketEnd; ix++) {
+					const float dx = posX - _sortedX[ix];
+					const float dy = posY - _sortedY[ix];
+					const float d2 = dx * dx + dy * dy;
+					if (d2 < radius2 && d2 > STEERING_EPSILON) {
+						const float dist = std::sqrt(d2);
+						const float weight = (1.0f - dist * invRadius) / dist;
+						push += glm::vec2(dx, dy) * weight;
+					}
+				}
+			}
+		}
+
+		#ifdef CROWD_SYSTEM_SSE
+		alignas(16) float lanesX[4];
+		alignas(16) float lanesY[4];
+		_mm_store_ps(lanesX, sumX);
+		_mm_store_ps(lanesY, sumY);
+		push += glm::vec2(lanesX[0] + lanesX[1] + lanesX[2] + lanesX[3], lanesY[0] + lanesY[1] + lanesY[2] + lanesY[3]);
+		#endif
+		return push;
+	}
+
+	glm::vec2 CrowdSystem::_GetAvoidance(size_t agent) const {
+		if (_obstacles.empty()) {
+			return glm::vec2(0.0f);
+		}
+
+		const float radius = _settings.AvoidanceRadius;
+		const glm::vec2 position = glm::vec2(_posX[agent], _posY[agent]);
+		const glm::vec2 velocity = glm::vec2(_velX[agent], _velY[agent]);
+
+		// Probe where we are and where we'll be shortly, so agents turn before they hit a wall
+		const glm::vec2 probes[2] = { position, position + velocity * _settings.LookAhead };
+
+		glm::vec2 push = glm::vec2(0.0f);
+		for (const Obstacle& obstacle : _obstacles) {
+			for (const glm::vec2& probe : probes) {
+				const glm::vec2 closest = glm::clamp(probe, obstacle.Min, obstacle.Max);
+				const glm::vec2 away = probe - closest;
+				const float d2 = glm::dot(away, away);
+				if (d2 > radius * radius) {
+					continue;
+				}
+
+				if (d2 > STEERING_EPSILON) {
+					const float dist = std::sqrt(d2);
+					push += away * ((1.0f - dist / radius) / dist);
+				} else {
+					// The probe is inside the box, push out through the nearest face
+					const glm::vec2 toMin = probe - obstacle.Min;
+					const glm::vec2 toMax = obstacle.Max - probe;
+					const float nearest = std::min({ toMin.x, toMin.y, toMax.x, toMax.y });
+					if (nearest == toMin.x)      push.x -= 1.0f;
+					else if (nearest == toMax.x) push.x += 1.0f;
+					else if (nearest == toMin.y) push.y -= 1.0f;
+					else                         push.y += 1.0f;
+				}
+			}
+		}
+		return push;
+	}
+
+	void CrowdSystem::_WriteBack() {
+		for (size_t agent = 0; agent < _count; agent++) {
+			GameObject* object = _rawObjects[agent];
+			if (object == nullptr) {
+				continue;
+			}
+
+			// Agents only steer in X and Y, leave the height to whoever owns it
+			const glm::vec3& current = object->GetPosition();
+			const glm::vec3 position = glm::vec3(_posX[agent], _posY[agent], current.z);
+			if (position == current) {
+				continue;
+			}
+			object->SetPostion(position);
+
+			// The enemy models face away from their forward axis, so like the old steering code
+			// we look at a point behind the agent to face where it's going
+			const glm::vec2 velocity = glm::vec2(_velX[agent], _velY[agent]);
+			if (glm::dot(velocity, velocity) > FACING_SPEED * FACING_SPEED) {
+				object->LookAt(position - glm::vec3(velocity, 0.0f));
+			}
+			_versions[agent] = object->GetTransformVersion();
+		}
+	}
+}
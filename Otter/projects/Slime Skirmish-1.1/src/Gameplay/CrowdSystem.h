@@ -0,0 +1,218 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/GameObject.h"
+#include "Gameplay/FlowField.h"
+
+class btCollisionWorld;
+
+namespace Gameplay {
+	/// <summary>
+	/// What an agent is trying to do relative to the crowd's target
+	/// </summary>
+	enum class SteeringBehaviour : int32_t {
+		// Stand still, agents will still push away from each other and obstacles
+		Idle   = 0,
+		// Move towards the target at full speed
+		Seek   = 1,
+		// Move away from the target at full speed
+		Flee   = 2,
+		// Move towards the target, slowing down and stopping as it gets close
+		Arrive = 3
+	};
+
+	/// <summary>
+	/// Tuning for a crowd, shared by all of it's agents
+	/// </summary>
+	struct CrowdSettings {
+		// The default top speed of new agents, in units per second
+		float MaxSpeed = 2.0f;
+		// The largest change in velocity an agent can make per second
+		float MaxForce = 8.0f;
+		// Agents only react to the target while it's within this distance, or always if 0
+		float SenseRadius = 10.0f;
+		// Arriving agents start to slow down this far from their stopping point
+		float SlowingRadius = 3.0f;
+		// Arriving agents stop this far from the target
+		float StopDistance = 1.0f;
+		// Agents closer than this push each other apart, this is also the spatial hash cell size
+		float SeparationRadius = 1.5f;
+		float SeparationWeight = 1.5f;
+		// How far ahead agents look for obstacles, in seconds of travel at their current velocity
+		float LookAhead = 0.5f;
+		// Agents push away from obstacles closer than this
+		float AvoidanceRadius = 1.0f;
+		float AvoidanceWeight = 2.0f;
+		// True to split the update across the thread pool
+		bool  MultiThreaded = true;
+		// True to use the SIMD kernels if the platform supports them
+		bool  UseSimd = true;
+	};
+
+	/// <summary>
+	/// Steers a crowd of agents (ex: the enemies in a room) towards or away from a shared target,
+	/// while keeping them apart from each other and out of static obstacles.
+	///
+	/// Agent state is kept as SoA arrays so the steering kernel can run 4 agents at a time with
+	/// SSE, in chunks across the thread pool. Neighbours are found with a uniform spatial hash that
+	/// is rebuilt every update with a counting sort, which leaves each cell's agents next to each
+	/// other in memory. Agents attached to a gameobject have their positions written back in a
+	/// single pass at the end of the update, on the calling thread.
+	///
+	/// If the crowd has a flow field, seeking and arriving agents follow it around walls instead
+	/// of heading straight for the target.
+	///
+	/// Agent indices are only stable until an agent is removed
+	/// </summary>
+	class CrowdSystem {
+	public:
+		typedef std::shared_ptr<CrowdSystem> Sptr;
+		typedef CrowdSettings Settings;
+
+		CrowdSystem();
+		~CrowdSystem();
+
+		CrowdSystem(const CrowdSystem& other) = delete;
+		CrowdSystem& operator=(const CrowdSystem& other) = delete;
+
+		/// <summary>
+		/// Gets the tuning for the crowd, changes take effect on the next update
+		/// </summary>
+		Settings& GetSettings();
+
+		/// <summary>
+		/// Adds an agent that drives a gameobject. The object's position is read back in if
+		/// something else moves it, and the agent is removed when the object is destroyed
+		/// </summary>
+		/// <param name="object">The object to steer</param>
+		/// <param name="behaviour">What the agent should do</param>
+		/// <returns>The index of the new agent</returns>
+		size_t AddAgent(const GameObject::Sptr& object, SteeringBehaviour behaviour = SteeringBehaviour::Arrive);
+		/// <summary>
+		/// Adds an agent that is not attached to anything, use GetPosition to read it's state
+		/// </summary>
+		/// <param name="position">The starting position, only X and Y are used</param>
+		/// <param name="behaviour">What the agent should do</param>
+		/// <returns>The index of the new agent</returns>
+		size_t AddAgent(const glm::vec3& position, SteeringBehaviour behaviour = SteeringBehaviour::Arrive);
+		/// <summary>
+		/// Removes the agent driving the given object, if there is one
+		/// </summary>
+		void RemoveAgent(const GameObject* object);
+		/// <summary>
+		/// Removes all agents
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Gets the index of the agent driving the given object, or -1 if none exists
+		/// </summary>
+		int FindAgent(const GameObject* object) const;
+		size_t GetAgentCount() const;
+
+		void SetBehaviour(size_t agent, SteeringBehaviour behaviour);
+		SteeringBehaviour GetBehaviour(size_t agent) const;
+		/// <summary>
+		/// Overrides the top speed of a single agent
+		/// </summary>
+		void SetMaxSpeed(size_t agent, float maxSpeed);
+		glm::vec2 GetPosition(size_t agent) const;
+		glm::vec2 GetVelocity(size_t agent) const;
+
+		/// <summary>
+		/// Sets the point that agents seek, flee or arrive at, only X and Y are used
+		/// </summary>
+		void SetTarget(const glm::vec3& target);
+		const glm::vec2& GetTarget() const;
+
+		/// <summary>
+		/// Sets the flow field that agents follow to reach the target, or nullptr to head straight
+		/// for it. The field should have the same goal as the crowd's target
+		/// </summary>
+		void SetFlowField(const FlowField::Sptr& field);
+		const FlowField::Sptr& GetFlowField() const;
+
+		/// <summary>
+		/// Adds a static box for agents to steer around, in world space
+		/// </summary>
+		/// <param name="min">The minimum X and Y of the box</param>
+		/// <param name="max">The maximum X and Y of the box</param>
+		void AddObstacle(const glm::vec2& min, const glm::vec2& max);
+		void ClearObstacles();
+		/// <summary>
+		/// Replaces the obstacles with the static and kinematic colliders in a physics world that
+		/// overlap a box, picked the same way as FlowField::SyncObstacles so that the crowd and the
+		/// field always agree on where the walls are
+		/// </summary>
+		/// <param name="world">The world to read colliders from</param>
+		/// <param name="min">The minimum X and Y of the area to take colliders from</param>
+		/// <param name="max">The maximum X and Y of the area to take colliders from</param>
+		/// <param name="minHeight">Colliders entirely below this height are ignored (ex: the floor)</param>
+		/// <param name="maxHeight">Colliders entirely above this height are ignored</param>
+		void SyncObstacles(btCollisionWorld* world, const glm::vec2& min, const glm::vec2& max, float minHeight, float maxHeight);
+
+		/// <summary>
+		/// Steps all agents forward, and writes their positions back to their gameobjects.
+		/// Should be called on the main thread, from a fixed tick
+		/// </summary>
+		/// <param name="dt">The time step in seconds</param>
+		void Update(float dt);
+
+		/// <summary>
+		/// Returns true if this build was compiled with the SIMD steering kernel
+		/// </summary>
+		static bool IsSimdSupported();
+
+	protected:
+		struct Obstacle {
+			glm::vec2 Min;
+			glm::vec2 Max;
+		};
+
+		Settings  _settings;
+		glm::vec2 _target;
+		std::vector<Obstacle> _obstacles;
+		FlowField::Sptr       _flowField;
+
+		// Agent state, as SoA. The arrays are padded to a multiple of 4 with agents that can't
+		// move, so the SIMD kernel never has to handle a partial group
+		size_t                 _count;
+		std::vector<float>     _posX, _posY;
+		std::vector<float>     _velX, _velY;
+		std::vector<float>     _maxSpeed;
+		std::vector<int32_t>   _behaviour;
+		// The objects agents drive, null for agents that aren't attached to anything
+		std::vector<std::weak_ptr<GameObject>> _objects;
+		std::vector<GameObject*>               _rawObjects;
+		// The transform version of each object when we last wrote to it, if it changes someone else moved it
+		std::vector<uint32_t>                  _versions;
+		std::unordered_map<const GameObject*, size_t> _lookup;
+
+		// The spatial hash, rebuilt each update. Cell N's agents are at [_cellStart[N], _cellStart[N + 1])
+		// in the sorted position arrays, which are padded so the SIMD loop can read past the end
+		float                 _cellSize;
+		uint32_t              _cellMask;
+		std::vector<uint32_t> _agentCell;
+		std::vector<uint32_t> _cellStart;
+		std::vector<float>    _sortedX, _sortedY;
+
+		size_t _AddAgent(const glm::vec2& position, SteeringBehaviour behaviour, const GameObject::Sptr& object);
+		void _RemoveAt(size_t index);
+		// Resizes the agent arrays to fit _count agents, zeroing any padding
+		void _ResizeArrays();
+
+		// Removes agents whose objects were destroyed, and reads back objects that were moved
+		void _SyncFromObjects();
+		void _BuildHash();
+		// Steers the agents in groups of 4, [begin, end) are group indices
+		void _SteerGroups(size_t begin, size_t end, float dt);
+		// Gets the push away from neighbours and obstacles for a single agent
+		glm::vec2 _GetSeparation(size_t agent) const;
+		glm::vec2 _GetAvoidance(size_t agent) const;
+		void _WriteBack();
+	};
+}
@@ -0,0 +1,317 @@
+#include "Gameplay/FlowField.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <btBulletCollisionCommon.h>
+
+#include "Logging.h"
+#include "Utils/ThreadPool.h"
+
+// The integration value of cells that can't reach the goal
+#define UNREACHABLE 0xFFFFFFFFu
+// The cost of a step to a side or diagonal neighbour, in tenths of a cell
+#define STRAIGHT_STEP 10u
+#define DIAGONAL_STEP 14u
+// The number of rows per thread pool chunk when working out flow directions
+#define PARALLEL_GRAIN_SIZE 16
+
+namespace Gameplay {
+	const uint8_t FlowField::BLOCKED = 255;
+
+	// The 8 neighbours of a cell, counter-clockwise from +X. Odd entries are diagonals
+	static const glm::ivec2 NEIGHBOURS[8] = {
+		{ 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+	};
+	static const glm::vec2 NEIGHBOUR_DIRECTIONS[8] = {
+		glm::normalize(glm::vec2(NEIGHBOURS[0])), glm::normalize(glm::vec2(NEIGHBOURS[1])),
+		glm::normalize(glm::vec2(NEIGHBOURS[2])), glm::normalize(glm::vec2(NEIGHBOURS[3])),
+		glm::normalize(glm::vec2(NEIGHBOURS[4])), glm::normalize(glm::vec2(NEIGHBOURS[5])),
+		glm::normalize(glm::vec2(NEIGHBOURS[6])), glm::normalize(glm::vec2(NEIGHBOURS[7]))
+	};
+
+	/// <summary>
+	/// Returns true if an agent can step from a cell to it's neighbour. Diagonal steps can't cut
+	/// the corner of a blocked cell, or agents would try to squeeze between touching obstacles
+	/// </summary>
+	static inline bool CanStep(const std::vector<uint8_t>& costs, int width, int height, int x, int y, int direction) {
+		const glm::ivec2& offset = NEIGHBOURS[direction];
+		const int nx = x + offset.x, ny = y + offset.y;
+		if (nx < 0 || ny < 0 || nx >= width || ny >= height || costs[ny * width + nx] == FlowField::BLOCKED) {
+			return false;
+		}
+		if (direction & 1) {
+			return costs[y * width + nx] != FlowField::BLOCKED && costs[ny * width + x] != FlowField::BLOCKED;
+		}
+		return true;
+	}
+
+	FlowField::FlowField(const glm::vec2& min, const glm::vec2& max, float cellSize) :
+		_min(glm::min(min, max)),
+		_cellSize(cellSize),
+		_width(0),
+		_height(0),
+		_costs(),
+		_costVersion(1),
+		_obstacleBounds(),
+		_goal(0),
+		_requestedGoal(-1),
+		_requestedVersion(0),
+		_field(nullptr),
+		_pending()
+	{
+		LOG_ASSERT(cellSize > 0.0f, "Cell size must be greater than zero!");
+		const glm::vec2 size = glm::abs(max - min);
+		_width = std::max((int)std::ceil(size.x / cellSize), 1);
+		_height = std::max((int)std::ceil(size.y / cellSize), 1);
+		_costs.assign((size_t)_width * _height, 1);
+	}
+
+	FlowField::~FlowField() = default;
+
+	const glm::vec2& FlowField::GetMin() const {
+		return _min;
+	}
+
+	int FlowField::GetWidth() const {
+		return _width;
+	}
+
+	int FlowField::GetHeight() const {
+		return _height;
+	}
+
+	float FlowField::GetCellSize() const {
+		return _cellSize;
+	}
+
+	glm::ivec2 FlowField::GetCell(const glm::vec2& position) const {
+		return glm::ivec2(glm::floor((position - _min) / _cellSize));
+	}
+
+	bool FlowField::IsInside(const glm::ivec2& cell) const {
+		return cell.x >= 0 && cell.y >= 0 && cell.x < _width && cell.y < _height;
+	}
+
+	void FlowField::SetCost(const glm::ivec2& cell, uint8_t cost) {
+		LOG_ASSERT(IsInside(cell), "Cell is outside of the grid!");
+		uint8_t& current = _costs[cell.y * _width + cell.x];
+		cost = std::max(cost, (uint8_t)1);
+		if (current != cost) {
+			current = cost;
+			_costVersion++;
+		}
+	}
+
+	uint8_t FlowField::GetCost(const glm::ivec2& cell) const {
+		LOG_ASSERT(IsInside(cell), "Cell is outside of the grid!");
+		return _costs[cell.y * _width + cell.x];
+	}
+
+	void FlowField::FillCost(const glm::vec2& min, const glm::vec2& max, uint8_t cost) {
+		const glm::ivec2 first = glm::max(GetCell(glm::min(min, max)), glm::ivec2(0));
+		const glm::ivec2 last = glm::min(GetCell(glm::max(min, max)), glm::ivec2(_width - 1, _height - 1));
+		cost = std::max(cost, (uint8_t)1);
+		for (int y = first.y; y <= last.y; y++) {
+			for (int x = first.x; x <= last.x; x++) {
+				_costs[y * _width + x] = cost;
+			}
+		}
+		_costVersion++;
+	}
+
+	void FlowField::ResetCosts() {
+		std::fill(_costs.begin(), _costs.end(), (uint8_t)1);
+		_obstacleBounds.clear();
+		_costVersion++;
+	}
+
+	bool FlowField::SyncObstacles(btCollisionWorld* world) {
+		const glm::vec2 gridMax = _min + glm::vec2(_width, _height) * _cellSize;
+
+		// Gather the bounds of everything solid that doesn't move on it's own. Bounds are snapped
+		// to the grid, so objects moving around inside a cell don't cause a rebuild
+		std::vector<glm::ivec4> bounds;
+		const btCollisionObjectArray& objects = world->getCollisionObjectArray();
+		for (int ix = 0; ix < objects.size(); ix++) {
+			const btCollisionObject* object = objects[ix];
+			if (!object->isStaticOrKinematicObject() || (object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE)) {
+				continue;
+			}
+
+			btVector3 aabbMin, aabbMax;
+			object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+			if (aabbMax.z() < MinHeight || aabbMin.z() > MaxHeight ||
+				aabbMax.x() < _min.x || aabbMax.y() < _min.y || aabbMin.x() > gridMax.x || aabbMin.y() > gridMax.y) {
+				continue;
+			}
+
+			const glm::ivec2 first = GetCell(glm::vec2(aabbMin.x(), aabbMin.y()) - AgentRadius);
+			const glm::ivec2 last = GetCell(glm::vec2(aabbMax.x(), aabbMax.y()) + AgentRadius);
+			bounds.push_back(glm::ivec4(first, last));
+		}
+
+		if (bounds == _obstacleBounds) {
+			return false;
+		}
+
+		std::fill(_costs.begin(), _costs.end(), (uint8_t)1);
+		for (const glm::ivec4& cells : bounds) {
+			const glm::ivec2 first = glm::max(glm::ivec2(cells.x, cells.y), glm::ivec2(0));
+			const glm::ivec2 last = glm::min(glm::ivec2(cells.z, cells.w), glm::ivec2(_width - 1, _height - 1));
+			for (int y = first.y; y <= last.y; y++) {
+				std::fill(_costs.begin() + (y * _width + first.x), _costs.begin() + (y * _width + last.x + 1), BLOCKED);
+			}
+		}
+		_obstacleBounds = std::move(bounds);
+		_costVersion++;
+		return true;
+	}
+
+	void FlowField::SetGoal(const glm::vec3& position) {
+		_goal = GetCell(glm::vec2(position));
+	}
+
+	void FlowField::Update() {
+		if (_pending.valid() && _pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			_field = _pending.get();
+		}
+
+		if (_goal == _requestedGoal && _costVersion == _requestedVersion) {
+			return;
+		}
+
+		// Agents need something to follow, so the very first field is built right away. After that,
+		// if a rebuild is already running we let it finish and start the next one on a later update
+		if (_field == nullptr || !Async) {
+			_Request(false, true);
+		} else if (!_pending.valid()) {
+			_Request(true, false);
+		}
+	}
+
+	void FlowField::Build(bool parallel) {
+		_Request(false, parallel);
+	}
+
+	bool FlowField::IsReady() const {
+		return _field != nullptr;
+	}
+
+	bool FlowField::Sample(const glm::vec2& position, glm::vec2& outDirection) const {
+		if (_field == nullptr) {
+			return false;
+		}
+		const glm::ivec2 cell = GetCell(position);
+		if (!IsInside(cell)) {
+			return false;
+		}
+		const int8_t direction = _field->Directions[cell.y * _width + cell.x];
+		if (direction < 0) {
+			return false;
+		}
+		outDirection = NEIGHBOUR_DIRECTIONS[direction];
+		return true;
+	}
+
+	float FlowField::GetPathDistance(const glm::vec2& position) const {
+		const glm::ivec2 cell = GetCell(position);
+		if (_field == nullptr || !IsInside(cell)) {
+			return -1.0f;
+		}
+		const uint32_t integration = _field->Integration[cell.y * _width + cell.x];
+		return integration == UNREACHABLE ? -1.0f : (integration / (float)STRAIGHT_STEP) * _cellSize;
+	}
+
+	void FlowField::_Request(bool async, bool parallel) {
+		_requestedGoal = _goal;
+		_requestedVersion = _costVersion;
+
+		if (async) {
+			// The worker gets it's own copy of the costs, so we're free to keep changing them
+			_pending = ThreadPool::Submit([costs = _costs, width = _width, height = _height, goal = _goal, version = _costVersion]() {
+				return _BuildField(costs, width, height, goal, version, false);
+			});
+		} else {
+			// Anything still running is older than what we're about to build
+			_pending = std::future<std::shared_ptr<Field>>();
+			_field = _BuildField(_costs, _width, _height, _goal, _costVersion, parallel);
+		}
+	}
+
+	std::shared_ptr<FlowField::Field> FlowField::_BuildField(const std::vector<uint8_t>& costs, int width, int height, const glm::ivec2& goal, uint32_t costVersion, bool parallel) {
+		std::shared_ptr<Field> field = std::make_shared<Field>();
+		field->Goal = goal;
+		field->CostVersion = costVersion;
+		field->Integration.assign(costs.size(), UNREACHABLE);
+		field->Directions.assign(costs.size(), -1);
+		if (goal.x < 0 || goal.y < 0 || goal.x >= width || goal.y >= height) {
+			return field;
+		}
+
+		// Dijkstra with a bucket queue (Dial's algorithm). Step costs are small integers, so a ring
+		// of buckets one larger than the biggest step can hold every distance still in the queue
+		std::vector<uint32_t>& integration = field->Integration;
+		std::vector<std::vector<uint32_t>> buckets(DIAGONAL_STEP * (BLOCKED - 1) + 1);
+		const uint32_t goalIndex = goal.y * width + goal.x;
+		integration[goalIndex] = 0;
+		buckets[0].push_back(goalIndex);
+		size_t queued = 1;
+
+		for (uint32_t distance = 0; queued > 0; distance++) {
+			// Every step costs at least STRAIGHT_STEP, so nothing we relax lands back in this bucket
+			std::vector<uint32_t>& bucket = buckets[distance % buckets.size()];
+			queued -= bucket.size();
+			for (const uint32_t cell : bucket) {
+				if (integration[cell] != distance) {
+					// We found a shorter path to this cell after it was queued
+					continue;
+				}
+
+				const int x = cell % width, y = cell / width;
+				for (int direction = 0; direction < 8; direction++) {
+					if (!CanStep(costs, width, height, x, y, direction)) {
+						continue;
+					}
+					const uint32_t neighbour = (y + NEIGHBOURS[direction].y) * width + (x + NEIGHBOURS[direction].x);
+					const uint32_t step = costs[neighbour] * ((direction & 1) ? DIAGONAL_STEP : STRAIGHT_STEP);
+					if (distance + step < integration[neighbour]) {
+						integration[neighbour] = distance + step;
+						buckets[(distance + step) % buckets.size()].push_back(neighbour);
+						queued++;
+					}
+				}
+			}
+			bucket.clear();
+		}
+
+		// Point every cell at it's cheapest neighbour. Blocked cells have no cost of their own, so
+		// agents that end up inside one are led back out to the nearest open cell
+		auto directions = [&](size_t begin, size_t end) {
+			for (int y = (int)begin; y < (int)end; y++) {
+				for (int x = 0; x < width; x++) {
+					const uint32_t cell = y * width + x;
+					uint32_t best = integration[cell];
+					int8_t bestDirection = -1;
+					for (int direction = 0; direction < 8; direction++) {
+						if (!CanStep(costs, width, height, x, y, direction)) {
+							continue;
+						}
+						const uint32_t value = integration[(y + NEIGHBOURS[direction].y) * width + (x + NEIGHBOURS[direction].x)];
+						if (value < best) {
+							best = value;
+							bestDirection = (int8_t)direction;
+						}
+					}
+					field->Directions[cell] = bestDirection;
+				}
+			}
+		};
+		if (parallel) {
+			ThreadPool::ParallelFor(height, PARALLEL_GRAIN_SIZE, directions);
+		} else {
+			directions(0, height);
+		}
+
+		return field;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <future>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+class btCollisionWorld;
+
+namespace Gameplay {
+	/// <summary>
+	/// A navigation grid over an area of the level (ex: a room), that finds the way to a single
+	/// goal for every cell at once. All agents heading to the same goal can then look up their
+	/// direction in O(1), instead of each one searching for it's own path.
+	///
+	/// Static and kinematic colliders are rasterized into a grid of costs. From that, an
+	/// integration field (the path cost from every cell to the goal) is built with Dijkstra's
+	/// algorithm over 8 neighbours, and a flow field pointing each cell at it's cheapest
+	/// neighbour. The fields are only rebuilt when the goal moves to another cell or the
+	/// obstacles change. Rebuilds run on the thread pool, with the last finished field used
+	/// until the new one is ready
+	/// </summary>
+	class FlowField {
+	public:
+		typedef std::shared_ptr<FlowField> Sptr;
+
+		/// <summary>
+		/// The cost of a cell that can't be walked through
+		/// </summary>
+		static const uint8_t BLOCKED;
+
+		/// <summary>
+		/// Obstacles are grown by this much, so paths keep agents this far from walls
+		/// </summary>
+		float AgentRadius = 0.5f;
+		/// <summary>
+		/// Colliders only block a cell if they overlap this range of heights
+		/// </summary>
+		float MinHeight = 0.25f;
+		float MaxHeight = 2.5f;
+		/// <summary>
+		/// True to rebuild the fields on the thread pool, false to rebuild them in Update
+		/// </summary>
+		bool  Async = true;
+
+		/// <summary>
+		/// Creates a flow field covering an area of the XY plane, with every cell walkable
+		/// </summary>
+		/// <param name="min">The minimum X and Y of the area</param>
+		/// <param name="max">The maximum X and Y of the area</param>
+		/// <param name="cellSize">The size of a single cell</param>
+		FlowField(const glm::vec2& min, const glm::vec2& max, float cellSize);
+		~FlowField();
+
+		FlowField(const FlowField& other) = delete;
+		FlowField& operator=(const FlowField& other) = delete;
+
+		int GetWidth() const;
+		int GetHeight() const;
+		float GetCellSize() const;
+		/// <summary>
+		/// Gets the world space corner of the grid's first cell
+		/// </summary>
+		const glm::vec2& GetMin() const;
+
+		/// <summary>
+		/// Gets the cell containing a world position, which may be outside of the grid
+		/// </summary>
+		glm::ivec2 GetCell(const glm::vec2& position) const;
+		bool IsInside(const glm::ivec2& cell) const;
+
+		/// <summary>
+		/// Sets the cost of moving into a cell, from 1 to 254, or BLOCKED
+		/// </summary>
+		void SetCost(const glm::ivec2& cell, uint8_t cost);
+		uint8_t GetCost(const glm::ivec2& cell) const;
+		/// <summary>
+		/// Sets the cost of every cell that overlaps a box in world space
+		/// </summary>
+		void FillCost(const glm::vec2& min, const glm::vec2& max, uint8_t cost);
+		/// <summary>
+		/// Makes every cell walkable, with a cost of 1
+		/// </summary>
+		void ResetCosts();
+
+		/// <summary>
+		/// Rasterizes the static and kinematic colliders in a physics world that overlap the grid,
+		/// replacing all costs. Does nothing if none of the colliders have changed since the last call
+		/// </summary>
+		/// <param name="world">The world to read colliders from</param>
+		/// <returns>True if the obstacles changed and the costs were updated</returns>
+		bool SyncObstacles(btCollisionWorld* world);
+
+		/// <summary>
+		/// Sets the position agents are trying to reach, only X and Y are used
+		/// </summary>
+		void SetGoal(const glm::vec3& position);
+
+		/// <summary>
+		/// Picks up finished rebuilds, and starts a new one if the goal or costs have changed.
+		/// Should be called on the main thread, before agents sample the field. The first
+		/// rebuild always runs right away, so there is a field to sample
+		/// </summary>
+		void Update();
+		/// <summary>
+		/// Rebuilds the fields on the calling thread, replacing any rebuild in progress
+		/// </summary>
+		/// <param name="parallel">True to split the flow directions across the thread pool</param>
+		void Build(bool parallel = true);
+
+		/// <summary>
+		/// Returns true if there is a field to sample
+		/// </summary>
+		bool IsReady() const;
+		/// <summary>
+		/// Gets the direction to move in to reach the goal from a world position
+		/// </summary>
+		/// <param name="position">The position of the agent</param>
+		/// <param name="outDirection">Receives the unit direction, if there is one</param>
+		/// <returns>False if the position is outside of the grid, in the goal cell, or can't reach the goal</returns>
+		bool Sample(const glm::vec2& position, glm::vec2& outDirection) const;
+		/// <summary>
+		/// Gets the length of the path from a world position to the goal, or a negative value if it can't be reached
+		/// </summary>
+		float GetPathDistance(const glm::vec2& position) const;
+
+	protected:
+		// The result of a rebuild, never modified once it's been handed over
+		struct Field {
+			glm::ivec2 Goal;
+			uint32_t   CostVersion;
+			// The path cost to the goal for each cell, in tenths of a cell
+			std::vector<uint32_t> Integration;
+			// The neighbour to move to from each cell, see NEIGHBOURS in the source, or -1 for none
+			std::vector<int8_t>   Directions;
+		};
+
+		glm::vec2  _min;
+		float      _cellSize;
+		int        _width, _height;
+
+		std::vector<uint8_t> _costs;
+		uint32_t             _costVersion;
+		// The cells covered by each collider that was rasterized, to tell when they change
+		std::vector<glm::ivec4> _obstacleBounds;
+
+		glm::ivec2 _goal;
+		// The goal and costs of the newest rebuild that was started
+		glm::ivec2 _requestedGoal;
+		uint32_t   _requestedVersion;
+
+		std::shared_ptr<const Field>       _field;
+		std::future<std::shared_ptr<Field>> _pending;
+
+		// Builds the fields for a grid, safe to call from any thread
+		static std::shared_ptr<Field> _BuildField(const std::vector<uint8_t>& costs, int width, int height, const glm::ivec2& goal, uint32_t costVersion, bool parallel);
+		void _Request(bool async, bool parallel);
+	};
+}
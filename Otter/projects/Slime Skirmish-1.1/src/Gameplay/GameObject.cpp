@@ -12,6 +12,7 @@
 #include "Utils/ImGuiHelper.h"
 
 #include "Gameplay/Scene.h"
+#include "Gameplay/Physics/PhysicsBase.h"
 
 namespace Gameplay {
 	GameObject::GameObject() :
@@ -29,6 +30,9 @@ namespace Gameplay {
 		_worldTransform(MAT4_IDENTITY),
 		_inverseWorldTransform(MAT4_IDENTITY),
 		_isWorldTransformDirty(true),
+		_renderTransform(MAT4_IDENTITY),
+		_hasRenderTransform(false),
+		_transformVersion(0),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
 	{ }
@@ -120,6 +124,8 @@ namespace Gameplay {
 	void GameObject::SetPostion(const glm::vec3& position) {
 		_position = position;
 		_isLocalTransformDirty = true;
+		_hasRenderTransform = false;
+		_transformVersion++;
 	}
 
 	const glm::vec3& GameObject::GetPosition() const {
@@ -129,6 +135,8 @@ namespace Gameplay {
 	void GameObject::SetRotation(const glm::quat& value) {
 		_rotation = value;
 		_isLocalTransformDirty = true;
+		_hasRenderTransform = false;
+		_transformVersion++;
 	}
 
 	const glm::quat& GameObject::GetRotation() const {
@@ -138,6 +146,8 @@ namespace Gameplay {
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
 		_rotation = glm::quat(glm::radians(eulerAngles));
 		_isLocalTransformDirty = true;
+		_hasRenderTransform = false;
+		_transformVersion++;
 	}
 
 	glm::vec3 GameObject::GetRotationEuler() const {
@@ -147,6 +157,8 @@ namespace Gameplay {
 	void GameObject::SetScale(const glm::vec3& value) {
 		_scale = value;
 		_isLocalTransformDirty = true;
+		_hasRenderTransform = false;
+		_transformVersion++;
 	}
 
 	const glm::vec3& GameObject::GetScale() const {
@@ -174,6 +186,23 @@ namespace Gameplay {
 		return _inverseLocalTransform;
 	}
 
+	void GameObject::SetRenderTransform(const glm::mat4& value) {
+		_renderTransform = value;
+		_hasRenderTransform = true;
+	}
+
+	const glm::mat4& GameObject::GetRenderTransform() const {
+		return _hasRenderTransform ? _renderTransform : GetTransform();
+	}
+
+	void GameObject::ClearRenderTransform() {
+		_hasRenderTransform = false;
+	}
+
+	uint32_t GameObject::GetTransformVersion() const {
+		return _transformVersion;
+	}
+
 	void GameObject::RenderGUI() {
 		for (auto& component : _components) {
 			if (component->IsEnabled) {
@@ -217,6 +246,16 @@ namespace Gameplay {
 		_PurgeDeletedChildren();
 	}
 
+	void GameObject::SetComponentsEnabled(bool enabled) {
+		for (auto& component : _components) {
+			component->IsEnabled = enabled;
+			// Disabled physics objects would otherwise keep colliding and setting off triggers
+			if (Physics::PhysicsBase* physics = dynamic_cast<Physics::PhysicsBase*>(component.get())) {
+				physics->SetSimulated(enabled);
+			}
+		}
+	}
+
 	bool GameObject::Has(const std::type_index& type) {
 		// Iterate over all the pointers in the components list
 		for (const auto& ptr : _components) {
@@ -443,6 +482,74 @@ namespace Gameplay {
 		return _selfRef.lock();
 	}
 
+	GameObject::Sptr GameObject::Clone() const
+	{
+		struct CloneEntry {
+			const GameObject* Source;
+			// The index of the parent's entry, or -1 for the root
+			int               Parent;
+			GameObject::Sptr  Copy;
+		};
+
+		// Walk the hierarchy breadth first, so a parent's copy always exists by the time we get
+		// to it's children. Each entry remembers where it's parent's copy is, which is all the
+		// GUID remapping the links between the copies need
+		std::vector<CloneEntry> copies;
+		copies.reserve(_children.size() + 1);
+		copies.push_back({ this, -1, nullptr });
+		for (size_t ix = 0; ix < copies.size(); ix++) {
+			const GameObject* source = copies[ix].Source;
+			GameObject::Sptr copy = _scene->CreateGameObject(source->Name);
+			copy->_position = source->_position;
+			copy->_rotation = source->_rotation;
+			copy->_scale    = source->_scale;
+			copy->_hp       = source->_hp;
+			copies[ix].Copy = copy;
+
+			if (copies[ix].Parent >= 0) {
+				const GameObject::Sptr& parent = copies[copies[ix].Parent].Copy;
+				copy->_parent = parent;
+				parent->_children.push_back(copy);
+			}
+
+			for (auto& child : source->_children) {
+				GameObject::Sptr childPtr = child.Resolve();
+				if (childPtr != nullptr) {
+					copies.push_back({ childPtr.get(), (int)ix, nullptr });
+				}
+			}
+		}
+
+		// The root keeps our place in the outer hierarchy
+		GameObject::Sptr parent = _parent.Resolve();
+		if (parent != nullptr) {
+			parent->AddChild(copies[0].Copy);
+		}
+
+		// Attach all the components before any of them wake up, since some look at their
+		// siblings on awake (ex: mesh colliders need the render component)
+		for (auto& [source, parentIndex, copy] : copies) {
+			copy->_components.reserve(source->_components.size());
+			for (auto& component : source->_components) {
+				IComponent::Sptr result = ComponentManager::Clone(component);
+				if (result == nullptr) {
+					LOG_WARN("Failed to clone component {} on {}", component->ComponentTypeName(), source->Name);
+					continue;
+				}
+				result->_context = copy.get();
+				copy->_components.push_back(result);
+				result->OnLoad();
+			}
+		}
+		if (_scene->GetIsAwake()) {
+			for (auto& entry : copies) {
+				entry.Copy->Awake();
+			}
+		}
+
+		return copies[0].Copy;
+	}
+
 	GameObject::Sptr GameObject::FromJson(const nlohmann::json& data)
 	{
 		// We need to manually construct since the GameObject constructor is
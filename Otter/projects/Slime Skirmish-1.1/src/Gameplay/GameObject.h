@@ -219,6 +219,27 @@ namespace Gameplay {
 		const glm::mat4& GetLocalTransform() const;
 		const glm::mat4& GetInverseLocalTransform() const;
 
+		/// <summary>
+		/// Overrides the world transform that this object is drawn with, physics uses this to
+		/// blend between simulation steps. The override is cleared when the object is moved
+		/// </summary>
+		/// <param name="value">The world transform to draw the object with</param>
+		void SetRenderTransform(const glm::mat4& value);
+		/// <summary>
+		/// Gets the world transform that this object should be drawn with
+		/// </summary>
+		const glm::mat4& GetRenderTransform() const;
+		/// <summary>
+		/// Goes back to drawing the object with it's regular transform
+		/// </summary>
+		void ClearRenderTransform();
+
+		/// <summary>
+		/// Gets a counter that goes up every time the object's position, rotation or scale is set,
+		/// so that other systems can cheaply check if the object has moved since they last looked
+		/// </summary>
+		uint32_t GetTransformVersion() const;
+
 		/// <summary>
 		/// Allows components to render GUI elements to the screen
 		/// </summary>
@@ -240,6 +261,14 @@ namespace Gameplay {
 		/// <param name="deltaTime">The time since the last frame, in seconds</param>
 		void Update(float dt);
 
+		/// <summary>
+		/// Enables or disables every component on this object at once, disabled objects
+		/// are not updated, rendered or simulated, but stay in the scene. Physics components
+		/// are also taken out of the physics world, see PhysicsBase::SetSimulated
+		/// </summary>
+		/// <param name="enabled">True to enable all components, false to disable them</param>
+		void SetComponentsEnabled(bool enabled);
+
 		/// <summary>
 		/// Checks whether this gameobject has a component of the given type
 		/// </summary>
@@ -318,6 +347,15 @@ namespace Gameplay {
 
 		std::shared_ptr<GameObject> SelfRef();
 
+		/// <summary>
+		/// Makes a copy of this object and all of it's children in the same scene, without
+		/// going through JSON. Every copy gets a new GUID, and links between objects in the
+		/// hierarchy point at the copies instead of the originals. Components are copied with
+		/// ComponentManager::Clone. The copy has the same parent as this object
+		/// </summary>
+		/// <returns>The copy of this object</returns>
+		GameObject::Sptr Clone() const;
+
 		/// <summary>
 		/// Loads a render object from a JSON blob
 		/// </summary>
@@ -349,6 +387,13 @@ namespace Gameplay {
 		mutable glm::mat4 _inverseWorldTransform;
 		mutable bool _isWorldTransformDirty;
 
+		// Interpolated transform for rendering, if one has been set since the object last moved
+		glm::mat4 _renderTransform;
+		bool _hasRenderTransform;
+
+		// Bumped whenever the position, rotation or scale is set
+		uint32_t _transformVersion;
+
 		// For the hierarchy
 		WeakRef _parent;
 		std::vector<WeakRef> _children;
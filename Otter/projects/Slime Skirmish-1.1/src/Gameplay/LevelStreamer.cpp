@@ -0,0 +1,329 @@
+#include "Gameplay/LevelStreamer.h"
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "Gameplay/Scene.h"
+#include "Gameplay/MeshResource.h"
+#include "Utils/ThreadPool.h"
+#include "Logging.h"
+
+namespace Gameplay {
+	const int LevelStreamer::TRACE_FRAMES = 60;
+
+	#pragma region SectionPrefab
+
+	int SectionPrefab::FindElement(const std::string& name) const {
+		auto it = std::find_if(Elements.begin(), Elements.end(), [&](const Element& element) {
+			return element.Name == name;
+		});
+		return it == Elements.end() ? -1 : static_cast<int>(it - Elements.begin());
+	}
+
+	int LevelSection::GetAliveCount() const {
+		return static_cast<int>(std::count_if(Spawned.begin(), Spawned.end(), [](const GameObject::WeakRef& ref) {
+			return ref.IsAlive();
+		}));
+	}
+
+	#pragma endregion
+
+	LevelStreamer::LevelStreamer(Scene* scene, const SectionPrefab& prefab, const glm::vec3& origin, int numSlots) :
+		_scene(scene),
+		_prefab(prefab),
+		_origin(origin),
+		_sections(),
+		_current(0),
+		_pendingPlan(),
+		_pendingSpawns(),
+		_recentFrames(TRACE_FRAMES, 0.0f),
+		_recentHead(0),
+		_traces(),
+		_framesSinceTransition(-1)
+	{
+		_sections.resize(std::max(numSlots, 2));
+	}
+
+	LevelStreamer::~LevelStreamer() {
+		// The plan is built from our prefab, so we can't let it outlive us
+		if (_pendingPlan.valid()) {
+			_pendingPlan.wait();
+		}
+	}
+
+	void LevelStreamer::Init() {
+		for (int slot = 0; slot < (int)_sections.size(); slot++) {
+			LevelSection::Sptr section = std::make_shared<LevelSection>();
+			section->Slot = slot;
+			section->Number = slot + 1;
+			section->Objects.reserve(_prefab.Elements.size());
+
+			// Names are suffixed with the slot so that they're still unique in the scene
+			for (const auto& element : _prefab.Elements) {
+				const std::string name = element.Name + std::to_string(slot + 1);
+				GameObject::Sptr object = _scene->FindObjectByName(name);
+				if (object == nullptr) {
+					object = _scene->CreateGameObject(name);
+					object->SetPostion(_origin + _prefab.Stride * (float)slot + element.Position);
+					object->SetRotation(element.Rotation);
+					object->SetScale(element.Scale);
+					if (element.Setup) {
+						element.Setup(object);
+					}
+				}
+				section->Objects.push_back(object);
+			}
+			_sections[slot] = section;
+		}
+
+		// The player starts in the first section, so it has to be loaded right away. The
+		// sections ahead of it will stream in over the next few frames
+		_current = 0;
+		const LevelSection::Sptr& first = _sections[0];
+		_ApplyPlan(first, _PlanSection(first->Number));
+		_CreateSpawns(first, (int)_pendingSpawns.size());
+		for (auto& spawned : first->Spawned) {
+			if (spawned.IsAlive()) {
+				spawned->SetComponentsEnabled(true);
+			}
+		}
+		first->SectionState = LevelSection::State::Active;
+	}
+
+	void LevelStreamer::Update(float dt) {
+		_RecordFrame(dt * 1000.0f);
+
+		LevelSection::Sptr section = _GetStreamingSection();
+		if (section != nullptr) {
+			_StreamStep(section, SpawnBudget, false);
+		}
+	}
+
+	void LevelStreamer::Advance() {
+		const LevelSection::Sptr& next = GetNext();
+
+		// The player beat the streamer here, finish loading the section even if it costs us a frame
+		bool blocked = next->SectionState != LevelSection::State::Ready;
+		if (blocked) {
+			LOG_WARN("Entered section {} before it finished streaming in, loading it now", next->Number);
+			while (next->SectionState != LevelSection::State::Ready) {
+				_StreamStep(next, std::numeric_limits<int>::max(), true);
+			}
+		}
+
+		for (auto& spawned : next->Spawned) {
+			if (spawned.IsAlive()) {
+				spawned->SetComponentsEnabled(true);
+			}
+		}
+		next->SectionState = LevelSection::State::Active;
+		_BeginTrace(next->Number, blocked);
+
+		// The section behind the player gets recycled as the furthest one ahead, anything
+		// still spawned in it can go now that the player can't get back there
+		const LevelSection::Sptr& retired = _sections[_current];
+		for (auto& spawned : retired->Spawned) {
+			if (spawned.IsAlive()) {
+				_DestroySpawn(spawned.Resolve());
+			}
+		}
+		retired->Spawned.clear();
+		MeshResource::PruneGeneratedMeshes();
+		retired->Number += (int)_sections.size();
+		retired->SectionState = LevelSection::State::Planning;
+
+		_current = next->Slot;
+	}
+
+	const LevelSection::Sptr& LevelStreamer::GetCurrent() const {
+		return _sections[_current];
+	}
+
+	const LevelSection::Sptr& LevelStreamer::GetNext() const {
+		return _sections[(_current + 1) % _sections.size()];
+	}
+
+	bool LevelStreamer::IsNextReady() const {
+		return GetNext()->SectionState == LevelSection::State::Ready;
+	}
+
+	const GameObject::Sptr& LevelStreamer::GetElement(const LevelSection::Sptr& section, int elementIndex) const {
+		return section->Objects[elementIndex];
+	}
+
+	void LevelStreamer::SaveTrace(const std::string& path) const {
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			LOG_WARN("Failed to open \"{}\" to write the streaming trace", path);
+			return;
+		}
+		file << "section,frame,ms,blocked\n";
+		for (const auto& trace : _traces) {
+			for (int ix = 0; ix < (int)trace.FrameMs.size(); ix++) {
+				file << trace.SectionNumber << "," << (ix - trace.TransitionFrame) << "," << trace.FrameMs[ix] << "," << (trace.Blocked ? 1 : 0) << "\n";
+			}
+		}
+	}
+
+	#pragma region Streaming
+
+	LevelSection::Sptr LevelStreamer::_GetStreamingSection() const {
+		for (size_t ix = 1; ix < _sections.size(); ix++) {
+			const LevelSection::Sptr& section = _sections[(_current + ix) % _sections.size()];
+			if (section->SectionState != LevelSection::State::Ready) {
+				return section;
+			}
+		}
+		return nullptr;
+	}
+
+	void LevelStreamer::_StreamStep(const LevelSection::Sptr& section, int spawnBudget, bool block) {
+		switch (section->SectionState) {
+			case LevelSection::State::Planning:
+				if (!_pendingPlan.valid()) {
+					const int number = section->Number;
+					_pendingPlan = ThreadPool::Submit([this, number]() {
+						return _PlanSection(number);
+					});
+				}
+				if (block || _pendingPlan.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+					_ApplyPlan(section, _pendingPlan.get());
+				}
+				break;
+			case LevelSection::State::Loading:
+				_CreateSpawns(section, spawnBudget);
+				break;
+			default:
+				break;
+		}
+	}
+
+	LevelStreamer::SectionPlan LevelStreamer::_PlanSection(int number) const {
+		SectionPlan result;
+		result.Number = number;
+		result.Origin = _origin + _prefab.Stride * (float)(number - 1);
+
+		result.ElementPositions.reserve(_prefab.Elements.size());
+		for (const auto& element : _prefab.Elements) {
+			result.ElementPositions.push_back(result.Origin + element.Position);
+		}
+
+		if (_prefab.PlanSpawns) {
+			_prefab.PlanSpawns(number, result.SpawnPositions);
+			for (auto& position : result.SpawnPositions) {
+				position += result.Origin;
+			}
+		}
+		return result;
+	}
+
+	void LevelStreamer::_ApplyPlan(const LevelSection::Sptr& section, const SectionPlan& plan) {
+		section->Number = plan.Number;
+		section->Origin = plan.Origin;
+		for (size_t ix = 0; ix < section->Objects.size(); ix++) {
+			section->Objects[ix]->SetPostion(plan.ElementPositions[ix]);
+		}
+
+		section->Spawned.clear();
+		section->Spawned.reserve(plan.SpawnPositions.size());
+		_pendingSpawns = plan.SpawnPositions;
+		section->SectionState = LevelSection::State::Loading;
+	}
+
+	bool LevelStreamer::RemoveSpawn(const GameObject::Sptr& object) {
+		std::vector<GameObject::WeakRef>& spawned = _sections[_current]->Spawned;
+		auto it = std::find_if(spawned.begin(), spawned.end(), [&](const GameObject::WeakRef& ref) {
+			return ref.Resolve() == object;
+		});
+		if (it == spawned.end()) {
+			return false;
+		}
+
+		// The current section is always fully loaded, so the order of it's spawns doesn't matter
+		*it = spawned.back();
+		spawned.pop_back();
+		_DestroySpawn(object);
+		return true;
+	}
+
+	void LevelStreamer::_DestroySpawn(const GameObject::Sptr& object) {
+		if (_prefab.DestroySpawn) {
+			_prefab.DestroySpawn(object);
+		} else {
+			_scene->RemoveGameObject(object);
+		}
+	}
+
+	void LevelStreamer::_CreateSpawns(const LevelSection::Sptr& section, int maxCount) {
+		int created = 0;
+		while (created < maxCount && section->Spawned.size() < _pendingSpawns.size()) {
+			const int index = (int)section->Spawned.size();
+			GameObject::Sptr object = _prefab.CreateSpawn ? _prefab.CreateSpawn(_scene, index, _pendingSpawns[index]) : nullptr;
+			if (object != nullptr) {
+				// Park the object until the player gets to this section
+				object->SetComponentsEnabled(false);
+			}
+			section->Spawned.push_back(object);
+			created++;
+		}
+
+		if (section->Spawned.size() >= _pendingSpawns.size()) {
+			_pendingSpawns.clear();
+			section->SectionState = LevelSection::State::Ready;
+		}
+	}
+
+	#pragma endregion
+
+	#pragma region Frame Trace
+
+	void LevelStreamer::_RecordFrame(float ms) {
+		_recentFrames[_recentHead] = ms;
+		_recentHead = (_recentHead + 1) % TRACE_FRAMES;
+
+		if (_framesSinceTransition < 0) {
+			return;
+		}
+
+		TransitionTrace& trace = _traces.back();
+		trace.FrameMs.push_back(ms);
+		_framesSinceTransition++;
+
+		// Once we've seen enough frames after the transition, report how it went
+		if (_framesSinceTransition >= TRACE_FRAMES) {
+			float average = 0.0f;
+			float worst = 0.0f;
+			for (int ix = 0; ix < trace.TransitionFrame; ix++) {
+				average += trace.FrameMs[ix];
+			}
+			average /= std::max(trace.TransitionFrame, 1);
+			for (int ix = trace.TransitionFrame; ix < (int)trace.FrameMs.size(); ix++) {
+				worst = std::max(worst, trace.FrameMs[ix]);
+			}
+
+			LOG_INFO("[Streaming] Section {} transition: {:.2f}ms on the transition frame, worst {:.2f}ms after it, {:.2f}ms average before{}",
+				trace.SectionNumber, trace.FrameMs[trace.TransitionFrame], worst, average, trace.Blocked ? " (blocked on loading)" : "");
+			_framesSinceTransition = -1;
+		}
+	}
+
+	void LevelStreamer::_BeginTrace(int sectionNumber, bool blocked) {
+		TransitionTrace trace;
+		trace.SectionNumber = sectionNumber;
+		trace.Blocked = blocked;
+		trace.FrameMs.reserve(TRACE_FRAMES * 2);
+
+		// Copy out the ring buffer, oldest frame first
+		for (int ix = 0; ix < TRACE_FRAMES; ix++) {
+			trace.FrameMs.push_back(_recentFrames[(_recentHead + ix) % TRACE_FRAMES]);
+		}
+		// The cost of this frame shows up in the next frame's delta time
+		trace.TransitionFrame = TRACE_FRAMES;
+
+		_traces.push_back(std::move(trace));
+		_framesSinceTransition = 0;
+	}
+
+	#pragma endregion
+}
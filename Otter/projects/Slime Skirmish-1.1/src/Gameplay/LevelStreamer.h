@@ -0,0 +1,234 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <string>
+#include <future>
+#include <functional>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/GameObject.h"
+
+namespace Gameplay {
+	class Scene;
+
+	/// <summary>
+	/// Describes the contents of a single level section (a room), so that the streamer
+	/// can stamp out copies of it and move them around without knowing what is inside
+	/// </summary>
+	struct SectionPrefab {
+		/// <summary>
+		/// A single object in the section, with a transform relative to the section origin
+		/// </summary>
+		struct Element {
+			std::string Name;
+			glm::vec3   Position = glm::vec3(0.0f);
+			glm::vec3   Rotation = glm::vec3(0.0f);
+			glm::vec3   Scale    = glm::vec3(1.0f);
+			// Adds the components for the element, called once when the section is instantiated
+			std::function<void(const GameObject::Sptr&)> Setup;
+		};
+
+		std::vector<Element> Elements;
+		// The offset from one section to the next along the level
+		glm::vec3 Stride = glm::vec3(0.0f);
+
+		/// <summary>
+		/// Decides where the objects for a section will spawn, relative to the section origin.
+		/// This is invoked on a worker thread, so it must not touch the scene
+		/// </summary>
+		std::function<void(int sectionNumber, std::vector<glm::vec3>& outPositions)> PlanSpawns;
+		/// <summary>
+		/// Creates a spawned object at the given world position, invoked on the main thread. The
+		/// streamer disables the object until the player reaches its section
+		/// </summary>
+		std::function<GameObject::Sptr(Scene* scene, int index, const glm::vec3& position)> CreateSpawn;
+		/// <summary>
+		/// Gets rid of a spawned object once it's section is retired or it's removed with
+		/// LevelStreamer::RemoveSpawn (ex: by handing it back to an object pool). If this is
+		/// not set, the object is removed from the scene
+		/// </summary>
+		std::function<void(const GameObject::Sptr& object)> DestroySpawn;
+
+		/// <summary>
+		/// Gets the index of the element with the given name, or -1 if none exists
+		/// </summary>
+		int FindElement(const std::string& name) const;
+	};
+
+	/// <summary>
+	/// One live copy of a section prefab in the scene
+	/// </summary>
+	struct LevelSection {
+		typedef std::shared_ptr<LevelSection> Sptr;
+
+		enum class State {
+			// Waiting for the worker to plan the section
+			Planning,
+			// Planned, spawned objects are being created over the next few frames
+			Loading,
+			// Everything is created and parked, waiting for the player
+			Ready,
+			// The player is in this section
+			Active
+		};
+
+		// Which slot of the streamer this section lives in, sections are reused in a ring
+		int       Slot = 0;
+		// The number of the section along the level, starting at 1
+		int       Number = 0;
+		glm::vec3 Origin = glm::vec3(0.0f);
+		State     SectionState = State::Planning;
+
+		// The instantiated objects, in the same order as SectionPrefab::Elements
+		std::vector<GameObject::Sptr>    Objects;
+		// Objects spawned for this section, these expire as the scene removes them
+		std::vector<GameObject::WeakRef> Spawned;
+
+		/// <summary>
+		/// Gets the number of spawned objects that are still in the scene
+		/// </summary>
+		int GetAliveCount() const;
+	};
+
+	/// <summary>
+	/// Streams level sections ahead of the player. A fixed ring of sections is instantiated
+	/// up front, and whenever the player moves into a new section, the section behind them
+	/// is retired and recycled as the next one ahead.
+	///
+	/// Planning a section (placement and spawn points) runs on the thread pool, and spawned
+	/// objects are created a few per frame while the player is still busy in the current section,
+	/// parked with their components disabled. Advancing into a section then only has to enable
+	/// objects that already exist, so transitions don't cost a frame.
+	///
+	/// The streamer also records frame times around each transition, see SaveTrace
+	/// </summary>
+	class LevelStreamer {
+	public:
+		typedef std::shared_ptr<LevelStreamer> Sptr;
+
+		/// <summary>
+		/// The maximum number of spawned objects to create in a single frame
+		/// </summary>
+		int SpawnBudget = 2;
+
+		/// <summary>
+		/// Creates a new streamer, call Init to instantiate the sections
+		/// </summary>
+		/// <param name="scene">The scene to create objects in</param>
+		/// <param name="prefab">The description of a section</param>
+		/// <param name="origin">The origin of the first section</param>
+		/// <param name="numSlots">The number of sections kept in the scene at a time, at least 2</param>
+		LevelStreamer(Scene* scene, const SectionPrefab& prefab, const glm::vec3& origin, int numSlots = 2);
+		~LevelStreamer();
+
+		LevelStreamer(const LevelStreamer& other) = delete;
+		LevelStreamer& operator=(const LevelStreamer& other) = delete;
+
+		/// <summary>
+		/// Instantiates all the section slots, fully loads and activates the first section,
+		/// and starts streaming in the ones after it. Objects that already exist in the scene
+		/// with a matching name (ex: from a loaded scene) are reused
+		/// </summary>
+		void Init();
+
+		/// <summary>
+		/// Pumps the streaming work, should be called once per frame on the main thread
+		/// </summary>
+		/// <param name="dt">The frame time in seconds, recorded for the transition trace</param>
+		void Update(float dt);
+
+		/// <summary>
+		/// Makes the next section the current one, enabling all of it's spawned objects, and
+		/// starts recycling the section behind the player. If the next section has not finished
+		/// streaming in, this will block until it has
+		/// </summary>
+		void Advance();
+
+		/// <summary>
+		/// Gets the section the player is currently in
+		/// </summary>
+		const LevelSection::Sptr& GetCurrent() const;
+		/// <summary>
+		/// Gets the section directly ahead of the player
+		/// </summary>
+		const LevelSection::Sptr& GetNext() const;
+		/// <summary>
+		/// Returns true if the next section is fully loaded and can be entered without blocking
+		/// </summary>
+		bool IsNextReady() const;
+
+		/// <summary>
+		/// Gets the object for the given prefab element in a section
+		/// </summary>
+		/// <param name="section">The section to look in</param>
+		/// <param name="elementIndex">The index of the element, see SectionPrefab::FindElement</param>
+		const GameObject::Sptr& GetElement(const LevelSection::Sptr& section, int elementIndex) const;
+
+		/// <summary>
+		/// Removes a spawned object from the current section and gets rid of it, see
+		/// SectionPrefab::DestroySpawn. This changes the order of the section's spawned
+		/// objects, so it must not be called while iterating over them
+		/// </summary>
+		/// <returns>False if the object was not spawned in the current section</returns>
+		bool RemoveSpawn(const GameObject::Sptr& object);
+
+		/// <summary>
+		/// Writes the recorded transition frame times to a CSV file, with one row per frame
+		/// </summary>
+		/// <param name="path">The path of the file to write</param>
+		void SaveTrace(const std::string& path) const;
+
+	protected:
+		// The result of planning a section on a worker
+		struct SectionPlan {
+			int       Number;
+			glm::vec3 Origin;
+			// World space positions of the prefab elements
+			std::vector<glm::vec3> ElementPositions;
+			// World space positions of the spawned objects
+			std::vector<glm::vec3> SpawnPositions;
+		};
+
+		// Frame times recorded around a single transition
+		struct TransitionTrace {
+			int                SectionNumber;
+			int                TransitionFrame;
+			bool               Blocked;
+			std::vector<float> FrameMs;
+		};
+
+		// The number of frames to record on either side of a transition
+		static const int TRACE_FRAMES;
+
+		Scene*                          _scene;
+		SectionPrefab                   _prefab;
+		glm::vec3                       _origin;
+		std::vector<LevelSection::Sptr> _sections;
+		int                             _current;
+
+		// Sections stream in one at a time, nearest first. This is the plan being built on
+		// a worker, and the spawn positions of the loading section that are not created yet
+		std::future<SectionPlan>        _pendingPlan;
+		std::vector<glm::vec3>          _pendingSpawns;
+
+		std::vector<float>              _recentFrames;
+		int                             _recentHead;
+		std::vector<TransitionTrace>    _traces;
+		int                             _framesSinceTransition;
+
+		// Gets the nearest section ahead of the player that is not loaded yet, or nullptr
+		LevelSection::Sptr _GetStreamingSection() const;
+		// Does the next step of streaming in a section, blocking on the worker if requested
+		void _StreamStep(const LevelSection::Sptr& section, int spawnBudget, bool block);
+		// Plans a section, safe to call from any thread
+		SectionPlan _PlanSection(int number) const;
+		// Moves a section into place from a finished plan, and queues up it's spawns
+		void _ApplyPlan(const LevelSection::Sptr& section, const SectionPlan& plan);
+		// Creates up to maxCount queued spawns for a loading section
+		void _CreateSpawns(const LevelSection::Sptr& section, int maxCount);
+		void _DestroySpawn(const GameObject::Sptr& object);
+
+		void _RecordFrame(float ms);
+		void _BeginTrace(int sectionNumber, bool blocked);
+	};
+}
@@ -108,8 +108,12 @@ namespace Gameplay {
 
 	Material::Sptr Material::Clone() const
 	{
-		// hehe, neat lil' hack
-		return FromJson(ToJson());
+		// The uniforms already know their locations and types in the shader, so we can copy
+		// their storage straight across instead of looking them all up again
+		Material::Sptr result = std::make_shared<Material>(_shader);
+		result->Name = Name;
+		result->_uniforms = _uniforms;
+		return result;
 	}
 
 	Material::Sptr Material::FromJson(const nlohmann::json& data) {
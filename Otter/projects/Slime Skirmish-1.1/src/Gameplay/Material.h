@@ -73,7 +73,8 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Creates a clone of this material, useful for cases where you have many similar 
-		/// materials with slight variations
+		/// materials with slight variations. The clone shares our shader and textures, but
+		/// has it's own copy of the other parameters and a new GUID
 		/// </summary>
 		Material::Sptr Clone() const;
 
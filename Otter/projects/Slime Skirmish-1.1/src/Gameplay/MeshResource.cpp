@@ -2,22 +2,26 @@
 #include <filesystem>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/VirtualFileSystem.h"
 
 namespace Gameplay {
+	const std::string MeshResource::GeneratedMeshCacheDir = "mesh_cache";
+	const uint32_t MeshResource::GENERATED_MESH_VERSION = 2;
+	std::unordered_map<uint64_t, std::weak_ptr<VertexArrayObject>> MeshResource::_generatedMeshes;
+
 	MeshResource::MeshResource() :
 		IResource(),
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
-		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		Mesh(nullptr)
 	{ }
 
 	MeshResource::MeshResource(const std::string& filename) :
 		IResource(),
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
-		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		Mesh(nullptr)
 	{
 		Mesh = ObjLoader::LoadFromFile(filename);
 	}
@@ -44,17 +48,13 @@ namespace Gameplay {
 		MeshResource::Sptr result = std::make_shared<MeshResource>();
 		if (blob.contains("params") && blob["params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexColTangents> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
-			MeshFactory::CalculateTBN(mesh);
-			result->Mesh = mesh.Bake();
+			result->GenerateMesh();
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
+			if (result->Filename != "null" && VirtualFileSystem::Exists(result->Filename)) {
 				#ifdef OPTIMIZED_OBJ_LOADER
 				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
 				#else
@@ -67,15 +67,66 @@ namespace Gameplay {
 	}
 
 	void MeshResource::GenerateMesh() {
-		MeshBuilder<VertexPosNormTexColTangents> mesh;
-		for (auto& param : MeshBuilderParams) {
-			MeshFactory::AddParameterized(mesh, param);
+		// Mix the vertex layout and generator version into the hash, so changes to either invalidate the cache
+		uint64_t hash = MeshBuilderParam::Hash(MeshBuilderParams);
+		hash = (hash ^ GENERATED_MESH_VERSION) * 0x100000001b3ull;
+		hash = (hash ^ sizeof(VertexPosNormTexColTangents)) * 0x100000001b3ull;
+
+		// If another resource has already generated this mesh, share the VAO
+		auto it = _generatedMeshes.find(hash);
+		if (it != _generatedMeshes.end()) {
+			Mesh = it->second.lock();
+			if (Mesh != nullptr) {
+				return;
+			}
 		}
-		MeshFactory::CalculateTBN(mesh);
-		Mesh = mesh.Bake();
+
+		char cacheName[32];
+		sprintf_s(cacheName, "%016llx.bin", (unsigned long long)hash);
+		const std::string cachePath = (std::filesystem::path(GeneratedMeshCacheDir) / cacheName).string();
+
+		// Try to load a version we've already baked to disk
+		Mesh = nullptr;
+		if (VirtualFileSystem::Exists(cachePath)) {
+			try {
+				Mesh = OptimizedObjLoader::LoadFromFile(cachePath);
+			} catch (const std::runtime_error& e) {
+				LOG_WARN("Failed to load cached mesh \"{}\": {}", cachePath, e.what());
+			}
+		}
+
+		// Nothing cached, generate the mesh and bake it to disk for next time
+		if (Mesh == nullptr) {
+			MeshBuilder<VertexPosNormTexColTangents> mesh;
+			for (auto& param : MeshBuilderParams) {
+				MeshFactory::AddParameterized(mesh, param);
+			}
+			MeshFactory::CalculateTBN(mesh);
+			Mesh = mesh.Bake();
+
+			std::error_code error;
+			std::filesystem::create_directories(GeneratedMeshCacheDir, error);
+			try {
+				OptimizedObjLoader::SaveBinaryFile(mesh, cachePath);
+			} catch (const std::runtime_error& e) {
+				LOG_WARN("Failed to write mesh cache \"{}\": {}", cachePath, e.what());
+			}
+		}
+
+		_generatedMeshes[hash] = Mesh;
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	void MeshResource::PruneGeneratedMeshes() {
+		for (auto it = _generatedMeshes.begin(); it != _generatedMeshes.end();) {
+			if (it->second.expired()) {
+				it = _generatedMeshes.erase(it);
+			} else {
+				it++;
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -3,9 +3,6 @@
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
 
-// bullet triangle mesh pre-declaration
-class btTriangleMesh;
-
 namespace Gameplay {
 	/// <summary>
 	/// A mesh resource contains information on how to generate a VAO at runtime
@@ -46,13 +43,11 @@ namespace Gameplay {
 		/// The optional mesh resource for generating colliders from this mesh
 		/// </summary>
 		MeshResource::Sptr             ColliderMeshData;
-		/// <summary>
-		/// Allows for bullet to generate a triangle mesh from this mesh and cache it
-		/// </summary>
-		std::shared_ptr<btTriangleMesh> BulletTriMesh;
 
 		/// <summary>
-		/// Generates a new mesh from the mesh builder parameters
+		/// Generates a new mesh from the mesh builder parameters. Generated meshes are cached
+		/// by the hash of their parameters, both in memory (so identical resources will share
+		/// a single VAO) and on disk in the binary mesh format
 		/// </summary>
 		void GenerateMesh();
 		/// <summary>
@@ -61,9 +56,27 @@ namespace Gameplay {
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Drops cache entries for generated meshes that are no longer referenced. Call this
+		/// when a level section or scene unloads so the in-memory cache doesn't grow across loads
+		/// </summary>
+		static void PruneGeneratedMeshes();
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+
+		/// <summary>
+		/// The directory that generated meshes are cached to
+		/// </summary>
+		static const std::string GeneratedMeshCacheDir;
+
+	protected:
+		// Bump this when the mesh factory output changes to invalidate old cache files
+		static const uint32_t GENERATED_MESH_VERSION;
+
+		// Generated meshes that are currently alive, keyed by their parameter hash
+		static std::unordered_map<uint64_t, std::weak_ptr<VertexArrayObject>> _generatedMeshes;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "Gameplay/ObjectPool.h"
+
+#include "Gameplay/Scene.h"
+#include "Logging.h"
+
+namespace Gameplay {
+	ObjectPool::ObjectPool(Scene* scene, const CreateFunc& create, const ResetFunc& reset) :
+		_scene(scene),
+		_create(create),
+		_reset(reset),
+		_stats(),
+		_slots(),
+		_lookup(),
+		_spawned(),
+		_parked()
+	{
+		LOG_ASSERT(_create, "Object pools need a function to create their objects!");
+	}
+
+	ObjectPool::~ObjectPool() = default;
+
+	void ObjectPool::Prewarm(size_t count) {
+		_slots.reserve(count);
+		_spawned.reserve(count);
+		_parked.reserve(count);
+		while (_slots.size() < count) {
+			_CreateObject();
+		}
+	}
+
+	GameObject::Sptr ObjectPool::Spawn(const glm::vec3& position, bool enabled) {
+		if (_parked.empty()) {
+			_CreateObject();
+			_stats.Created++;
+		} else {
+			_stats.Reused++;
+		}
+
+		const int slotIndex = _parked.back();
+		_parked.pop_back();
+
+		Slot& slot = _slots[slotIndex];
+		slot.SpawnedIndex = (int)_spawned.size();
+		_spawned.push_back(slotIndex);
+
+		if (_reset) {
+			_reset(slot.Object, position);
+		} else {
+			slot.Object->SetPostion(position);
+		}
+		if (enabled) {
+			slot.Object->SetComponentsEnabled(true);
+		}
+		return slot.Object;
+	}
+
+	bool ObjectPool::Despawn(const GameObject* object) {
+		auto it = _lookup.find(object);
+		if (it == _lookup.end() || _slots[it->second].SpawnedIndex < 0) {
+			return false;
+		}
+
+		// Swap the last spawned object into this one's place, so despawning is O(1)
+		const int index = _slots[it->second].SpawnedIndex;
+		const int last = _spawned.back();
+		_spawned[index] = last;
+		_slots[last].SpawnedIndex = index;
+		_spawned.pop_back();
+
+		_Park(it->second);
+		_stats.Despawned++;
+		return true;
+	}
+
+	void ObjectPool::DespawnAll() {
+		for (int slot : _spawned) {
+			_Park(slot);
+		}
+		_stats.Despawned += (int)_spawned.size();
+		_spawned.clear();
+	}
+
+	bool ObjectPool::IsSpawned(const GameObject* object) const {
+		auto it = _lookup.find(object);
+		return it != _lookup.end() && _slots[it->second].SpawnedIndex >= 0;
+	}
+
+	size_t ObjectPool::GetSpawnedCount() const {
+		return _spawned.size();
+	}
+
+	size_t ObjectPool::GetParkedCount() const {
+		return _parked.size();
+	}
+
+	size_t ObjectPool::GetSize() const {
+		return _slots.size();
+	}
+
+	const ObjectPool::Stats& ObjectPool::GetStats() const {
+		return _stats;
+	}
+
+	void ObjectPool::ResetStats() {
+		_stats = Stats();
+	}
+
+	void ObjectPool::_CreateObject() {
+		const int slotIndex = (int)_slots.size();
+		GameObject::Sptr object = _create(_scene, slotIndex);
+		LOG_ASSERT(object != nullptr, "Object pool failed to create an object!");
+
+		_slots.push_back({ object, -1 });
+		_lookup[object.get()] = slotIndex;
+		// Keep room for every object in both lists, so moving between them never allocates
+		_spawned.reserve(_slots.size());
+		_parked.reserve(_slots.size());
+		_Park(slotIndex);
+	}
+
+	void ObjectPool::_Park(int slot) {
+		_slots[slot].SpawnedIndex = -1;
+		_slots[slot].Object->SetComponentsEnabled(false);
+		_parked.push_back(slot);
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/GameObject.h"
+
+namespace Gameplay {
+	class Scene;
+
+	/// <summary>
+	/// Keeps a set of gameobjects built from the same template (ex: enemies), so that waves
+	/// of them can be spawned and despawned without creating or destroying anything.
+	///
+	/// Objects are created up front with Prewarm, along with all their components and physics
+	/// shapes, and parked with their components disabled. Spawning hands out a parked object
+	/// and despawning parks it again, both in O(1). Physics objects are only taken in and out
+	/// of the world, see PhysicsBase::SetSimulated. The pool only creates new objects when
+	/// it runs dry, these are counted in the stats so waves can be checked for allocations
+	/// </summary>
+	class ObjectPool {
+	public:
+		typedef std::shared_ptr<ObjectPool> Sptr;
+
+		/// <summary>
+		/// Creates a new object for the pool, with all of it's components
+		/// </summary>
+		typedef std::function<GameObject::Sptr(Scene* scene, int index)> CreateFunc;
+		/// <summary>
+		/// Puts an object back in it's starting state (ex: health), and moves it to where it's spawning
+		/// </summary>
+		typedef std::function<void(const GameObject::Sptr& object, const glm::vec3& position)> ResetFunc;
+
+		/// <summary>
+		/// Counts what the pool has done since the stats were last reset
+		/// </summary>
+		struct Stats {
+			// Objects that had to be created because the pool was empty
+			int Created = 0;
+			// Spawns that reused a parked object
+			int Reused = 0;
+			int Despawned = 0;
+		};
+
+		/// <summary>
+		/// Creates a new, empty pool, call Prewarm to fill it
+		/// </summary>
+		/// <param name="scene">The scene to create objects in</param>
+		/// <param name="create">Creates a new object for the pool</param>
+		/// <param name="reset">Resets an object when it's spawned, can be empty</param>
+		ObjectPool(Scene* scene, const CreateFunc& create, const ResetFunc& reset);
+		~ObjectPool();
+
+		ObjectPool(const ObjectPool& other) = delete;
+		ObjectPool& operator=(const ObjectPool& other) = delete;
+
+		/// <summary>
+		/// Creates parked objects until the pool holds at least count objects. This is not
+		/// counted in the stats
+		/// </summary>
+		void Prewarm(size_t count);
+
+		/// <summary>
+		/// Takes an object out of the pool, creating a new one if none are parked
+		/// </summary>
+		/// <param name="position">The position to spawn the object at</param>
+		/// <param name="enabled">False to leave the object's components disabled, for objects that are
+		/// waiting for something else to turn them on (ex: the level streamer)</param>
+		GameObject::Sptr Spawn(const glm::vec3& position, bool enabled = true);
+		/// <summary>
+		/// Parks an object that was spawned from this pool
+		/// </summary>
+		/// <returns>False if the object is not a spawned object from this pool</returns>
+		bool Despawn(const GameObject* object);
+		/// <summary>
+		/// Parks every spawned object
+		/// </summary>
+		void DespawnAll();
+
+		/// <summary>
+		/// Returns true if the object belongs to this pool and is spawned
+		/// </summary>
+		bool IsSpawned(const GameObject* object) const;
+		size_t GetSpawnedCount() const;
+		size_t GetParkedCount() const;
+		/// <summary>
+		/// Gets the total number of objects the pool has created
+		/// </summary>
+		size_t GetSize() const;
+
+		const Stats& GetStats() const;
+		void ResetStats();
+
+	protected:
+		// Every object the pool has created, in the order they were made
+		struct Slot {
+			GameObject::Sptr Object;
+			// Where the object is in _spawned, or -1 if it's parked
+			int              SpawnedIndex;
+		};
+
+		Scene*     _scene;
+		CreateFunc _create;
+		ResetFunc  _reset;
+		Stats      _stats;
+
+		std::vector<Slot> _slots;
+		// Only filled in when an object is created, so spawning and despawning never allocate
+		std::unordered_map<const GameObject*, int> _lookup;
+		// Slot indices of the spawned and parked objects. Both have room for every object
+		std::vector<int> _spawned;
+		std::vector<int> _parked;
+
+		// Creates a new object and parks it
+		void _CreateObject();
+		void _Park(int slot);
+	};
+}
@@ -15,6 +15,10 @@ namespace Gameplay::Physics {
 
 	CapsuleCollider::~CapsuleCollider() = default;
 
+	ICollider::Sptr CapsuleCollider::_Copy() const {
+		return std::shared_ptr<CapsuleCollider>(new CapsuleCollider(*this));
+	}
+
 	void CapsuleCollider::DrawImGui() {
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat, "Radius", &_radius, 0.1f, 0.01f);
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat, "Height", &_radius, 0.1f, 0.01f);
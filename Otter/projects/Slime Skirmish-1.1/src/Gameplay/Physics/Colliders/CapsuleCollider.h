@@ -25,6 +25,7 @@ namespace Gameplay::Physics {
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
+		virtual ICollider::Sptr _Copy() const override;
 
 	private:
 		float _radius;
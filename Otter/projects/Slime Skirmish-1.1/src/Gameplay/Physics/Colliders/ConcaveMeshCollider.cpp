@@ -0,0 +1,64 @@
+#include "ConcaveMeshCollider.h"
+
+#include "Gameplay/GameObject.h"
+#include "Gameplay/MeshResource.h"
+#include "Gameplay/Components/RenderComponent.h"
+#include "Gameplay/Physics/RigidBody.h"
+
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay::Physics {
+	ConcaveMeshCollider::Sptr ConcaveMeshCollider::Create() {
+		return std::shared_ptr<ConcaveMeshCollider>(new ConcaveMeshCollider());
+	}
+
+	ConcaveMeshCollider::~ConcaveMeshCollider() = default;
+
+	ICollider::Sptr ConcaveMeshCollider::_Copy() const {
+		return std::shared_ptr<ConcaveMeshCollider>(new ConcaveMeshCollider(*this));
+	}
+
+	ConcaveMeshCollider::ConcaveMeshCollider() :
+		ICollider(ColliderType::ConcaveMesh),
+		_triMesh(nullptr)
+	{ }
+
+	btCollisionShape* ConcaveMeshCollider::CreateShape() const {
+		return _triMesh != nullptr ? _triMesh->CreateShape() : nullptr;
+	}
+
+	void ConcaveMeshCollider::Awake(GameObject* context)
+	{
+		RenderComponent::Sptr renderer = context->Get<RenderComponent>();
+		MeshResource::Sptr mesh = (renderer != nullptr ? renderer->GetMeshResource() : nullptr);
+
+		// If we have no mesh, we can't create a collider for it!
+		if (mesh == nullptr) {
+			LOG_WARN("Mesh collider attached to gameobject without a mesh!");
+			return;
+		}
+
+		// If we have an explicit collider, grab that instead
+		if (mesh->ColliderMeshData != nullptr) {
+			mesh = mesh->ColliderMeshData;
+		}
+
+		RigidBody::Sptr body = context->Get<RigidBody>();
+		if (body != nullptr && body->GetType() == RigidBodyType::Dynamic) {
+			LOG_WARN("Concave mesh collider on dynamic body \"{}\", use a convex mesh collider instead", context->Name);
+		}
+
+		// Load or cook the BVH, this will be shared with any other colliders using the same mesh
+		_triMesh = CollisionCooker::CookTriangleMesh(mesh);
+	}
+
+	void ConcaveMeshCollider::FromJson(const nlohmann::json& data) {
+	}
+
+	void ConcaveMeshCollider::ToJson(nlohmann::json& blob) const {
+	}
+
+	void ConcaveMeshCollider::DrawImGui() {
+		ImGui::Text("Triangles: %d", _triMesh != nullptr ? (int)(_triMesh->Indices.size() / 3) : 0);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Gameplay/Physics/ICollider.h"
+#include "Gameplay/Physics/CollisionCooker.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// A collider that uses the full triangle mesh of an object, accelerated with a quantized
+	/// BVH that is cooked ahead of time. This is meant for static level geometry, bullet does
+	/// not support triangle meshes on dynamic bodies (use ConvexMeshCollider for those)
+	/// </summary>
+	class ConcaveMeshCollider final : public ICollider {
+	public:
+		typedef std::shared_ptr<ConcaveMeshCollider> Sptr;
+		static ConcaveMeshCollider::Sptr Create();
+		virtual ~ConcaveMeshCollider();
+
+		// Inherited from ICollider
+		virtual void Awake(GameObject* context) override;
+		virtual void DrawImGui() override;
+		virtual void ToJson(nlohmann::json& blob) const override;
+		virtual void FromJson(const nlohmann::json& data) override;
+
+	protected:
+		CookedTriangleMesh::Sptr _triMesh;
+
+		ConcaveMeshCollider();
+
+		virtual btCollisionShape* CreateShape() const override;
+		virtual ICollider::Sptr _Copy() const override;
+	};
+}
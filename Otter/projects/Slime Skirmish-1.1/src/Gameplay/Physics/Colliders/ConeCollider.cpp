@@ -15,6 +15,10 @@ namespace Gameplay::Physics {
 
 	ConeCollider::~ConeCollider() = default;
 
+	ICollider::Sptr ConeCollider::_Copy() const {
+		return std::shared_ptr<ConeCollider>(new ConeCollider(*this));
+	}
+
 	void ConeCollider::DrawImGui() {
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat, "Radius", &_radius, 0.1f, 0.01f);
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat, "Height", &_radius, 0.1f, 0.01f);
@@ -42,6 +42,7 @@ namespace Gameplay::Physics {
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
+		virtual ICollider::Sptr _Copy() const override;
 
 	private:
 		float _radius;
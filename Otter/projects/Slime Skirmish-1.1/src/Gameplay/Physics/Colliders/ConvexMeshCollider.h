@@ -1,17 +1,28 @@
 #pragma once
 
 #include "Gameplay/Physics/ICollider.h"
+#include "Gameplay/Physics/CollisionCooker.h"
 
 namespace Gameplay::Physics {
 	/// <summary>
-	/// A complex collider type that allows us to construct collision hulls from arbitrary convex meshes
+	/// A complex collider type that allows us to construct collision hulls from arbitrary convex meshes.
+	/// The hull is cooked from the mesh's source data and simplified to a limited number of points,
+	/// see CollisionCooker
 	/// </summary>
 	class ConvexMeshCollider final : public ICollider {
 	public:
 		typedef std::shared_ptr<ConvexMeshCollider> Sptr;
-		static ConvexMeshCollider::Sptr Create();
+		static ConvexMeshCollider::Sptr Create(int maxVertices = 32);
 		virtual ~ConvexMeshCollider();
 
+		/// <summary>
+		/// Sets the maximum number of points in the cooked hull, fewer points makes for cheaper collisions
+		/// </summary>
+		/// <param name="value">The new vertex limit, clamped to CollisionCooker::MIN_HULL_VERTICES and MAX_HULL_VERTICES</param>
+		/// <returns>A pointer to this, should ONLY be used for operator chaining</returns>
+		ConvexMeshCollider* SetMaxVertices(int value);
+		int GetMaxVertices() const;
+
 		// Inherited from ICollider
 		virtual void Awake(GameObject* context) override;
 		virtual void DrawImGui() override;
@@ -19,9 +30,13 @@ namespace Gameplay::Physics {
 		virtual void FromJson(const nlohmann::json& data) override;
 
 	protected:
-		btTriangleMesh* _triMesh;
-		ConvexMeshCollider();
+		int                    _maxVertices;
+		MeshResource::Sptr     _mesh;
+		CookedConvexHull::Sptr _hull;
+
+		ConvexMeshCollider(int maxVertices);
 
 		virtual btCollisionShape* CreateShape() const override;
+		virtual ICollider::Sptr _Copy() const override;
 	};
-}
\ No newline at end of file
+}
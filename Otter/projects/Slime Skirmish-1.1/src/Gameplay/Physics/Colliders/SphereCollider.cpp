@@ -14,6 +14,10 @@ namespace Gameplay::Physics {
 
 	SphereCollider::~SphereCollider()= default;
 
+	ICollider::Sptr SphereCollider::_Copy() const {
+		return std::shared_ptr<SphereCollider>(new SphereCollider(*this));
+	}
+
 	btCollisionShape* SphereCollider::CreateShape() const {
 		return new btSphereShape(_radius);
 	}
@@ -0,0 +1,363 @@
+#include "Gameplay/Physics/CollisionCooker.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btShapeHull.h>
+#include <BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
+#include <LinearMath/btConvexHull.h>
+
+#include "Logging.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/MeshFactory.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	const uint32_t CollisionCooker::COOKED_VERSION = 1;
+	const int CollisionCooker::MIN_HULL_VERTICES = 4;
+	const int CollisionCooker::MAX_HULL_VERTICES = 62;
+	std::mutex CollisionCooker::_cacheMutex;
+	std::unordered_map<uint64_t, std::weak_ptr<CookedConvexHull>>   CollisionCooker::_hulls;
+	std::unordered_map<uint64_t, std::weak_ptr<CookedTriangleMesh>> CollisionCooker::_triangleMeshes;
+
+	// Mixes a value into an FNV-1a hash
+	inline static uint64_t HashMix(uint64_t hash, uint64_t value) {
+		return (hash ^ value) * 0x100000001b3ull;
+	}
+
+	// Mixes a block of bytes into an FNV-1a hash
+	inline static uint64_t HashBytes(uint64_t hash, const uint8_t* data, size_t size) {
+		for (size_t ix = 0; ix < size; ix++) {
+			hash = HashMix(hash, data[ix]);
+		}
+		return hash;
+	}
+
+	#pragma region Cooked Shapes
+
+	btCollisionShape* CookedConvexHull::CreateShape() const {
+		if (Points.empty()) {
+			return nullptr;
+		}
+		btConvexHullShape* result = new btConvexHullShape(&Points[0].x, (int)Points.size(), sizeof(glm::vec3));
+		// Cooked hulls are already minimal, but bullet needs the polyhedral data for its better contact clipping
+		result->initializePolyhedralFeatures();
+		return result;
+	}
+
+	CookedTriangleMesh::CookedTriangleMesh() :
+		Vertices(),
+		Indices(),
+		_meshInterface(nullptr),
+		_shape(nullptr),
+		_bvh(nullptr),
+		_bvhBuffer(nullptr)
+	{ }
+
+	CookedTriangleMesh::~CookedTriangleMesh() {
+		// The shape does not own the BVH since we gave it one with setOptimizedBvh
+		delete _shape;
+		delete _meshInterface;
+		if (_bvh != nullptr) {
+			_bvh->~btOptimizedBvh();
+		}
+		btAlignedFree(_bvhBuffer);
+	}
+
+	btCollisionShape* CookedTriangleMesh::CreateShape() const {
+		if (_shape == nullptr) {
+			return nullptr;
+		}
+		return new btScaledBvhTriangleMeshShape(_shape, btVector3(1.0f, 1.0f, 1.0f));
+	}
+
+	#pragma endregion
+
+	CookedConvexHull::Sptr CollisionCooker::CookConvexHull(const MeshResource::Sptr& mesh, int maxVertices) {
+		if (mesh == nullptr) {
+			return nullptr;
+		}
+		maxVertices = glm::clamp(maxVertices, MIN_HULL_VERTICES, MAX_HULL_VERTICES);
+
+		uint64_t hash = _HashSource(*mesh);
+		hash = HashMix(hash, (uint64_t)CookedType::ConvexHull);
+		hash = HashMix(hash, COOKED_VERSION);
+		hash = HashMix(hash, (uint64_t)maxVertices);
+
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+
+		// If another collider has already cooked this hull, share it
+		auto it = _hulls.find(hash);
+		if (it != _hulls.end()) {
+			CookedConvexHull::Sptr existing = it->second.lock();
+			if (existing != nullptr) {
+				return existing;
+			}
+		}
+
+		CookedConvexHull::Sptr result = std::make_shared<CookedConvexHull>();
+		const std::string cachePath = _GetCachePath(hash, ".hull");
+
+		// Try to load a hull we've already cooked
+		FileView file = VirtualFileSystem::Open(cachePath);
+		if (file && file.GetSize() >= sizeof(CookedHeader)) {
+			CookedHeader header;
+			memcpy(&header, file.GetData(), sizeof(CookedHeader));
+			if (memcmp(header.HeaderBytes, CookedHeader().HeaderBytes, 4) == 0 &&
+				header.Version == COOKED_VERSION &&
+				header.Type == CookedType::ConvexHull &&
+				file.GetSize() >= sizeof(CookedHeader) + header.NumVertices * sizeof(glm::vec3))
+			{
+				result->Points.resize(header.NumVertices);
+				memcpy(result->Points.data(), file.GetData() + sizeof(CookedHeader), header.NumVertices * sizeof(glm::vec3));
+			} else {
+				LOG_WARN("Cooked hull \"{}\" is invalid or out of date, re-cooking", cachePath);
+			}
+		}
+
+		// Nothing cached, cook it from the source mesh
+		if (result->Points.empty()) {
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+			if (!_ReadSource(*mesh, positions, indices) || indices.size() < 3) {
+				LOG_WARN("Could not read geometry for convex hull, mesh has no source data");
+				return nullptr;
+			}
+
+			// Sample the mesh's support function to get a simplified hull, with no margin since
+			// the hull shape will add its own
+			btTriangleIndexVertexArray meshInterface((int)(indices.size() / 3), reinterpret_cast<int*>(indices.data()), 3 * sizeof(uint32_t),
+				(int)positions.size(), &positions[0].x, sizeof(glm::vec3));
+			btConvexTriangleMeshShape source(&meshInterface);
+			source.setMargin(0.0f);
+
+			btShapeHull hull(&source);
+			if (!hull.buildHull(0.0f)) {
+				LOG_WARN("Failed to build hull for convex mesh");
+				return nullptr;
+			}
+
+			const btVector3* hullPoints = hull.getVertexPointer();
+			int numPoints = hull.numVertices();
+
+			// btShapeHull may still give us more points than we want, reduce it down to our limit
+			HullLibrary library;
+			HullResult reduced;
+			bool isReduced = false;
+			if (numPoints > maxVertices) {
+				HullDesc desc(QF_TRIANGLES, numPoints, hullPoints, sizeof(btVector3));
+				desc.mMaxVertices = maxVertices;
+				if (library.CreateConvexHull(desc, reduced) == QE_OK) {
+					hullPoints = &reduced.m_OutputVertices[0];
+					numPoints = (int)reduced.mNumOutputVertices;
+					isReduced = true;
+				}
+			}
+
+			result->Points.resize(numPoints);
+			for (int ix = 0; ix < numPoints; ix++) {
+				result->Points[ix] = ToGlm(hullPoints[ix]);
+			}
+			if (isReduced) {
+				library.ReleaseResult(reduced);
+			}
+
+			LOG_TRACE("Cooked convex hull with {} points from {} triangles", numPoints, indices.size() / 3);
+
+			CookedHeader header;
+			header.Version     = COOKED_VERSION;
+			header.Type        = CookedType::ConvexHull;
+			header.NumVertices = (uint32_t)result->Points.size();
+			header.NumIndices  = 0;
+			header.BvhSize     = 0;
+			header.AabbMin     = glm::vec3(0.0f);
+			header.AabbMax     = glm::vec3(0.0f);
+			_WriteCookedFile(cachePath, header, result->Points, {}, nullptr);
+		}
+
+		_hulls[hash] = result;
+		return result;
+	}
+
+	CookedTriangleMesh::Sptr CollisionCooker::CookTriangleMesh(const MeshResource::Sptr& mesh) {
+		if (mesh == nullptr) {
+			return nullptr;
+		}
+
+		uint64_t hash = _HashSource(*mesh);
+		hash = HashMix(hash, (uint64_t)CookedType::TriangleMesh);
+		hash = HashMix(hash, COOKED_VERSION);
+
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+
+		// If another collider has already cooked this mesh, share it
+		auto it = _triangleMeshes.find(hash);
+		if (it != _triangleMeshes.end()) {
+			CookedTriangleMesh::Sptr existing = it->second.lock();
+			if (existing != nullptr) {
+				return existing;
+			}
+		}
+
+		CookedTriangleMesh::Sptr result = std::make_shared<CookedTriangleMesh>();
+		const std::string cachePath = _GetCachePath(hash, ".bvh");
+
+		// Try to load a mesh we've already cooked
+		FileView file = VirtualFileSystem::Open(cachePath);
+		if (file && file.GetSize() >= sizeof(CookedHeader)) {
+			CookedHeader header;
+			memcpy(&header, file.GetData(), sizeof(CookedHeader));
+
+			const size_t verticesSize = header.NumVertices * sizeof(glm::vec3);
+			const size_t indicesSize  = header.NumIndices * sizeof(uint32_t);
+			if (memcmp(header.HeaderBytes, CookedHeader().HeaderBytes, 4) == 0 &&
+				header.Version == COOKED_VERSION &&
+				header.Type == CookedType::TriangleMesh &&
+				file.GetSize() >= sizeof(CookedHeader) + verticesSize + indicesSize + header.BvhSize)
+			{
+				const uint8_t* seek = file.GetData() + sizeof(CookedHeader);
+				result->Vertices.resize(header.NumVertices);
+				memcpy(result->Vertices.data(), seek, verticesSize);
+				seek += verticesSize;
+				result->Indices.resize(header.NumIndices);
+				memcpy(result->Indices.data(), seek, indicesSize);
+				seek += indicesSize;
+
+				if (!_InitTriangleMesh(*result, header.AabbMin, header.AabbMax, seek, header.BvhSize)) {
+					LOG_WARN("Failed to load BVH from \"{}\", re-cooking", cachePath);
+					result = std::make_shared<CookedTriangleMesh>();
+				}
+			} else {
+				LOG_WARN("Cooked mesh \"{}\" is invalid or out of date, re-cooking", cachePath);
+			}
+		}
+
+		// Nothing cached, cook it from the source mesh
+		if (result->_shape == nullptr) {
+			if (!_ReadSource(*mesh, result->Vertices, result->Indices) || result->Indices.size() < 3) {
+				LOG_WARN("Could not read geometry for triangle mesh, mesh has no source data");
+				return nullptr;
+			}
+
+			// Let bullet build the quantized BVH, then serialize it so that we can store it
+			btTriangleIndexVertexArray meshInterface((int)(result->Indices.size() / 3), reinterpret_cast<int*>(result->Indices.data()), 3 * sizeof(uint32_t),
+				(int)result->Vertices.size(), &result->Vertices[0].x, sizeof(glm::vec3));
+			btBvhTriangleMeshShape builder(&meshInterface, true, true);
+
+			btOptimizedBvh* bvh = builder.getOptimizedBvh();
+			const uint32_t bvhSize = bvh->calculateSerializeBufferSize();
+			void* bvhData = btAlignedAlloc(bvhSize, 16);
+			bvh->serializeInPlace(bvhData, bvhSize, false);
+
+			CookedHeader header;
+			header.Version     = COOKED_VERSION;
+			header.Type        = CookedType::TriangleMesh;
+			header.NumVertices = (uint32_t)result->Vertices.size();
+			header.NumIndices  = (uint32_t)result->Indices.size();
+			header.BvhSize     = bvhSize;
+			header.AabbMin     = ToGlm(builder.getLocalAabbMin());
+			header.AabbMax     = ToGlm(builder.getLocalAabbMax());
+			_WriteCookedFile(cachePath, header, result->Vertices, result->Indices, bvhData);
+
+			// Load it back the same way we would from disk, so there's only one code path at runtime
+			bool success = _InitTriangleMesh(*result, header.AabbMin, header.AabbMax, bvhData, bvhSize);
+			btAlignedFree(bvhData);
+			if (!success) {
+				LOG_WARN("Failed to cook triangle mesh BVH");
+				return nullptr;
+			}
+
+			LOG_TRACE("Cooked BVH triangle mesh with {} triangles", result->Indices.size() / 3);
+		}
+
+		_triangleMeshes[hash] = result;
+		return result;
+	}
+
+	uint64_t CollisionCooker::_HashSource(const MeshResource& mesh) {
+		// Mesh builder params take priority, see MeshResource::ToJson
+		if (mesh.MeshBuilderParams.size() > 0) {
+			return HashMix(MeshBuilderParam::Hash(mesh.MeshBuilderParams), sizeof(VertexPosNormTexColTangents));
+		}
+		// Hash the contents rather than just the size, so editing a mesh always re-cooks it. This is
+		// a lot cheaper than cooking, and packed files are hashed straight out of the mapping
+		uint64_t hash = AssetPack::HashPath(AssetPack::NormalizePath(mesh.Filename));
+		FileView file = VirtualFileSystem::Open(mesh.Filename);
+		hash = HashMix(hash, file.GetSize());
+		return HashBytes(hash, file.GetData(), file.GetSize());
+	}
+
+	bool CollisionCooker::_ReadSource(const MeshResource& mesh, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		if (mesh.MeshBuilderParams.size() > 0) {
+			MeshBuilder<VertexPosNormTexCol> builder;
+			for (const auto& param : mesh.MeshBuilderParams) {
+				MeshFactory::AddParameterized(builder, param);
+			}
+
+			positions.resize(builder.GetVertexCount());
+			const VertexPosNormTexCol* vertices = builder.GetVertexDataPtr();
+			for (size_t ix = 0; ix < positions.size(); ix++) {
+				positions[ix] = vertices[ix].Position;
+			}
+			indices.assign(builder.GetIndexDataPtr(), builder.GetIndexDataPtr() + builder.GetIndexCount());
+			return true;
+		}
+		else if (!mesh.Filename.empty() && mesh.Filename != "null") {
+			try {
+				return OptimizedObjLoader::LoadPositions(mesh.Filename, positions, indices);
+			} catch (const std::runtime_error& e) {
+				LOG_WARN("Failed to read mesh \"{}\" for cooking: {}", mesh.Filename, e.what());
+			}
+		}
+		return false;
+	}
+
+	std::string CollisionCooker::_GetCachePath(uint64_t hash, const char* extension) {
+		char cacheName[32];
+		sprintf_s(cacheName, "%016llx%s", (unsigned long long)hash, extension);
+		return (std::filesystem::path(MeshResource::GeneratedMeshCacheDir) / cacheName).string();
+	}
+
+	void CollisionCooker::_WriteCookedFile(const std::string& path, const CookedHeader& header, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices, const void* bvhData) {
+		std::error_code error;
+		std::filesystem::create_directories(MeshResource::GeneratedMeshCacheDir, error);
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			LOG_WARN("Failed to write collision cache \"{}\"", path);
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CookedHeader));
+		file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(glm::vec3));
+		file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+		if (bvhData != nullptr) {
+			file.write(reinterpret_cast<const char*>(bvhData), header.BvhSize);
+		}
+	}
+
+	bool CollisionCooker::_InitTriangleMesh(CookedTriangleMesh& result, const glm::vec3& aabbMin, const glm::vec3& aabbMax, const void* bvhData, uint32_t bvhSize) {
+		if (bvhSize == 0 || result.Indices.size() < 3) {
+			return false;
+		}
+
+		// The BVH is fixed up in place, so it needs its own aligned copy that lives as long as the mesh
+		result._bvhBuffer = btAlignedAlloc(bvhSize, 16);
+		memcpy(result._bvhBuffer, bvhData, bvhSize);
+		result._bvh = btOptimizedBvh::deSerializeInPlace(result._bvhBuffer, bvhSize, false);
+		if (result._bvh == nullptr) {
+			return false;
+		}
+
+		result._meshInterface = new btTriangleIndexVertexArray((int)(result.Indices.size() / 3), reinterpret_cast<int*>(result.Indices.data()), 3 * sizeof(uint32_t),
+			(int)result.Vertices.size(), &result.Vertices[0].x, sizeof(glm::vec3));
+		// Providing the AABB up front stops bullet from walking every triangle to calculate it
+		result._meshInterface->setPremadeAabb(btVector3(aabbMin.x, aabbMin.y, aabbMin.z), btVector3(aabbMax.x, aabbMax.y, aabbMax.z));
+
+		result._shape = new btBvhTriangleMeshShape(result._meshInterface, true, false);
+		result._shape->setOptimizedBvh(result._bvh);
+		return true;
+	}
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/MeshResource.h"
+
+// bullet pre-declarations
+class btCollisionShape;
+class btTriangleIndexVertexArray;
+class btBvhTriangleMeshShape;
+class btOptimizedBvh;
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// A simplified convex hull cooked from a mesh. Shared between all colliders that use
+	/// the same mesh and vertex limit, each collider creates its own btConvexHullShape from it
+	/// </summary>
+	class CookedConvexHull {
+	public:
+		typedef std::shared_ptr<CookedConvexHull> Sptr;
+
+		/// <summary>
+		/// The points on the hull, in mesh space
+		/// </summary>
+		std::vector<glm::vec3> Points;
+
+		/// <summary>
+		/// Creates a new btConvexHullShape from the cooked points
+		/// </summary>
+		/// <returns>A shape allocated with new, owned by the caller</returns>
+		btCollisionShape* CreateShape() const;
+	};
+
+	/// <summary>
+	/// A triangle mesh with a quantized BVH cooked from a mesh, for static level geometry.
+	/// The mesh data, BVH and btBvhTriangleMeshShape are shared between all colliders that
+	/// use the same mesh, colliders only ever create a lightweight scaled wrapper around it
+	/// </summary>
+	class CookedTriangleMesh {
+	public:
+		typedef std::shared_ptr<CookedTriangleMesh> Sptr;
+
+		CookedTriangleMesh();
+		~CookedTriangleMesh();
+
+		CookedTriangleMesh(const CookedTriangleMesh& other) = delete;
+		CookedTriangleMesh& operator=(const CookedTriangleMesh& other) = delete;
+
+		/// <summary>
+		/// The vertex positions, in mesh space
+		/// </summary>
+		std::vector<glm::vec3> Vertices;
+		/// <summary>
+		/// The triangle list indices
+		/// </summary>
+		std::vector<uint32_t>  Indices;
+
+		/// <summary>
+		/// Creates a new btScaledBvhTriangleMeshShape that wraps the shared BVH shape, so
+		/// that the owning body can scale it without rebuilding the BVH
+		/// </summary>
+		/// <returns>A shape allocated with new, owned by the caller</returns>
+		btCollisionShape* CreateShape() const;
+
+	private:
+		friend class CollisionCooker;
+
+		btTriangleIndexVertexArray* _meshInterface;
+		btBvhTriangleMeshShape*     _shape;
+		btOptimizedBvh*             _bvh;
+		// The BVH is deserialized in place, so this is the memory that _bvh lives in
+		void*                       _bvhBuffer;
+	};
+
+	/// <summary>
+	/// Cooks mesh resources into collision shapes, so that colliders never need to read back
+	/// mesh data from the GPU. Cooked results are cached on disk in the mesh cache directory
+	/// (keyed by the mesh's source and the cook settings) and in memory, so each shape is
+	/// only cooked once and then shared between every collider that uses it.
+	///
+	/// Mesh files are keyed by their path and a hash of their contents, so edited meshes are
+	/// re-cooked the next time they're used
+	/// </summary>
+	class CollisionCooker {
+	public:
+		CollisionCooker() = delete;
+
+		/// <summary>
+		/// The range of hull vertex limits that Bullet can cook. HullLibrary needs at least
+		/// a tetrahedron, and btShapeHull samples at most 62 directions (42 unit sphere
+		/// points, plus up to 20 preferred penetration directions)
+		/// </summary>
+		static const int MIN_HULL_VERTICES;
+		static const int MAX_HULL_VERTICES;
+
+		/// <summary>
+		/// Gets or cooks a simplified convex hull for the given mesh. The hull is built
+		/// with btShapeHull, then reduced further if it has more than maxVertices points
+		/// </summary>
+		/// <param name="mesh">The mesh to cook, should be the collider mesh if one exists</param>
+		/// <param name="maxVertices">The maximum number of points in the hull, clamped to [MIN_HULL_VERTICES, MAX_HULL_VERTICES]</param>
+		/// <returns>The cooked hull, or nullptr if the mesh has no geometry we can read</returns>
+		static CookedConvexHull::Sptr CookConvexHull(const MeshResource::Sptr& mesh, int maxVertices);
+
+		/// <summary>
+		/// Gets or cooks a BVH triangle mesh for the given mesh
+		/// </summary>
+		/// <param name="mesh">The mesh to cook, should be the collider mesh if one exists</param>
+		/// <returns>The cooked mesh, or nullptr if the mesh has no geometry we can read</returns>
+		static CookedTriangleMesh::Sptr CookTriangleMesh(const MeshResource::Sptr& mesh);
+
+	protected:
+		// Bump this when the cooked output changes to invalidate old cache files
+		static const uint32_t COOKED_VERSION;
+
+		// The type of data stored in a cooked file
+		enum class CookedType : uint32_t {
+			ConvexHull   = 1,
+			TriangleMesh = 2
+		};
+
+		// Header for cooked collision files, followed by the vertices, the indices and the serialized BVH
+		struct CookedHeader {
+			char       HeaderBytes[4] = { 'C', 'O', 'L', 'M' };
+			uint32_t   Version;
+			CookedType Type;
+			uint32_t   NumVertices;
+			uint32_t   NumIndices;
+			uint32_t   BvhSize;
+			glm::vec3  AabbMin;
+			glm::vec3  AabbMax;
+		};
+
+		static std::mutex _cacheMutex;
+		static std::unordered_map<uint64_t, std::weak_ptr<CookedConvexHull>>   _hulls;
+		static std::unordered_map<uint64_t, std::weak_ptr<CookedTriangleMesh>> _triangleMeshes;
+
+		// Hashes where the mesh comes from, so we can look up cooked data without parsing or cooking it
+		static uint64_t _HashSource(const MeshResource& mesh);
+		// Reads the positions and indices of a mesh on the CPU, from the file or the mesh builder params
+		static bool _ReadSource(const MeshResource& mesh, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices);
+		static std::string _GetCachePath(uint64_t hash, const char* extension);
+
+		static void _WriteCookedFile(const std::string& path, const CookedHeader& header, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices, const void* bvhData);
+		// Builds the runtime shape from the mesh data and a serialized BVH
+		static bool _InitTriangleMesh(CookedTriangleMesh& result, const glm::vec3& aabbMin, const glm::vec3& aabbMax, const void* bvhData, uint32_t bvhSize);
+	};
+}
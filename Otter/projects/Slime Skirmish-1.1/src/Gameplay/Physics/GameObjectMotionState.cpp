@@ -0,0 +1,25 @@
+#include "Gameplay/Physics/GameObjectMotionState.h"
+
+#include "Gameplay/GameObject.h"
+#include "Gameplay/Physics/RigidBody.h"
+
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	GameObjectMotionState::GameObjectMotionState(RigidBody* body) :
+		btMotionState(),
+		_body(body)
+	{ }
+
+	void GameObjectMotionState::getWorldTransform(btTransform& worldTrans) const {
+		GameObject* context = _body->GetGameObject();
+		worldTrans.setIdentity();
+		worldTrans.setOrigin(ToBt(context->GetPosition()));
+		worldTrans.setRotation(ToBt(context->GetRotation()));
+	}
+
+	void GameObjectMotionState::setWorldTransform(const btTransform& worldTrans) {
+		// Bullet only calls this for active bodies after a step
+		_body->_OnMovedByPhysics(worldTrans);
+	}
+}
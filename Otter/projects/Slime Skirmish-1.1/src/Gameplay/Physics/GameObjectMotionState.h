@@ -0,0 +1,24 @@
+#pragma once
+#include "LinearMath/btMotionState.h"
+
+namespace Gameplay::Physics {
+	class RigidBody;
+
+	/// <summary>
+	/// Connects a bullet rigid body directly to it's gameobject. Bullet reads the gameobject's
+	/// transform through this for kinematic bodies, and writes back to it after each step for
+	/// every dynamic body that is awake, so sleeping bodies cost nothing to sync
+	/// </summary>
+	class GameObjectMotionState : public btMotionState {
+	public:
+		GameObjectMotionState(RigidBody* body);
+		virtual ~GameObjectMotionState() = default;
+
+		// Inherited from btMotionState
+		virtual void getWorldTransform(btTransform& worldTrans) const override;
+		virtual void setWorldTransform(const btTransform& worldTrans) override;
+
+	protected:
+		RigidBody* _body;
+	};
+}
@@ -14,6 +14,7 @@
 #include "Gameplay/Physics/Colliders/ConeCollider.h"
 #include "Gameplay/Physics/Colliders/CylinderCollider.h"
 #include "Gameplay/Physics/Colliders/ConvexMeshCollider.h"
+#include "Gameplay/Physics/Colliders/ConcaveMeshCollider.h"
 
 namespace Gameplay::Physics {
 	const char* ColliderTypeComboNames = "Plane\0Box\0Sphere\0Capsule\0Cone\0Cylinder\0Convex Mesh\0Concave Mesh\0Terrain\0";
@@ -79,6 +80,16 @@ namespace Gameplay::Physics {
 		return _guid;
 	}
 
+	ICollider::Sptr ICollider::Clone() const {
+		ICollider::Sptr result = _Copy();
+		// The copy got our shape pointer, it needs it's own or we'd both try to delete it. The
+		// body it's added to builds the new shape when it wakes up
+		result->_shape = nullptr;
+		result->_isDirty = false;
+		result->_guid = Guid::New();
+		return result;
+	}
+
 	ICollider::Sptr ICollider::Create(ColliderType type) {
 		switch (type)
 		{
@@ -89,7 +100,7 @@ namespace Gameplay::Physics {
 			case ColliderType::Cone:        return ConeCollider::Create();
 			case ColliderType::Cylinder:    return CylinderCollider::Create();
 			case ColliderType::ConvexMesh:  return ConvexMeshCollider::Create();
-			case ColliderType::ConcaveMesh: throw std::runtime_error("Collider type not supported!"); return nullptr;
+			case ColliderType::ConcaveMesh: return ConcaveMeshCollider::Create();
 			case ColliderType::Terrain:     throw std::runtime_error("Collider type not supported!"); return nullptr;
 			case ColliderType::Unknown:
 			default:
@@ -28,7 +28,7 @@ ENUM(ColliderType, int,
 	 Cylinder  = 6,
 	 // Convex meshes have no inward faces, ie no caves
 	 ConvexMesh = 7,
-	 // Concave meshes can have inward faces (NOT IMPLEMENTED)
+	 // Concave meshes can have inward faces, only supported on static and kinematic bodies
 	 ConcaveMesh = 8,
 	 // Used for creating terrain colliders,
 	 // much more complex than the other colliders (NOT IMPLEMENTED)
@@ -133,6 +133,12 @@ namespace Gameplay::Physics {
 		/// </summary>
 		Guid GetGUID() const;
 
+		/// <summary>
+		/// Makes a copy of this collider's settings with a new GUID. The copy does not
+		/// share our bullet shape, it will make it's own when it's added to a body
+		/// </summary>
+		ICollider::Sptr Clone() const;
+
 		/// <summary>
 		/// Helper function to create a collider based on the given
 		/// collider type
@@ -155,6 +161,8 @@ namespace Gameplay::Physics {
 		/// </summary>
 		/// <returns>A btCollisionShape allocated with new</returns>
 		virtual btCollisionShape* CreateShape() const = 0;
+		// Copies the derived collider's settings, see Clone
+		virtual ICollider::Sptr _Copy() const = 0;
 
 	private:
 		// Allow RigidBody to access protected and private members
@@ -17,7 +17,9 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		_isShapeDirty(true),
 		_collisionGroup(0x01),
 		_collisionMask(0xFFFFFFFF),
-		_prevScale(glm::vec3(1.0f))
+		_isSimulated(true),
+		_prevScale(glm::vec3(1.0f)),
+		_syncedTransformVersion(0)
 	{ }
 
 	PhysicsBase::~PhysicsBase() {
@@ -137,6 +139,23 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		return _collisionMask;
 	}
 
+	bool PhysicsBase::IsSimulated() const {
+		return _isSimulated;
+	}
+
+	void PhysicsBase::_CopyBaseFrom(const PhysicsBase& other) {
+		_collisionGroup = other._collisionGroup;
+		_collisionMask  = other._collisionMask;
+		_isSimulated    = other._isSimulated;
+
+		// Cooked meshes are shared, so copying colliders is cheap, the shapes are built on awake
+		_colliders.reserve(other._colliders.size());
+		for (auto& collider : other._colliders) {
+			_colliders.push_back(collider->Clone());
+		}
+		_isShapeDirty = true;
+	}
+
 	ICollider::Sptr PhysicsBase::AddCollider(const ICollider::Sptr& collider) {
 		if (_scene != nullptr) {
 			collider->Awake(GetGameObject());
@@ -204,8 +223,9 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 	}
 
 	bool PhysicsBase::_HandleGroupDirty() {
-		// If the group or mask have changed, notify bullet
-		if (_isGroupMaskDirty) {
+		// If the group or mask have changed, notify bullet. Objects that aren't in the world
+		// have no proxy, they get the new values when they are added back in
+		if (_isGroupMaskDirty && _GetBroadphaseHandle() != nullptr) {
 			_GetBroadphaseHandle()->m_collisionFilterGroup = _collisionGroup;
 			_GetBroadphaseHandle()->m_collisionFilterMask  = _collisionMask;
 
@@ -225,7 +245,9 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		transform.setRotation(ToBt(context->GetRotation()));
 		if (context->GetScale() != _prevScale) {
 			_shape->setLocalScaling(ToBt(context->GetScale()));
-			_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
+			if (_GetBroadphaseHandle() != nullptr) {
+				_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
+			}
 			_prevScale = context->GetScale();
 		}
 	}
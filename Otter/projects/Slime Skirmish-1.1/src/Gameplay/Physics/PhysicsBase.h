@@ -69,6 +69,19 @@ namespace Gameplay {
 			/// <param name="collider">The collider to remove</param>
 			void RemoveCollider(const ICollider::Sptr& collider);
 
+			/// <summary>
+			/// Takes the object out of the physics world, or puts it back in. The shape and
+			/// bullet object are kept, so this is cheap enough to do every time an object is
+			/// parked (ex: by an object pool). Objects that aren't simulated don't collide
+			/// with or trigger anything
+			/// </summary>
+			/// <param name="simulated">True to add the object to the world, false to remove it</param>
+			virtual void SetSimulated(bool simulated) = 0;
+			/// <summary>
+			/// Returns true if this object is in the physics world, see SetSimulated
+			/// </summary>
+			bool IsSimulated() const;
+
 
 			/// <summary>
 			/// Invoked for each RigidBody before the physics world is stepped forward a frame,
@@ -101,7 +114,13 @@ namespace Gameplay {
 			int _collisionMask;
 			mutable bool _isGroupMaskDirty;
 
+			// Whether the object should be in the physics world, objects that are created while
+			// not simulated are only added once SetSimulated(true) is called
+			bool _isSimulated;
+
 			glm::vec3 _prevScale;
+			// The gameobject's transform version when we last synced with bullet, see GameObject::GetTransformVersion
+			uint32_t  _syncedTransformVersion;
 
 			PhysicsBase();
 
@@ -109,6 +128,8 @@ namespace Gameplay {
 
 			void ToJsonBase(nlohmann::json& output) const;
 			void FromJsonBase(const nlohmann::json& input);
+			// Copies the group, mask and colliders from another object, for Clone
+			void _CopyBaseFrom(const PhysicsBase& other);
 
 			// Handles adding a collider to our compound shape
 			void _AddColliderToShape(ICollider* collider);
@@ -2,14 +2,18 @@
 
 #include <algorithm>
 #include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/quaternion.hpp>
 
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Scene.h"
+#include "Gameplay/Physics/GameObjectMotionState.h"
 
 // Utils
 #include "Utils/ImGuiHelper.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/GlmBulletConversions.h"
+#include "Utils/GlmDefines.h"
 
 namespace Gameplay::Physics {
 	RigidBody::RigidBody(RigidBodyType type) :
@@ -27,13 +31,22 @@ namespace Gameplay::Physics {
 		_angularVelocity(btVector3(0, 0, 0)),
 		_angularVelocityDirty(false),
 		_angularFactor(btVector3(1,1,1)),
-		_angularFactorDirty(false)
+		_angularFactorDirty(false),
+		_prevPosition(glm::vec3(0.0f)),
+		_prevRotation(glm::quat(glm::vec3(0.0f))),
+		_currPosition(glm::vec3(0.0f)),
+		_currRotation(glm::quat(glm::vec3(0.0f))),
+		_movedThisStep(false),
+		_isBlending(false)
 	{ }
 
 	RigidBody::~RigidBody() {
 		if (_body != nullptr) {
 			// Remove from the physics world
-			_scene->GetPhysicsWorld()->removeRigidBody(_body);
+			_scene->GetTriggerManager().Unregister(_body);
+			if (_isSimulated) {
+				_scene->GetPhysicsWorld()->removeRigidBody(_body);
+			}
 
 			// Clean up all our memory
 			delete _motionState;
@@ -101,26 +114,33 @@ namespace Gameplay::Physics {
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce) {
+		// Bullet doesn't wake bodies up for forces, so a sleeping body would ignore them
+		_body->activate();
 		_body->applyCentralForce(ToBt(worldForce));
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce, const glm::vec3& localOffset) {
+		_body->activate();
 		_body->applyForce(ToBt(worldForce), ToBt(localOffset));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce) {
+		_body->activate();
 		_body->applyCentralImpulse(ToBt(worldForce));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce, const glm::vec3& localOffset) {
+		_body->activate();
 		_body->applyImpulse(ToBt(worldForce), ToBt(localOffset));
 	}
 
 	void RigidBody::ApplyTorque(const glm::vec3& worldTorque) {
+		_body->activate();
 		_body->applyTorque(ToBt(worldTorque));
 	}
 
 	void RigidBody::ApplyTorqueImpulse(const glm::vec3& worldTorque) {
+		_body->activate();
 		_body->applyTorqueImpulse(ToBt(worldTorque));
 	}
 
@@ -144,6 +164,9 @@ namespace Gameplay::Physics {
 				_body->setCollisionFlags(flags);
 				_body->setGravity(_scene->GetPhysicsWorld()->getGravity());
 			}
+			// Trigger volumes filter on our type
+			_body->setUserIndex3(*_type);
+			_body->activate(true);
 		}
 	}
 
@@ -151,34 +174,126 @@ namespace Gameplay::Physics {
 		return _type;
 	}
 
+	bool RigidBody::IsSleeping() const {
+		return _body != nullptr && !_body->isActive();
+	}
+
+	void RigidBody::WakeUp() {
+		if (_body != nullptr) {
+			_body->activate(true);
+		}
+	}
+
+	void RigidBody::SetSimulated(bool simulated) {
+		if (simulated == _isSimulated) {
+			return;
+		}
+		_isSimulated = simulated;
+
+		// Not awake yet, Awake will check the flag
+		if (_body == nullptr) {
+			return;
+		}
+
+		if (simulated) {
+			_scene->GetPhysicsWorld()->addRigidBody(_body, _collisionGroup, _collisionMask);
+			_isGroupMaskDirty = false;
+			// Adding the body resets it's gravity, statics should never fall
+			if (_type == RigidBodyType::Static) {
+				_body->setGravity(btVector3(0.0f, 0.0f, 0.0f));
+			}
+			_body->activate(true);
+		} else {
+			_scene->GetPhysicsWorld()->removeRigidBody(_body);
+		}
+	}
+
 	void RigidBody::PhysicsPreStep(float dt) {
 		// Update any dirty state that may have changed
 		_HandleStateDirty();
 
-		if (_type != RigidBodyType::Static) {		
+		// Only send our transform to bullet if something other than physics has moved us
+		GameObject* context = GetGameObject();
+		if (context->GetTransformVersion() != _syncedTransformVersion) {
 			btTransform transform;
 			_CopyGameobjectTransformTo(transform);
+			_body->setWorldTransform(transform);
 
-			// Copy to body and to it's motion state
+			// Kinematics work out their velocity from where they were last step, anything
+			// else has been teleported and shouldn't sweep from the old spot
+			if (_type != RigidBodyType::Kinematic) {
+				_body->setInterpolationWorldTransform(transform);
+			}
+			// Snap instead of blending from the old spot
 			if (_type == RigidBodyType::Dynamic) {
-				_body->setWorldTransform(transform);
-			} else {
-				// Kinematics prefer to be driven my motion state for some reason :|
-				_body->getMotionState()->setWorldTransform(transform);
+				_prevPosition = _currPosition = context->GetPosition();
+				_prevRotation = _currRotation = context->GetRotation();
 			}
+
+			// Kinematics read their transform from the motion state, but only while they're awake
+			_body->activate(true);
+			_syncedTransformVersion = context->GetTransformVersion();
 		}
 	}
 
 	void RigidBody::PhysicsPostStep(float dt) {
-		// Kinematics are driven externally and statics don't move, so only need to get data out for dynamics!
-		if (_type == RigidBodyType::Dynamic) {
-			btTransform transform = _body->getWorldTransform();
-			_CopyGameobjectTransformFrom(transform);
+		// Dynamic bodies that moved have already been synced by the motion state, a body that
+		// didn't is asleep, so there's nothing left to blend between
+		if (_type == RigidBodyType::Dynamic && !_movedThisStep) {
+			_prevPosition = _currPosition;
+			_prevRotation = _currRotation;
+		}
+		_movedThisStep = false;
+	}
+
+	void RigidBody::_OnMovedByPhysics(const btTransform& transform) {
+		_CopyGameobjectTransformFrom(transform);
+
+		// This move came from bullet, so it doesn't need to be sent back next step
+		GameObject* context = GetGameObject();
+		_syncedTransformVersion = context->GetTransformVersion();
+
+		_prevPosition = _currPosition;
+		_prevRotation = _currRotation;
+		_currPosition = context->GetPosition();
+		_currRotation = context->GetRotation();
+
+		// Store a copy of our velocities
+		_linearVelocity = _body->getLinearVelocity();
+		_angularVelocity = _body->getAngularVelocity();
+		_movedThisStep = true;
+	}
+
+	void RigidBody::InterpolateRenderTransform(float alpha) {
+		if (_type != RigidBodyType::Dynamic) {
+			return;
+		}
+
+		GameObject* context = GetGameObject();
 
-			// Store a copy of our velocities
-			_linearVelocity = _body->getLinearVelocity();
-			_angularVelocity = _body->getAngularVelocity();
+		// Moved directly on a frame without a physics step, PhysicsPreStep hasn't seen it yet so
+		// snap to the new spot now instead of drawing the blend between the old steps
+		if (context->GetTransformVersion() != _syncedTransformVersion) {
+			_prevPosition = _currPosition = context->GetPosition();
+			_prevRotation = _currRotation = context->GetRotation();
 		}
+
+		// At rest, so the regular transform is already where we want to draw
+		if (_prevPosition == _currPosition && _prevRotation == _currRotation) {
+			if (_isBlending) {
+				context->ClearRenderTransform();
+				_isBlending = false;
+			}
+			return;
+		}
+
+		glm::mat4 transform = glm::translate(MAT4_IDENTITY, glm::mix(_prevPosition, _currPosition, alpha));
+		transform *= glm::mat4_cast(glm::slerp(_prevRotation, _currRotation, alpha));
+		transform = glm::scale(transform, context->GetScale());
+
+		GameObject::Sptr parent = context->GetParent();
+		context->SetRenderTransform(parent != nullptr ? parent->GetTransform() * transform : transform);
+		_isBlending = true;
 	}
 
 	void RigidBody::Awake() {
@@ -204,22 +319,21 @@ namespace Gameplay::Physics {
 		_shape->calculateLocalInertia(_mass, _inertia);
 		_isMassDirty = false;
 
-		// Create a default motion state instance for tracking the bodies motion
-		_motionState = new btDefaultMotionState();
-
-		// Get the object's starting transform, create a bullet representation for it
-		btTransform transform; 
-		transform.setIdentity();
-		transform.setOrigin(ToBt(context->GetPosition()));
-		transform.setRotation(ToBt(context->GetRotation()));
-		_motionState->setWorldTransform(transform);
+		// Our motion state hands bullet the object's starting transform, and tracks the bodies motion
+		_motionState = new GameObjectMotionState(this);
+		_syncedTransformVersion = context->GetTransformVersion();
+		_prevPosition = _currPosition = context->GetPosition();
+		_prevRotation = _currRotation = context->GetRotation();
 
 		// Create the bullet rigidbody and add it to the physics scene
 		_body = new btRigidBody(_mass, _motionState, _shape, _inertia);
 		// Add a pointer to our own weak reference to allow getting this component as a shared_ptr later
 		_body->setUserPointer(&SelfRef());
 
-		_scene->GetPhysicsWorld()->addRigidBody(_body);
+		if (_isSimulated) {
+			_scene->GetPhysicsWorld()->addRigidBody(_body, _collisionGroup, _collisionMask);
+		}
+		_isGroupMaskDirty = false;
 
 		// If the object is kinematic (driven by a controller), tell bullet that
 		if (_type == RigidBodyType::Kinematic) {
@@ -230,12 +344,10 @@ namespace Gameplay::Physics {
 			_body->setGravity(btVector3(0.0f, 0.0f, 0.0f));
 			_body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
 		}
-	
-		_body->setActivationState(DISABLE_DEACTIVATION);
 
-		// Copy over group and mask info
-		_body->getBroadphaseProxy()->m_collisionFilterGroup = _collisionGroup;
-		_body->getBroadphaseProxy()->m_collisionFilterMask  = _collisionMask;
+		// Let trigger volumes know about us
+		_body->setUserIndex3(*_type);
+		_scene->GetTriggerManager().RegisterBody(_body, SelfRef());
 	}
 
 	void RigidBody::RenderImGui()
@@ -268,18 +380,32 @@ namespace Gameplay::Physics {
 		return result;
 	}
 
+	IComponent::Sptr RigidBody::Clone() const {
+		RigidBody::Sptr result = std::make_shared<RigidBody>(_type);
+		result->_CopyBaseFrom(*this);
+		result->_mass = _mass;
+		result->_linearDamping  = _linearDamping;
+		result->_angularDamping = _angularDamping;
+		result->_isDampingDirty = true;
+		result->_angularFactor  = _angularFactor;
+		result->_angularFactorDirty = true;
+		return result;
+	}
+
 	void RigidBody::_HandleStateDirty() {
 		// Only dynamic bodies have velocities
 		if (_type == RigidBodyType::Dynamic) {
-			// If outside code has changed our velocity, send that to Bullet
+			// If outside code has changed our velocity, send that to Bullet and make sure we're awake to use it
 			if (_linearVelocityDirty) {
 				_body->setLinearVelocity(_linearVelocity);
+				_body->activate();
 				_linearVelocityDirty = false;
 			}
 
 			// If outside code has changed our angular velocity, send that to Bullet
 			if (_angularVelocityDirty) {
 				_body->setAngularVelocity(_angularVelocity);
+				_body->activate();
 				_angularVelocityDirty = false;
 			}
 
@@ -309,6 +435,7 @@ namespace Gameplay::Physics {
 				// Recalulcate our inertia properties and send to bullet
 				_shape->calculateLocalInertia(_mass, _inertia);
 				_body->setMassProps(_mass, _inertia);
+				_body->activate();
 			}
 			_isMassDirty = false;
 		}
@@ -24,9 +24,15 @@ ENUM(RigidBodyType, int,
 namespace Gameplay { class Scene; }
 
 namespace Gameplay::Physics {
+	class GameObjectMotionState;
+
 	/// <summary>
 	/// A rigid body is a static, kinematic, or dynamic body that represents a collision object
 	/// within our physics scene
+	///
+	/// Bodies are allowed to sleep once they come to rest. A sleeping body is woken by bullet
+	/// when something touches it, and by us whenever the gameobject is moved or the body's
+	/// velocity is changed or a force is applied to it
 	/// </summary>
 	class RigidBody : public PhysicsBase {
 	public:
@@ -152,28 +158,51 @@ namespace Gameplay::Physics {
 		/// </summary>
 		RigidBodyType GetType() const;
 
+		/// <summary>
+		/// Returns true if bullet has put this body to sleep because it came to rest
+		/// </summary>
+		bool IsSleeping() const;
+		/// <summary>
+		/// Wakes the body up if it is sleeping, so that it will be simulated again
+		/// </summary>
+		void WakeUp();
+
+		virtual void SetSimulated(bool simulated) override;
+
 		/// <summary>
 		/// Invoked for each RigidBody before the physics world is stepped forward a frame,
-		/// handles body initialization, shape changes, mass changes, etc...
+		/// handles body initialization, shape changes, mass changes, etc... The gameobject's
+		/// transform is only sent to bullet if it has changed since the last step
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPreStep(float dt) override;
 		/// <summary>
-		/// Invoked for each RigidBody after the physics world is stepped forward a frame,
-		/// handles copying transform to the OpenGL state
+		/// Invoked for each RigidBody after the physics world is stepped forward a frame. The
+		/// transform is copied to the gameobject by our motion state as bullet moves the body,
+		/// so this only has to settle the interpolation state for bodies that didn't move
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPostStep(float dt) override;
 
+		/// <summary>
+		/// Blends between the last two physics states of a dynamic body and hands the
+		/// result to the gameobject as it's render transform
+		/// </summary>
+		/// <param name="alpha">How far between the previous and current step to blend, in the 0-1 range</param>
+		void InterpolateRenderTransform(float alpha);
+
 		// Inherited from IComponent
 		virtual void Awake() override;
 		virtual void RenderImGui() override;
 		virtual nlohmann::json ToJson() const override;
 		static RigidBody::Sptr FromJson(const nlohmann::json& data);
+		virtual IComponent::Sptr Clone() const override;
 		MAKE_TYPENAME(RigidBody)
 
 
 	protected:
+		friend class GameObjectMotionState;
+
 		// The physics update mode for the body (static, dynamic, kinematic)
 		RigidBodyType _type;
 
@@ -198,8 +227,20 @@ namespace Gameplay::Physics {
 		btVector3        _angularFactor;
 		bool             _angularFactorDirty;
 
+		// The results of the last two physics steps, for render interpolation
+		glm::vec3        _prevPosition;
+		glm::quat        _prevRotation;
+		glm::vec3        _currPosition;
+		glm::quat        _currRotation;
+		// Whether bullet synced the body during the last step, which it does for every awake body
+		bool             _movedThisStep;
+		// Whether we've handed the gameobject a blended render transform
+		bool             _isBlending;
+
 		// Handles resolving any dirty state stuff for our object
 		void _HandleStateDirty();
+		// Invoked by our motion state when bullet syncs an awake body after a step
+		void _OnMovedByPhysics(const btTransform& transform);
 
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
 	};
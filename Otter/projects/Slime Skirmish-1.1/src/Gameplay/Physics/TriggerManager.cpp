@@ -0,0 +1,132 @@
+#include "Gameplay/Physics/TriggerManager.h"
+#include <algorithm>
+#include <iterator>
+
+#include <btBulletCollisionCommon.h>
+
+#include "Gameplay/GameObject.h"
+#include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/RigidBody.h"
+
+namespace Gameplay::Physics {
+	TriggerManager::TriggerManager() :
+		_nextId(1),
+		_components(),
+		_currentPairs(),
+		_nextPairs(),
+		_entered(),
+		_left()
+	{ }
+
+	void TriggerManager::RegisterBody(btCollisionObject* object, const std::weak_ptr<IComponent>& component) {
+		_Register(object, component, TagBody);
+	}
+
+	void TriggerManager::RegisterTrigger(btCollisionObject* object, const std::weak_ptr<IComponent>& component) {
+		_Register(object, component, TagTrigger);
+	}
+
+	void TriggerManager::Unregister(btCollisionObject* object) {
+		// Any pairs with this object will drop out on the next update, but without a component
+		// left to hand to the callbacks, so no leave events are sent for it
+		_components.erase(object->getUserIndex());
+		object->setUserIndex(-1);
+		object->setUserIndex2(-1);
+	}
+
+	void TriggerManager::Update(btDispatcher* dispatcher) {
+		// Bullet has already found contacts for every pair during the step, so we just need to
+		// pick out the ones between a trigger and a body
+		_nextPairs.clear();
+		const int numManifolds = dispatcher->getNumManifolds();
+		for (int ix = 0; ix < numManifolds; ix++) {
+			const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(ix);
+			if (manifold->getNumContacts() == 0) {
+				continue;
+			}
+
+			const btCollisionObject* trigger = manifold->getBody0();
+			const btCollisionObject* body = manifold->getBody1();
+			if (trigger->getUserIndex2() != TagTrigger) {
+				std::swap(trigger, body);
+			}
+			if (trigger->getUserIndex2() != TagTrigger || body->getUserIndex2() != TagBody || !_PassesFilter(trigger, body)) {
+				continue;
+			}
+
+			_nextPairs.push_back(((uint64_t)(uint32_t)trigger->getUserIndex() << 32) | (uint32_t)body->getUserIndex());
+		}
+
+		// Compound shapes can have several manifolds for the same pair
+		std::sort(_nextPairs.begin(), _nextPairs.end());
+		_nextPairs.erase(std::unique(_nextPairs.begin(), _nextPairs.end()), _nextPairs.end());
+
+		_entered.clear();
+		_left.clear();
+		std::set_difference(_nextPairs.begin(), _nextPairs.end(), _currentPairs.begin(), _currentPairs.end(), std::back_inserter(_entered));
+		std::set_difference(_currentPairs.begin(), _currentPairs.end(), _nextPairs.begin(), _nextPairs.end(), std::back_inserter(_left));
+		_currentPairs.swap(_nextPairs);
+
+		// Callbacks can add or remove objects, so the sets need to be settled before we send anything
+		for (uint64_t pair : _left) {
+			_Dispatch(pair, false);
+		}
+		for (uint64_t pair : _entered) {
+			_Dispatch(pair, true);
+		}
+	}
+
+	size_t TriggerManager::GetOverlapCount() const {
+		return _currentPairs.size();
+	}
+
+	int TriggerManager::_Register(btCollisionObject* object, const std::weak_ptr<IComponent>& component, Tag tag) {
+		const int id = _nextId++;
+		object->setUserIndex(id);
+		object->setUserIndex2(tag);
+		_components[id] = component;
+		return id;
+	}
+
+	bool TriggerManager::_PassesFilter(const btCollisionObject* trigger, const btCollisionObject* body) {
+		// The broadphase already checks this both ways, but the trigger's mask may have been
+		// changed since the pair was made
+		if ((body->getBroadphaseHandle()->m_collisionFilterGroup & trigger->getBroadphaseHandle()->m_collisionFilterMask) == 0) {
+			return false;
+		}
+
+		// Dynamic bodies are always reported, statics and kinematics only if the trigger asks for them
+		const int flags = trigger->getUserIndex3();
+		switch ((RigidBodyType)body->getUserIndex3()) {
+			case RigidBodyType::Static:
+				return (flags & *TriggerTypeFlags::Statics) != 0;
+			case RigidBodyType::Kinematic:
+				return (flags & *TriggerTypeFlags::Kinematics) != 0;
+			default:
+				return true;
+		}
+	}
+
+	void TriggerManager::_Dispatch(uint64_t pair, bool entered) {
+		auto triggerIt = _components.find((int)(pair >> 32));
+		auto bodyIt = _components.find((int)(pair & 0xFFFFFFFF));
+		if (triggerIt == _components.end() || bodyIt == _components.end()) {
+			return;
+		}
+
+		TriggerVolume::Sptr trigger = std::static_pointer_cast<TriggerVolume>(triggerIt->second.lock());
+		RigidBody::Sptr body = std::static_pointer_cast<RigidBody>(bodyIt->second.lock());
+		// Objects don't trigger their own volumes
+		if (trigger == nullptr || body == nullptr || trigger->GetGameObject() == body->GetGameObject()) {
+			return;
+		}
+
+		if (entered) {
+			body->GetGameObject()->OnEnteredTrigger(trigger);
+			trigger->GetGameObject()->OnTriggerVolumeEntered(body);
+		} else {
+			body->GetGameObject()->OnLeavingTrigger(trigger);
+			trigger->GetGameObject()->OnTriggerVolumeLeaving(body);
+		}
+	}
+}
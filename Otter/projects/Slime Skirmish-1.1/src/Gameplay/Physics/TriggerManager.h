@@ -0,0 +1,86 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+class btCollisionObject;
+class btDispatcher;
+
+namespace Gameplay {
+	class IComponent;
+}
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Tracks which rigid bodies are inside which trigger volumes for a whole physics world.
+	///
+	/// After each step, the overlaps are gathered in a single pass over the contact manifolds
+	/// that bullet already built during the step, and stored as a sorted set of (trigger, body)
+	/// ID pairs. Enter and leave events are then just the set difference against the previous
+	/// step's pairs, so the cost of dispatching events scales with the number of overlaps that
+	/// changed, instead of the number of triggers times the number of overlaps.
+	///
+	/// Collision objects are tagged with their ID in the user index, whether they are a trigger or
+	/// a body in the second user index, and their TriggerTypeFlags or RigidBodyType in the third
+	/// </summary>
+	class TriggerManager {
+	public:
+		TriggerManager();
+
+		TriggerManager(const TriggerManager& other) = delete;
+		TriggerManager& operator=(const TriggerManager& other) = delete;
+
+		/// <summary>
+		/// Starts tracking a rigid body, should be called once its bullet object has been created
+		/// </summary>
+		/// <param name="object">The bullet object for the body</param>
+		/// <param name="component">The RigidBody component that owns the object</param>
+		void RegisterBody(btCollisionObject* object, const std::weak_ptr<IComponent>& component);
+		/// <summary>
+		/// Starts tracking a trigger volume, should be called once its bullet object has been created
+		/// </summary>
+		/// <param name="object">The bullet object for the trigger</param>
+		/// <param name="component">The TriggerVolume component that owns the object</param>
+		void RegisterTrigger(btCollisionObject* object, const std::weak_ptr<IComponent>& component);
+		/// <summary>
+		/// Stops tracking a body or trigger, should be called before its bullet object is destroyed
+		/// </summary>
+		void Unregister(btCollisionObject* object);
+
+		/// <summary>
+		/// Gathers this step's overlaps from the dispatcher's contact manifolds, and invokes the
+		/// trigger callbacks for anything that has entered or left a trigger since the last step
+		/// </summary>
+		/// <param name="dispatcher">The dispatcher of the world that was just stepped</param>
+		void Update(btDispatcher* dispatcher);
+
+		/// <summary>
+		/// Gets the number of body-trigger overlaps as of the last update
+		/// </summary>
+		size_t GetOverlapCount() const;
+
+	protected:
+		// What kind of object we registered, stored in the bullet object's second user index
+		enum Tag {
+			TagBody    = 1,
+			TagTrigger = 2
+		};
+
+		int _nextId;
+		std::unordered_map<int, std::weak_ptr<IComponent>> _components;
+
+		// Sorted (trigger ID << 32 | body ID) keys for the last step, and the one being built
+		std::vector<uint64_t> _currentPairs;
+		std::vector<uint64_t> _nextPairs;
+		// The changes between the two, kept around so we don't reallocate every step
+		std::vector<uint64_t> _entered;
+		std::vector<uint64_t> _left;
+
+		int _Register(btCollisionObject* object, const std::weak_ptr<IComponent>& component, Tag tag);
+		// Returns true if a trigger is interested in a body, based on the trigger's flags and mask
+		static bool _PassesFilter(const btCollisionObject* trigger, const btCollisionObject* body);
+		// Invokes the callbacks for one entered or left pair
+		void _Dispatch(uint64_t pair, bool entered);
+	};
+}
@@ -1,6 +1,6 @@
 #include "Gameplay/Physics/TriggerVolume.h"
 
-#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <btBulletCollisionCommon.h>
 
 #include "Utils/GlmBulletConversions.h"
 
@@ -18,7 +18,10 @@ namespace Gameplay::Physics {
 
 	TriggerVolume::~TriggerVolume() {
 		if (_ghost != nullptr) {
-			_scene->GetPhysicsWorld()->removeCollisionObject(_ghost);
+			_scene->GetTriggerManager().Unregister(_ghost);
+			if (_isSimulated) {
+				_scene->GetPhysicsWorld()->removeCollisionObject(_ghost);
+			}
 			delete _ghost;
 		}
 	}
@@ -28,113 +31,18 @@ namespace Gameplay::Physics {
 		_HandleShapeDirty();
 		_HandleGroupDirty();
 
-		// Copy our transform info from OpenGL
+		// Only send our transform to bullet if something has moved us since last time
 		GameObject* context = GetGameObject();
-		btTransform transform;
-		_CopyGameobjectTransformTo(transform);
-
-		_ghost->setWorldTransform(transform);
-	}
-
-	void TriggerVolume::PhysicsPostStep(float dt) {
-		// This will store all the objects inside the trigger this frame
-		std::vector<std::weak_ptr<RigidBody>> thisFrameCollision;
-
-		// Get all our collisions from from the world
-		_scene->GetPhysicsWorld()->getDispatcher()->dispatchAllCollisionPairs(_ghost->getOverlappingPairCache(), _scene->GetPhysicsWorld()->getDispatchInfo(), _scene->GetPhysicsWorld()->getDispatcher());
-		btBroadphasePairArray& collisionPairs = _ghost->getOverlappingPairCache()->getOverlappingPairArray();
-
-		// Determine how many objects are intersecting the volume
-		const int numObjects=collisionPairs.size();
-		thisFrameCollision.reserve(numObjects);
-
-		// Will store our contact manifolds, can be static to be shared between frames and instances
-		static btManifoldArray	m_manifoldArray;
-
-		// Iterate over all the objects that we're colliding with
-		for (int i = 0; i < numObjects; ++i) {
-			// resize the number of manifolds to zero for everything we collide with
-			m_manifoldArray.resize(0);
-
-			// Get the btCollisionObject that we're colliding with
-			btCollisionObject *obj = _ghost->getOverlappingObject(i);
-
-			// Get the contact pair and resolve contact manifolds
-			btBroadphasePair* pair = &collisionPairs[i];
-			if (pair != nullptr && pair->m_algorithm != nullptr) {
-				pair->m_algorithm->getAllContactManifolds(m_manifoldArray);
-			} else {
-				continue;
-			}
-
-			// Iterate over all the contact manifolds and check if any of them have contacts
-			bool hasCollision = false;
-			for (int j=0; j < m_manifoldArray.size(); j++) {
-				btPersistentManifold* manifold = m_manifoldArray[j];
-				if (manifold != nullptr && manifold->getNumContacts() > 0) {
-					hasCollision = true;
-					break;
-				}
-			}
-
-			// If we have contacts and the object's group matches our mask (since this isn't filtered for us)
-			if (hasCollision && (obj->getBroadphaseHandle()->m_collisionFilterGroup & _collisionMask)) {
-				// Make sure the internal type is a bullet rigid body (no trigger-trigger interactions)
-				if (obj->getInternalType() == btCollisionObject::CO_RIGID_BODY) {
-					// Get the collision object as a btRigidBody
-					const btRigidBody *body = (const btRigidBody *)obj;
-
-					// Make sure that the object is not a kinematic or static object (note: you may want
-					// to modify this behaviour depending on your game)
-					if ((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT & btCollisionObject::CF_KINEMATIC_OBJECT == 0) ||
-						((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT) == *(_typeFlags & TriggerTypeFlags::Statics)) ||
-						((body->getCollisionFlags() & btCollisionObject::CF_KINEMATIC_OBJECT) == *(_typeFlags & TriggerTypeFlags::Kinematics))) {
-
-						// Extract the weak pointer that we stored in all our rigidbody user pointers
-						std::weak_ptr<IComponent> rawPtr = *reinterpret_cast<std::weak_ptr<IComponent>*>(body->getUserPointer());
-						// Cast lock the raw pointer and cast up to a RigidBody
-						std::shared_ptr<RigidBody> physicsPtr = std::dynamic_pointer_cast<RigidBody>(rawPtr.lock());
-
-						// As long as we got a pointer out, we can proceed to try and invoke
-						if (physicsPtr != nullptr && physicsPtr->GetGameObject() != GetGameObject()) {
-							// Add the object to the known collisions for this frame
-							thisFrameCollision.push_back(physicsPtr);
-
-							// Check to see if the object has been added to our object cache
-							auto& it = std::find_if(_currentCollisions.begin(), _currentCollisions.end(), [&](const std::weak_ptr<RigidBody>& item) {
-								return item.lock() == physicsPtr;
-							});
-
-							// If the object is NOT in the cache, we invoke all the callbacks
-							if (it == _currentCollisions.end()) {
-								physicsPtr->GetGameObject()->OnEnteredTrigger(std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock()));
-								GetGameObject()->OnTriggerVolumeEntered(physicsPtr);
-							}
-						}
-					}
-				}
-
-			}
+		if (context->GetTransformVersion() != _syncedTransformVersion) {
+			btTransform transform;
+			_CopyGameobjectTransformTo(transform);
+			_ghost->setWorldTransform(transform);
+			_syncedTransformVersion = context->GetTransformVersion();
 		}
-	
-		// Compare our current frame list to the previous frame to see if anything has left
-		for (auto& weakPtr : _currentCollisions) {
-			// Search the the current list to see if the item still exists
-			auto& it = std::find_if(thisFrameCollision.begin(), thisFrameCollision.end(), [&](const std::weak_ptr<RigidBody>& item) {
-				return item.lock() == weakPtr.lock();
-			});
-
-			// If the item no longer exists in the list, we need to invoke exit callbacks
-			if (it == thisFrameCollision.end()) {
-				weakPtr.lock()->GetGameObject()->OnLeavingTrigger(std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock()));
-				GetGameObject()->OnTriggerVolumeLeaving(weakPtr.lock());
-			}
-		}
-
-		// Load the contents of the current collision items into the cache
-		_currentCollisions.swap(thisFrameCollision);
 	}
 
+	void TriggerVolume::PhysicsPostStep(float dt) { }
+
 	void TriggerVolume::Awake() {
 		GameObject* context = GetGameObject();
 		_scene = GetGameObject()->GetScene();
@@ -153,23 +61,49 @@ namespace Gameplay::Physics {
 			_AddColliderToShape(collider.get());
 		}
 
-		// Create the ghost object
-		_ghost = new btPairCachingGhostObject();
+		// Create the ghost object, it's never simulated so it must never sleep, or bullet would
+		// stop finding contacts between it and sleeping bodies
+		_ghost = new btCollisionObject();
 		_ghost->setCollisionShape(_shape);
 		_ghost->setUserPointer(&SelfRef());
 		_ghost->setCollisionFlags(_ghost->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+		_ghost->setActivationState(DISABLE_DEACTIVATION);
+		_ghost->setUserIndex3(*_typeFlags);
 
 		// Get the transform and send it to the ghost
 		btTransform transform;
 		_CopyGameobjectTransformTo(transform);
 		_ghost->setWorldTransform(transform);
+		_syncedTransformVersion = context->GetTransformVersion();
+
+		// Add the object to the scene, along with our group and mask info
+		if (_isSimulated) {
+			_scene->GetPhysicsWorld()->addCollisionObject(_ghost, _collisionGroup, _collisionMask);
+		}
+		_isGroupMaskDirty = false;
+
+		_scene->GetTriggerManager().RegisterTrigger(_ghost, SelfRef());
+	}
+
+	void TriggerVolume::SetSimulated(bool simulated) {
+		if (simulated == _isSimulated) {
+			return;
+		}
+		_isSimulated = simulated;
 
-		// Add the object to the scene
-		_scene->GetPhysicsWorld()->addCollisionObject(_ghost);
-		
-		// Copy over group and mask info
-		_ghost->getBroadphaseHandle()->m_collisionFilterGroup = _collisionGroup;
-		_ghost->getBroadphaseHandle()->m_collisionFilterMask  = _collisionMask;
+		// Not awake yet, Awake will check the flag
+		if (_ghost == nullptr) {
+			return;
+		}
+
+		// Removing the ghost drops all of it's pairs, so the trigger manager will send leave
+		// events for anything that was inside it
+		if (simulated) {
+			_scene->GetPhysicsWorld()->addCollisionObject(_ghost, _collisionGroup, _collisionMask);
+			_isGroupMaskDirty = false;
+		} else {
+			_scene->GetPhysicsWorld()->removeCollisionObject(_ghost);
+		}
 	}
 
 	void TriggerVolume::RenderImGui() {
@@ -182,6 +116,13 @@ namespace Gameplay::Physics {
 		return result;
 	}
 
+	IComponent::Sptr TriggerVolume::Clone() const {
+		TriggerVolume::Sptr result = std::make_shared<TriggerVolume>();
+		result->_CopyBaseFrom(*this);
+		result->_typeFlags = _typeFlags;
+		return result;
+	}
+
 	TriggerVolume::Sptr TriggerVolume::FromJson(const nlohmann::json& data) {
 		TriggerVolume::Sptr result = std::make_shared<TriggerVolume>();
 		result->FromJsonBase(data);
@@ -194,6 +135,9 @@ namespace Gameplay::Physics {
 
 	void TriggerVolume::SetFlags(TriggerTypeFlags flags) {
 		_typeFlags = flags;
+		if (_ghost != nullptr) {
+			_ghost->setUserIndex3(*_typeFlags);
+		}
 	}
 
 	Gameplay::Physics::TriggerTypeFlags TriggerVolume::GetFlags() const {
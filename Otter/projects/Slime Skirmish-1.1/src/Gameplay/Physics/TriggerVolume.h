@@ -4,7 +4,7 @@
 #include "Gameplay/Physics/RigidBody.h"
 #include "EnumToString.h"
 
-class btPairCachingGhostObject;
+class btCollisionObject;
 
 namespace Gameplay::Physics {
 
@@ -16,7 +16,8 @@ namespace Gameplay::Physics {
 
 	/// <summary>
 	/// A trigger volume defines a shape in 3D space that allows us to respond to rigid bodies
-	/// entering a volume in 3D space. Handles invoking Trigger events on gameobjects
+	/// entering a volume in 3D space. The scene's TriggerManager tracks the overlaps for all
+	/// trigger volumes at once, and invokes the Trigger events on gameobjects
 	/// </summary>
 	class TriggerVolume : public PhysicsBase {
 	public:
@@ -33,12 +34,13 @@ namespace Gameplay::Physics {
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPreStep(float dt) override;
 		/// <summary>
-		/// Invoked for each RigidBody after the physics world is stepped forward a frame,
-		/// handles copying transform to the OpenGL state
+		/// Nothing to do here, enter and leave events for all triggers are sent by the scene's TriggerManager
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPostStep(float dt) override;
 
+		virtual void SetSimulated(bool simulated) override;
+
 		void SetFlags(TriggerTypeFlags flags);
 		TriggerTypeFlags GetFlags() const;
 
@@ -48,14 +50,15 @@ namespace Gameplay::Physics {
 		virtual void RenderImGui() override;
 		virtual nlohmann::json ToJson() const override;
 		static TriggerVolume::Sptr FromJson(const nlohmann::json& data);
+		virtual IComponent::Sptr Clone() const override;
 		MAKE_TYPENAME(TriggerVolume);
 
 	protected:
-		btPairCachingGhostObject*   _ghost;
+		// A plain collision object with no contact response, the trigger manager finds our
+		// overlaps from the world's contacts so we don't need a ghost's pair cache
+		btCollisionObject*          _ghost;
 		TriggerTypeFlags            _typeFlags;
 
-		std::vector<std::weak_ptr<RigidBody>> _currentCollisions;
-
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
 
 	};
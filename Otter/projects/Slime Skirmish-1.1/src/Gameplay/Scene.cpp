@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include <locale>
 #include <codecvt>
+#include <algorithm>
 
 #include "Utils/FileHelpers.h"
 #include "Utils/GlmBulletConversions.h"
@@ -19,6 +20,7 @@ namespace Gameplay {
 	Scene::Scene() :
 		_objects(std::vector<GameObject::Sptr>()),
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
+		_deletionScratch(),
 		Lights(std::vector<Light>()),
 		IsPlaying(false),
 		MainCamera(nullptr),
@@ -29,7 +31,8 @@ namespace Gameplay {
 		_skyboxMesh(nullptr),
 		_skyboxTexture(nullptr),
 		_skyboxRotation(glm::mat3(1.0f)),
-		_gravity(glm::vec3(0.0f, 0.0f, -9.81f))
+		_gravity(glm::vec3(0.0f, 0.0f, -9.81f)),
+		_scheduler(_clock)
 	{
 		_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>();
 		_lightingUbo->GetData().AmbientCol = glm::vec3(0.1f);
@@ -37,10 +40,13 @@ namespace Gameplay {
 		_lightingUbo->Bind(LIGHT_UBO_BINDING_SLOT);
 
 		_InitPhysics();
+		_spatialQueries = std::make_unique<SpatialQueries>(this, _physicsWorld);
 
 	}
 
 	Scene::~Scene() {
+		// Tasks can hold on to objects, so get rid of them while the physics world is still around
+		_scheduler.CancelAll();
 		_objects.clear();
 		_CleanupPhysics();
 	}
@@ -49,6 +55,14 @@ namespace Gameplay {
 		_bulletDebugDraw->setDebugMode((btIDebugDraw::DebugDrawModes)mode);
 	}
 
+	Physics::TriggerManager& Scene::GetTriggerManager() {
+		return _triggerManager;
+	}
+
+	SpatialQueries& Scene::GetSpatialQueries() {
+		return *_spatialQueries;
+	}
+
 	void Scene::SetSkyboxShader(const std::shared_ptr<Shader>& shader) {
 		_skyboxShader = shader;
 	}
@@ -85,6 +99,15 @@ namespace Gameplay {
 		return result;
 	}
 
+	GameObject::Sptr Scene::AddGameObject(const GameObject::Sptr& object) {
+		LOG_ASSERT(object->_scene == nullptr, "Game object already belongs to a scene!");
+		object->_scene = this;
+		object->_parent.SceneContext = this;
+		object->_selfRef = object;
+		_objects.push_back(object);
+		return object;
+	}
+
 	void Scene::RemoveGameObject(const GameObject::Sptr& object) {
 		_deletionQueue.push_back(object);
 	}
@@ -137,27 +160,52 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
-		ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-			body->PhysicsPreStep(dt);
-		});
-		ComponentManager::Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-			body->PhysicsPreStep(dt);
-		});
-
-		if (IsPlaying) {
+		// When we're not playing, we still want bullet to know where things are for editing
+		if (!IsPlaying) {
+			ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+				body->PhysicsPreStep(dt);
+			});
+			ComponentManager::Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
+				body->PhysicsPreStep(dt);
+			});
+			return;
+		}
 
-			_physicsWorld->stepSimulation(dt, 15);
+		// Step the world at a fixed rate, no matter how long the frame was
+		const int steps = _clock.Accumulate(dt);
+		const float step = _clock.GetFixedTimestep();
+		for (int ix = 0; ix < steps; ix++) {
+			_clock.InvokeFixedTicks();
 
 			ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-				body->PhysicsPostStep(dt);
+				body->PhysicsPreStep(step);
 			});
 			ComponentManager::Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-				body->PhysicsPostStep(dt);
+				body->PhysicsPreStep(step);
 			});
-			if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
-				_physicsWorld->debugDrawWorld();
-				DebugDrawer::Get().FlushAll();
-			}
+
+			// We're doing our own fixed stepping, so bullet should take exactly one step
+			_physicsWorld->stepSimulation(step, 0);
+
+			ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+				body->PhysicsPostStep(step);
+			});
+			// Sends enter and leave events for every trigger volume at once
+			_triggerManager.Update(_collisionDispatcher);
+
+			// Wake up timers that are due, and tasks waiting on the triggers we just sent
+			_scheduler.Tick();
+		}
+
+		// Blend the bodies between their last two steps so motion is smooth at any frame rate
+		const float alpha = _clock.GetAlpha();
+		ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+			body->InterpolateRenderTransform(alpha);
+		});
+
+		if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
+			// Only queues the lines, they get drawn with the rest of the debug drawing once the scene is rendered
+			_physicsWorld->debugDrawWorld();
 		}
 	}
 
@@ -167,8 +215,12 @@ namespace Gameplay {
 			for (auto& obj : _objects) {
 				obj->Update(dt);
 			}
+			_clock.InvokeVariableTicks(dt);
+			_scheduler.Frame(dt);
 		}
 		_FlushDeleteQueue();
+		// Cheap, the rendered objects are only synced if something queries them
+		_spatialQueries->Invalidate();
 	}
 
 	void Scene::PreRender() {
@@ -221,6 +273,14 @@ namespace Gameplay {
 		return _physicsWorld;
 	}
 
+	SimulationClock& Scene::GetClock() {
+		return _clock;
+	}
+
+	Scheduler& Scene::GetScheduler() {
+		return _scheduler;
+	}
+
 	Scene::Sptr Scene::FromJson(const nlohmann::json& data)
 	{
 		Scene::Sptr result = std::make_shared<Scene>();
@@ -241,11 +301,7 @@ namespace Gameplay {
 		// Make sure the scene has objects, then load them all in!
 		LOG_ASSERT(data["objects"].is_array(), "Objects not present in scene!");
 		for (auto& object : data["objects"]) {
-			GameObject::Sptr obj = GameObject::FromJson(object);
-			obj->_scene = result.get();
-			obj->_parent.SceneContext = result.get();
-			obj->_selfRef = obj;
-			result->_objects.push_back(obj);
+			result->AddGameObject(GameObject::FromJson(object));
 		}
 
 		// Re-build the parent hierarchy 
@@ -330,10 +386,10 @@ namespace Gameplay {
 
 	void Scene::_InitPhysics() {
 		_collisionConfig = new btDefaultCollisionConfiguration();
-		_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
 		_broadphaseInterface = new btDbvtBroadphase();
 		_ghostCallback = new btGhostPairCallback();
 		_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
+		_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
 		_constraintSolver = new btSequentialImpulseConstraintSolver();
 		_physicsWorld = new btDiscreteDynamicsWorld(
 			_collisionDispatcher,
@@ -342,6 +398,8 @@ namespace Gameplay {
 			_collisionConfig
 		);
 		_physicsWorld->setGravity(ToBt(_gravity));
+		// Bodies are allowed to sleep, so only update the bounds of the ones that are awake
+		_physicsWorld->setForceUpdateAllAabbs(false);
 		// TODO bullet debug drawing
 		_bulletDebugDraw = new BulletDebugDraw();
 		_physicsWorld->setDebugDrawer(_bulletDebugDraw);
@@ -359,13 +417,24 @@ namespace Gameplay {
 
 
 	void Scene::_FlushDeleteQueue() {
+		if (_deletionQueue.empty()) {
+			return;
+		}
+
+		// Removing a whole wave at once would search and shift the object list once per object,
+		// so sort what's being removed and drop it all in a single pass instead
+		_deletionScratch.clear();
 		for (auto& weakPtr : _deletionQueue) {
-			if (weakPtr.expired()) continue;
-			auto& it = std::find(_objects.begin(), _objects.end(), weakPtr.lock());
-			if (it != _objects.end()) {
-				_objects.erase(it);
+			if (!weakPtr.expired()) {
+				_deletionScratch.push_back(weakPtr.lock().get());
 			}
 		}
+		std::sort(_deletionScratch.begin(), _deletionScratch.end());
+		_objects.erase(std::remove_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& object) {
+			return std::binary_search(_deletionScratch.begin(), _deletionScratch.end(), object.get());
+		}), _objects.end());
+
+		_deletionScratch.clear();
 		_deletionQueue.clear();
 	}
 
@@ -5,6 +5,10 @@
 #include "Gameplay/Components/Camera.h"
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Light.h"
+#include "Gameplay/SimulationClock.h"
+#include "Gameplay/Scheduler.h"
+#include "Gameplay/Physics/TriggerManager.h"
+#include "Gameplay/SpatialQueries.h"
 
 #include "Physics/BulletDebugDraw.h"
 
@@ -56,6 +60,16 @@ namespace Gameplay {
 
 		void SetPhysicsDebugDrawMode(BulletDebugMode mode);
 
+		/// <summary>
+		/// Gets the manager that sends trigger volume events for this scene's physics world
+		/// </summary>
+		Physics::TriggerManager& GetTriggerManager();
+
+		/// <summary>
+		/// Gets the batched raycast, sweep, overlap and nearest object queries for this scene
+		/// </summary>
+		SpatialQueries& GetSpatialQueries();
+
 		void SetSkyboxShader(const std::shared_ptr<Shader>& shader);
 		std::shared_ptr<Shader> GetSkyboxShader() const;
 
@@ -78,6 +92,13 @@ namespace Gameplay {
 		/// <returns>A new gameobject with the given name</returns>
 		GameObject::Sptr CreateGameObject(const std::string& name);
 
+		/// <summary>
+		/// Adds a game object that was loaded with GameObject::FromJson to this scene
+		/// </summary>
+		/// <param name="object">The loaded gameobject, must not already belong to a scene</param>
+		/// <returns>The object that was added</returns>
+		GameObject::Sptr AddGameObject(const GameObject::Sptr& object);
+
 		/// <summary>
 		/// Queues a game object for deletion at the call of the next Update function
 		/// </summary>
@@ -124,6 +145,10 @@ namespace Gameplay {
 		/// Performs physics updates for all physics bodies in this scene,
 		/// should be called after Update in the main loop
 		/// 
+		/// The frame time is split into fixed steps by the scene's clock, with fixed tick
+		/// callbacks invoked before each step. Dynamic bodies are then blended between their
+		/// last two steps for rendering, see GameObject::GetRenderTransform
+		/// 
 		/// Only invokes events if IsPlaying is true
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
@@ -131,7 +156,7 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Performs updates on all enabled components and gameobjects in the
-		/// scene
+		/// scene, then invokes the clock's variable tick callbacks
 		/// 
 		/// Only invokes events if IsPlaying is true
 		/// </summary>
@@ -173,6 +198,17 @@ namespace Gameplay {
 		/// </summary>
 		btDynamicsWorld* GetPhysicsWorld() const;
 
+		/// <summary>
+		/// Gets the clock that controls the fixed physics rate, and that gameplay
+		/// systems can register fixed or variable rate ticks with
+		/// </summary>
+		SimulationClock& GetClock();
+		/// <summary>
+		/// Gets the scheduler for delayed callbacks and gameplay tasks, which is ticked after
+		/// each physics step and each frame while the scene is playing
+		/// </summary>
+		Scheduler& GetScheduler();
+
 		/// <summary>
 		/// Loads a scene from a JSON blob
 		/// </summary>
@@ -214,6 +250,16 @@ namespace Gameplay {
 
 		BulletDebugDraw* _bulletDebugDraw;
 
+		// Tracks overlaps between trigger volumes and rigid bodies
+		Physics::TriggerManager _triggerManager;
+		// Answers spatial queries using bullet's broadphase and a tree of rendered objects
+		std::unique_ptr<SpatialQueries> _spatialQueries;
+
+		// Splits frames into fixed physics steps
+		SimulationClock _clock;
+		// Runs timers and tasks off of the clock's fixed steps
+		Scheduler       _scheduler;
+
 		// The path that we've saved or loaded this scene from
 		std::string             _filePath;
 
@@ -223,6 +269,8 @@ namespace Gameplay {
 		// Stores all the objects in our scene
 		std::vector<GameObject::Sptr>  _objects;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
+		// The objects being removed by a flush, kept around so flushing doesn't allocate
+		std::vector<GameObject*>                _deletionScratch;
 
 		// Info for rendering our skybox will be stored in the scene itself
 		std::shared_ptr<Shader>       _skyboxShader;
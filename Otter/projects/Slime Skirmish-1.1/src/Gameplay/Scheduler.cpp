@@ -0,0 +1,330 @@
+#include "Gameplay/Scheduler.h"
+#include <cmath>
+#include <algorithm>
+
+#include "Gameplay/SimulationClock.h"
+#include "Logging.h"
+
+namespace Gameplay {
+	Task::Task(Handle handle) :
+		_handle(handle)
+	{ }
+
+	Task::Task(Task&& other) noexcept :
+		_handle(other._handle)
+	{
+		other._handle = nullptr;
+	}
+
+	Task& Task::operator=(Task&& other) noexcept {
+		if (this != &other) {
+			if (_handle) {
+				_handle.destroy();
+			}
+			_handle = other._handle;
+			other._handle = nullptr;
+		}
+		return *this;
+	}
+
+	Task::~Task() {
+		if (_handle) {
+			_handle.destroy();
+		}
+	}
+
+	void Seconds::await_suspend(Task::Handle handle) const {
+		Scheduler* owner = handle.promise().Owner;
+		owner->_WaitTicks(handle.promise().Id, owner->SecondsToTicks(Duration));
+	}
+
+	void FrameAwaiter::await_suspend(Task::Handle handle) {
+		_owner = handle.promise().Owner;
+		_owner->_WaitFrame(handle.promise().Id);
+	}
+
+	float FrameAwaiter::await_resume() const noexcept {
+		return _owner->GetFrameTime();
+	}
+
+	void Signal::Awaiter::await_suspend(Task::Handle handle) const {
+		Source->_waiting.push_back({ handle.promise().Owner->_self, handle.promise().Id });
+	}
+
+	void Signal::Fire() {
+		for (const Waiter& waiter : _waiting) {
+			if (std::shared_ptr<Scheduler*> owner = waiter.Owner.lock()) {
+				(*owner)->_MakeReady(waiter.Task);
+			}
+		}
+		_waiting.clear();
+	}
+
+	size_t Signal::GetWaitingCount() const {
+		return _waiting.size();
+	}
+
+	Scheduler::Scheduler(const SimulationClock& clock) :
+		_clock(clock),
+		_self(std::make_shared<Scheduler*>(this)),
+		_now(0),
+		_frameTime(0.0f),
+		_entries(),
+		_freeEntries(),
+		_pendingCount(0),
+		_nextFrame(),
+		_ready(),
+		_timerScratch(),
+		_taskScratch()
+	{ }
+
+	Scheduler::~Scheduler() {
+		// Let go of our waiters in any signals that outlive us
+		_self.reset();
+		CancelAll();
+	}
+
+	Scheduler::TaskHandle Scheduler::Start(Task&& task) {
+		LOG_ASSERT(task._handle, "Task has already been started!");
+
+		Task::Handle coroutine = task._handle;
+		task._handle = nullptr;
+
+		TaskHandle handle = _Add(coroutine, nullptr);
+		coroutine.promise().Owner = this;
+		coroutine.promise().Id = handle;
+
+		_Resume(handle);
+		return IsPending(handle) ? handle : 0;
+	}
+
+	Scheduler::TaskHandle Scheduler::After(float seconds, const std::function<void()>& func) {
+		TaskHandle handle = _Add(nullptr, func);
+		_WaitTicks(handle, SecondsToTicks(seconds));
+		return handle;
+	}
+
+	void Scheduler::Cancel(TaskHandle handle) {
+		Entry* entry = _Get(handle);
+		if (entry == nullptr) {
+			return;
+		}
+
+		if (entry->Running) {
+			entry->Cancelled = true;
+			return;
+		}
+		if (entry->Coroutine) {
+			entry->Coroutine.destroy();
+		}
+		_Free((uint32_t)handle);
+	}
+
+	void Scheduler::CancelAll() {
+		for (uint32_t ix = 0; ix < _entries.size(); ix++) {
+			Entry& entry = _entries[ix];
+			if (entry.Alive && !entry.Running) {
+				if (entry.Coroutine) {
+					entry.Coroutine.destroy();
+				}
+				_Free(ix);
+			}
+		}
+	}
+
+	bool Scheduler::IsPending(TaskHandle handle) const {
+		return _Get(handle) != nullptr;
+	}
+
+	size_t Scheduler::GetPendingCount() const {
+		return _pendingCount;
+	}
+
+	uint64_t Scheduler::GetTickCount() const {
+		return _now;
+	}
+
+	float Scheduler::GetFrameTime() const {
+		return _frameTime;
+	}
+
+	uint64_t Scheduler::SecondsToTicks(float seconds) const {
+		// Knock a little off so that durations that are a whole number of steps don't round up an extra step
+		const float steps = std::ceil(seconds / _clock.GetFixedTimestep() - 0.001f);
+		return std::max(static_cast<uint64_t>(std::max(steps, 0.0f)), (uint64_t)1);
+	}
+
+	void Scheduler::Tick() {
+		_now++;
+
+		// Move timers down from the levels that have come to the start of a new slot, starting
+		// from the top so that timers can fall through more than one level in a tick
+		for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+			const uint64_t span = 1ull << (SLOT_BITS * level);
+			if ((_now & (span - 1)) == 0) {
+				_Cascade(level);
+			}
+		}
+
+		_timerScratch.clear();
+		std::swap(_timerScratch, _wheel[0][_now & SLOT_MASK]);
+		for (const Timer& timer : _timerScratch) {
+			// Timers past the end of the wheel can land in a slot before they're due
+			if (timer.Expiry > _now) {
+				_File(timer);
+			} else {
+				_Resume(timer.Task);
+			}
+		}
+
+		_RunReady();
+	}
+
+	void Scheduler::Frame(float dt) {
+		_frameTime = dt;
+
+		_taskScratch.clear();
+		std::swap(_taskScratch, _nextFrame);
+		for (TaskHandle task : _taskScratch) {
+			_Resume(task);
+		}
+
+		_RunReady();
+	}
+
+	Scheduler::TaskHandle Scheduler::_Add(Task::Handle coroutine, const std::function<void()>& callback) {
+		uint32_t index;
+		if (_freeEntries.empty()) {
+			index = (uint32_t)_entries.size();
+			_entries.push_back({ nullptr, nullptr, 1, false, false, false });
+		} else {
+			index = _freeEntries.back();
+			_freeEntries.pop_back();
+		}
+
+		Entry& entry = _entries[index];
+		entry.Coroutine = coroutine;
+		entry.Callback = callback;
+		entry.Alive = true;
+		entry.Running = false;
+		entry.Cancelled = false;
+		_pendingCount++;
+
+		return ((TaskHandle)entry.Generation << 32) | index;
+	}
+
+	Scheduler::Entry* Scheduler::_Get(TaskHandle handle) {
+		const uint32_t index = (uint32_t)handle;
+		const uint32_t generation = (uint32_t)(handle >> 32);
+		if (index >= _entries.size() || !_entries[index].Alive || _entries[index].Generation != generation) {
+			return nullptr;
+		}
+		return &_entries[index];
+	}
+
+	const Scheduler::Entry* Scheduler::_Get(TaskHandle handle) const {
+		return const_cast<Scheduler*>(this)->_Get(handle);
+	}
+
+	void Scheduler::_Free(uint32_t index) {
+		Entry& entry = _entries[index];
+		entry.Coroutine = nullptr;
+		entry.Callback = nullptr;
+		entry.Alive = false;
+		entry.Running = false;
+		entry.Cancelled = false;
+		entry.Generation++;
+		_freeEntries.push_back(index);
+		_pendingCount--;
+	}
+
+	void Scheduler::_File(const Timer& timer) {
+		const uint64_t delta = timer.Expiry > _now ? timer.Expiry - _now : 0;
+
+		// Find the lowest level whose slots can reach the timer
+		int level = 0;
+		while (level < WHEEL_LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1)))) {
+			level++;
+		}
+
+		// Timers past the end of the wheel go in the furthest slot, and get filed again when it comes up
+		uint64_t at = timer.Expiry;
+		const uint64_t wheelSpan = 1ull << (SLOT_BITS * WHEEL_LEVELS);
+		if (delta >= wheelSpan) {
+			at = _now + wheelSpan - 1;
+		}
+
+		_wheel[level][(at >> (SLOT_BITS * level)) & SLOT_MASK].push_back(timer);
+	}
+
+	void Scheduler::_Cascade(int level) {
+		std::vector<Timer>& slot = _wheel[level][(_now >> (SLOT_BITS * level)) & SLOT_MASK];
+
+		_timerScratch.clear();
+		std::swap(_timerScratch, slot);
+		for (const Timer& timer : _timerScratch) {
+			_File(timer);
+		}
+	}
+
+	void Scheduler::_WaitTicks(TaskHandle task, uint64_t ticks) {
+		_File({ _now + ticks, task });
+	}
+
+	void Scheduler::_WaitFrame(TaskHandle task) {
+		_nextFrame.push_back(task);
+	}
+
+	void Scheduler::_MakeReady(TaskHandle task) {
+		_ready.push_back(task);
+	}
+
+	void Scheduler::_RunReady() {
+		// Tasks we resume can fire signals of their own, so keep going until nothing is ready
+		while (!_ready.empty()) {
+			_taskScratch.clear();
+			std::swap(_taskScratch, _ready);
+			for (TaskHandle task : _taskScratch) {
+				_Resume(task);
+			}
+		}
+	}
+
+	void Scheduler::_Resume(TaskHandle task) {
+		Entry* entry = _Get(task);
+		if (entry == nullptr) {
+			// Cancelled while it was waiting
+			return;
+		}
+
+		const uint32_t index = (uint32_t)task;
+		if (entry->Callback) {
+			// Free the entry first, so that the callback can schedule itself again
+			std::function<void()> callback = std::move(entry->Callback);
+			_Free(index);
+			callback();
+			return;
+		}
+
+		Task::Handle coroutine = entry->Coroutine;
+		entry->Running = true;
+		coroutine.resume();
+
+		// The entry list may have grown while the task ran, so look it up again
+		Entry& after = _entries[index];
+		after.Running = false;
+		if (coroutine.done() && coroutine.promise().Exception) {
+			try {
+				std::rethrow_exception(coroutine.promise().Exception);
+			} catch (const std::exception& e) {
+				LOG_ERROR("Task {} threw an exception: {}", task, e.what());
+			} catch (...) {
+				LOG_ERROR("Task {} threw an unknown exception", task);
+			}
+		}
+		if (coroutine.done() || after.Cancelled) {
+			coroutine.destroy();
+			_Free(index);
+		}
+	}
+}
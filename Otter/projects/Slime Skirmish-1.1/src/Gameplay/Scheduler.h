@@ -0,0 +1,270 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <coroutine>
+#include <exception>
+#include <memory>
+
+namespace Gameplay {
+	class Scheduler;
+	class SimulationClock;
+
+	/// <summary>
+	/// A gameplay coroutine, which is started by handing it to Scheduler::Start. Inside a
+	/// task you can wait for scene time with co_await Seconds(1.5f), for the next frame with
+	/// co_await NextFrame, or for a Signal to fire (ex: TriggerVolumeEnterBehaviour::TriggerEntered).
+	/// A waiting task costs nothing until it wakes up. A task that throws is stopped, and the
+	/// exception is logged by the scheduler
+	/// </summary>
+	class Task {
+	public:
+		struct promise_type {
+			// The scheduler running the task, and the task's handle in that scheduler
+			Scheduler* Owner = nullptr;
+			uint64_t   Id    = 0;
+			// Set if the task threw, the task finishes and the scheduler logs it and cleans up
+			std::exception_ptr Exception;
+
+			Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			// Tasks don't run until they've been handed to a scheduler
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			// The scheduler destroys the coroutine once it sees that it's done
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() { }
+			void unhandled_exception() { Exception = std::current_exception(); }
+		};
+		typedef std::coroutine_handle<promise_type> Handle;
+
+		Task(Task&& other) noexcept;
+		Task& operator=(Task&& other) noexcept;
+		// Destroys the coroutine if it was never started
+		~Task();
+
+		Task(const Task& other) = delete;
+		Task& operator=(const Task& other) = delete;
+
+	protected:
+		friend class Scheduler;
+		explicit Task(Handle handle);
+
+		Handle _handle;
+	};
+
+	/// <summary>
+	/// Waits for an amount of scene time, rounded up to a whole number of fixed steps.
+	/// Waiting for zero or less seconds doesn't suspend
+	/// </summary>
+	struct Seconds {
+		float Duration;
+
+		explicit Seconds(float duration) : Duration(duration) { }
+
+		bool await_ready() const noexcept { return Duration <= 0.0f; }
+		void await_suspend(Task::Handle handle) const;
+		void await_resume() const noexcept { }
+	};
+
+	/// <summary>
+	/// Waits until the next frame, and resumes with that frame's time in seconds
+	/// </summary>
+	struct FrameAwaiter {
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(Task::Handle handle);
+		float await_resume() const noexcept;
+
+	protected:
+		Scheduler* _owner = nullptr;
+	};
+	struct NextFrameTag {
+		FrameAwaiter operator co_await() const noexcept { return FrameAwaiter(); }
+	};
+	/// <summary>
+	/// Use with co_await in a task to wait for the next frame, ex: float dt = co_await NextFrame;
+	/// </summary>
+	inline constexpr NextFrameTag NextFrame{};
+
+	/// <summary>
+	/// Something tasks can wait for with co_await. Firing the signal wakes every task that is
+	/// waiting on it, on their scheduler's next tick or frame, so that tasks never run in the
+	/// middle of something else (ex: while trigger events are being sent)
+	///
+	/// Copies of a signal start with no waiting tasks, so components holding them can still be cloned.
+	/// Signals can safely outlive the schedulers of the tasks waiting on them, waiters whose scheduler
+	/// is gone are dropped when the signal fires
+	/// </summary>
+	class Signal {
+	public:
+		struct Awaiter {
+			Signal* Source;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(Task::Handle handle) const;
+			void await_resume() const noexcept { }
+		};
+
+		Signal() = default;
+		Signal(const Signal& other) : _waiting() { }
+		Signal& operator=(const Signal& other) { return *this; }
+
+		/// <summary>
+		/// Wakes all tasks waiting on this signal
+		/// </summary>
+		void Fire();
+		size_t GetWaitingCount() const;
+
+		Awaiter operator co_await() noexcept { return Awaiter{ this }; }
+
+	protected:
+		struct Waiter {
+			// Expires when the scheduler is destroyed, see Scheduler::_self
+			std::weak_ptr<Scheduler*> Owner;
+			uint64_t                  Task;
+		};
+		std::vector<Waiter> _waiting;
+	};
+
+	/// <summary>
+	/// Runs delayed callbacks and gameplay coroutines (see Task) off of the scene's clock, so
+	/// that cooldowns and timed effects don't depend on the frame rate, pause with the game,
+	/// and can be run without a window by ticking the scheduler by hand.
+	///
+	/// Timers are kept in a hierarchical timer wheel, with one tick per fixed step. Each of the
+	/// 4 levels has 64 slots, and each level's slots are 64 times longer than the level below it,
+	/// so a timer is filed in O(1) and only moved down a level when it's slot comes up. Each
+	/// tick only looks at the timers that are due, no matter how many are waiting. Timers longer
+	/// than the wheel (about 3 days at 60hz) are parked in the last slot and filed again
+	/// </summary>
+	class Scheduler {
+	public:
+		/// <summary>
+		/// Identifies a task or callback, 0 is never a valid handle
+		/// </summary>
+		typedef uint64_t TaskHandle;
+
+		/// <summary>
+		/// Creates a scheduler that converts seconds into steps of the given clock
+		/// </summary>
+		Scheduler(const SimulationClock& clock);
+		~Scheduler();
+
+		Scheduler(const Scheduler& other) = delete;
+		Scheduler& operator=(const Scheduler& other) = delete;
+
+		/// <summary>
+		/// Starts a task, which runs right away until the first time it waits
+		/// </summary>
+		/// <returns>A handle that can be used to cancel the task, or 0 if it finished without waiting</returns>
+		TaskHandle Start(Task&& task);
+		/// <summary>
+		/// Invokes a function once an amount of scene time has passed
+		/// </summary>
+		/// <param name="seconds">The delay, rounded up to a whole number of fixed steps</param>
+		/// <param name="func">The function to invoke</param>
+		/// <returns>A handle that can be used to cancel the callback</returns>
+		TaskHandle After(float seconds, const std::function<void()>& func);
+
+		/// <summary>
+		/// Stops a task or callback, destroying the task's coroutine. A task can cancel
+		/// itself, in which case it's destroyed the next time it waits
+		/// </summary>
+		void Cancel(TaskHandle handle);
+		/// <summary>
+		/// Cancels every task and callback
+		/// </summary>
+		void CancelAll();
+		/// <summary>
+		/// Returns true if a task or callback is still waiting to run
+		/// </summary>
+		bool IsPending(TaskHandle handle) const;
+		/// <summary>
+		/// Gets the number of tasks and callbacks that are waiting
+		/// </summary>
+		size_t GetPendingCount() const;
+
+		/// <summary>
+		/// Gets the number of fixed steps that have been ticked
+		/// </summary>
+		uint64_t GetTickCount() const;
+		/// <summary>
+		/// Gets the length of the last frame, see NextFrame
+		/// </summary>
+		float GetFrameTime() const;
+		/// <summary>
+		/// Converts a duration into a number of fixed steps, rounded up and at least 1
+		/// </summary>
+		uint64_t SecondsToTicks(float seconds) const;
+
+		/// <summary>
+		/// Advances the timers by one fixed step, and runs everything that is due.
+		/// The scene calls this after each physics step
+		/// </summary>
+		void Tick();
+		/// <summary>
+		/// Runs the tasks waiting for the next frame. The scene calls this from Update
+		/// </summary>
+		/// <param name="dt">The time in seconds since the last frame</param>
+		void Frame(float dt);
+
+	protected:
+		friend struct Seconds;
+		friend struct FrameAwaiter;
+		friend class Signal;
+
+		static const int      WHEEL_LEVELS = 4;
+		static const int      SLOT_BITS    = 6;
+		static const int      SLOT_COUNT   = 1 << SLOT_BITS;
+		static const uint64_t SLOT_MASK    = SLOT_COUNT - 1;
+
+		struct Entry {
+			// Set for tasks
+			Task::Handle          Coroutine;
+			// Set for callbacks
+			std::function<void()> Callback;
+			uint32_t              Generation;
+			bool                  Alive;
+			// True while the task's coroutine is on the stack, so we don't destroy it out from under itself
+			bool                  Running;
+			bool                  Cancelled;
+		};
+		struct Timer {
+			uint64_t   Expiry;
+			TaskHandle Task;
+		};
+
+		const SimulationClock& _clock;
+		// Signals hold weak references to this rather than raw pointers to us, so that a signal
+		// firing after we're gone (ex: a component during scene teardown) doesn't touch a dead scheduler
+		std::shared_ptr<Scheduler*> _self;
+		uint64_t _now;
+		float    _frameTime;
+
+		// Handles are the entry's index in the low bits, and it's generation in the high bits,
+		// so anything still waiting on an entry that has been reused is ignored when it wakes
+		std::vector<Entry>    _entries;
+		std::vector<uint32_t> _freeEntries;
+		size_t                _pendingCount;
+
+		std::vector<Timer> _wheel[WHEEL_LEVELS][SLOT_COUNT];
+		std::vector<TaskHandle> _nextFrame;
+		std::vector<TaskHandle> _ready;
+
+		// Swapped with the lists above while running them, so they can be added to as we go
+		std::vector<Timer>      _timerScratch;
+		std::vector<TaskHandle> _taskScratch;
+
+		TaskHandle _Add(Task::Handle coroutine, const std::function<void()>& callback);
+		Entry* _Get(TaskHandle handle);
+		const Entry* _Get(TaskHandle handle) const;
+		void _Free(uint32_t index);
+
+		void _File(const Timer& timer);
+		void _Cascade(int level);
+
+		void _WaitTicks(TaskHandle task, uint64_t ticks);
+		void _WaitFrame(TaskHandle task);
+		void _MakeReady(TaskHandle task);
+		void _RunReady();
+		void _Resume(TaskHandle task);
+	};
+}
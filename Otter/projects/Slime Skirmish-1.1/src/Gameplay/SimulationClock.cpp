@@ -0,0 +1,139 @@
+#include "Gameplay/SimulationClock.h"
+#include <algorithm>
+#include <cmath>
+
+#include "Logging.h"
+
+namespace Gameplay {
+	SimulationClock::SimulationClock() :
+		_fixedTimestep(1.0f / 60.0f),
+		_maxCatchUpSteps(4),
+		_accumulator(0.0f),
+		_stepCount(0),
+		_nextHandle(1),
+		_fixedTicks(),
+		_variableTicks(),
+		_invokeDepth(0),
+		_pendingFixedTicks(),
+		_pendingVariableTicks()
+	{ }
+
+	void SimulationClock::SetFixedRate(float hz) {
+		LOG_ASSERT(hz > 0.0f, "Fixed rate must be greater than zero!");
+		_fixedTimestep = 1.0f / hz;
+	}
+
+	float SimulationClock::GetFixedTimestep() const {
+		return _fixedTimestep;
+	}
+
+	void SimulationClock::SetMaxCatchUpSteps(int value) {
+		_maxCatchUpSteps = std::max(value, 1);
+	}
+
+	int SimulationClock::GetMaxCatchUpSteps() const {
+		return _maxCatchUpSteps;
+	}
+
+	int SimulationClock::Accumulate(float dt) {
+		_accumulator += std::max(dt, 0.0f);
+
+		int steps = static_cast<int>(std::floor(_accumulator / _fixedTimestep));
+		if (steps > _maxCatchUpSteps) {
+			// We can't keep up, drop the time we can't simulate but keep the fraction of a
+			// step we were part way through so interpolation doesn't jump
+			LOG_TRACE("Simulation fell behind by {} steps, dropping {:.1f}ms", steps - _maxCatchUpSteps, (steps - _maxCatchUpSteps) * _fixedTimestep * 1000.0f);
+			_accumulator = std::fmod(_accumulator, _fixedTimestep) + _maxCatchUpSteps * _fixedTimestep;
+			steps = _maxCatchUpSteps;
+		}
+
+		_accumulator -= steps * _fixedTimestep;
+		_stepCount += steps;
+		return steps;
+	}
+
+	float SimulationClock::GetAlpha() const {
+		return std::clamp(_accumulator / _fixedTimestep, 0.0f, 1.0f);
+	}
+
+	uint64_t SimulationClock::GetStepCount() const {
+		return _stepCount;
+	}
+
+	SimulationClock::TickHandle SimulationClock::AddFixedTick(const TickFunc& func) {
+		// Adding to the list we're looping over could move the callback that's running
+		std::vector<Tick>& target = _invokeDepth > 0 ? _pendingFixedTicks : _fixedTicks;
+		target.push_back({ _nextHandle, func, false });
+		return _nextHandle++;
+	}
+
+	SimulationClock::TickHandle SimulationClock::AddVariableTick(const TickFunc& func) {
+		std::vector<Tick>& target = _invokeDepth > 0 ? _pendingVariableTicks : _variableTicks;
+		target.push_back({ _nextHandle, func, false });
+		return _nextHandle++;
+	}
+
+	void SimulationClock::RemoveTick(TickHandle handle) {
+		auto mark = [handle](std::vector<Tick>& ticks) {
+			for (Tick& tick : ticks) {
+				if (tick.Handle == handle) {
+					tick.Removed = true;
+				}
+			}
+		};
+		mark(_fixedTicks);
+		mark(_variableTicks);
+		mark(_pendingFixedTicks);
+		mark(_pendingVariableTicks);
+
+		// If a callback removed the tick, it might be the one that's running, so it gets erased later
+		if (_invokeDepth == 0) {
+			_ApplyPending();
+		}
+	}
+
+	void SimulationClock::InvokeFixedTicks() {
+		InvokeScope scope(*this);
+		for (size_t ix = 0; ix < _fixedTicks.size(); ix++) {
+			if (!_fixedTicks[ix].Removed) {
+				_fixedTicks[ix].Func(_fixedTimestep);
+			}
+		}
+	}
+
+	void SimulationClock::InvokeVariableTicks(float dt) {
+		InvokeScope scope(*this);
+		for (size_t ix = 0; ix < _variableTicks.size(); ix++) {
+			if (!_variableTicks[ix].Removed) {
+				_variableTicks[ix].Func(dt);
+			}
+		}
+	}
+
+	SimulationClock::InvokeScope::InvokeScope(SimulationClock& clock) :
+		Clock(clock)
+	{
+		Clock._invokeDepth++;
+	}
+
+	SimulationClock::InvokeScope::~InvokeScope() {
+		if (--Clock._invokeDepth == 0) {
+			Clock._ApplyPending();
+		}
+	}
+
+	void SimulationClock::_ApplyPending() {
+		auto isRemoved = [](const Tick& tick) { return tick.Removed; };
+		auto apply = [&](std::vector<Tick>& ticks, std::vector<Tick>& pending) {
+			ticks.erase(std::remove_if(ticks.begin(), ticks.end(), isRemoved), ticks.end());
+			for (Tick& tick : pending) {
+				if (!tick.Removed) {
+					ticks.push_back(std::move(tick));
+				}
+			}
+			pending.clear();
+		};
+		apply(_fixedTicks, _pendingFixedTicks);
+		apply(_variableTicks, _pendingVariableTicks);
+	}
+}
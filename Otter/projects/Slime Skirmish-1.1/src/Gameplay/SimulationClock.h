@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+namespace Gameplay {
+	/// <summary>
+	/// Splits variable length frames into fixed length simulation steps. Frame time is
+	/// added to an accumulator, and a fixed step is taken each time a full step's worth
+	/// of time has built up. Anything left over is exposed as an interpolation factor, so
+	/// that rendering can blend between the last two simulation states.
+	///
+	/// If the simulation falls behind (ex: after a long frame), at most MaxCatchUpSteps
+	/// are taken in a frame and the rest of the time is dropped, so that a slow frame
+	/// can't cause an even slower one.
+	///
+	/// Gameplay systems can register callbacks to run once per fixed step, or once per frame.
+	/// Callbacks may add or remove ticks while they run, added ticks start on the next invoke
+	/// </summary>
+	class SimulationClock {
+	public:
+		typedef std::function<void(float)> TickFunc;
+		typedef uint32_t TickHandle;
+
+		SimulationClock();
+
+		/// <summary>
+		/// Sets the number of fixed steps per second
+		/// </summary>
+		/// <param name="hz">The new rate, in steps per second</param>
+		void SetFixedRate(float hz);
+		/// <summary>
+		/// Gets the length of a single fixed step, in seconds
+		/// </summary>
+		float GetFixedTimestep() const;
+
+		/// <summary>
+		/// Sets the maximum number of fixed steps that can be taken in one frame
+		/// </summary>
+		/// <param name="value">The new maximum, at least 1</param>
+		void SetMaxCatchUpSteps(int value);
+		/// <summary>
+		/// Gets the maximum number of fixed steps that can be taken in one frame
+		/// </summary>
+		int GetMaxCatchUpSteps() const;
+
+		/// <summary>
+		/// Adds frame time to the accumulator, and returns how many fixed steps
+		/// should be taken this frame
+		/// </summary>
+		/// <param name="dt">The time since the last frame, in seconds</param>
+		int Accumulate(float dt);
+		/// <summary>
+		/// Gets how far we are between the previous fixed step and the next one, in the 0-1
+		/// range. Use this to blend between the last two simulation states when rendering
+		/// </summary>
+		float GetAlpha() const;
+		/// <summary>
+		/// Gets the total number of fixed steps taken so far
+		/// </summary>
+		uint64_t GetStepCount() const;
+
+		/// <summary>
+		/// Registers a callback to be invoked once per fixed step, with the fixed timestep.
+		/// Use this for anything that moves objects or needs to behave the same at any frame rate
+		/// </summary>
+		/// <param name="func">The function to invoke</param>
+		/// <returns>A handle that can be used to remove the callback</returns>
+		TickHandle AddFixedTick(const TickFunc& func);
+		/// <summary>
+		/// Registers a callback to be invoked once per frame, with the frame time. Use this
+		/// for input handling, UI and anything else that should respond immediately
+		/// </summary>
+		/// <param name="func">The function to invoke</param>
+		/// <returns>A handle that can be used to remove the callback</returns>
+		TickHandle AddVariableTick(const TickFunc& func);
+		/// <summary>
+		/// Removes a fixed or variable tick callback
+		/// </summary>
+		/// <param name="handle">The handle returned when the callback was added</param>
+		void RemoveTick(TickHandle handle);
+
+		/// <summary>
+		/// Invokes all fixed tick callbacks, should be called once for each fixed step
+		/// </summary>
+		void InvokeFixedTicks();
+		/// <summary>
+		/// Invokes all variable tick callbacks, should be called once per frame
+		/// </summary>
+		/// <param name="dt">The time since the last frame, in seconds</param>
+		void InvokeVariableTicks(float dt);
+
+	protected:
+		struct Tick {
+			TickHandle Handle;
+			TickFunc   Func;
+			// Set when the tick is removed while callbacks are running, it's erased afterwards
+			bool       Removed;
+		};
+
+		float    _fixedTimestep;
+		int      _maxCatchUpSteps;
+		float    _accumulator;
+		uint64_t _stepCount;
+
+		TickHandle        _nextHandle;
+		std::vector<Tick> _fixedTicks;
+		std::vector<Tick> _variableTicks;
+
+		// Ticks can't be added or erased while we're looping over them, so changes made by
+		// callbacks wait here until the outermost invoke is done
+		int               _invokeDepth;
+		std::vector<Tick> _pendingFixedTicks;
+		std::vector<Tick> _pendingVariableTicks;
+
+		// Holds _invokeDepth up for the lifetime of an invoke, and applies pending changes when the
+		// outermost one ends. Done in a destructor so that a callback throwing can't leave us
+		// deferring every add and remove forever
+		struct InvokeScope {
+			SimulationClock& Clock;
+			InvokeScope(SimulationClock& clock);
+			~InvokeScope();
+		};
+
+		void _ApplyPending();
+	};
+}
@@ -0,0 +1,375 @@
+#include "Gameplay/SpatialQueries.h"
+#include <algorithm>
+
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+
+#include "Gameplay/Scene.h"
+#include "Gameplay/GameObject.h"
+#include "Gameplay/Components/ComponentManager.h"
+#include "Gameplay/Components/RenderComponent.h"
+#include "Gameplay/Physics/RigidBody.h"
+
+#include "Utils/ThreadPool.h"
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay {
+	namespace {
+		// Lets us use lambdas to visit tree leaves
+		struct LeafVisitor : btDbvt::ICollide {
+			std::function<void(const btDbvtNode*)> Func;
+
+			LeafVisitor(const std::function<void(const btDbvtNode*)>& func) : Func(func) { }
+			void Process(const btDbvtNode* leaf) override { Func(leaf); }
+		};
+
+		// How far rendered objects can move before their leaf has to be moved in the tree
+		const float RENDERABLE_MARGIN = 0.5f;
+
+		// Intersects a ray with a sphere, returning the distance along the ray or -1 on a miss
+		float RaySphere(const glm::vec3& from, const glm::vec3& dir, float length, const glm::vec3& center, float radius) {
+			const glm::vec3 offset = from - center;
+			const float b = glm::dot(offset, dir);
+			const float c = glm::dot(offset, offset) - radius * radius;
+			// Starting outside and pointing away
+			if (c > 0.0f && b > 0.0f) {
+				return -1.0f;
+			}
+			const float discriminant = b * b - c;
+			if (discriminant < 0.0f) {
+				return -1.0f;
+			}
+			const float t = std::max(-b - std::sqrt(discriminant), 0.0f);
+			return t <= length ? t : -1.0f;
+		}
+	}
+
+	SpatialQueries::SpatialQueries(Scene* scene, btCollisionWorld* world) :
+		_scene(scene),
+		_world(world),
+		_renderables(),
+		_renderableEntries(),
+		_syncCount(0),
+		_isDirty(true)
+	{ }
+
+	SpatialQueries::~SpatialQueries() = default;
+
+	void SpatialQueries::Invalidate() {
+		_isDirty = true;
+	}
+
+	void SpatialQueries::SyncRenderables() {
+		_isDirty = false;
+		_syncCount++;
+
+		ComponentManager::Each<RenderComponent>([&](const RenderComponent::Sptr& renderer) {
+			GameObject* object = renderer->GetGameObject();
+			if (object == nullptr || object->GetScene() != _scene) {
+				return;
+			}
+
+			// Objects can be freed and a new one created at the same address between syncs
+			auto it = _renderableEntries.find(object);
+			if (it != _renderableEntries.end() && it->second.Object.expired()) {
+				if (it->second.Leaf != nullptr) {
+					_renderables.remove(it->second.Leaf);
+				}
+				_renderableEntries.erase(it);
+				it = _renderableEntries.end();
+			}
+
+			if (it == _renderableEntries.end()) {
+				Renderable entry;
+				entry.Object = object->SelfRef();
+				entry.Raw = object;
+				entry.Leaf = nullptr;
+				entry.Version = object->GetTransformVersion();
+				it = _renderableEntries.emplace(object, entry).first;
+
+				// Physics objects can already be found through bullet's broadphase
+				if (object->Get<Physics::RigidBody>() == nullptr) {
+					btDbvtVolume volume = _UpdateBounds(it->second);
+					volume.Expand(btVector3(RENDERABLE_MARGIN, RENDERABLE_MARGIN, RENDERABLE_MARGIN));
+					it->second.Leaf = _renderables.insert(volume, &it->second);
+				}
+			} else if (it->second.Leaf != nullptr && it->second.Version != object->GetTransformVersion()) {
+				// Leaves are padded, so small moves don't need to touch the tree at all
+				btDbvtVolume volume = _UpdateBounds(it->second);
+				if (!it->second.Leaf->volume.Contain(volume)) {
+					volume.Expand(btVector3(RENDERABLE_MARGIN, RENDERABLE_MARGIN, RENDERABLE_MARGIN));
+					_renderables.update(it->second.Leaf, volume);
+				}
+				it->second.Version = object->GetTransformVersion();
+			}
+			it->second.LastSeen = _syncCount;
+		});
+
+		// Anything we didn't see this time has been removed or disabled
+		for (auto it = _renderableEntries.begin(); it != _renderableEntries.end(); ) {
+			if (it->second.LastSeen != _syncCount) {
+				if (it->second.Leaf != nullptr) {
+					_renderables.remove(it->second.Leaf);
+				}
+				it = _renderableEntries.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	void SpatialQueries::Raycast(const RayQuery* queries, size_t count, QueryHit* results, bool parallel) {
+		_SyncIfDirty();
+		_RunBatch(count, parallel, [&](size_t begin, size_t end) {
+			for (size_t ix = begin; ix < end; ix++) {
+				_Raycast(queries[ix], results[ix]);
+			}
+		});
+	}
+
+	void SpatialQueries::Overlap(const SphereQuery* queries, size_t count, QueryHit* results, size_t maxPerQuery, uint32_t* counts, bool parallel) {
+		_SyncIfDirty();
+		_RunBatch(count, parallel, [&](size_t begin, size_t end) {
+			for (size_t ix = begin; ix < end; ix++) {
+				counts[ix] = _Overlap(queries[ix], results + ix * maxPerQuery, maxPerQuery, false);
+			}
+		});
+	}
+
+	void SpatialQueries::Nearest(const SphereQuery* queries, size_t count, QueryHit* results, size_t k, uint32_t* counts, bool parallel) {
+		_SyncIfDirty();
+		_RunBatch(count, parallel, [&](size_t begin, size_t end) {
+			for (size_t ix = begin; ix < end; ix++) {
+				counts[ix] = _Overlap(queries[ix], results + ix * k, k, true);
+			}
+		});
+	}
+
+	size_t SpatialQueries::GetRenderableCount() const {
+		return (size_t)std::count_if(_renderableEntries.begin(), _renderableEntries.end(), [](const auto& item) {
+			return item.second.Leaf != nullptr;
+		});
+	}
+
+	void SpatialQueries::_SyncIfDirty() {
+		if (_isDirty) {
+			SyncRenderables();
+		}
+	}
+
+	void SpatialQueries::_Raycast(const RayQuery& query, QueryHit& result) const {
+		result = QueryHit();
+
+		const float length = glm::distance(query.From, query.To);
+		if (length <= 0.0f) {
+			return;
+		}
+		const glm::vec3 dir = (query.To - query.From) / length;
+		float closest = length;
+
+		// The tree traversals are re-entrant, but the broadphase's own ray test shares a stack
+		// between threads, so we walk its trees ourselves and test the shapes directly
+		if (query.Filter.Targets & QueryTargets::Physics) {
+			btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(_world->getBroadphase());
+			btTransform from(btQuaternion::getIdentity(), ToBt(query.From));
+			btTransform to(btQuaternion::getIdentity(), ToBt(query.To));
+
+			if (query.Radius <= 0.0f) {
+				btCollisionWorld::ClosestRayResultCallback callback(from.getOrigin(), to.getOrigin());
+				LeafVisitor visitor([&](const btDbvtNode* leaf) {
+					btCollisionObject* object = static_cast<btCollisionObject*>(static_cast<btDbvtProxy*>(leaf->data)->m_clientObject);
+					if (_PassesFilter(object, query.Filter)) {
+						btCollisionWorld::rayTestSingle(from, to, object, object->getCollisionShape(), object->getWorldTransform(), callback);
+					}
+				});
+				btDbvt::rayTest(broadphase->m_sets[0].m_root, from.getOrigin(), to.getOrigin(), visitor);
+				btDbvt::rayTest(broadphase->m_sets[1].m_root, from.getOrigin(), to.getOrigin(), visitor);
+
+				if (callback.hasHit()) {
+					closest = callback.m_closestHitFraction * length;
+					result.Object = _GetGameObject(callback.m_collisionObject);
+					result.Point = ToGlm(callback.m_hitPointWorld);
+					result.Normal = ToGlm(callback.m_hitNormalWorld);
+					result.Distance = closest;
+				}
+			} else {
+				btSphereShape sphere(query.Radius);
+				btCollisionWorld::ClosestConvexResultCallback callback(from.getOrigin(), to.getOrigin());
+				LeafVisitor visitor([&](const btDbvtNode* leaf) {
+					btCollisionObject* object = static_cast<btCollisionObject*>(static_cast<btDbvtProxy*>(leaf->data)->m_clientObject);
+					if (_PassesFilter(object, query.Filter)) {
+						btCollisionWorld::objectQuerySingle(&sphere, from, to, object, object->getCollisionShape(), object->getWorldTransform(), callback, 0.0f);
+					}
+				});
+
+				// The trees can only test rays against boxes, so use the box around the whole sweep
+				const btVector3 padding(query.Radius, query.Radius, query.Radius);
+				const btDbvtVolume volume = btDbvtVolume::FromMM(ToBt(glm::min(query.From, query.To)) - padding, ToBt(glm::max(query.From, query.To)) + padding);
+				broadphase->m_sets[0].collideTV(broadphase->m_sets[0].m_root, volume, visitor);
+				broadphase->m_sets[1].collideTV(broadphase->m_sets[1].m_root, volume, visitor);
+
+				if (callback.hasHit()) {
+					closest = callback.m_closestHitFraction * length;
+					result.Object = _GetGameObject(callback.m_hitCollisionObject);
+					result.Point = ToGlm(callback.m_hitPointWorld);
+					result.Normal = ToGlm(callback.m_hitNormalWorld);
+					result.Distance = closest;
+				}
+			}
+		}
+
+		if (query.Filter.Targets & QueryTargets::Renderables) {
+			LeafVisitor visitor([&](const btDbvtNode* leaf) {
+				const Renderable* entry = static_cast<const Renderable*>(leaf->data);
+				if (entry->Raw == query.Filter.Ignore) {
+					return;
+				}
+				// Sweeping a sphere against a sphere is the same as a ray against their combined radius
+				const float t = RaySphere(query.From, dir, closest, entry->Center, entry->Radius + query.Radius);
+				if (t >= 0.0f && (result.Object == nullptr || t < closest)) {
+					closest = t;
+					const glm::vec3 center = query.From + dir * t;
+					const glm::vec3 offset = center - entry->Center;
+					result.Object = entry->Raw;
+					result.Normal = glm::dot(offset, offset) > 0.0f ? glm::normalize(offset) : -dir;
+					result.Point = entry->Center + result.Normal * entry->Radius;
+					result.Distance = t;
+				}
+			});
+
+			if (query.Radius <= 0.0f) {
+				btDbvt::rayTest(_renderables.m_root, ToBt(query.From), ToBt(query.To), visitor);
+			} else {
+				const btVector3 padding(query.Radius, query.Radius, query.Radius);
+				const btDbvtVolume volume = btDbvtVolume::FromMM(ToBt(glm::min(query.From, query.To)) - padding, ToBt(glm::max(query.From, query.To)) + padding);
+				_renderables.collideTV(_renderables.m_root, volume, visitor);
+			}
+		}
+	}
+
+	uint32_t SpatialQueries::_Overlap(const SphereQuery& query, QueryHit* results, size_t maxResults, bool keepNearest) const {
+		uint32_t count = 0;
+		if (maxResults == 0) {
+			return 0;
+		}
+
+		// Adds a hit, keeping the results sorted by distance if we only want the nearest ones
+		auto addHit = [&](GameObject* object, const glm::vec3& point, float distance) {
+			if (object == nullptr || object == query.Filter.Ignore) {
+				return;
+			}
+
+			// An object can be in the physics tree more than once (ex: a body and a trigger)
+			for (uint32_t ix = 0; ix < count; ix++) {
+				if (results[ix].Object == object) {
+					if (!keepNearest || results[ix].Distance <= distance) {
+						return;
+					}
+					std::move(results + ix + 1, results + count, results + ix);
+					count--;
+					break;
+				}
+			}
+
+			QueryHit hit;
+			hit.Object = object;
+			hit.Point = point;
+			hit.Normal = distance > 0.0f ? (query.Center - point) / distance : glm::vec3(0.0f);
+			hit.Distance = distance;
+
+			if (!keepNearest) {
+				if (count < maxResults) {
+					results[count++] = hit;
+				}
+				return;
+			}
+
+			// Insertion sort into the k nearest, dropping the furthest when we're full
+			if (count == maxResults && distance >= results[count - 1].Distance) {
+				return;
+			}
+			uint32_t slot = count < maxResults ? count++ : count - 1;
+			while (slot > 0 && results[slot - 1].Distance > distance) {
+				results[slot] = results[slot - 1];
+				slot--;
+			}
+			results[slot] = hit;
+		};
+
+		const btDbvtVolume volume = btDbvtVolume::FromCR(ToBt(query.Center), query.Radius);
+
+		if (query.Filter.Targets & QueryTargets::Physics) {
+			btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(_world->getBroadphase());
+			LeafVisitor visitor([&](const btDbvtNode* leaf) {
+				const btDbvtProxy* proxy = static_cast<const btDbvtProxy*>(leaf->data);
+				const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+				if (!_PassesFilter(object, query.Filter)) {
+					return;
+				}
+
+				// Test against the object's exact bounds, the tree's boxes are padded
+				const glm::vec3 point = glm::clamp(query.Center, ToGlm(proxy->m_aabbMin), ToGlm(proxy->m_aabbMax));
+				const float distance = glm::distance(query.Center, point);
+				if (distance <= query.Radius) {
+					addHit(_GetGameObject(object), point, distance);
+				}
+			});
+			broadphase->m_sets[0].collideTV(broadphase->m_sets[0].m_root, volume, visitor);
+			broadphase->m_sets[1].collideTV(broadphase->m_sets[1].m_root, volume, visitor);
+		}
+
+		if (query.Filter.Targets & QueryTargets::Renderables) {
+			LeafVisitor visitor([&](const btDbvtNode* leaf) {
+				const Renderable* entry = static_cast<const Renderable*>(leaf->data);
+				const glm::vec3 offset = query.Center - entry->Center;
+				const float centerDistance = glm::length(offset);
+				const float distance = std::max(centerDistance - entry->Radius, 0.0f);
+				if (distance <= query.Radius) {
+					const glm::vec3 point = distance > 0.0f ? entry->Center + offset * (entry->Radius / centerDistance) : query.Center;
+					addHit(entry->Raw, point, distance);
+				}
+			});
+			_renderables.collideTV(_renderables.m_root, volume, visitor);
+		}
+
+		return count;
+	}
+
+	void SpatialQueries::_RunBatch(size_t count, bool parallel, const std::function<void(size_t, size_t)>& func) {
+		if (parallel) {
+			// Queries are fairly cheap, so keep the chunks big enough to be worth handing out
+			ThreadPool::ParallelFor(count, 16, func);
+		} else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	btDbvtVolume SpatialQueries::_UpdateBounds(Renderable& entry) const {
+		const glm::mat4& transform = entry.Raw->GetTransform();
+		const glm::vec3 scale = entry.Raw->GetScale();
+		entry.Center = glm::vec3(transform[3]);
+		entry.Radius = RenderableRadius * std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+
+		return btDbvtVolume::FromCR(ToBt(entry.Center), entry.Radius);
+	}
+
+	GameObject* SpatialQueries::_GetGameObject(const btCollisionObject* object) {
+		// All our physics objects store a weak reference to their component as the user pointer
+		const std::weak_ptr<IComponent>* ref = static_cast<const std::weak_ptr<IComponent>*>(object->getUserPointer());
+		if (ref == nullptr) {
+			return nullptr;
+		}
+		std::shared_ptr<IComponent> component = ref->lock();
+		return component != nullptr ? component->GetGameObject() : nullptr;
+	}
+
+	bool SpatialQueries::_PassesFilter(const btCollisionObject* object, const QueryFilter& filter) {
+		if ((object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE) && !(filter.Targets & QueryTargets::Triggers)) {
+			return false;
+		}
+		if ((object->getBroadphaseHandle()->m_collisionFilterGroup & filter.CollisionMask) == 0) {
+			return false;
+		}
+		return filter.Ignore == nullptr || _GetGameObject(object) != filter.Ignore;
+	}
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+#include <BulletCollision/BroadphaseCollision/btDbvt.h>
+
+class btCollisionWorld;
+class btCollisionObject;
+
+namespace Gameplay {
+	class GameObject;
+	class Scene;
+
+	/// <summary>
+	/// Which kinds of objects a spatial query should look at
+	/// </summary>
+	enum class QueryTargets : uint32_t {
+		// Objects with a RigidBody, found through bullet's broadphase
+		Physics     = 1 << 0,
+		// Rendered objects without a RigidBody, found through our own tree
+		Renderables = 1 << 1,
+		// Trigger volumes are skipped unless this is set
+		Triggers    = 1 << 2,
+		All         = Physics | Renderables
+	};
+	inline QueryTargets operator|(QueryTargets a, QueryTargets b) { return (QueryTargets)((uint32_t)a | (uint32_t)b); }
+	inline bool operator&(QueryTargets a, QueryTargets b) { return ((uint32_t)a & (uint32_t)b) != 0; }
+
+	/// <summary>
+	/// Filtering shared by all the query types
+	/// </summary>
+	struct QueryFilter {
+		QueryTargets      Targets = QueryTargets::All;
+		// Physics objects are only hit if their collision group matches this mask
+		int               CollisionMask = -1;
+		// An object to skip, usually whoever is asking
+		const GameObject* Ignore = nullptr;
+	};
+
+	/// <summary>
+	/// A ray from one point to another, or a sphere swept between them if Radius is non-zero
+	/// </summary>
+	struct RayQuery {
+		glm::vec3   From = glm::vec3(0.0f);
+		glm::vec3   To = glm::vec3(0.0f);
+		float       Radius = 0.0f;
+		QueryFilter Filter;
+	};
+
+	/// <summary>
+	/// A sphere to find objects inside of, or around
+	/// </summary>
+	struct SphereQuery {
+		glm::vec3   Center = glm::vec3(0.0f);
+		float       Radius = 1.0f;
+		QueryFilter Filter;
+	};
+
+	/// <summary>
+	/// A single result of a spatial query
+	/// </summary>
+	struct QueryHit {
+		// The object that was hit, or nullptr if a ray missed. Only valid until objects are removed from the scene
+		GameObject* Object = nullptr;
+		// For rays, the hit point and surface normal. For spheres, the closest point on the object's bounds
+		glm::vec3   Point = glm::vec3(0.0f);
+		glm::vec3   Normal = glm::vec3(0.0f);
+		// The distance along the ray, or from the sphere's center
+		float       Distance = 0.0f;
+	};
+
+	/// <summary>
+	/// Answers "what is near me" style questions for gameplay code, in batches.
+	///
+	/// Physics objects are found by walking the DBVTs inside bullet's broadphase, with exact ray
+	/// and sweep tests against their shapes. Rendered objects without a rigid body are kept in a
+	/// separate dynamic AABB tree, and are treated as spheres around their position scaled by
+	/// RenderableRadius. Overlap and nearest queries test against bounds rather than exact shapes.
+	///
+	/// Each query in a batch writes to its own slot in the caller's buffers, so batches can be
+	/// split across the thread pool. Queries must not run while the scene is being stepped
+	/// or updated.
+	///
+	/// The tree of rendered objects is only synced by the first query after the scene marks it
+	/// out of date, so frames without any queries don't pay for it.
+	/// </summary>
+	class SpatialQueries {
+	public:
+		/// <summary>
+		/// The radius of a rendered object's bounds at a scale of 1
+		/// </summary>
+		float RenderableRadius = 1.0f;
+
+		SpatialQueries(Scene* scene, btCollisionWorld* world);
+		~SpatialQueries();
+
+		SpatialQueries(const SpatialQueries& other) = delete;
+		SpatialQueries& operator=(const SpatialQueries& other) = delete;
+
+		/// <summary>
+		/// Marks the tree of rendered objects as out of date, the next query will sync it. The
+		/// scene calls this once per frame
+		/// </summary>
+		void Invalidate();
+		/// <summary>
+		/// Updates the tree of rendered objects. Only objects that have moved since the last
+		/// call are touched. Queries call this as needed, see Invalidate
+		/// </summary>
+		void SyncRenderables();
+
+		/// <summary>
+		/// Finds the closest hit for each ray, or each swept sphere if the query has a radius
+		/// </summary>
+		/// <param name="queries">The rays to cast</param>
+		/// <param name="count">The number of queries</param>
+		/// <param name="results">Receives one hit per query, with a null object for misses</param>
+		/// <param name="parallel">True to split the batch across the thread pool</param>
+		void Raycast(const RayQuery* queries, size_t count, QueryHit* results, bool parallel = true);
+
+		/// <summary>
+		/// Finds the objects whose bounds touch each sphere
+		/// </summary>
+		/// <param name="queries">The spheres to test</param>
+		/// <param name="count">The number of queries</param>
+		/// <param name="results">Receives up to maxPerQuery hits per query, query N starting at N * maxPerQuery</param>
+		/// <param name="maxPerQuery">The number of result slots for each query</param>
+		/// <param name="counts">Receives the number of hits written for each query</param>
+		/// <param name="parallel">True to split the batch across the thread pool</param>
+		void Overlap(const SphereQuery* queries, size_t count, QueryHit* results, size_t maxPerQuery, uint32_t* counts, bool parallel = true);
+
+		/// <summary>
+		/// Finds the k nearest objects to the center of each sphere, within it's radius, sorted
+		/// from nearest to furthest
+		/// </summary>
+		/// <param name="queries">The spheres to search</param>
+		/// <param name="count">The number of queries</param>
+		/// <param name="results">Receives up to k hits per query, query N starting at N * k</param>
+		/// <param name="k">The number of objects to find for each query</param>
+		/// <param name="counts">Receives the number of hits written for each query</param>
+		/// <param name="parallel">True to split the batch across the thread pool</param>
+		void Nearest(const SphereQuery* queries, size_t count, QueryHit* results, size_t k, uint32_t* counts, bool parallel = true);
+
+		/// <summary>
+		/// Gets the number of rendered objects in the tree
+		/// </summary>
+		size_t GetRenderableCount() const;
+
+	protected:
+		// A rendered object in our tree, the leaf's data points back to this. The bounds are
+		// copied out so queries never have to touch the gameobject's lazily updated transform
+		struct Renderable {
+			std::weak_ptr<GameObject> Object;
+			GameObject*               Raw;
+			btDbvtNode*               Leaf;
+			glm::vec3                 Center;
+			float                     Radius;
+			uint32_t                  Version;
+			uint32_t                  LastSeen;
+		};
+
+		Scene*             _scene;
+		btCollisionWorld*  _world;
+
+		btDbvt                                      _renderables;
+		std::unordered_map<GameObject*, Renderable> _renderableEntries;
+		uint32_t                                    _syncCount;
+		bool                                        _isDirty;
+
+		void _Raycast(const RayQuery& query, QueryHit& result) const;
+		uint32_t _Overlap(const SphereQuery& query, QueryHit* results, size_t maxResults, bool keepNearest) const;
+
+		// Syncs the tree of rendered objects if it has been invalidated, before a batch runs
+		void _SyncIfDirty();
+
+		// Invokes func(begin, end) over the batch, on the thread pool if requested
+		static void _RunBatch(size_t count, bool parallel, const std::function<void(size_t, size_t)>& func);
+		// Updates the bounds of a rendered object from it's gameobject, and returns them as a volume
+		btDbvtVolume _UpdateBounds(Renderable& entry) const;
+		// Gets the gameobject that owns a bullet object, or nullptr if it isn't one of ours
+		static GameObject* _GetGameObject(const btCollisionObject* object);
+		// Returns true if a physics object passes a query's filter
+		static bool _PassesFilter(const btCollisionObject* object, const QueryFilter& filter);
+	};
+}
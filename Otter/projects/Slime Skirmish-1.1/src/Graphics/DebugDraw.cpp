@@ -1,24 +1,39 @@
 #include "Graphics/DebugDraw.h"
+#include <algorithm>
+#include <cstring>
 
 DebugDrawer::DebugDrawer() :
 	_colorStack(std::stack<glm::vec3>()),
 	_transformStack(std::stack<glm::mat4>()),
+	_durationStack(std::stack<float>()),
 	_viewProjection(glm::mat4(1.0f)),
-	_lineOffset(0),
-	_triangleOffset(0)
+	_isIdentity(true),
+	_lines(),
+	_tris(),
+	_timedLines(),
+	_timedTris(),
+	_time(0.0f),
+	_timedLinesDrawn(false),
+	_timedTrisDrawn(false),
+	_ringVBO(nullptr),
+	_ringVAO(nullptr),
+	_ringMapped(nullptr),
+	_ringStaging(),
+	_ringFences(),
+	_ringSegmentSize(0),
+	_ringSegment(0),
+	_ringHead(0),
+	_drawCount(0)
 {
-	_linesVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
-	_linesVBO->LoadData<VertexPosCol>(nullptr, LINE_BATCH_SIZE * 2);
-	_linesVAO = VertexArrayObject::Create();
-	_linesVAO->AddVertexBuffer(_linesVBO, VertexPosCol::V_DECL);
-
-	_trisVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
-	_trisVBO->LoadData<VertexPosCol>(nullptr, TRI_BATCH_SIZE * 3);
-	_trisVAO = VertexArrayObject::Create();
-	_trisVAO->AddVertexBuffer(_trisVBO, VertexPosCol::V_DECL);
+	_CreateRing(RING_SEGMENT_SIZE);
 
 	_colorStack.push(glm::vec3(1.0f));
 	_transformStack.push(glm::mat4(1.0f));
+	_durationStack.push(0.0f);
+}
+
+DebugDrawer::~DebugDrawer() {
+	_DestroyRing();
 }
 
 void DebugDrawer::PushColor(const glm::vec3& color) {
@@ -33,15 +48,41 @@ glm::vec3 DebugDrawer::PopColor() {
 }
 
 void DebugDrawer::PushWorldMatrix(const glm::mat4& value) {
-	FlushAll();
 	_transformStack.push(value);
+	_isIdentity = value == glm::mat4(1.0f);
 }
 
 void DebugDrawer::PopWorldMatrix() {
 	LOG_ASSERT(_transformStack.size() > 1, "Attempting to pop more transforms than you are pushing! Check your code!");
-	FlushAll();
 	_transformStack.pop();
+	_isIdentity = _transformStack.top() == glm::mat4(1.0f);
+}
+
+void DebugDrawer::PushDuration(float seconds) {
+	_durationStack.push(seconds);
+}
+
+float DebugDrawer::PopDuration() {
+	LOG_ASSERT(_durationStack.size() > 1, "Attempting to pop more durations than you are pushing! Check your code!");
+	float result = _durationStack.top();
+	_durationStack.pop();
+	return result;
+}
 
+void DebugDrawer::Update(float dt) {
+	_time += dt;
+	_ExpireTimed(_timedLines, 2);
+	_ExpireTimed(_timedTris, 3);
+	_timedLinesDrawn = false;
+	_timedTrisDrawn = false;
+	_drawCount = 0;
+}
+
+void DebugDrawer::ClearPersistent() {
+	_timedLines.Vertices.clear();
+	_timedLines.Expiry.clear();
+	_timedTris.Vertices.clear();
+	_timedTris.Expiry.clear();
 }
 
 void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2) {
@@ -54,34 +95,16 @@ void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::
 
 void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& color1, const glm::vec3& color2)
 {
-	_lineBuffer[_lineOffset + 0].Color = glm::vec4(color1, 1.0f);
-	_lineBuffer[_lineOffset + 0].Position = p1;
-	_lineBuffer[_lineOffset + 1].Color = glm::vec4(color2, 1.0f);
-	_lineBuffer[_lineOffset + 1].Position = p2;
-
-	_lineOffset += 2;
-	if (_lineOffset >= LINE_BATCH_SIZE) {
-		FlushLines();
-	}
+	VertexPosCol* vertices = _AddPrimitive(_lines, _timedLines, 2);
+	vertices[0].Color = glm::vec4(color1, 1.0f);
+	vertices[0].Position = _Transform(p1);
+	vertices[1].Color = glm::vec4(color2, 1.0f);
+	vertices[1].Position = _Transform(p2);
 }
 
 void DebugDrawer::FlushLines()
 {
-	if (_lineOffset > 0) {
-		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_linesVBO->LoadData<VertexPosCol>(_lineBuffer, LINE_BATCH_SIZE * 2);
-		_linesVAO->Bind();
-		_linesVAO->Draw(DrawMode::LineList);
-		_linesVAO->Unbind();
-		_lineOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
-	}
+	_Flush(true, false);
 }
 
 void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3) {
@@ -95,42 +118,23 @@ void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::v
 
 void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& c3)
 {
-	_triBuffer[_triangleOffset + 0].Color = glm::vec4(c1, 1.0f);
-	_triBuffer[_triangleOffset + 0].Position = p1;
-	_triBuffer[_triangleOffset + 1].Color = glm::vec4(c2, 1.0f);
-	_triBuffer[_triangleOffset + 1].Position = p2;
-	_triBuffer[_triangleOffset + 2].Color = glm::vec4(c3, 1.0f);
-	_triBuffer[_triangleOffset + 2].Position = p3;
-
-	_triangleOffset += 3;
-	if (_triangleOffset >= TRI_BATCH_SIZE) {
-		FlushTris();
-	}
+	VertexPosCol* vertices = _AddPrimitive(_tris, _timedTris, 3);
+	vertices[0].Color = glm::vec4(c1, 1.0f);
+	vertices[0].Position = _Transform(p1);
+	vertices[1].Color = glm::vec4(c2, 1.0f);
+	vertices[1].Position = _Transform(p2);
+	vertices[2].Color = glm::vec4(c3, 1.0f);
+	vertices[2].Position = _Transform(p3);
 }
 
 void DebugDrawer::FlushTris()
 {
-	if (_triangleOffset > 0) {
-		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_trisVBO->LoadData<VertexPosCol>(_triBuffer, TRI_BATCH_SIZE * 3);
-		_trisVAO->Bind();
-		_trisVAO->Draw(DrawMode::LineList);
-		_trisVAO->Unbind();
-		_triangleOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
-	}
+	_Flush(false, true);
 }
 
 void DebugDrawer::FlushAll()
 {
-	FlushLines();
-	FlushTris();
+	_Flush(true, true);
 }
 
 void DebugDrawer::SetViewProjection(const glm::mat4& viewProjection)
@@ -138,6 +142,183 @@ void DebugDrawer::SetViewProjection(const glm::mat4& viewProjection)
 	_viewProjection = viewProjection;
 }
 
+VertexPosCol* DebugDrawer::_AddPrimitive(std::vector<VertexPosCol>& immediate, TimedPrimitives& timed, size_t vertexCount) {
+	std::vector<VertexPosCol>* target = &immediate;
+
+	float duration = _durationStack.top();
+	if (duration > 0.0f) {
+		timed.Expiry.push_back(_time + duration);
+		target = &timed.Vertices;
+	} else if (immediate.size() + vertexCount > MAX_QUEUED_VERTICES) {
+		// Nobody is flushing us, so the old primitives will never be seen anyway
+		static bool warned = false;
+		if (!warned) {
+			LOG_WARN("Debug draw queue reached {} vertices without a flush, dropping queued primitives", immediate.size());
+			warned = true;
+		}
+		immediate.clear();
+	}
+
+	size_t start = target->size();
+	target->resize(start + vertexCount);
+	return target->data() + start;
+}
+
+glm::vec3 DebugDrawer::_Transform(const glm::vec3& point) const {
+	return _isIdentity ? point : glm::vec3(_transformStack.top() * glm::vec4(point, 1.0f));
+}
+
+void DebugDrawer::_Flush(bool lines, bool tris) {
+	// Timed primitives only get drawn once per frame, no matter how many flushes there are
+	bool timedLines = lines && !_timedLinesDrawn;
+	bool timedTris = tris && !_timedTrisDrawn;
+
+	size_t lineCount = lines ? _lines.size() + (timedLines ? _timedLines.Vertices.size() : 0) : 0;
+	size_t triCount = tris ? _tris.size() + (timedTris ? _timedTris.Vertices.size() : 0) : 0;
+	size_t total = lineCount + triCount;
+
+	if (total > 0) {
+		// Lines and triangles go into the ring back to back, so we only need one upload
+		size_t first = _ReserveRing(total);
+		VertexPosCol* target = _ringMapped;
+		if (target != nullptr) {
+			target += first;
+		} else {
+			if (_ringStaging.size() < total) {
+				_ringStaging.resize(total);
+			}
+			target = _ringStaging.data();
+		}
+
+		auto append = [&](const std::vector<VertexPosCol>& source) {
+			if (!source.empty()) {
+				memcpy(target, source.data(), source.size() * sizeof(VertexPosCol));
+				target += source.size();
+			}
+		};
+		if (lines) {
+			append(_lines);
+			if (timedLines) append(_timedLines.Vertices);
+		}
+		if (tris) {
+			append(_tris);
+			if (timedTris) append(_timedTris.Vertices);
+		}
+
+		// Without a persistent mapping, we upload exactly what was written
+		if (_ringMapped == nullptr) {
+			_ringVBO->UpdateSubData(_ringStaging.data(), first * sizeof(VertexPosCol), total * sizeof(VertexPosCol));
+		}
+
+		// Vertices are already in world space, so we only need the view projection
+		__Shader->Bind();
+		__Shader->SetUniformMatrix("u_MVP", _viewProjection);
+		_ringVAO->Bind();
+		if (lineCount > 0) {
+			glDrawArrays(GL_LINES, (GLint)first, (GLsizei)lineCount);
+			_drawCount++;
+		}
+		if (triCount > 0) {
+			glDrawArrays(GL_TRIANGLES, (GLint)(first + lineCount), (GLsizei)triCount);
+			_drawCount++;
+		}
+		VertexArrayObject::Unbind();
+	}
+
+	if (lines) {
+		_lines.clear();
+		_timedLinesDrawn = true;
+	}
+	if (tris) {
+		_tris.clear();
+		_timedTrisDrawn = true;
+	}
+}
+
+void DebugDrawer::_CreateRing(size_t segmentSize) {
+	_ringSegmentSize = segmentSize;
+	_ringSegment = 0;
+	_ringHead = 0;
+	_ringFences.assign(RING_SEGMENT_COUNT, nullptr);
+
+	_ringVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
+	_ringMapped = static_cast<VertexPosCol*>(_ringVBO->MapPersistent(sizeof(VertexPosCol), segmentSize * RING_SEGMENT_COUNT));
+	_ringVAO = VertexArrayObject::Create();
+	_ringVAO->AddVertexBuffer(_ringVBO, VertexPosCol::V_DECL);
+}
+
+void DebugDrawer::_DestroyRing() {
+	for (GLsync fence : _ringFences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+	}
+	_ringFences.clear();
+
+	// Deleting the buffer also unmaps it
+	_ringMapped = nullptr;
+	_ringVAO = nullptr;
+	_ringVBO = nullptr;
+}
+
+size_t DebugDrawer::_ReserveRing(size_t count) {
+	// Storage that's been persistently mapped can't be resized, so we make a new ring.
+	// GL keeps the old buffer alive until the GPU is done with it
+	if (count > _ringSegmentSize) {
+		size_t segmentSize = _ringSegmentSize;
+		while (segmentSize < count) {
+			segmentSize *= 2;
+		}
+		LOG_INFO("Expanding debug draw ring from {} to {} vertices per segment", _ringSegmentSize, segmentSize);
+		_DestroyRing();
+		_CreateRing(segmentSize);
+	}
+
+	// Move on to the next segment if this one is full
+	if (_ringHead + count > _ringSegmentSize) {
+		// Everything drawn from this segment has been submitted, once this fence goes off the GPU is done with it
+		GLsync& current = _ringFences[_ringSegment];
+		if (current != nullptr) {
+			glDeleteSync(current);
+		}
+		current = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		_ringSegment = (_ringSegment + 1) % RING_SEGMENT_COUNT;
+		_ringHead = 0;
+
+		// Make sure the GPU has finished drawing from the segment we're about to overwrite
+		GLsync& next = _ringFences[_ringSegment];
+		if (next != nullptr) {
+			GLenum result = glClientWaitSync(next, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			while (result == GL_TIMEOUT_EXPIRED) {
+				result = glClientWaitSync(next, 0, 1000000);
+			}
+			glDeleteSync(next);
+			next = nullptr;
+		}
+	}
+
+	size_t first = _ringSegment * _ringSegmentSize + _ringHead;
+	_ringHead += count;
+	return first;
+}
+
+void DebugDrawer::_ExpireTimed(TimedPrimitives& timed, size_t verticesPerPrimitive) {
+	// Shuffle the primitives that are still alive to the front, keeping them in order
+	size_t kept = 0;
+	for (size_t ix = 0; ix < timed.Expiry.size(); ix++) {
+		if (timed.Expiry[ix] > _time) {
+			if (kept != ix) {
+				timed.Expiry[kept] = timed.Expiry[ix];
+				std::copy_n(timed.Vertices.begin() + ix * verticesPerPrimitive, verticesPerPrimitive, timed.Vertices.begin() + kept * verticesPerPrimitive);
+			}
+			kept++;
+		}
+	}
+	timed.Expiry.resize(kept);
+	timed.Vertices.resize(kept * verticesPerPrimitive);
+}
+
 DebugDrawer& DebugDrawer::Get() {
 	if (__Instance == nullptr) {
 		__Instance = new DebugDrawer();
@@ -1,6 +1,8 @@
 #pragma once
 #include <GLM/glm.hpp>
 #include <stack>
+#include <vector>
+#include <limits>
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Shader.h"
 
@@ -8,13 +10,23 @@
 /// Utility class for drawing lines and triangles in an immediate mode style
 /// 
 /// Includes a stack for transformations and color, to ease implementation of complex
-/// debuggers
+/// debuggers. Vertices are transformed as they're added, so changing the transform
+/// doesn't need a flush, and everything queued is streamed through a persistently
+/// mapped ring buffer and drawn with one call for lines and one for triangles.
+/// Primitives can also be kept around for a while, see PushDuration
 /// </summary>
 class DebugDrawer
 {
 public:
-	inline static const size_t LINE_BATCH_SIZE = 8192;
-	inline static const size_t TRI_BATCH_SIZE = 4096;
+	// The number of vertices each segment of the ring can hold, grows if a flush needs more
+	inline static const size_t RING_SEGMENT_SIZE = 65536;
+	// The number of segments in the ring, the GPU can be drawing from all but one of them
+	inline static const size_t RING_SEGMENT_COUNT = 3;
+	// The most vertices that can be waiting for a flush. If nothing flushes (ex: physics debug
+	// drawing in a headless run), the queue is dropped when it gets this big instead of growing forever
+	inline static const size_t MAX_QUEUED_VERTICES = RING_SEGMENT_SIZE * 16;
+	// A duration that keeps primitives around until ClearPersistent is called
+	inline static const float PERSISTENT = std::numeric_limits<float>::infinity();
 
 	// Delete copy and mode
 
@@ -23,7 +35,7 @@ public:
 	DebugDrawer& operator =(const DebugDrawer& other) = delete;
 	DebugDrawer& operator =(DebugDrawer&& other) = delete;
 
-	virtual ~DebugDrawer() = default;
+	virtual ~DebugDrawer();
 
 	/// <summary>
 	/// Gets the singleton instance of the debug drawer
@@ -47,15 +59,37 @@ public:
 	glm::vec3 PopColor();
 
 	/// <summary>
-	/// Pushes a new transform to the stack, replacing the existing value and flushing all lines and tris
+	/// Pushes a new transform to the stack, replacing the existing value. Primitives
+	/// are transformed as they are added, so this doesn't need to flush
 	/// </summary>
 	/// <param name="world">The new world transform to use for drawing</param>
 	void PushWorldMatrix(const glm::mat4& world);
 	/// <summary>
-	/// Pops a transform from the stack, replacing the existing value and flushing all lines and tris
+	/// Pops a transform from the stack, replacing the existing value
 	/// </summary>
 	void PopWorldMatrix();
 
+	/// <summary>
+	/// Pushes a new duration to the stack. Primitives added while the duration is above 0
+	/// are drawn every frame until that many seconds have passed (see Update), or until
+	/// ClearPersistent is called if it's PERSISTENT. The default of 0 draws for a single flush
+	/// </summary>
+	/// <param name="seconds">How long primitives should stay on screen, in seconds</param>
+	void PushDuration(float seconds);
+	/// <summary>
+	/// Pops a duration from the stack, replacing the existing value
+	/// </summary>
+	float PopDuration();
+	/// <summary>
+	/// Advances the clock that timed primitives use, removing any that have run out
+	/// </summary>
+	/// <param name="dt">The time in seconds since the last frame</param>
+	void Update(float dt);
+	/// <summary>
+	/// Removes all timed and persistent primitives
+	/// </summary>
+	void ClearPersistent();
+
 	/// <summary>
 	/// Draws a line between 2 points using the current debug color
 	/// </summary>
@@ -116,7 +150,8 @@ public:
 	void FlushTris();
 
 	/// <summary>
-	/// Flushes any remaining triangles and lines, drawing them to the screen and resetting their counters
+	/// Flushes any remaining triangles and lines, drawing them to the screen and resetting their
+	/// counters. Draws with at most 2 calls, no matter how many primitives were queued
 	/// </summary>
 	void FlushAll();
 
@@ -125,23 +160,55 @@ public:
 	/// </summary>
 	void SetViewProjection(const glm::mat4& viewProjection);
 
+	/// <summary>
+	/// Gets the number of draw calls made by flushes since the last Update
+	/// </summary>
+	int GetDrawCount() const { return _drawCount; }
+
 protected:
 	DebugDrawer();
 
+	// Primitives that stay around for more than one flush, with the time each one runs out
+	struct TimedPrimitives {
+		std::vector<VertexPosCol> Vertices;
+		std::vector<float>        Expiry;
+	};
+
 	std::stack<glm::vec3> _colorStack;
 	std::stack<glm::mat4> _transformStack;
+	std::stack<float>     _durationStack;
 	glm::mat4    _viewProjection;
-	glm::mat4    _worldMatrix;
-
-	size_t       _lineOffset;
-	VertexPosCol _lineBuffer[LINE_BATCH_SIZE * 2];
-	size_t       _triangleOffset;
-	VertexPosCol _triBuffer[TRI_BATCH_SIZE * 3];
-
-	VertexBuffer::Sptr _linesVBO;
-	VertexArrayObject::Sptr _linesVAO;
-	VertexBuffer::Sptr _trisVBO;
-	VertexArrayObject::Sptr _trisVAO;
+	// Lets us skip transforming vertices when nothing is pushed, like for physics debugging
+	bool         _isIdentity;
+
+	// Primitives for the next flush, already in world space
+	std::vector<VertexPosCol> _lines;
+	std::vector<VertexPosCol> _tris;
+	TimedPrimitives _timedLines;
+	TimedPrimitives _timedTris;
+	float        _time;
+	// Timed primitives are drawn by the first flush after each Update
+	bool         _timedLinesDrawn;
+	bool         _timedTrisDrawn;
+
+	// The ring buffer we stream vertices through
+	VertexBuffer::Sptr      _ringVBO;
+	VertexArrayObject::Sptr _ringVAO;
+	VertexPosCol*           _ringMapped;
+	std::vector<VertexPosCol> _ringStaging;
+	std::vector<GLsync>     _ringFences;
+	size_t                  _ringSegmentSize;
+	size_t                  _ringSegment;
+	size_t                  _ringHead;
+	int                     _drawCount;
+
+	VertexPosCol* _AddPrimitive(std::vector<VertexPosCol>& immediate, TimedPrimitives& timed, size_t vertexCount);
+	glm::vec3 _Transform(const glm::vec3& point) const;
+	void _Flush(bool lines, bool tris);
+	void _CreateRing(size_t segmentSize);
+	void _DestroyRing();
+	size_t _ReserveRing(size_t count);
+	void _ExpireTimed(TimedPrimitives& timed, size_t verticesPerPrimitive);
 
 	inline static DebugDrawer* __Instance = nullptr;
 	inline static Shader::Sptr __Shader = nullptr;
@@ -2,19 +2,22 @@
 
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/Texture2D.h"
-
-#include <stb_truetype.h>
+#include "Graphics/FontFace.h"
 
 	struct GlyphInfo {
 		glm::vec2 Positions[4];
 		glm::vec2 UVs[4];
 		float OffsetX, OffsetY;
+		// The atlas page the glyph is on, see Font::GetAtlas
+		uint32_t Page;
+		// False if there's nothing to draw yet (or ever, for spaces), the glyph should be skipped but still advance the pen
 		bool IsPacked;
 	};
 
 	/// <summary>
-	/// The font resource wraps around stb_truetype to allow us to render text to the screen
-	/// A Font class contains the texture atlas and data needed to render glyphs using said atlas
+	/// The font resource allows us to render text to the screen at a given size. Fonts
+	/// using the same file share a FontFace, which holds a distance field atlas that
+	/// works for every size, and fills in glyphs as they get used
 	/// </summary>
 	class Font : public IResource {
 	public:
@@ -35,23 +38,27 @@
 		void Load(const std::string& fontPath, float size = 16.0f);
 
 		/// <summary>
-		/// Adds a range of unicode characters to enable in this font.
-		/// Since we are rendering to a texture, we need to know all of the characters
-		/// that we will want to render ahead of time
+		/// Adds a range of unicode characters that Bake will load ahead of time. Any
+		/// other character the font has will still be loaded the first time it's used
 		/// </summary>
 		/// <param name="min">The minimum unicode character (inclusive)</param>
 		/// <param name="max">The maximum unicode character (inclusive)</param>
 		void AddGlyphRange(uint32_t min, uint32_t max);
 
 		/// <summary>
-		/// Generates the texture to use when rendering with this font, must be called
-		/// before the font is used
+		/// Queues the glyphs in the font's glyph ranges to be rasterized, so they're
+		/// likely to be ready by the time they're drawn
 		/// </summary>
 		void Bake();
 		/// <summary>
-		/// Gets the texture atlas for this font
+		/// Gets one of the texture atlas pages for this font, see GlyphInfo::Page
+		/// </summary>
+		const Texture2D::Sptr& GetAtlas(uint32_t page = 0);
+		/// <summary>
+		/// Gets a number that changes whenever glyphs are added to or removed from the
+		/// atlas, text built with this font should be rebuilt when it changes
 		/// </summary>
-		const Texture2D::Sptr& GetAtlas();
+		uint32_t GetRevision();
 
 		/// <summary>
 		/// Extracts information about a glyph with the given codepoint, positioning
@@ -60,18 +67,23 @@
 		/// <param name="codePoint">The unicode codepoint to attempt to lookup</param>
 		/// <param name="offsetX">The x position of the glyph</param>
 		/// <param name="offsetY">The y position of the glyph</param>
-		GlyphInfo GetGlyph(uint32_t codePoint, float offsetX, float offsetY) const;
+		GlyphInfo GetGlyph(uint32_t codePoint, float offsetX, float offsetY);
 		/// <summary>
 		/// Gets the kerning (horizontal space) between 2 unicode characters
 		/// </summary>
 		/// <param name="char1">The left character</param>
 		/// <param name="char2">The right character</param>
 		/// <returns>The space between characters</returns>
-		float  GetKerning(int char1, int char2) const;
+		float  GetKerning(int char1, int char2);
 		/// <summary>
 		/// Returns the vertical height of a line of text for this font
 		/// </summary>
 		float  GetLineHeight() const;
+		/// <summary>
+		/// Returns how far glyph quads extend past the outline of the glyph, which
+		/// should be left out when measuring text
+		/// </summary>
+		float  GetGlyphPadding() const;
 
 		/// <summary>
 		/// Measures the size of a string using this font
@@ -94,24 +106,11 @@
 
 	protected:
 		std::vector<glm::uvec2> _glyphRanges;
-		std::map<uint32_t, GlyphInfo> _glyphMap;
-		GlyphInfo                     _defaultGlyph;
-		Texture2D::Sptr   _atlas;
+		FontFace::Sptr    _face;
 		std::string       _fontPath;
-		std::string       _fontData;
 		float             _fontSize;
 
 		float             _pixelHeightScale;
-		float             _emToPixel;
-		int               _ascent,
-						  _descent,
-						  _lineGap;
-
-		uint32_t          _atlasWidth,
-			              _atlasHeight;
-
-		stbtt_packedchar* _glyphs;
-		stbtt_fontinfo    _fontInfo;
-
-		GlyphInfo __CreateGlyph(uint32_t index);
+		// Converts from the face's distance field size to this font's size
+		float             _sizeRatio;
 	};
\ No newline at end of file
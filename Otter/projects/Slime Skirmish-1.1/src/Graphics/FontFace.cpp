@@ -0,0 +1,339 @@
+#include "Graphics/FontFace.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/ThreadPool.h"
+#include "Logging.h"
+
+const float    FontFace::SDF_SIZE    = 32.0f;
+const int      FontFace::SDF_PADDING = 4;
+const uint32_t FontFace::PAGE_SIZE   = 512;
+const uint32_t FontFace::MAX_PAGES   = 4;
+
+// The distance field value that sits right on the edge of a glyph, and how much the
+// value changes per pixel, so that the padding covers the full 0-255 range
+static const uint8_t SDF_ON_EDGE = 128;
+static const float   SDF_PIXEL_DIST_SCALE = 128.0f / FontFace::SDF_PADDING;
+
+// The printable ASCII characters, kerning between these is worked out up front
+static const uint32_t KERNING_FIRST = 32;
+static const uint32_t KERNING_LAST  = 126;
+static const uint32_t KERNING_COUNT = KERNING_LAST - KERNING_FIRST + 1;
+
+std::unordered_map<std::string, std::weak_ptr<FontFace>> FontFace::__faces;
+
+FontFace::Sptr FontFace::Get(const std::string& fontPath) {
+	// Re-use the face if someone else already has it loaded
+	auto it = __faces.find(fontPath);
+	if (it != __faces.end()) {
+		if (Sptr face = it->second.lock()) {
+			return face;
+		}
+	}
+
+	// Open the file, if it's packed we can use the mapped data directly without a copy
+	FileView data = VirtualFileSystem::Open(fontPath);
+	if (!data || data.Empty()) {
+		LOG_ERROR("Failed to load font file from {}", fontPath);
+		return nullptr;
+	}
+
+	Sptr result = std::make_shared<FontFace>(data);
+	if (!result->IsValid()) {
+		return nullptr;
+	}
+	__faces[fontPath] = result;
+	return result;
+}
+
+FontFace::FontFace(const FileView& data) :
+	_source(std::make_shared<RasterSource>()),
+	_results(std::make_shared<ResultQueue>()),
+	_isValid(false),
+	_ascent(0),
+	_descent(0),
+	_lineGap(0),
+	_glyphs(),
+	_codePoints(),
+	_asciiKerning(),
+	_kerning(),
+	_pages(),
+	_freeCells(),
+	_cellSize(0),
+	_cellsPerRow(0),
+	_clock(0),
+	_revision(0)
+{
+	_source->Data = data;
+	_source->Info = stbtt_fontinfo();
+	_source->Scale = 0.0f;
+
+	// Attempt to initialize the font from the data read from the file
+	const uint8_t* rawData = _source->Data.GetData();
+	if (!stbtt_InitFont(&_source->Info, rawData, stbtt_GetFontOffsetForIndex(rawData, 0))) {
+		LOG_ERROR("Failed to initialize font");
+		return;
+	}
+	_isValid = true;
+
+	// Gets the font metrics
+	stbtt_GetFontVMetrics(&_source->Info, &_ascent, &_descent, &_lineGap);
+	_source->Scale = stbtt_ScaleForPixelHeight(&_source->Info, SDF_SIZE);
+
+	// Every glyph gets the same size of cell, big enough for anything between the ascender
+	// and descender. This lets us hand cells out and take them back without any packing
+	_cellSize = (uint32_t)glm::ceil((_ascent - _descent) * _source->Scale) + SDF_PADDING * 2;
+	_cellsPerRow = PAGE_SIZE / _cellSize;
+
+	for (uint32_t ix = 0; ix < 128; ix++) {
+		_asciiGlyphs[ix] = stbtt_FindGlyphIndex(&_source->Info, ix);
+	}
+
+	// Text is mostly ASCII, so we look up the kerning for those pairs ahead of time
+	_asciiKerning.resize(KERNING_COUNT * KERNING_COUNT);
+	for (uint32_t left = 0; left < KERNING_COUNT; left++) {
+		for (uint32_t right = 0; right < KERNING_COUNT; right++) {
+			_asciiKerning[left * KERNING_COUNT + right] = (int16_t)stbtt_GetGlyphKernAdvance(&_source->Info,
+				_asciiGlyphs[KERNING_FIRST + left], _asciiGlyphs[KERNING_FIRST + right]);
+		}
+	}
+}
+
+bool FontFace::IsValid() const {
+	return _isValid;
+}
+
+float FontFace::GetScaleForPixelHeight(float size) const {
+	return _isValid ? stbtt_ScaleForPixelHeight(&_source->Info, size) : 0.0f;
+}
+
+const FontFace::Glyph& FontFace::GetGlyph(uint32_t codePoint) {
+	GlyphSlot& slot = _GetSlot(_GetGlyphIndex(codePoint));
+	slot.LastUsed = ++_clock;
+	if (slot.State == GlyphState::Unloaded) {
+		_Rasterize(slot);
+	}
+	return slot.Info;
+}
+
+void FontFace::Request(uint32_t codePoint) {
+	GetGlyph(codePoint);
+}
+
+int FontFace::GetKerning(uint32_t char1, uint32_t char2) {
+	if (!_isValid) {
+		return 0;
+	}
+
+	if (char1 >= KERNING_FIRST && char1 <= KERNING_LAST && char2 >= KERNING_FIRST && char2 <= KERNING_LAST) {
+		return _asciiKerning[(char1 - KERNING_FIRST) * KERNING_COUNT + (char2 - KERNING_FIRST)];
+	}
+
+	uint64_t key = ((uint64_t)char1 << 32) | char2;
+	auto it = _kerning.find(key);
+	if (it == _kerning.end()) {
+		int16_t kerning = (int16_t)stbtt_GetGlyphKernAdvance(&_source->Info, _GetGlyphIndex(char1), _GetGlyphIndex(char2));
+		it = _kerning.emplace(key, kerning).first;
+	}
+	return it->second;
+}
+
+const Texture2D::Sptr& FontFace::GetPage(uint32_t page) const {
+	static const Texture2D::Sptr none = nullptr;
+	return page < _pages.size() ? _pages[page].Texture : none;
+}
+
+uint32_t FontFace::GetRevision() {
+	_UploadResults();
+	return _revision;
+}
+
+int FontFace::_GetGlyphIndex(uint32_t codePoint) {
+	if (!_isValid) {
+		return 0;
+	}
+	if (codePoint < 128) {
+		return _asciiGlyphs[codePoint];
+	}
+
+	// Glyph index 0 is the font's missing glyph, so unknown codepoints fall back to that
+	auto it = _codePoints.find(codePoint);
+	if (it == _codePoints.end()) {
+		it = _codePoints.emplace(codePoint, stbtt_FindGlyphIndex(&_source->Info, codePoint)).first;
+	}
+	return it->second;
+}
+
+FontFace::GlyphSlot& FontFace::_GetSlot(int glyphIndex) {
+	auto it = _glyphs.find(glyphIndex);
+	if (it != _glyphs.end()) {
+		return it->second;
+	}
+
+	GlyphSlot slot = GlyphSlot();
+	slot.Info = Glyph();
+	slot.Info.Index = glyphIndex;
+	slot.State = GlyphState::Unloaded;
+
+	if (_isValid) {
+		int leftBearing = 0;
+		stbtt_GetGlyphHMetrics(&_source->Info, glyphIndex, &slot.Info.Advance, &leftBearing);
+
+		// This is the same box the distance field will cover, before the padding is added
+		int x0, y0, x1, y1;
+		stbtt_GetGlyphBitmapBox(&_source->Info, glyphIndex, _source->Scale, _source->Scale, &x0, &y0, &x1, &y1);
+
+		uint32_t width = (uint32_t)(x1 - x0) + SDF_PADDING * 2;
+		uint32_t height = (uint32_t)(y1 - y0) + SDF_PADDING * 2;
+
+		// Glyphs with no outline (like spaces) don't need any space in the atlas
+		if (x0 == x1 || y0 == y1) {
+			slot.State = GlyphState::Ready;
+		}
+		else if (width > _cellSize || height > _cellSize) {
+			LOG_WARN("Glyph {} ({}x{}) is too big for the font atlas, it will not be drawn", glyphIndex, width, height);
+			slot.State = GlyphState::Ready;
+		}
+		else {
+			slot.Info.Min = glm::vec2(x0 - SDF_PADDING, y0 - SDF_PADDING);
+			slot.Info.Max = glm::vec2(x1 + SDF_PADDING, y1 + SDF_PADDING);
+		}
+	}
+	else {
+		slot.State = GlyphState::Ready;
+	}
+	slot.Info.IsReady = slot.State == GlyphState::Ready;
+
+	return _glyphs.emplace(glyphIndex, slot).first->second;
+}
+
+void FontFace::_Rasterize(GlyphSlot& slot) {
+	uint32_t page, cell;
+	if (!_AllocateCell(page, cell)) {
+		return;
+	}
+
+	slot.State = GlyphState::Pending;
+	slot.Cell = cell;
+	slot.Info.Page = page;
+	_pages[page].Cells[cell] = slot.Info.Index;
+
+	glm::vec2 size = slot.Info.Max - slot.Info.Min;
+	glm::vec2 corner = glm::vec2((cell % _cellsPerRow) * _cellSize, (cell / _cellsPerRow) * _cellSize);
+	slot.Info.UvMin = corner / (float)PAGE_SIZE;
+	slot.Info.UvMax = (corner + size) / (float)PAGE_SIZE;
+
+	// The worker holds on to the font data and result queue, so it's fine if this face
+	// is freed while the glyph is still being rasterized
+	std::shared_ptr<RasterSource> source = _source;
+	std::shared_ptr<ResultQueue> results = _results;
+	int glyphIndex = slot.Info.Index;
+	uint32_t cellSize = _cellSize;
+
+	ThreadPool::Submit([source, results, glyphIndex, page, cell, cellSize]() {
+		RasterResult result;
+		result.GlyphIndex = glyphIndex;
+		result.Page = page;
+		result.Cell = cell;
+		result.Pixels.resize(cellSize * (size_t)cellSize, 0);
+
+		int width, height, offsetX, offsetY;
+		uint8_t* field = stbtt_GetGlyphSDF(&source->Info, source->Scale, glyphIndex, SDF_PADDING, SDF_ON_EDGE, SDF_PIXEL_DIST_SCALE,
+			&width, &height, &offsetX, &offsetY);
+
+		// Copy into the top left of the cell, so the whole cell gets overwritten when it's uploaded
+		if (field != nullptr) {
+			uint32_t rows = glm::min((uint32_t)height, cellSize);
+			uint32_t columns = glm::min((uint32_t)width, cellSize);
+			for (uint32_t iy = 0; iy < rows; iy++) {
+				memcpy(result.Pixels.data() + iy * cellSize, field + iy * width, columns);
+			}
+			stbtt_FreeSDF(field, nullptr);
+		}
+
+		std::lock_guard<std::mutex> lock(results->Mutex);
+		results->Results.push_back(std::move(result));
+		results->HasResults = true;
+	});
+}
+
+bool FontFace::_AllocateCell(uint32_t& page, uint32_t& cell) {
+	if (_freeCells.empty()) {
+		// Add another page if we're allowed one
+		if (_pages.size() < MAX_PAGES) {
+			Texture2DDescription desc = Texture2DDescription();
+			desc.Width = PAGE_SIZE;
+			desc.Height = PAGE_SIZE;
+			// RGBA so the GUI atlas can copy pages in directly, the distance is in red
+			desc.Format = InternalFormat::RGBA8;
+			desc.HorizontalWrap = WrapMode::ClampToEdge;
+			desc.VerticalWrap = WrapMode::ClampToEdge;
+			desc.MinificationFilter = MinFilter::Linear;
+			desc.MagnificationFilter = MagFilter::Linear;
+			desc.GenerateMipMaps = false;
+
+			Page newPage;
+			newPage.Texture = std::make_shared<Texture2D>(desc);
+			newPage.Texture->Clear(glm::vec4(0.0f));
+			newPage.Cells.resize(_cellsPerRow * _cellsPerRow, -1);
+
+			// Pushed in reverse so that cells are handed out from the top left
+			uint32_t pageIndex = (uint32_t)_pages.size();
+			for (uint32_t ix = (uint32_t)newPage.Cells.size(); ix > 0; ix--) {
+				_freeCells.push_back({ pageIndex, ix - 1 });
+			}
+			_pages.push_back(std::move(newPage));
+		}
+		// Otherwise we make room by evicting the glyph that's gone the longest without being used
+		else {
+			GlyphSlot* oldest = nullptr;
+			for (auto& [index, slot] : _glyphs) {
+				if (slot.State == GlyphState::Ready && slot.Info.Max != slot.Info.Min && (oldest == nullptr || slot.LastUsed < oldest->LastUsed)) {
+					oldest = &slot;
+				}
+			}
+			if (oldest == nullptr) {
+				LOG_WARN("Font atlas is full of glyphs that are still being rasterized");
+				return false;
+			}
+
+			oldest->State = GlyphState::Unloaded;
+			oldest->Info.IsReady = false;
+			_pages[oldest->Info.Page].Cells[oldest->Cell] = -1;
+			_freeCells.push_back({ oldest->Info.Page, oldest->Cell });
+			_revision++;
+		}
+	}
+
+	page = _freeCells.back().first;
+	cell = _freeCells.back().second;
+	_freeCells.pop_back();
+	return true;
+}
+
+void FontFace::_UploadResults() {
+	if (!_results->HasResults) {
+		return;
+	}
+
+	std::vector<RasterResult> results;
+	{
+		std::lock_guard<std::mutex> lock(_results->Mutex);
+		results.swap(_results->Results);
+		_results->HasResults = false;
+	}
+
+	for (RasterResult& result : results) {
+		// Make sure the cell still belongs to the glyph
+		auto it = _glyphs.find(result.GlyphIndex);
+		if (it == _glyphs.end() || it->second.State != GlyphState::Pending || it->second.Info.Page != result.Page || it->second.Cell != result.Cell) {
+			continue;
+		}
+
+		uint32_t x = (result.Cell % _cellsPerRow) * _cellSize;
+		uint32_t y = (result.Cell / _cellsPerRow) * _cellSize;
+		_pages[result.Page].Texture->LoadData(_cellSize, _cellSize, PixelFormat::Red, PixelType::UByte, result.Pixels.data(), x, y);
+
+		it->second.State = GlyphState::Ready;
+		it->second.Info.IsReady = true;
+		_revision++;
+	}
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+#include "Graphics/Texture2D.h"
+#include "Utils/AssetPack.h"
+
+#include <stb_truetype.h>
+
+/// <summary>
+/// A typeface loaded from a truetype file, shared by every Font that uses the file.
+/// Glyphs are stored as signed distance fields at a single size, so one set of atlas
+/// pages serves every font size. Glyphs are rasterized on a worker thread the first
+/// time they are asked for, and the least recently used glyphs are evicted once the
+/// pages fill up
+/// </summary>
+class FontFace {
+public:
+	typedef std::shared_ptr<FontFace> Sptr;
+
+	// The pixel height glyphs are rasterized at, fonts of other sizes scale from this
+	static const float    SDF_SIZE;
+	// How far the distance field extends past the edge of a glyph, in pixels
+	static const int      SDF_PADDING;
+	// The width and height of an atlas page
+	static const uint32_t PAGE_SIZE;
+	// How many pages we're allowed before we start evicting glyphs
+	static const uint32_t MAX_PAGES;
+
+	/// <summary>
+	/// A glyph's metrics and where it lives in the atlas
+	/// </summary>
+	struct Glyph {
+		int       Index;
+		// Horizontal advance, in font units
+		int       Advance;
+		// The bounds of the glyph's quad relative to the pen, in pixels at SDF_SIZE.
+		// Includes the distance field padding
+		glm::vec2 Min;
+		glm::vec2 Max;
+		// Where the glyph is in its page
+		glm::vec2 UvMin;
+		glm::vec2 UvMax;
+		uint32_t  Page;
+		// True once the glyph has been rasterized and uploaded, until then it only has metrics
+		bool      IsReady;
+	};
+
+	/// <summary>
+	/// Gets the typeface for the given truetype file, loading it if no one else is using it
+	/// </summary>
+	/// <param name="fontPath">The path to the truetype font</param>
+	/// <returns>The typeface, or nullptr if it could not be loaded</returns>
+	static Sptr Get(const std::string& fontPath);
+
+	FontFace(const FileView& data);
+	~FontFace() = default;
+
+	FontFace(const FontFace& other) = delete;
+	FontFace& operator=(const FontFace& other) = delete;
+
+	/// <summary>
+	/// Returns true if the font data could be loaded
+	/// </summary>
+	bool IsValid() const;
+
+	/// <summary>
+	/// Gets the scale that converts font units to pixels for a font of the given pixel height
+	/// </summary>
+	float GetScaleForPixelHeight(float size) const;
+	int GetAscent() const { return _ascent; }
+	int GetDescent() const { return _descent; }
+	int GetLineGap() const { return _lineGap; }
+
+	/// <summary>
+	/// Gets the glyph for a unicode codepoint, queuing it to be rasterized if it isn't
+	/// in the atlas. Codepoints the font doesn't have give the font's missing glyph
+	/// </summary>
+	/// <param name="codePoint">The unicode codepoint to look up</param>
+	const Glyph& GetGlyph(uint32_t codePoint);
+	/// <summary>
+	/// Queues a glyph to be rasterized ahead of time, if it isn't already
+	/// </summary>
+	/// <param name="codePoint">The unicode codepoint to rasterize</param>
+	void Request(uint32_t codePoint);
+
+	/// <summary>
+	/// Gets the kerning between 2 unicode characters, in font units
+	/// </summary>
+	int GetKerning(uint32_t char1, uint32_t char2);
+
+	/// <summary>
+	/// Gets one of the atlas pages, see Glyph::Page
+	/// </summary>
+	const Texture2D::Sptr& GetPage(uint32_t page) const;
+	/// <summary>
+	/// Gets the number of atlas pages that have been created
+	/// </summary>
+	uint32_t GetPageCount() const { return (uint32_t)_pages.size(); }
+
+	/// <summary>
+	/// Uploads any glyphs that have finished rasterizing. Returns a number that changes
+	/// whenever glyphs are added to or evicted from the atlas, so text can tell when it
+	/// needs to be rebuilt
+	/// </summary>
+	uint32_t GetRevision();
+
+private:
+	// Everything the worker threads need, which doesn't change once it's loaded
+	struct RasterSource {
+		FileView       Data;
+		stbtt_fontinfo Info;
+		float          Scale;
+	};
+
+	// A glyph that a worker has finished with, the pixels cover its whole cell
+	struct RasterResult {
+		int      GlyphIndex;
+		uint32_t Page;
+		uint32_t Cell;
+		std::vector<uint8_t> Pixels;
+	};
+
+	// Finished glyphs waiting to be uploaded, the workers add to this
+	struct ResultQueue {
+		std::mutex                Mutex;
+		std::vector<RasterResult> Results;
+		std::atomic<bool>         HasResults{ false };
+	};
+
+	enum class GlyphState {
+		Unloaded,
+		Pending,
+		Ready
+	};
+
+	struct GlyphSlot {
+		Glyph      Info;
+		GlyphState State;
+		uint32_t   Cell;
+		uint64_t   LastUsed;
+	};
+
+	struct Page {
+		Texture2D::Sptr Texture;
+		// The glyph index in each cell, or -1 for an empty cell
+		std::vector<int> Cells;
+	};
+
+	std::shared_ptr<RasterSource> _source;
+	std::shared_ptr<ResultQueue>  _results;
+	bool                          _isValid;
+
+	int _ascent, _descent, _lineGap;
+
+	// Glyph slots by glyph index, and the glyph index for each codepoint we've seen
+	std::unordered_map<int, GlyphSlot>     _glyphs;
+	std::unordered_map<uint32_t, int>      _codePoints;
+	int                                    _asciiGlyphs[128];
+
+	// Kerning between every pair of printable ASCII characters, anything else
+	// is looked up once and remembered
+	std::vector<int16_t>                   _asciiKerning;
+	std::unordered_map<uint64_t, int16_t>  _kerning;
+
+	std::vector<Page>                      _pages;
+	std::vector<std::pair<uint32_t, uint32_t>> _freeCells;
+	uint32_t                               _cellSize;
+	uint32_t                               _cellsPerRow;
+
+	uint64_t                               _clock;
+	uint32_t                               _revision;
+
+	int _GetGlyphIndex(uint32_t codePoint);
+	GlyphSlot& _GetSlot(int glyphIndex);
+	void _Rasterize(GlyphSlot& slot);
+	bool _AllocateCell(uint32_t& page, uint32_t& cell);
+	void _UploadResults();
+
+	static std::unordered_map<std::string, std::weak_ptr<FontFace>> __faces;
+};
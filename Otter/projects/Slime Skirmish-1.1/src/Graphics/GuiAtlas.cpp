@@ -0,0 +1,154 @@
+#include "Graphics/GuiAtlas.h"
+#include <vector>
+#include "Logging.h"
+
+// Each texture gets a border of its own edge pixels, so filtering at the edges of a
+// region doesn't pick up its neighbours
+static const uint32_t REGION_PADDING = 1;
+
+GuiAtlas::GuiAtlas(uint32_t size) :
+	_texture(nullptr),
+	_size(glm::min(size, (uint32_t)ITexture::GetLimits().MAX_TEXTURE_SIZE)),
+	_entries(),
+	_packedCount(0),
+	_shelfX(0),
+	_shelfY(0),
+	_shelfHeight(0)
+{
+	Texture2DDescription desc = Texture2DDescription();
+	desc.Width = _size;
+	desc.Height = _size;
+	desc.Format = InternalFormat::RGBA8;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	desc.MinificationFilter = MinFilter::Linear;
+	desc.MagnificationFilter = MagFilter::Linear;
+	desc.GenerateMipMaps = false;
+
+	_texture = std::make_shared<Texture2D>(desc);
+	_texture->Clear(glm::vec4(0.0f));
+}
+
+bool GuiAtlas::TryGetRegion(const Texture2D::Sptr& texture, Region& result) {
+	auto it = _entries.find(texture.get());
+
+	// New texture, or something new has taken the place of a freed one. The old
+	// texture's space isn't reclaimed, GUI textures tend to live as long as the game
+	if (it == _entries.end() || it->second.Source.expired()) {
+		Entry& entry = _entries[texture.get()];
+		entry.Source = texture;
+		_Pack(texture, entry);
+		it = _entries.find(texture.get());
+	}
+
+	result = it->second.Mapping;
+	return it->second.IsPacked;
+}
+
+bool GuiAtlas::_Allocate(uint32_t width, uint32_t height, glm::uvec2& position) {
+	if (width > _size || height > _size) {
+		return false;
+	}
+
+	// Start a new shelf if we've run out of room on this one
+	if (_shelfX + width > _size) {
+		_shelfY += _shelfHeight;
+		_shelfX = 0;
+		_shelfHeight = 0;
+	}
+	if (_shelfY + height > _size) {
+		return false;
+	}
+
+	position = { _shelfX, _shelfY };
+	_shelfX += width;
+	_shelfHeight = glm::max(_shelfHeight, height);
+	return true;
+}
+
+void GuiAtlas::_Pack(const Texture2D::Sptr& texture, Entry& entry) {
+	uint32_t width = texture->GetWidth();
+	uint32_t height = texture->GetHeight();
+
+	entry.Mapping.Mode = texture->GetMagFilter() == MagFilter::Nearest ? GuiSampleMode::Nearest : GuiSampleMode::Linear;
+
+	// Textures that don't fit keep their own UVs, and get drawn with their own texture bound
+	entry.Mapping.UvOffset = glm::vec2(0.0f);
+	entry.Mapping.UvScale = glm::vec2(1.0f);
+	entry.IsPacked = false;
+
+	uint32_t paddedWidth = width + REGION_PADDING * 2;
+	uint32_t paddedHeight = height + REGION_PADDING * 2;
+	if (width == 0 || height == 0 || !_Allocate(paddedWidth, paddedHeight, entry.Position)) {
+		LOG_WARN("Texture ({}x{}) does not fit in the GUI atlas, it will be drawn separately", width, height);
+		return;
+	}
+
+	_Copy(texture, entry);
+
+	entry.Mapping.UvOffset = glm::vec2(entry.Position + glm::uvec2(REGION_PADDING)) / (float)_size;
+	entry.Mapping.UvScale = glm::vec2(width, height) / (float)_size;
+	entry.IsPacked = true;
+	_packedCount++;
+}
+
+void GuiAtlas::Refresh() {
+	for (auto& [key, entry] : _entries) {
+		if (!entry.IsPacked) {
+			continue;
+		}
+		Texture2D::Sptr texture = entry.Source.lock();
+		if (texture != nullptr && texture->GetRevision() != entry.Revision) {
+			_Copy(texture, entry);
+		}
+	}
+}
+
+void GuiAtlas::_Copy(const Texture2D::Sptr& texture, Entry& entry) {
+	uint32_t width = texture->GetWidth();
+	uint32_t height = texture->GetHeight();
+	glm::uvec2 position = entry.Position;
+	entry.Revision = texture->GetRevision();
+
+	// Textures in the same format can be copied on the GPU without waiting on a readback.
+	// The border is made of copies of the edge rows and columns, and the corner pixels
+	if (texture->GetFormat() == InternalFormat::RGBA8) {
+		GLuint source = texture->GetHandle();
+		GLuint target = _texture->GetHandle();
+		uint32_t right = width - 1;
+		uint32_t bottom = height - 1;
+		uint32_t pad = REGION_PADDING;
+
+		// Interior, left/right columns, top/bottom rows
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, 0,     0,      0, target, GL_TEXTURE_2D, 0, position.x + pad,         position.y + pad,          0, width, height, 1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, 0,     0,      0, target, GL_TEXTURE_2D, 0, position.x,               position.y + pad,          0, 1,     height, 1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, right, 0,      0, target, GL_TEXTURE_2D, 0, position.x + pad + width, position.y + pad,          0, 1,     height, 1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, 0,     0,      0, target, GL_TEXTURE_2D, 0, position.x + pad,         position.y,                0, width, 1,      1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, 0,     bottom, 0, target, GL_TEXTURE_2D, 0, position.x + pad,         position.y + pad + height, 0, width, 1,      1);
+		// Corners
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, 0,     0,      0, target, GL_TEXTURE_2D, 0, position.x,               position.y,                0, 1,     1,      1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, right, 0,      0, target, GL_TEXTURE_2D, 0, position.x + pad + width, position.y,                0, 1,     1,      1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, 0,     bottom, 0, target, GL_TEXTURE_2D, 0, position.x,               position.y + pad + height, 0, 1,     1,      1);
+		glCopyImageSubData(source, GL_TEXTURE_2D, 0, right, bottom, 0, target, GL_TEXTURE_2D, 0, position.x + pad + width, position.y + pad + height, 0, 1,     1,      1);
+		return;
+	}
+
+	uint32_t paddedWidth = width + REGION_PADDING * 2;
+	uint32_t paddedHeight = height + REGION_PADDING * 2;
+
+	// Grab the texture's pixels back from the GPU. Formats with fewer channels are expanded,
+	// so a font's coverage ends up in the red channel
+	std::vector<glm::u8vec4> source(width * height);
+	glGetTextureImage(texture->GetHandle(), 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)(source.size() * sizeof(glm::u8vec4)), source.data());
+
+	// Copy into a padded image, repeating the edge pixels into the border
+	std::vector<glm::u8vec4> padded(paddedWidth * paddedHeight);
+	for (uint32_t iy = 0; iy < paddedHeight; iy++) {
+		uint32_t sy = (uint32_t)glm::clamp((int)iy - (int)REGION_PADDING, 0, (int)height - 1);
+		for (uint32_t ix = 0; ix < paddedWidth; ix++) {
+			uint32_t sx = (uint32_t)glm::clamp((int)ix - (int)REGION_PADDING, 0, (int)width - 1);
+			padded[iy * paddedWidth + ix] = source[sy * width + sx];
+		}
+	}
+	_texture->LoadData(paddedWidth, paddedHeight, PixelFormat::RGBA, PixelType::UByte, padded.data(), position.x, position.y);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <unordered_map>
+#include <memory>
+#include "Graphics/Texture2D.h"
+
+/// <summary>
+/// How the GUI shader should sample the texture for a vertex
+/// </summary>
+enum class GuiSampleMode : uint8_t {
+	Linear       = 0, // Regular filtered sprite
+	Nearest      = 1, // Snaps to texel centers, for textures that were set to nearest filtering
+	FontDistance = 2  // Red channel is a glyph's signed distance field, color comes from the vertex
+};
+
+/// <summary>
+/// Packs the textures used by the GUI into one shared texture, so that the GUI can
+/// be drawn without switching textures. Textures are copied in the first time they
+/// are used, and keep their spot for as long as they are alive. Textures that change
+/// afterwards (like font pages) are copied again by Refresh
+/// </summary>
+class GuiAtlas {
+public:
+	typedef std::shared_ptr<GuiAtlas> Sptr;
+
+	/// <summary>
+	/// Where a texture ended up in the atlas. A UV in the source texture maps to
+	/// UvOffset + UV * UvScale in the atlas. Mode is how the texture wants to be
+	/// filtered, fonts are flagged by the batcher instead
+	/// </summary>
+	struct Region {
+		glm::vec2     UvOffset;
+		glm::vec2     UvScale;
+		GuiSampleMode Mode;
+	};
+
+	static inline Sptr Create(uint32_t size = 2048) {
+		return std::make_shared<GuiAtlas>(size);
+	}
+
+	GuiAtlas(uint32_t size);
+	~GuiAtlas() = default;
+
+	GuiAtlas(const GuiAtlas& other) = delete;
+	GuiAtlas& operator=(const GuiAtlas& other) = delete;
+
+	/// <summary>
+	/// Gets the region of the atlas holding the given texture, copying it in if this
+	/// is the first time we've seen it. Returns false if the texture doesn't fit, in
+	/// which case it needs to be drawn on its own
+	/// </summary>
+	/// <param name="texture">The texture to look up</param>
+	/// <param name="result">Receives the texture's region in the atlas</param>
+	bool TryGetRegion(const Texture2D::Sptr& texture, Region& result);
+
+	/// <summary>
+	/// Copies in any packed textures that have had data loaded into them since they
+	/// were last copied. Should be called before drawing from the atlas
+	/// </summary>
+	void Refresh();
+
+	/// <summary>
+	/// Gets the texture that everything is packed into
+	/// </summary>
+	const Texture2D::Sptr& GetTexture() const { return _texture; }
+
+	/// <summary>
+	/// Gets the number of textures that have been packed into the atlas
+	/// </summary>
+	size_t GetPackedCount() const { return _packedCount; }
+
+private:
+	struct Entry {
+		// Lets us tell if the texture was freed and something else took its address
+		std::weak_ptr<Texture2D> Source;
+		Region     Mapping;
+		bool       IsPacked;
+		// Where the padded copy starts, and the source's revision when it was copied
+		glm::uvec2 Position;
+		uint32_t   Revision;
+	};
+
+	Texture2D::Sptr _texture;
+	uint32_t        _size;
+	std::unordered_map<Texture2D*, Entry> _entries;
+	size_t          _packedCount;
+
+	// Shelf packer state, textures are placed left to right in rows
+	uint32_t _shelfX;
+	uint32_t _shelfY;
+	uint32_t _shelfHeight;
+
+	bool _Allocate(uint32_t width, uint32_t height, glm::uvec2& position);
+	void _Pack(const Texture2D::Sptr& texture, Entry& entry);
+	void _Copy(const Texture2D::Sptr& texture, Entry& entry);
+};
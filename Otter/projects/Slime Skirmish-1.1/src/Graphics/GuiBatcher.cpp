@@ -2,56 +2,95 @@
 #include <GLM/gtc/matrix_transform.hpp>
 #include <GLM/gtc/matrix_inverse.hpp>
 #include "Utils/ResourceManager/ResourceManager.h"
-#include <locale>
-#include <codecvt>
+#include <algorithm>
+#include <iterator>
+#include "Graphics/TextLayout.h"
+#include "Utils/Utf8.h"
 
+// The pool bookkeeping has to outlive __immediate, since destroying a geometry hands its range back
+uint32_t GuiBatcher::__poolCapacity = 0;
+std::map<uint32_t, uint32_t> GuiBatcher::__freeRanges;
+std::vector<GuiGeometry*> GuiBatcher::__residentGeometry;
+uint32_t GuiBatcher::__indexedQuads = 0;
 
-std::unordered_map<Texture2D*, GuiBatcher::MeshData> GuiBatcher::_meshBuilders;
+std::vector<GuiBatcher::Command> GuiBatcher::__commands;
+Texture2D* GuiBatcher::__commandTexture = nullptr;
+GuiGeometry GuiBatcher::__immediate;
+
+Texture2D* GuiBatcher::__lastTexture = nullptr;
+GuiAtlas::Region GuiBatcher::__lastRegion = GuiAtlas::Region();
+bool GuiBatcher::__lastPacked = false;
 
 VertexArrayObject::Sptr GuiBatcher::__vao = nullptr;
 IndexBuffer::Sptr GuiBatcher::__ibo = nullptr;
+GuiGeometry* GuiBatcher::__recording = nullptr;
+
+std::vector<GLsizei> GuiBatcher::__drawCounts;
+std::vector<GLint> GuiBatcher::__drawBaseVertices;
+std::vector<const void*> GuiBatcher::__drawOffsets;
+int GuiBatcher::__drawCount = 0;
 
 Texture2D::Sptr GuiBatcher::__defaultUITexture = nullptr;
 int GuiBatcher::__defaultEdgeRadius = 0;
 
 VertexBuffer::Sptr GuiBatcher::__vbo = nullptr;
 Shader::Sptr GuiBatcher::__shader = nullptr;
-Shader::Sptr GuiBatcher::__fontShader = nullptr;
+GuiAtlas::Sptr GuiBatcher::__atlas = nullptr;
 glm::ivec2 GuiBatcher::__windowSize = { 0, 0 };
 glm::mat4 GuiBatcher::__projection = glm::mat4(1.0f);
 glm::mat3 GuiBatcher::__model = glm::mat3(1.0f);
 std::vector<glm::mat3> GuiBatcher::__modelTransformStack = std::vector<glm::mat3>();
 std::vector<GuiBatcher::IRect> GuiBatcher::__scissorRects = std::vector<GuiBatcher::IRect>();
 
+GuiGeometry::GuiGeometry() :
+	_vertices(),
+	_texture(nullptr),
+	_model(glm::mat3(1.0f)),
+	_isDirty(true),
+	_offset(0),
+	_capacity(0),
+	_isResident(false)
+{ }
+
+GuiGeometry::~GuiGeometry() {
+	GuiBatcher::__FreeRange(*this);
+}
+
+GuiGeometry::GuiGeometry(const GuiGeometry& other) :
+	GuiGeometry()
+{ }
+
+GuiGeometry& GuiGeometry::operator=(const GuiGeometry& other) {
+	MarkDirty();
+	return *this;
+}
+
+void GuiGeometry::MarkDirty() {
+	_isDirty = true;
+}
+
+bool GuiGeometry::NeedsRebuild() const {
+	return _isDirty || _model != GuiBatcher::GetModelTransform();
+}
+
 void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, const glm::vec2 uvMin, const glm::vec2 uvMax) {
-	// Create vertices and transform positions
-	VertexPosColTex verts[4];
-	verts[0].Position = __model * glm::vec3(min.x, min.y, 1.0f);
-	verts[1].Position = __model * glm::vec3(min.x, max.y, 1.0f);
-	verts[2].Position = __model * glm::vec3(max.x, max.y, 1.0f);
-	verts[3].Position = __model * glm::vec3(max.x, min.y, 1.0f);
-
-	// Grab mesh info for the texture batch
-	MeshData& mesh = _meshBuilders[tex.get()];
-	// We can use the vertex count for depth, so that things drawn later have a bit of spacing
-	float depth = mesh.Builder.GetVertexCount() / 1000.0f;
-
-	// Copy in all color and set depth 
-	for (int ix = 0; ix < 4; ix++) {
-		verts[ix].Color = color;
-		verts[ix].Position.z = depth;
-	}
+	// Transform positions. GUI is drawn without depth testing, so the order things
+	// are pushed in decides what ends up on top
+	glm::vec2 positions[4];
+	positions[0] = __model * glm::vec3(min.x, min.y, 1.0f);
+	positions[1] = __model * glm::vec3(min.x, max.y, 1.0f);
+	positions[2] = __model * glm::vec3(max.x, max.y, 1.0f);
+	positions[3] = __model * glm::vec3(max.x, min.y, 1.0f);
 
 	// Copy over UV coords
-	verts[0].UV = glm::vec2(uvMin.x, uvMax.y);
-	verts[1].UV = glm::vec2(uvMin.x, uvMin.y);
-	verts[2].UV = glm::vec2(uvMax.x, uvMin.y);
-	verts[3].UV = glm::vec2(uvMax.x, uvMax.y);
-
-	// Add vertices and indices to range
-	uint32_t ix = mesh.Builder.AddVertexRange(verts, 4);
-	mesh.Builder.AddIndexTri(ix + 0, ix + 2, ix + 1);
-	mesh.Builder.AddIndexTri(ix + 0, ix + 3, ix + 2);
+	glm::vec2 uvs[4];
+	uvs[0] = glm::vec2(uvMin.x, uvMax.y);
+	uvs[1] = glm::vec2(uvMin.x, uvMin.y);
+	uvs[2] = glm::vec2(uvMax.x, uvMin.y);
+	uvs[3] = glm::vec2(uvMax.x, uvMax.y);
+
+	// Adds the quad to either the geometry being recorded or the frame's command list
+	__AddQuad(tex, false, positions, uvs, color);
 }
 
 void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, int edgeRadius)
@@ -98,113 +137,337 @@ void GuiBatcher::SetProjection(const glm::mat4& projection) {
 }
 
 void GuiBatcher::RenderText(const std::wstring& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/) {
-	// How many characters we have
-	size_t length = text.size();
-
-	// Tracks the offset of the character
-	glm::vec2 offset = glm::vec2(0.0f);
+	// Layouts are cached by their UTF-8 text. The buffer is re-used, so once it's grown
+	// to fit our strings this doesn't allocate
+	static std::string utf8;
+	utf8.clear();
+	Utf8::Append(utf8, text);
+	RenderText(utf8, font, position, color, scale);
+}
 
+void GuiBatcher::RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/)
+{
 	// Transform the origin based off the model transform
 	glm::vec2 origin = __model * glm::vec3(position, 1.0f);
 
-	// Gets the texture used to render the font
-	Texture2D::Sptr atlas = font->GetAtlas();
-
-	// Grab the mesh builder and make sure it's a texture batch
-	MeshData& mesh = _meshBuilders[atlas.get()];
-	mesh.IsFont = true;
+	// Text that hasn't changed since it was last drawn doesn't need to be laid out again
+	const TextLayout& layout = TextLayoutCache::Get(font, text, scale);
 
 	// Allocate some space for the vertices
-	VertexPosColTex verts[4];
-	verts[0].Color = color;
-	verts[1].Color = color;
-	verts[2].Color = color;
-	verts[3].Color = color;
-
-	// Iterate over all characters in string
-	for (int i = 0; i < length; i++) {
-		// Grab the glyph data for the character
-		GlyphInfo glyph = font->GetGlyph(text[i], offset.x, offset.y);
-
-		// A newline will advance to the next line and return to the start of the line
-		if (text[i] == '\n') {
-			offset.y += font->GetLineHeight() * scale;
-			offset.x = 0;
+	glm::vec2 positions[4];
+
+	for (const TextLayout::Glyph& glyph : layout.Glyphs) {
+		positions[0] = origin + glyph.Positions[0];
+		positions[1] = origin + glyph.Positions[1];
+		positions[2] = origin + glyph.Positions[2];
+		positions[3] = origin + glyph.Positions[3];
+
+		__AddQuad(font->GetAtlas(glyph.Page), true, positions, glyph.UVs, color);
+	}
+}
+
+void GuiBatcher::BeginGeometry(GuiGeometry& geometry) {
+	LOG_ASSERT(__recording == nullptr, "GUI geometry is already being recorded!");
+	geometry._vertices.clear();
+	geometry._texture = nullptr;
+	geometry._model = __model;
+	geometry._isResident = false;
+	__recording = &geometry;
+}
+
+void GuiBatcher::EndGeometry() {
+	LOG_ASSERT(__recording != nullptr, "Geometry begin/end mismatch");
+	__recording->_isDirty = false;
+	__recording = nullptr;
+}
+
+void GuiBatcher::PushGeometry(GuiGeometry& geometry) {
+	if (geometry.GetQuadCount() > 0) {
+		__AddTextureCommand(geometry._texture.get());
+		__AddQuadsCommand(&geometry, 0, geometry.GetQuadCount());
+	}
+}
+
+const glm::mat3& GuiBatcher::GetModelTransform() {
+	return __model;
+}
+
+void GuiBatcher::Flush()
+{
+	__StaticInit();
+
+	// Immediate geometry is rebuilt every frame, so it always needs uploading. It's
+	// uploaded once, no matter how many commands draw from it
+	__immediate._isResident = false;
+
+	// Upload anything that isn't already on the GPU. If the pool had to grow, everything
+	// was evicted, so we start again
+	bool uploaded = false;
+	while (!uploaded) {
+		uploaded = true;
+		for (const Command& command : __commands) {
+			if (command.Type == CommandType::Quads && !__Upload(*command.Geometry, command.Geometry != &__immediate)) {
+				uploaded = false;
+				break;
+			}
 		}
-		// A return character simply returns to the start of the line
-		else if (text[i] == '\r') {
-			offset.x = 0;
+	}
+
+	// Pick up any changes to textures in the atlas, like glyphs being added to a font
+	__atlas->Refresh();
+
+	// Everything starts off unclipped, drawing from the atlas
+	glm::ivec4 scissor = glm::ivec4(0, 0, __windowSize.x, __windowSize.y);
+	Texture2D* texture = nullptr;
+	glScissor(scissor.x, scissor.y, scissor.z, scissor.w);
+	__atlas->GetTexture()->Bind(0);
+
+	// Bind shader, send uniforms
+	__shader->Bind();
+	__shader->SetUniformMatrix(0, &__projection, 1, false);
+	__vao->Bind();
+
+	// Walk the commands in order, quads are collected up until a state change forces us to draw them
+	__drawCount = 0;
+	for (const Command& command : __commands) {
+		switch (command.Type) {
+			case CommandType::Quads:
+			{
+				// Merge runs that sit next to each other in the pool
+				GLint baseVertex = (GLint)((command.Geometry->_offset + command.FirstQuad) * 4);
+				if (__drawCounts.size() > 0 && __drawBaseVertices.back() + (__drawCounts.back() / 6) * 4 == baseVertex) {
+					__drawCounts.back() += command.QuadCount * 6;
+				} else {
+					__drawCounts.push_back(command.QuadCount * 6);
+					__drawBaseVertices.push_back(baseVertex);
+				}
+				break;
+			}
+			case CommandType::Scissor:
+				if (command.Scissor != scissor) {
+					__DrawPending();
+					scissor = command.Scissor;
+					glScissor(scissor.x, scissor.y, scissor.z, scissor.w);
+				}
+				break;
+			case CommandType::Texture:
+				if (command.Texture != texture) {
+					__DrawPending();
+					texture = command.Texture;
+					if (texture != nullptr) {
+						texture->Bind(0);
+					} else {
+						__atlas->GetTexture()->Bind(0);
+					}
+				}
+				break;
 		}
-		// A tab character is 4 spaces
-		else if (text[i] == '\t') {
-			float xOffTemp{ 0 }, yOffTemp{ 0 };
-			glyph = font->GetGlyph(' ', xOffTemp, yOffTemp);
-			offset.x += glyph.OffsetX * 4;
+	}
+	__DrawPending();
+	VertexArrayObject::Unbind();
+
+	// Leave the scissor covering the whole window
+	glScissor(0, 0, __windowSize.x, __windowSize.y);
+
+	// Clear batch
+	__commands.clear();
+	__commandTexture = nullptr;
+	__lastTexture = nullptr;
+	__immediate._vertices.clear();
+}
+
+int GuiBatcher::GetLastDrawCount() {
+	return __drawCount;
+}
+
+void GuiBatcher::__DrawPending() {
+	if (__drawCounts.size() == 0) {
+		return;
+	}
+
+	uint32_t maxQuads = 0;
+	for (GLsizei count : __drawCounts) {
+		maxQuads = glm::max(maxQuads, (uint32_t)count / 6);
+	}
+	__EnsureQuadIndices(maxQuads);
+	__drawOffsets.resize(__drawCounts.size(), nullptr);
+
+	// Every quad shares the same indices, offset by the base vertex
+	glMultiDrawElementsBaseVertex(GL_TRIANGLES, __drawCounts.data(), GL_UNSIGNED_INT, __drawOffsets.data(), (GLsizei)__drawCounts.size(), __drawBaseVertices.data());
+	__drawCount++;
+
+	__drawCounts.clear();
+	__drawBaseVertices.clear();
+}
+
+void GuiBatcher::__AddQuad(const Texture2D::Sptr& tex, bool isFont, const glm::vec2* positions, const glm::vec2* uvs, const glm::vec4& color) {
+	// Find where the texture lives in the atlas, quads tend to come in runs with the same texture
+	if (tex.get() != __lastTexture) {
+		__StaticInit();
+		__lastPacked = __atlas->TryGetRegion(tex, __lastRegion);
+		__lastTexture = tex.get();
+	}
+	float mode = (float)(isFont ? GuiSampleMode::FontDistance : __lastRegion.Mode);
+
+	GuiGeometry* target = __recording;
+	if (target != nullptr) {
+		// Recorded geometry can mix anything in the atlas, but is drawn with one texture
+		LOG_ASSERT(target->GetQuadCount() == 0 || target->_texture.get() == (__lastPacked ? nullptr : tex.get()), "GUI geometry can't mix textures that aren't in the atlas!");
+		target->_texture = __lastPacked ? nullptr : tex;
+	}
+	// Otherwise the quad goes into the immediate geometry, and is drawn in the order it was pushed
+	else {
+		target = &__immediate;
+		__AddTextureCommand(__lastPacked ? nullptr : tex.get());
+		__AddQuadsCommand(target, target->GetQuadCount(), 1);
+	}
+
+	for (int ix = 0; ix < 4; ix++) {
+		target->_vertices.push_back(VertexGui(positions[ix], color, __lastRegion.UvOffset + uvs[ix] * __lastRegion.UvScale, mode));
+	}
+}
+
+void GuiBatcher::__AddTextureCommand(Texture2D* texture) {
+	if (texture != __commandTexture) {
+		__commands.push_back({ CommandType::Texture, nullptr, 0, 0, glm::ivec4(0), texture });
+		__commandTexture = texture;
+	}
+}
+
+void GuiBatcher::__AddQuadsCommand(GuiGeometry* geometry, uint32_t firstQuad, uint32_t quadCount) {
+	// Extend the last command if we're carrying on from where it left off
+	if (__commands.size() > 0) {
+		Command& last = __commands.back();
+		if (last.Type == CommandType::Quads && last.Geometry == geometry && last.FirstQuad + last.QuadCount == firstQuad) {
+			last.QuadCount += quadCount;
+			return;
 		}
-		// All other characters get rendered
-		else {
-			verts[0].Position = glm::vec3(origin + (offset + glyph.Positions[0]) * scale, 0.0f);
-			verts[1].Position = glm::vec3(origin + (offset + glyph.Positions[1]) * scale, 0.0f);
-			verts[2].Position = glm::vec3(origin + (offset + glyph.Positions[2]) * scale, 0.0f);
-			verts[3].Position = glm::vec3(origin + (offset + glyph.Positions[3]) * scale, 0.0f);
-			verts[0].UV = glyph.UVs[0];
-			verts[1].UV = glyph.UVs[1];
-			verts[2].UV = glyph.UVs[2];
-			verts[3].UV = glyph.UVs[3];
-
-			uint32_t ix = mesh.Builder.AddVertexRange(verts, 4);
-			mesh.Builder.AddIndexTri(ix + 0, ix + 1, ix + 2);
-			mesh.Builder.AddIndexTri(ix + 0, ix + 2, ix + 3);
-
-			// Advance the offset based on the size of the glyph
-			offset.x = glyph.OffsetX;
-			offset.y = glyph.OffsetY;
-
-			// If we have more characters, see if there's any kerning between the
-			// current and next character and add it to the x offset
-			if (i < length - 1) {
-				float kerning = font->GetKerning(text[i], text[i + 1]);
-				offset.x += kerning;
+	}
+	__commands.push_back({ CommandType::Quads, geometry, firstQuad, quadCount, glm::ivec4(0), nullptr });
+}
+
+bool GuiBatcher::__Upload(GuiGeometry& geometry, bool exactSize) {
+	if (geometry._isResident) {
+		return true;
+	}
+
+	// Retained geometry gets exactly the space it needs, so a static GUI packs tightly and
+	// its draws can be merged. Immediate geometry changes size every frame, so it gets room to grow
+	uint32_t quads = geometry.GetQuadCount();
+	if (quads > geometry._capacity || (exactSize && quads != geometry._capacity)) {
+		__FreeRange(geometry);
+
+		uint32_t size = quads;
+		if (!exactSize) {
+			size = 64;
+			while (size < quads) {
+				size *= 2;
 			}
 		}
 
+		uint32_t offset = 0;
+		if (!__AllocateRange(size, offset)) {
+			__GrowPool(size);
+			return false;
+		}
+		geometry._offset = offset;
+		geometry._capacity = size;
+		__residentGeometry.push_back(&geometry);
 	}
 
+	if (quads > 0) {
+		__vbo->UpdateSubData(geometry._vertices.data(), geometry._offset * 4 * sizeof(VertexGui), quads * 4 * sizeof(VertexGui));
+	}
+	geometry._isResident = true;
+	return true;
 }
 
-void GuiBatcher::RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/)
-{
-	static std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	RenderText(converter.from_bytes(text), font, position, color, scale);
+bool GuiBatcher::__AllocateRange(uint32_t quads, uint32_t& offset) {
+	// First fit, there's only ever a handful of GUI elements
+	for (auto it = __freeRanges.begin(); it != __freeRanges.end(); it++) {
+		if (it->second >= quads) {
+			offset = it->first;
+			uint32_t remaining = it->second - quads;
+			__freeRanges.erase(it);
+			if (remaining > 0) {
+				__freeRanges[offset + quads] = remaining;
+			}
+			return true;
+		}
+	}
+	return false;
 }
 
-void GuiBatcher::Flush()
-{
-	__StaticInit();
+void GuiBatcher::__FreeRange(GuiGeometry& geometry) {
+	if (geometry._capacity == 0) {
+		return;
+	}
+
+	uint32_t offset = geometry._offset;
+	uint32_t size = geometry._capacity;
+	geometry._offset = 0;
+	geometry._capacity = 0;
+	geometry._isResident = false;
+
+	auto resident = std::find(__residentGeometry.begin(), __residentGeometry.end(), &geometry);
+	if (resident != __residentGeometry.end()) {
+		*resident = __residentGeometry.back();
+		__residentGeometry.pop_back();
+	}
 
-	// Iterate over each texture and it's mesh
-	for (auto& [key, value] : _meshBuilders) {
-		Texture2D* tex = key;
-		// If the texture exists and the mesh has data
-		if (tex != nullptr && value.Builder.GetIndexCount() > 0) {
-			// Update the VAO and it's buffers
-			__vao->Bind();
-			__vbo->UpdateData(value.Builder.GetVertexDataPtr(), sizeof(VertexPosColTex), value.Builder.GetVertexCount(), true);
-			__ibo->UpdateData(value.Builder.GetIndexDataPtr(), sizeof(uint32_t), value.Builder.GetIndexCount(), true);
-
-			// Bind texture, send uniforms to shader
-			tex->Bind(0);
-			Shader::Sptr shader = value.IsFont ? __fontShader : __shader;
-			shader->Bind();
-			shader->SetUniformMatrix(0, &__projection, 1, false);
-
-			// Draw geometry
-			__vao->Draw();
-
-			// Clear mesh
-			value.Builder.Reset();
+	// Merge with the free ranges on either side
+	auto next = __freeRanges.lower_bound(offset);
+	if (next != __freeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		next = __freeRanges.erase(next);
+	}
+	if (next != __freeRanges.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
 		}
 	}
+	__freeRanges[offset] = size;
+}
+
+void GuiBatcher::__GrowPool(uint32_t minQuads) {
+	uint32_t capacity = glm::max(glm::max(__poolCapacity * 2, __poolCapacity + minQuads), 1024u);
+
+	// Reallocating the buffer throws away its contents, so evict everything. Geometry keeps
+	// a CPU copy of its vertices, so it will just be uploaded again
+	for (GuiGeometry* geometry : __residentGeometry) {
+		geometry->_offset = 0;
+		geometry->_capacity = 0;
+		geometry->_isResident = false;
+	}
+	__residentGeometry.clear();
+	__freeRanges.clear();
+	__freeRanges[0] = capacity;
+
+	__vbo->LoadData(nullptr, sizeof(VertexGui), capacity * 4);
+	__poolCapacity = capacity;
+}
+
+void GuiBatcher::__EnsureQuadIndices(uint32_t quads) {
+	if (quads <= __indexedQuads) {
+		return;
+	}
+
+	uint32_t count = glm::max(glm::max(quads, __indexedQuads * 2), 1024u);
+	std::vector<uint32_t> indices;
+	indices.reserve(count * 6);
+	for (uint32_t ix = 0; ix < count; ix++) {
+		uint32_t base = ix * 4;
+		indices.push_back(base + 0);
+		indices.push_back(base + 1);
+		indices.push_back(base + 2);
+		indices.push_back(base + 0);
+		indices.push_back(base + 2);
+		indices.push_back(base + 3);
+	}
+	__ibo->LoadData(indices.data(), indices.size());
+	__indexedQuads = count;
 }
 
 void GuiBatcher::PushModelTransform(const glm::mat3& transform) {
@@ -227,78 +490,70 @@ void GuiBatcher::__StaticInit()
 {
 	static bool needsInit = true;
 	if (needsInit) {
+		// One shader covers sprites and text, the vertices say how to sample the texture
 		__shader = Shader::Create();
 		__shader->LoadShaderPart(R"LIT(#version 460
-					layout(location = 0) in vec3 inPos;
+					layout(location = 0) in vec2 inPos;
 					layout(location = 1) in vec4 inColor;
 					layout(location = 3) in vec2 inUV;
+					layout(location = 4) in float inMode;
 
 					layout(location = 0) out vec4 outColor;
 					layout(location = 1) out vec2 outUV;
+					layout(location = 2) flat out int outMode;
 
 					layout(location = 0) uniform mat4 u_Projection;
 
 					void main() {
 						outColor = inColor;
 						outUV = inUV;
-						gl_Position = u_Projection * vec4(inPos, 1);
+						outMode = int(inMode + 0.5);
+						gl_Position = u_Projection * vec4(inPos, 0, 1);
 					}
 				)LIT", ShaderPartType::Vertex);
 
 		__shader->LoadShaderPart(R"LIT(#version 460
 					layout(location = 0) in vec4 inColor;
 					layout(location = 1) in vec2 inUV;
+					layout(location = 2) flat in int inMode;
 
 					layout(location = 0) out vec4 outColor;
 
 					uniform layout(binding=0) sampler2D s_Texture;
 
-					void main() {
-						outColor = texture(s_Texture, inUV) * inColor;
-					}
-				)LIT", ShaderPartType::Fragment);
-
-		__shader->Link();
-
-		__fontShader = Shader::Create();
-		__fontShader->LoadShaderPart(R"LIT(#version 460
-					layout(location = 0) in vec3 inPos;
-					layout(location = 1) in vec4 inColor;
-					layout(location = 3) in vec2 inUV;
-
-					layout(location = 0) out vec4 outColor;
-					layout(location = 1) out vec2 outUV;
-
-					layout(location = 0) uniform mat4 u_Projection;
-
-					void main() {
-						outColor = inColor;
-						outUV = inUV;
-						gl_Position = u_Projection * vec4(inPos, 1);
-					}
-				)LIT", ShaderPartType::Vertex);
-
-		__fontShader->LoadShaderPart(R"LIT(#version 460
-					layout(location = 0) in vec4 inColor;
-					layout(location = 1) in vec2 inUV;
-
-					layout(location = 0) out vec4 outColor;
-
-					uniform layout(binding=0) sampler2D s_Texture;
+					// Matches GuiSampleMode
+					const int MODE_NEAREST       = 1;
+					const int MODE_FONT_DISTANCE = 2;
 
 					void main() {
-						float fontPow = texture(s_Texture, inUV).r;
-						outColor = vec4(inColor.rgb, fontPow);
+						vec2 uv = inUV;
+						// The atlas is linearly filtered, so nearest filtering is done by snapping to texel centers
+						if (inMode == MODE_NEAREST) {
+							vec2 size = vec2(textureSize(s_Texture, 0));
+							uv = (floor(uv * size) + 0.5) / size;
+						}
+
+						vec4 texel = texture(s_Texture, uv);
+						if (inMode == MODE_FONT_DISTANCE) {
+							// Red is the distance to the glyph's edge, with the edge at 0.5. Smoothing
+							// over a screen pixel keeps the edges crisp at any text size
+							float dist = texel.r;
+							float width = fwidth(dist);
+							float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+							outColor = vec4(inColor.rgb, inColor.a * alpha);
+						} else {
+							outColor = texel * inColor;
+						}
 					}
 				)LIT", ShaderPartType::Fragment);
 
-		__fontShader->Link();
+		__shader->Link();
 
 		__vbo = VertexBuffer::Create(BufferUsage::DynamicDraw);
 		__ibo = IndexBuffer::Create(BufferUsage::DynamicDraw, IndexType::UInt);
 
 		__vao = VertexArrayObject::Create();
-		__vao->AddVertexBuffer(__vbo, VertexPosColTex::V_DECL);
+		__vao->AddVertexBuffer(__vbo, VertexGui::V_DECL);
 		__vao->SetIndexBuffer(__ibo);
 
 		// Generate a simple white texture with a black border
@@ -325,6 +580,8 @@ void GuiBatcher::__StaticInit()
 			__defaultUITexture->LoadData(16, 16, PixelFormat::RGBA, PixelType::UByte, data);
 		}
 
+		__atlas = GuiAtlas::Create();
+
 		needsInit = false;
 	}
 }
@@ -349,9 +606,8 @@ void GuiBatcher::PushScissorRect(const glm::vec2& min, const glm::vec2& max) {
 	int width = glm::max(maxWin.x, minWin.x) - glm::min(maxWin.x, minWin.x);
 	int height = glm::max(maxWin.y, minWin.y) - glm::min(maxWin.y, minWin.y);
 
-	// Draw current geo with the current scissor, then update it
-	Flush();
-	glScissor(minWin.x, maxWin.y, width, height);
+	// Anything pushed from here on gets clipped
+	__commands.push_back({ CommandType::Scissor, nullptr, 0, 0, glm::ivec4(minWin.x, maxWin.y, width, height), nullptr });
 }
 
 void GuiBatcher::PopScissorRect() {
@@ -365,9 +621,8 @@ void GuiBatcher::PopScissorRect() {
 	int width = glm::max(bounds.Min.x, bounds.Max.x) - glm::min(bounds.Min.x, bounds.Max.x);
 	int height = glm::max(bounds.Min.y, bounds.Max.y) - glm::min(bounds.Min.y, bounds.Max.y);
 
-	// Draw current geo with the current scissor, then update it
-	Flush();
-	glScissor(glm::min(bounds.Min.x, bounds.Max.x), glm::min(bounds.Min.y, bounds.Max.y), width, height);
+	// Go back to the previous scissor for anything pushed from here on
+	__commands.push_back({ CommandType::Scissor, nullptr, 0, 0, glm::ivec4(glm::min(bounds.Min.x, bounds.Max.x), glm::min(bounds.Min.y, bounds.Max.y), width, height), nullptr });
 }
 
 void GuiBatcher::SetDefaultTexture(const Texture2D::Sptr& value) {
@@ -7,12 +7,66 @@
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
-#include "Utils/MeshBuilder.h"
-#include <unordered_map>
+#include "Graphics/GuiAtlas.h"
+#include <map>
+
+	/// <summary>
+	/// A block of GUI geometry that an element keeps between frames. The element only
+	/// rebuilds it when something it depends on changes, and the batcher keeps it in a
+	/// persistent range of GPU memory, so unchanged geometry costs nothing to upload
+	/// </summary>
+	class GuiGeometry {
+	public:
+		GuiGeometry();
+		~GuiGeometry();
+
+		// Copies start out empty and dirty, since GPU ranges can't be shared
+		GuiGeometry(const GuiGeometry& other);
+		GuiGeometry& operator=(const GuiGeometry& other);
+
+		/// <summary>
+		/// Flags the geometry as needing to be rebuilt before it is next drawn
+		/// </summary>
+		void MarkDirty();
+		/// <summary>
+		/// Returns true if the geometry needs to be rebuilt, either because it was marked
+		/// dirty, or because the model transform it was built under has changed
+		/// </summary>
+		bool NeedsRebuild() const;
+
+		/// <summary>
+		/// Gets the texture this geometry has to be drawn with, or nullptr if everything
+		/// in it was drawn from the GUI atlas
+		/// </summary>
+		const Texture2D::Sptr& GetTexture() const { return _texture; }
+		/// <summary>
+		/// Gets the number of quads in this geometry
+		/// </summary>
+		uint32_t GetQuadCount() const { return (uint32_t)(_vertices.size() / 4); }
+
+	private:
+		friend class GuiBatcher;
+
+		std::vector<VertexGui> _vertices;
+		Texture2D::Sptr _texture;
+		glm::mat3       _model;
+		bool            _isDirty;
+
+		// Where we live in the batcher's vertex pool, in quads. A capacity of
+		// zero means we haven't been given a range yet
+		uint32_t _offset;
+		uint32_t _capacity;
+		// True if the range holds an up to date copy of our vertices
+		bool     _isResident;
+	};
 
 	/// <summary>
 	/// The GUI Batcher class provides utilities for drawing rectangles and
 	/// fonts to the screen in a 2D fashion
+	/// 
+	/// Everything pushed during a frame is recorded into an ordered list of commands, and
+	/// drawn in that order by Flush. Textures are packed into a shared GuiAtlas, so the
+	/// only thing that splits up the draws are scissor changes
 	/// </summary>
 	class GuiBatcher {
 	public:
@@ -49,13 +103,36 @@
 		/// <summary>
 		/// Renders a left-aligned line of text at the given position using a font
 		/// </summary>
-		/// <param name="text">The ASCII text to render</param>
+		/// <param name="text">The UTF-8 text to render</param>
 		/// <param name="font">The font to render with</param>
 		/// <param name="position">The position of the text in model space</param>
 		/// <param name="color">The color of the text</param>
 		/// <param name="scale">The scaling to apply to the text</param>
 		static void RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f);
 
+		/// <summary>
+		/// Starts recording into the given geometry instead of the batch, clearing anything
+		/// it had before. PushRect and RenderText will add to the geometry until EndGeometry
+		/// is called. Everything recorded into one geometry must use the same texture
+		/// </summary>
+		/// <param name="geometry">The geometry to rebuild</param>
+		static void BeginGeometry(GuiGeometry& geometry);
+		/// <summary>
+		/// Stops recording into the geometry passed to BeginGeometry, and marks it as clean
+		/// </summary>
+		static void EndGeometry();
+		/// <summary>
+		/// Adds previously recorded geometry to the batch. Geometry that hasn't changed
+		/// since it was last drawn is drawn straight from GPU memory, without an upload
+		/// </summary>
+		/// <param name="geometry">The geometry to draw</param>
+		static void PushGeometry(GuiGeometry& geometry);
+
+		/// <summary>
+		/// Gets the current model transform, which geometry will be transformed by
+		/// </summary>
+		static const glm::mat3& GetModelTransform();
+
 		/// <summary>
 		/// Sets the projection matrix to use for rendering, should ideally be an orthographic
 		/// projection that matches the screen size
@@ -66,7 +143,8 @@
 		/// </summary>
 		static void SetWindowSize(const glm::ivec2& size);
 		/// <summary>
-		/// Draws all geometry to the screen and prepares for the next batch
+		/// Draws everything that was pushed since the last flush, in the order it was pushed,
+		/// and prepares for the next batch. Should be called once all GUI has been pushed
 		/// </summary>
 		static void Flush();
 
@@ -82,14 +160,14 @@
 		static void PopModelTransform();
 
 		/// <summary>
-		/// Sets a new scissor region in model space. Note that this will invoke a 
-		/// flush
+		/// Sets a new scissor region in model space, anything pushed after this will
+		/// be clipped to it
 		/// </summary>
 		/// <param name="min">The minimum bounds of the scissor rectangle</param>
 		/// <param name="min">The maximum bounds of the scissor rectangle</param>
 		static void PushScissorRect(const glm::vec2& min, const glm::vec2& max);
 		/// <summary>
-		/// Pops the last scissor region, not that this will invoke a flush
+		/// Pops the last scissor region
 		/// </summary>
 		static void PopScissorRect();
 
@@ -112,15 +190,35 @@
 		/// </summary>
 		static int GetDefaultBorderRadius();
 
+		/// <summary>
+		/// Gets the number of draw calls the last flush used
+		/// </summary>
+		static int GetLastDrawCount();
+
 	private:
+		friend class GuiGeometry;
+
 		struct IRect {
 			glm::ivec2 Min;
 			glm::ivec2 Max;
 		};
 
-		struct MeshData {
-			MeshBuilder<VertexPosColTex> Builder;
-			bool IsFont;
+		enum class CommandType {
+			Quads,   // Draw a run of quads from a geometry
+			Scissor, // Change the scissor rectangle
+			Texture  // Switch textures, for textures that didn't fit in the atlas
+		};
+
+		struct Command {
+			CommandType  Type;
+			// Quads
+			GuiGeometry* Geometry;
+			uint32_t     FirstQuad;
+			uint32_t     QuadCount;
+			// Scissor, in the x, y, width, height order glScissor takes
+			glm::ivec4   Scissor;
+			// Texture, nullptr means the atlas
+			Texture2D*   Texture;
 		};
 
 		static glm::ivec2 __windowSize;
@@ -129,14 +227,50 @@
 		static std::vector<glm::mat3> __modelTransformStack;
 		static std::vector<IRect> __scissorRects;
 		static Shader::Sptr __shader;
-		static Shader::Sptr __fontShader;
-		static std::unordered_map<Texture2D*, MeshData> _meshBuilders;
+		static GuiAtlas::Sptr __atlas;
 		static VertexArrayObject::Sptr __vao;
 		static VertexBuffer::Sptr __vbo;
 		static IndexBuffer::Sptr __ibo;
+		static GuiGeometry* __recording;
+
+		// The vertex pool that geometry is sub-allocated from, sizes are in quads
+		static uint32_t __poolCapacity;
+		static std::map<uint32_t, uint32_t> __freeRanges;
+		static std::vector<GuiGeometry*> __residentGeometry;
+		// How many quads the shared index buffer covers
+		static uint32_t __indexedQuads;
+
+		// Everything pushed since the last flush, in order
+		static std::vector<Command> __commands;
+		// The texture the commands will have bound at the end of the list
+		static Texture2D* __commandTexture;
+		// Collects anything pushed outside of BeginGeometry/EndGeometry, this is
+		// re-uploaded every flush
+		static GuiGeometry __immediate;
+
+		// The last texture we looked up in the atlas, since quads tend to come in runs
+		static Texture2D* __lastTexture;
+		static GuiAtlas::Region __lastRegion;
+		static bool __lastPacked;
+
+		// Scratch arrays for glMultiDrawElementsBaseVertex
+		static std::vector<GLsizei> __drawCounts;
+		static std::vector<GLint> __drawBaseVertices;
+		static std::vector<const void*> __drawOffsets;
+		static int __drawCount;
 
 		static Texture2D::Sptr __defaultUITexture;
 		static int __defaultEdgeRadius;
 
 		static void __StaticInit();
+
+		static void __AddQuad(const Texture2D::Sptr& tex, bool isFont, const glm::vec2* positions, const glm::vec2* uvs, const glm::vec4& color);
+		static void __AddTextureCommand(Texture2D* texture);
+		static void __AddQuadsCommand(GuiGeometry* geometry, uint32_t firstQuad, uint32_t quadCount);
+		static void __DrawPending();
+		static bool __Upload(GuiGeometry& geometry, bool exactSize);
+		static bool __AllocateRange(uint32_t quads, uint32_t& offset);
+		static void __FreeRange(GuiGeometry& geometry);
+		static void __GrowPool(uint32_t minQuads);
+		static void __EnsureQuadIndices(uint32_t quads);
 	};
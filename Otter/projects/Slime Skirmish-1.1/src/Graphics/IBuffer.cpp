@@ -55,6 +55,27 @@ void IBuffer::UpdateData(const void* data, size_t elementSize, size_t elementCou
 	}
 }
 
+void IBuffer::UpdateSubData(const void* data, size_t offset, size_t size) {
+	LOG_ASSERT(offset + size <= _size, "Attempting to write beyond the end of the buffer!");
+	glNamedBufferSubData(_handle, offset, size, data);
+}
+
+void* IBuffer::MapPersistent(size_t elementSize, size_t elementCount) {
+	if (!GLAD_GL_VERSION_4_4) {
+		LoadData(nullptr, elementSize, elementCount);
+		return nullptr;
+	}
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glNamedBufferStorage(_handle, elementSize * elementCount, nullptr, flags | GL_DYNAMIC_STORAGE_BIT);
+
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+	_size = elementCount * elementSize;
+
+	return glMapNamedBufferRange(_handle, 0, _size, flags);
+}
+
 void IBuffer::Bind() const {
 	glBindBuffer((GLenum)_type, _handle);
 }
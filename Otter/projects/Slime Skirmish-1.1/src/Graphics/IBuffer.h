@@ -64,6 +64,24 @@ public:
 	virtual void LoadData(const void* data, size_t elementSize, size_t elementCount);
 
 	virtual void UpdateData(const void* data, size_t elementSize, size_t elementCount, bool allowResize = true);
+	/// <summary>
+	/// Overwrites part of this buffer without resizing it, using glNamedBufferSubData
+	/// </summary>
+	/// <param name="data">The data to write into the buffer</param>
+	/// <param name="offset">The offset into the buffer to start writing at, in bytes</param>
+	/// <param name="size">The number of bytes to write, the range must fit inside the buffer</param>
+	void UpdateSubData(const void* data, size_t offset, size_t size);
+	/// <summary>
+	/// Allocates the buffer's storage and keeps it mapped, so it can be written to directly
+	/// without any uploads. The mapping is coherent, but it's up to the caller to make sure
+	/// the GPU isn't still reading a range before it gets overwritten (see glFenceSync).
+	/// Storage allocated this way can't be resized, so this should only be called once.
+	/// Returns nullptr if persistent mapping isn't supported (before GL 4.4), in which case
+	/// the buffer is allocated as usual and can be written with UpdateSubData
+	/// </summary>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to make room for</param>
+	void* MapPersistent(size_t elementSize, size_t elementCount);
 
 	/// <summary>
 	/// Loads an array of data into this buffer, using the bindless method glNamedBufferData
@@ -47,6 +47,11 @@ public:
 	/// <param name="slot">The slot to unbind, 0 &lt;= slot &lt; MAX_TEXTURE_UNITS</param>
 	static void Unbind(int slot);
 
+	/// <summary>
+	/// Gets the underlying OpenGL handle for this texture
+	/// </summary>
+	GLuint GetHandle() const { return _handle; }
+
 	/// <summary>
 	/// Clears the first level of this texture to a solid color, note this only works for color texture types!
 	/// </summary>
@@ -0,0 +1,146 @@
+#include "Graphics/TextLayout.h"
+#include <algorithm>
+#include <cstring>
+#include "Utils/Utf8.h"
+
+const size_t TextLayoutCache::CAPACITY = 512;
+
+std::unordered_map<uint64_t, TextLayoutCache::Entry> TextLayoutCache::__entries;
+std::vector<uint64_t> TextLayoutCache::__ages;
+uint64_t TextLayoutCache::__clock = 0;
+size_t TextLayoutCache::__buildCount = 0;
+
+void TextLayout::Build(Font& font, std::string_view text, float scale) {
+	Glyphs.clear();
+	Min = glm::vec2(0.0f);
+	Max = glm::vec2(0.0f);
+
+	// We lay the text out at the font's size, and scale as we store it
+	glm::vec2 pen = glm::vec2(0.0f);
+	float lineHeight = 0.0f;
+	float maxWidth = 0.0f;
+	float totalHeight = 0.0f;
+	float padding = font.GetGlyphPadding();
+
+	// Kerning only applies between 2 characters on the same line
+	uint32_t previous = 0;
+	bool hasPrevious = false;
+
+	size_t index = 0;
+	while (index < text.size()) {
+		uint32_t codePoint = Utf8::Next(text, index);
+
+		// A newline will advance to the next line and return to the start of the line
+		if (codePoint == '\n') {
+			pen.y += font.GetLineHeight();
+			pen.x = 0.0f;
+			totalHeight += lineHeight;
+			lineHeight = 0.0f;
+			hasPrevious = false;
+			continue;
+		}
+		// A return character simply returns to the start of the line
+		else if (codePoint == '\r') {
+			pen.x = 0.0f;
+			hasPrevious = false;
+			continue;
+		}
+		// A tab character is 4 spaces
+		else if (codePoint == '\t') {
+			pen.x += font.GetGlyph(' ', 0.0f, 0.0f).OffsetX * 4;
+			maxWidth = glm::max(maxWidth, pen.x);
+			hasPrevious = false;
+			continue;
+		}
+
+		if (hasPrevious) {
+			pen.x += font.GetKerning(previous, codePoint);
+		}
+		GlyphInfo glyph = font.GetGlyph(codePoint, pen.x, pen.y);
+
+		// Glyphs that are still being rasterized (or are blank) are skipped, but still take up space
+		if (glyph.IsPacked) {
+			Glyph& result = Glyphs.emplace_back();
+			for (int ix = 0; ix < 4; ix++) {
+				result.Positions[ix] = (pen + glyph.Positions[ix]) * scale;
+				result.UVs[ix] = glyph.UVs[ix];
+			}
+			result.Page = glyph.Page;
+
+			glm::vec2 glyphMin = glm::min(result.Positions[0], result.Positions[2]);
+			glm::vec2 glyphMax = glm::max(result.Positions[0], result.Positions[2]);
+			Min = Glyphs.size() == 1 ? glyphMin : glm::min(Min, glyphMin);
+			Max = Glyphs.size() == 1 ? glyphMax : glm::max(Max, glyphMax);
+		}
+
+		// The top of the glyph's quad includes the distance field padding, which isn't part of the text
+		lineHeight = glm::max(lineHeight, -glyph.Positions[1].y - padding);
+		pen.x = glyph.OffsetX;
+		maxWidth = glm::max(maxWidth, pen.x);
+
+		previous = codePoint;
+		hasPrevious = true;
+	}
+
+	totalHeight += lineHeight;
+	Size = glm::vec2(maxWidth, totalHeight) * scale;
+}
+
+const TextLayout& TextLayoutCache::Get(const Font::Sptr& font, std::string_view text, float scale /*= 1.0f*/) {
+	// Mix the font and scale into the string's hash
+	uint32_t scaleBits;
+	memcpy(&scaleBits, &scale, sizeof(float));
+	uint64_t key = std::hash<std::string_view>()(text);
+	key ^= std::hash<const Font*>()(font.get()) + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+	key ^= scaleBits + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+
+	// Grabbing the revision also uploads any glyphs that have finished loading
+	uint32_t revision = font->GetRevision();
+
+	auto it = __entries.find(key);
+	if (it == __entries.end()) {
+		if (__entries.size() >= CAPACITY) {
+			__Trim();
+		}
+		it = __entries.emplace(key, Entry()).first;
+	}
+	Entry& entry = it->second;
+	entry.LastUsed = ++__clock;
+
+	// A hit only counts if it's really the same text, otherwise the slot gets taken over
+	bool matches = entry.Source.lock() == font && entry.Scale == scale && entry.Text == text;
+	if (!matches) {
+		entry.Source = font;
+		entry.Text.assign(text.data(), text.size());
+		entry.Scale = scale;
+	}
+	if (!matches || entry.FontRevision != revision) {
+		entry.Layout.Build(*font, text, scale);
+		entry.FontRevision = revision;
+		__buildCount++;
+	}
+	return entry.Layout;
+}
+
+void TextLayoutCache::Clear() {
+	__entries.clear();
+}
+
+void TextLayoutCache::__Trim() {
+	// Throw out everything that's older than the median age
+	__ages.clear();
+	for (const auto& [key, entry] : __entries) {
+		__ages.push_back(entry.LastUsed);
+	}
+	auto middle = __ages.begin() + __ages.size() / 2;
+	std::nth_element(__ages.begin(), middle, __ages.end());
+	uint64_t cutoff = *middle;
+
+	for (auto it = __entries.begin(); it != __entries.end();) {
+		if (it->second.LastUsed < cutoff) {
+			it = __entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include "Graphics/Font.h"
+
+/// <summary>
+/// A string that has been laid out with a font at a given scale, ready to be turned
+/// into quads. Positions are relative to the top left of the text
+/// </summary>
+struct TextLayout {
+	struct Glyph {
+		glm::vec2 Positions[4];
+		glm::vec2 UVs[4];
+		// The font atlas page the glyph is on
+		uint32_t  Page;
+	};
+
+	// Only glyphs that have something to draw, spaces and glyphs that are still loading are left out
+	std::vector<Glyph> Glyphs;
+	// The size of the text, measured like Font::MeausureString but with kerning applied
+	glm::vec2          Size;
+	// The bounds of the glyph quads
+	glm::vec2          Min;
+	glm::vec2          Max;
+
+	/// <summary>
+	/// Lays out a UTF-8 string, replacing anything that was in the layout
+	/// </summary>
+	/// <param name="font">The font to lay the string out with</param>
+	/// <param name="text">The UTF-8 string to lay out</param>
+	/// <param name="scale">The scaling to apply to the text</param>
+	void Build(Font& font, std::string_view text, float scale);
+};
+
+/// <summary>
+/// Remembers the layouts of recently drawn strings, so that text which is drawn often
+/// (like a HUD) only gets laid out when it changes. Layouts are keyed on the font,
+/// string and scale, and are redone if the font's atlas changes
+/// </summary>
+class TextLayoutCache {
+public:
+	TextLayoutCache() = delete;
+
+	// How many layouts we keep before the least recently used half get thrown out
+	static const size_t CAPACITY;
+
+	/// <summary>
+	/// Gets the layout for a UTF-8 string, laying it out if it isn't in the cache. The
+	/// layout is only valid until the next call
+	/// </summary>
+	/// <param name="font">The font to lay the string out with</param>
+	/// <param name="text">The UTF-8 string to lay out</param>
+	/// <param name="scale">The scaling to apply to the text, default is 1.0f</param>
+	static const TextLayout& Get(const Font::Sptr& font, std::string_view text, float scale = 1.0f);
+
+	/// <summary>
+	/// Gets the number of layouts in the cache
+	/// </summary>
+	static size_t GetCount() { return __entries.size(); }
+	/// <summary>
+	/// Gets the number of layouts that have been built, including rebuilds because a font changed
+	/// </summary>
+	static size_t GetBuildCount() { return __buildCount; }
+	/// <summary>
+	/// Throws out every layout in the cache
+	/// </summary>
+	static void Clear();
+
+private:
+	struct Entry {
+		// The font is only held weakly, the address alone could be re-used by a new font
+		std::weak_ptr<Font> Source;
+		std::string         Text;
+		float               Scale;
+		uint32_t            FontRevision;
+		uint64_t            LastUsed;
+		TextLayout          Layout;
+	};
+
+	static std::unordered_map<uint64_t, Entry> __entries;
+	static std::vector<uint64_t> __ages;
+	static uint64_t __clock;
+	static size_t   __buildCount;
+
+	static void __Trim();
+};
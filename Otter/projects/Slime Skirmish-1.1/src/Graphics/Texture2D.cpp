@@ -3,6 +3,7 @@
 #include <Logging.h>
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -82,7 +83,7 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 	// Align the data store to the size of a single component to ensure we don't get weirdness with images that aren't RGBA
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 	int componentSize = (GLint)GetTexelComponentSize(type);
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
 
 	// Upload our data to our image
 	glTextureSubImage2D(_handle, 0, offsetX, offsetY, width, height, (GLenum)format, (GLenum)type, data);
@@ -91,6 +92,8 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 	if (_description.GenerateMipMaps) {
 		glGenerateTextureMipmap(_handle);
 	}
+
+	_revision++;
 }
 
 void Texture2D::_LoadDataFromFile() {
@@ -101,9 +104,10 @@ void Texture2D::_LoadDataFromFile() {
 		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// Use STBI to load the image
+		// Use STBI to decode the image, the file may live in a mounted asset pack
+		FileView file = VirtualFileSystem::Open(_description.Filename);
 		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
+		uint8_t* data = file ? stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &width, &height, &numChannels, targetChannels) : nullptr;
 
 		// If we could not load any data, warn and return null
 		if (data == nullptr) {
@@ -125,7 +129,7 @@ void Texture2D::_LoadDataFromFile() {
 
 		// This is one of those poorly documented things in OpenGL
 		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_UNPACK_ALIGNMENT)");
 		}
 
 		// Update our description to match what we loaded
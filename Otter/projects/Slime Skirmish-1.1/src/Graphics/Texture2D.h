@@ -142,11 +142,18 @@ public:
 	/// </summary>
 	const Texture2DDescription& GetDescription() const { return _description; }
 
+	/// <summary>
+	/// Gets a number that changes every time data is loaded into this texture, so
+	/// anything holding a copy of the pixels can tell when it's out of date
+	/// </summary>
+	uint32_t GetRevision() const { return _revision; }
+
 	virtual nlohmann::json ToJson() const override;
 	static Texture2D::Sptr FromJson(const nlohmann::json& data);
 
 protected:
 	Texture2DDescription _description;
+	uint32_t             _revision = 0;
 
 	/// <summary>
 	/// Loads this texture from the file specified in the description
@@ -2,6 +2,7 @@
 #include <filesystem>
 #include "stb_image.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
 
 TextureCube::TextureCube(const std::string& baseFilename) :
 	ITexture(TextureType::Cubemap),
@@ -82,7 +83,7 @@ void TextureCube::_LoadFromDescription()
 			targetPath += baseName.extension();
 
 			// If the file exists, store it in the description
-			if (std::filesystem::exists(targetPath)) {
+			if (VirtualFileSystem::Exists(targetPath.string())) {
 				_description.FaceFileNames[face] = targetPath.string();
 			}
 		}
@@ -115,9 +116,10 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 		const std::string& filename = _description.FaceFileNames[face];
 		int fileWidth, fileHeight, fileNumChannels;
 
-		// Use STBI to load the image
+		// Use STBI to decode the image, the file may live in a mounted asset pack
+		FileView file = VirtualFileSystem::Open(filename);
 		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 0);
+		uint8_t* data = file ? stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &fileWidth, &fileHeight, &fileNumChannels, 0) : nullptr;
 
 		// If we could not load any data, warn and return null
 		if (data == nullptr) {
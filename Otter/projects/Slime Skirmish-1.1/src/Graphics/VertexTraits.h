@@ -0,0 +1,102 @@
+#pragma once
+
+#include <type_traits>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Compile time description of a vertex type's attributes. This replaces looking up
+/// attribute offsets from the V_DECL at runtime, all accessors resolve to direct member
+/// access and attributes that a vertex type does not have are compiled out entirely
+/// via if constexpr.
+///
+/// Attributes are detected by member name, so any vertex struct following the same
+/// naming as the ones in VertexTypes.h (Position, Normal, UV, Color, Tangent, BiTangent)
+/// will work without needing a specialization
+/// </summary>
+/// <typeparam name="Vertex">The vertex type to inspect</typeparam>
+template <typename Vertex>
+struct VertexTraits {
+private:
+	template <typename V, typename = void> struct _HasPosition : std::false_type {};
+	template <typename V> struct _HasPosition<V, std::void_t<decltype(std::declval<V>().Position)>> : std::true_type {};
+	template <typename V, typename = void> struct _HasNormal : std::false_type {};
+	template <typename V> struct _HasNormal<V, std::void_t<decltype(std::declval<V>().Normal)>> : std::true_type {};
+	template <typename V, typename = void> struct _HasUV : std::false_type {};
+	template <typename V> struct _HasUV<V, std::void_t<decltype(std::declval<V>().UV)>> : std::true_type {};
+	template <typename V, typename = void> struct _HasColor : std::false_type {};
+	template <typename V> struct _HasColor<V, std::void_t<decltype(std::declval<V>().Color)>> : std::true_type {};
+	template <typename V, typename = void> struct _HasTangent : std::false_type {};
+	template <typename V> struct _HasTangent<V, std::void_t<decltype(std::declval<V>().Tangent)>> : std::true_type {};
+	template <typename V, typename = void> struct _HasBiTangent : std::false_type {};
+	template <typename V> struct _HasBiTangent<V, std::void_t<decltype(std::declval<V>().BiTangent)>> : std::true_type {};
+
+public:
+	static constexpr bool HasPosition  = _HasPosition<Vertex>::value;
+	static constexpr bool HasNormal    = _HasNormal<Vertex>::value;
+	static constexpr bool HasUV        = _HasUV<Vertex>::value;
+	static constexpr bool HasColor     = _HasColor<Vertex>::value;
+	static constexpr bool HasTangent   = _HasTangent<Vertex>::value;
+	static constexpr bool HasBiTangent = _HasBiTangent<Vertex>::value;
+
+	inline static void SetPosition(Vertex& vertex, const glm::vec3& value) {
+		if constexpr (HasPosition) { vertex.Position = value; }
+	}
+	inline static void SetNormal(Vertex& vertex, const glm::vec3& value) {
+		if constexpr (HasNormal) { vertex.Normal = value; }
+	}
+	inline static void SetTexture(Vertex& vertex, const glm::vec2& value) {
+		if constexpr (HasUV) { vertex.UV = value; }
+	}
+	inline static void SetColor(Vertex& vertex, const glm::vec4& value) {
+		// Color may be stored with fewer than 4 components, truncate to fit
+		if constexpr (HasColor) { vertex.Color = decltype(vertex.Color)(value); }
+	}
+	inline static void SetTangent(Vertex& vertex, const glm::vec3& value) {
+		if constexpr (HasTangent) { vertex.Tangent = value; }
+	}
+	inline static void SetBiTangent(Vertex& vertex, const glm::vec3& value) {
+		if constexpr (HasBiTangent) { vertex.BiTangent = value; }
+	}
+
+	inline static glm::vec3 GetPosition(const Vertex& vertex) {
+		if constexpr (HasPosition) { return vertex.Position; }
+		else { return glm::vec3(0.0f); }
+	}
+	inline static glm::vec3 GetNormal(const Vertex& vertex) {
+		if constexpr (HasNormal) { return vertex.Normal; }
+		else { return glm::vec3(0.0f); }
+	}
+	inline static glm::vec2 GetTexture(const Vertex& vertex) {
+		if constexpr (HasUV) { return vertex.UV; }
+		else { return glm::vec2(0.0f); }
+	}
+	inline static glm::vec4 GetColor(const Vertex& vertex) {
+		if constexpr (HasColor) {
+			// Expand smaller color types out, defaulting alpha to 1
+			if constexpr (std::is_same_v<std::decay_t<decltype(vertex.Color)>, glm::vec4>) { return vertex.Color; }
+			else if constexpr (std::is_same_v<std::decay_t<decltype(vertex.Color)>, glm::vec3>) { return glm::vec4(vertex.Color, 1.0f); }
+			else { return glm::vec4(vertex.Color, 0.0f, 1.0f); }
+		}
+		else { return glm::vec4(1.0f); }
+	}
+	inline static glm::vec3 GetTangent(const Vertex& vertex) {
+		if constexpr (HasTangent) { return vertex.Tangent; }
+		else { return glm::vec3(0.0f); }
+	}
+	inline static glm::vec3 GetBiTangent(const Vertex& vertex) {
+		if constexpr (HasBiTangent) { return vertex.BiTangent; }
+		else { return glm::vec3(0.0f); }
+	}
+
+	/// <summary>
+	/// Creates a new vertex, setting all the fields that the vertex type has
+	/// </summary>
+	inline static Vertex Create(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col) {
+		Vertex result;
+		SetPosition(result, pos);
+		SetNormal(result, norm);
+		SetTexture(result, uv);
+		SetColor(result, col);
+		return result;
+	}
+};
@@ -3,6 +3,7 @@
 
 VertexPosCol* VPC = nullptr;
 VertexPosColTex* VPCT = nullptr;
+VertexGui* VG = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
@@ -22,6 +23,12 @@ const std::vector<BufferAttribute> VertexPosColTex::V_DECL ={
 	BufferAttribute(1, 4, AttributeType::Float, sizeof(VertexPosColTex), (size_t)&VPCT->Color, AttribUsage::Color),
 	BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexPosColTex), (size_t)&VPCT->UV, AttribUsage::Texture),
 };
+const std::vector<BufferAttribute> VertexGui::V_DECL = {
+	BufferAttribute(0, 2, AttributeType::Float, sizeof(VertexGui), (size_t)&VG->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, AttributeType::Float, sizeof(VertexGui), (size_t)&VG->Color, AttribUsage::Color),
+	BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexGui), (size_t)&VG->UV, AttribUsage::Texture),
+	BufferAttribute(4, 1, AttributeType::Float, sizeof(VertexGui), (size_t)&VG->Mode, AttribUsage::User0),
+};
 const std::vector<BufferAttribute> VertexPosNormTex::V_DECL = {
 	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormTex), (size_t)&VPNT->Position, AttribUsage::Position),
 	BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormTex), (size_t)&VPNT->Normal, AttribUsage::Normal),
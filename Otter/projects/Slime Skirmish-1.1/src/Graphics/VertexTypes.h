@@ -31,6 +31,20 @@ struct VertexPosColTex {
 	static const std::vector<BufferAttribute> V_DECL;
 };
 
+// Used by the GuiBatcher, Mode tells the GUI shader how to sample the texture (see GuiSampleMode)
+struct VertexGui {
+	glm::vec2 Position;
+	glm::vec4 Color;
+	glm::vec2 UV;
+	float     Mode;
+
+	VertexGui() : Position(glm::vec2(0.0f)), Color(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)), UV({ 0.0f, 0.0f }), Mode(0.0f) {}
+	VertexGui(const glm::vec2& pos, const glm::vec4& col, const glm::vec2& uv, float mode) :
+		Position(pos), Color(col), UV(uv), Mode(mode) {}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
 struct VertexPosNormCol {
 	glm::vec3 Position;
 	glm::vec3 Normal;
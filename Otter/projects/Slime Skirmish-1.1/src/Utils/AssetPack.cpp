@@ -0,0 +1,316 @@
+#include "Utils/AssetPack.h"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+#include <gzip/compress.hpp>
+#include <gzip/decompress.hpp>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/StringUtils.h"
+#include "Logging.h"
+
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#pragma region MappedFile
+
+MappedFile::~MappedFile() {
+	#ifdef WINDOWS
+	if (_data != nullptr) { UnmapViewOfFile(_data); }
+	if (_mappingHandle != nullptr) { CloseHandle(_mappingHandle); }
+	if (_fileHandle != nullptr) { CloseHandle(_fileHandle); }
+	#else
+	if (_data != nullptr) { munmap(const_cast<uint8_t*>(_data), _size); }
+	if (_fileDescriptor != -1) { close(_fileDescriptor); }
+	#endif
+}
+
+MappedFile::Sptr MappedFile::Open(const std::string& filename) {
+	MappedFile::Sptr result = MappedFile::Sptr(new MappedFile());
+
+	#ifdef WINDOWS
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	result->_fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		return nullptr;
+	}
+	result->_size = static_cast<size_t>(size.QuadPart);
+
+	result->_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (result->_mappingHandle == nullptr) {
+		return nullptr;
+	}
+	result->_data = reinterpret_cast<const uint8_t*>(MapViewOfFile(result->_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	#else
+	result->_fileDescriptor = open(filename.c_str(), O_RDONLY);
+	if (result->_fileDescriptor == -1) {
+		return nullptr;
+	}
+
+	struct stat info;
+	if (fstat(result->_fileDescriptor, &info) != 0 || info.st_size == 0) {
+		return nullptr;
+	}
+	result->_size = static_cast<size_t>(info.st_size);
+
+	void* data = mmap(nullptr, result->_size, PROT_READ, MAP_PRIVATE, result->_fileDescriptor, 0);
+	result->_data = data == MAP_FAILED ? nullptr : reinterpret_cast<const uint8_t*>(data);
+	#endif
+
+	return result->_data != nullptr ? result : nullptr;
+}
+
+#pragma endregion
+
+#pragma region FileView
+
+FileView::FileView(const uint8_t* data, size_t size, std::shared_ptr<const void> storage) :
+	_data(data),
+	_size(size),
+	_storage(storage)
+{ }
+
+FileView::FileView(std::string&& contents) {
+	std::shared_ptr<std::string> storage = std::make_shared<std::string>(std::move(contents));
+	_data = reinterpret_cast<const uint8_t*>(storage->data());
+	_size = storage->size();
+	_storage = storage;
+}
+
+std::string FileView::ToString() const {
+	return _data != nullptr ? std::string(GetChars(), _size) : std::string();
+}
+
+#pragma endregion
+
+#pragma region AssetPack
+
+AssetPack::Sptr AssetPack::Load(const std::string& filename) {
+	MappedFile::Sptr mapping = MappedFile::Open(filename);
+	if (mapping == nullptr) {
+		LOG_ERROR("Failed to map asset pack \"{}\"", filename);
+		return nullptr;
+	}
+
+	// Make sure the header makes sense before we trust any offsets in it
+	if (mapping->GetSize() < sizeof(PackHeader)) {
+		LOG_ERROR("Asset pack \"{}\" is too small to be valid", filename);
+		return nullptr;
+	}
+	const PackHeader* header = reinterpret_cast<const PackHeader*>(mapping->GetData());
+	if (memcmp(header->HeaderBytes, PackHeader().HeaderBytes, 4) != 0 || header->Version != VERSION) {
+		LOG_ERROR("Asset pack \"{}\" has an invalid header or unsupported version", filename);
+		return nullptr;
+	}
+	if (sizeof(PackHeader) + (header->NumEntries * sizeof(PackEntry)) > mapping->GetSize() ||
+		header->StringTableOffset + header->StringTableSize > mapping->GetSize()) {
+		LOG_ERROR("Asset pack \"{}\" is truncated", filename);
+		return nullptr;
+	}
+
+	AssetPack::Sptr result = AssetPack::Sptr(new AssetPack());
+	result->_filename = filename;
+	result->_mapping  = mapping;
+	result->_header   = header;
+	result->_entries  = reinterpret_cast<const PackEntry*>(mapping->GetData() + sizeof(PackHeader));
+	result->_strings  = reinterpret_cast<const char*>(mapping->GetData() + header->StringTableOffset);
+
+	LOG_INFO("Mounted asset pack \"{}\" ({} entries, {} bytes)", filename, header->NumEntries, mapping->GetSize());
+	return result;
+}
+
+std::string AssetPack::NormalizePath(const std::string& path) {
+	std::string result = fs::path(path).lexically_normal().generic_string();
+	StringTools::ToLower(result);
+	// Strip any leading ./ or / so that "./res/a.png", "/res/a.png" and "res/a.png" resolve to the same entry
+	while (!result.empty() && (result[0] == '/' || (result.size() >= 2 && result[0] == '.' && result[1] == '/'))) {
+		result.erase(0, result[0] == '/' ? 1 : 2);
+	}
+	return result;
+}
+
+uint64_t AssetPack::HashPath(const std::string& normalizedPath) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (char c : normalizedPath) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+const AssetPack::PackEntry* AssetPack::Find(const std::string& normalizedPath) const {
+	const uint64_t hash = HashPath(normalizedPath);
+	const PackEntry* end = _entries + _header->NumEntries;
+
+	// Entries are sorted by hash, so we can binary search, then walk any collisions
+	const PackEntry* it = std::lower_bound(_entries, end, hash, [](const PackEntry& entry, uint64_t value) {
+		return entry.PathHash < value;
+	});
+	for (; it != end && it->PathHash == hash; it++) {
+		if (normalizedPath == GetEntryPath(it)) {
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+FileView AssetPack::Open(const PackEntry* entry) const {
+	if (entry == nullptr || entry->Offset + entry->StoredSize > _mapping->GetSize()) {
+		return FileView();
+	}
+
+	const uint8_t* data = _mapping->GetData() + entry->Offset;
+	if (entry->Flags & EntryCompressed) {
+		std::string inflated = gzip::decompress(reinterpret_cast<const char*>(data), entry->StoredSize);
+		if (inflated.size() != entry->Size) {
+			LOG_ERROR("Entry \"{}\" in asset pack \"{}\" failed to decompress", GetEntryPath(entry), _filename);
+			return FileView();
+		}
+		return FileView(std::move(inflated));
+	} else {
+		// The view holds a reference to the mapping, so it stays valid if the pack is unmounted
+		return FileView(data, entry->Size, _mapping);
+	}
+}
+
+const char* AssetPack::GetEntryPath(const PackEntry* entry) const {
+	return entry->PathOffset < _header->StringTableSize ? _strings + entry->PathOffset : "";
+}
+
+#pragma endregion
+
+#pragma region AssetPackBuilder
+
+void AssetPackBuilder::AddFile(const std::string& sourcePath, const std::string& packPath, bool compress) {
+	_files.push_back({ sourcePath, AssetPack::NormalizePath(packPath), compress });
+}
+
+void AssetPackBuilder::AddDirectory(const std::string& directory, const std::string& packRoot, const std::vector<std::string>& compressedExtensions) {
+	const fs::path root = fs::path(directory).lexically_normal();
+
+	for (const auto& item : fs::recursive_directory_iterator(root)) {
+		if (!item.is_regular_file()) {
+			continue;
+		}
+		std::string extension = item.path().extension().string();
+		StringTools::ToLower(extension);
+		bool compress = std::find(compressedExtensions.begin(), compressedExtensions.end(), extension) != compressedExtensions.end();
+
+		AddFile(item.path().string(), (fs::path(packRoot) / item.path().lexically_relative(root)).generic_string(), compress);
+	}
+}
+
+bool AssetPackBuilder::Write(const std::string& outFilename) const {
+	// Sort our files by their hash so the runtime can binary search the index
+	std::vector<const SourceFile*> files;
+	files.reserve(_files.size());
+	for (const SourceFile& file : _files) {
+		files.push_back(&file);
+	}
+	std::stable_sort(files.begin(), files.end(), [](const SourceFile* a, const SourceFile* b) {
+		return AssetPack::HashPath(a->PackPath) < AssetPack::HashPath(b->PackPath);
+	});
+	// Drop duplicate paths, the first one added wins
+	files.erase(std::unique(files.begin(), files.end(), [](const SourceFile* a, const SourceFile* b) {
+		return a->PackPath == b->PackPath;
+	}), files.end());
+
+	// Build the string table
+	std::string stringTable;
+	std::vector<AssetPack::PackEntry> entries(files.size());
+	for (size_t ix = 0; ix < files.size(); ix++) {
+		entries[ix].PathHash   = AssetPack::HashPath(files[ix]->PackPath);
+		entries[ix].PathOffset = static_cast<uint32_t>(stringTable.size());
+		stringTable.append(files[ix]->PackPath);
+		stringTable.push_back('\0');
+	}
+
+	auto alignToPage = [](uint64_t value) {
+		return (value + AssetPack::PAGE_SIZE - 1) & ~static_cast<uint64_t>(AssetPack::PAGE_SIZE - 1);
+	};
+
+	AssetPack::PackHeader header = AssetPack::PackHeader();
+	header.NumEntries        = static_cast<uint32_t>(entries.size());
+	header.StringTableOffset = sizeof(AssetPack::PackHeader) + entries.size() * sizeof(AssetPack::PackEntry);
+	header.StringTableSize   = stringTable.size();
+
+	std::ofstream file(outFilename, std::ios::binary);
+	if (!file) {
+		LOG_ERROR("Failed to open \"{}\" for writing", outFilename);
+		return false;
+	}
+
+	// Reserve space for the header and index, we'll come back and fill them once we know the offsets
+	uint64_t offset = alignToPage(header.StringTableOffset + header.StringTableSize);
+	file.seekp(offset, std::ios::beg);
+
+	size_t totalSize = 0, totalStored = 0;
+	for (size_t ix = 0; ix < files.size(); ix++) {
+		std::string contents = FileHelpers::ReadFile(files[ix]->SourcePath);
+		entries[ix].Size = contents.size();
+		entries[ix].Flags = AssetPack::EntryNone;
+
+		if (files[ix]->Compress && !contents.empty()) {
+			std::string compressed = gzip::compress(contents.data(), contents.size());
+			// Only keep the compressed version if it actually saved us something
+			if (compressed.size() < contents.size()) {
+				contents = std::move(compressed);
+				entries[ix].Flags |= AssetPack::EntryCompressed;
+			}
+		}
+
+		entries[ix].Offset = offset;
+		entries[ix].StoredSize = contents.size();
+
+		file.seekp(offset, std::ios::beg);
+		file.write(contents.data(), contents.size());
+		offset = alignToPage(offset + contents.size());
+
+		totalSize += entries[ix].Size;
+		totalStored += entries[ix].StoredSize;
+	}
+
+	// Pad out the final page so the last entry can be mapped whole
+	if (file.tellp() < static_cast<std::streamoff>(offset)) {
+		file.seekp(offset - 1, std::ios::beg);
+		file.put('\0');
+	}
+
+	// Now we can write the header, index and string table
+	file.seekp(0, std::ios::beg);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(AssetPack::PackHeader));
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPack::PackEntry));
+	file.write(stringTable.data(), stringTable.size());
+
+	if (!file) {
+		LOG_ERROR("Failed to write asset pack \"{}\"", outFilename);
+		return false;
+	}
+
+	LOG_INFO("Wrote asset pack \"{}\" with {} entries ({} bytes of assets, {} bytes stored)", outFilename, entries.size(), totalSize, totalStored);
+	return true;
+}
+
+std::vector<std::string> AssetPackBuilder::DefaultCompressedExtensions() {
+	return { ".obj", ".glsl", ".json", ".txt", ".mtl", ".gltf" };
+}
+
+#pragma endregion
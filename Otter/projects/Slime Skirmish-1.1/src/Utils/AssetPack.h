@@ -0,0 +1,216 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/// <summary>
+/// Wraps a read-only memory mapping of a file on disk. The OS pages the file in
+/// on demand, so opening even a very large file is effectively free
+/// </summary>
+class MappedFile {
+public:
+	typedef std::shared_ptr<MappedFile> Sptr;
+
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile& operator=(MappedFile&& other) = delete;
+
+	~MappedFile();
+
+	/// <summary>
+	/// Maps the given file into memory, or returns nullptr if the file could not be mapped
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	static MappedFile::Sptr Open(const std::string& filename);
+
+	const uint8_t* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+private:
+	MappedFile() = default;
+
+	const uint8_t* _data = nullptr;
+	size_t         _size = 0;
+	#ifdef WINDOWS
+	void*          _fileHandle = nullptr;
+	void*          _mappingHandle = nullptr;
+	#else
+	int            _fileDescriptor = -1;
+	#endif
+};
+
+/// <summary>
+/// A read-only view of a single file, either pointing directly into a mounted
+/// asset pack, or owning a buffer that was loaded from disk or decompressed.
+/// Views keep their backing storage alive, so they may outlive the pack being unmounted
+/// </summary>
+class FileView {
+public:
+	FileView() = default;
+	FileView(const uint8_t* data, size_t size, std::shared_ptr<const void> storage);
+	FileView(std::string&& contents);
+
+	const uint8_t* GetData() const { return _data; }
+	const char* GetChars() const { return reinterpret_cast<const char*>(_data); }
+	size_t GetSize() const { return _size; }
+	bool IsValid() const { return _data != nullptr; }
+	bool Empty() const { return _size == 0; }
+
+	/// <summary>
+	/// Copies the contents of this view into a string
+	/// </summary>
+	std::string ToString() const;
+
+	operator bool() const { return IsValid(); }
+
+private:
+	const uint8_t*              _data = nullptr;
+	size_t                      _size = 0;
+	std::shared_ptr<const void> _storage = nullptr;
+};
+
+/// <summary>
+/// An asset pack is a single archive containing many files, with a hashed path
+/// index so lookups are a binary search rather than a filesystem query. Every entry
+/// starts on a page boundary so that uncompressed entries can be handed out directly
+/// from the memory mapped file without any copies
+///
+/// Layout:
+///   PackHeader
+///   PackEntry[NumEntries]   (sorted by PathHash)
+///   char[StringTableSize]   (null-terminated, normalized paths)
+///   ... padding to page ...
+///   entry data (each entry aligned to PageSize)
+/// </summary>
+class AssetPack {
+public:
+	typedef std::shared_ptr<AssetPack> Sptr;
+
+	static constexpr uint16_t VERSION   = 0x01;
+	static constexpr uint32_t PAGE_SIZE = 4096;
+
+	enum EntryFlags : uint32_t {
+		EntryNone       = 0,
+		EntryCompressed = 1 << 0
+	};
+
+	struct PackHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'O', 'P', 'A', 'K' };
+		uint16_t Version = VERSION;
+		uint16_t Reserved = 0;
+		uint32_t NumEntries = 0;
+		uint32_t PageSize = PAGE_SIZE;
+		uint64_t StringTableOffset = 0;
+		uint64_t StringTableSize = 0;
+	};
+
+	struct PackEntry {
+		// FNV-1a hash of the normalized path
+		uint64_t PathHash;
+		// Offset of the data from the start of the pack, always page aligned
+		uint64_t Offset;
+		// The number of bytes stored in the pack (compressed size if compressed)
+		uint64_t StoredSize;
+		// The size of the file once decompressed
+		uint64_t Size;
+		// Offset into the string table for the full path
+		uint32_t PathOffset;
+		// See EntryFlags
+		uint32_t Flags;
+	};
+
+	AssetPack(const AssetPack& other) = delete;
+	AssetPack(AssetPack&& other) = delete;
+	AssetPack& operator=(const AssetPack& other) = delete;
+	AssetPack& operator=(AssetPack&& other) = delete;
+
+	/// <summary>
+	/// Maps and validates an asset pack from disk, returns nullptr on failure
+	/// </summary>
+	/// <param name="filename">The path to the .pak file</param>
+	static AssetPack::Sptr Load(const std::string& filename);
+
+	/// <summary>
+	/// Normalizes a path for hashing, converting it to lowercase with forward slashes,
+	/// and with any ../ resolved and leading ./ or / removed
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+	/// <summary>
+	/// Hashes an already normalized path using 64 bit FNV-1a
+	/// </summary>
+	static uint64_t HashPath(const std::string& normalizedPath);
+
+	/// <summary>
+	/// Finds an entry in this pack, or nullptr if it does not exist
+	/// </summary>
+	/// <param name="normalizedPath">The result of NormalizePath for the file to find</param>
+	const PackEntry* Find(const std::string& normalizedPath) const;
+	/// <summary>
+	/// Gets a view of the given entry's contents. Uncompressed entries point directly into
+	/// the mapped file, compressed entries are inflated into a new buffer
+	/// </summary>
+	FileView Open(const PackEntry* entry) const;
+
+	const std::string& GetFilename() const { return _filename; }
+	uint32_t GetEntryCount() const { return _header->NumEntries; }
+	const char* GetEntryPath(const PackEntry* entry) const;
+
+private:
+	AssetPack() = default;
+
+	std::string       _filename;
+	MappedFile::Sptr  _mapping;
+	const PackHeader* _header = nullptr;
+	const PackEntry*  _entries = nullptr;
+	const char*       _strings = nullptr;
+};
+
+/// <summary>
+/// Helper for cooking a set of files into an asset pack. Files are read when
+/// Write is called, so adding files is cheap
+/// </summary>
+class AssetPackBuilder {
+public:
+	AssetPackBuilder() = default;
+
+	/// <summary>
+	/// Adds a single file to the pack
+	/// </summary>
+	/// <param name="sourcePath">The path of the file on disk</param>
+	/// <param name="packPath">The path that the file will be looked up by at runtime</param>
+	/// <param name="compress">True to gzip the file contents</param>
+	void AddFile(const std::string& sourcePath, const std::string& packPath, bool compress = false);
+	/// <summary>
+	/// Recursively adds all files in a directory. Paths in the pack will be relative to
+	/// the directory, so packing the working directory gives the same paths our loaders use
+	/// </summary>
+	/// <param name="directory">The directory to add</param>
+	/// <param name="packRoot">A prefix to add to all paths in the pack, ie "textures"</param>
+	/// <param name="compressedExtensions">The extensions (with the dot, ie ".obj") that should be compressed</param>
+	void AddDirectory(const std::string& directory, const std::string& packRoot = "", const std::vector<std::string>& compressedExtensions = DefaultCompressedExtensions());
+
+	/// <summary>
+	/// Writes the pack to disk
+	/// </summary>
+	/// <param name="outFilename">The path of the pack to write</param>
+	/// <returns>True if the pack was written successfully</returns>
+	bool Write(const std::string& outFilename) const;
+
+	/// <summary>
+	/// Gets the list of extensions that are usually worth compressing (mostly text formats).
+	/// Images are already compressed, and binary meshes and fonts are left raw so they can be
+	/// used straight from the mapped file
+	/// </summary>
+	static std::vector<std::string> DefaultCompressedExtensions();
+
+private:
+	struct SourceFile {
+		std::string SourcePath;
+		std::string PackPath;
+		bool        Compress;
+	};
+	std::vector<SourceFile> _files;
+};
@@ -0,0 +1,1015 @@
+#include "Utils/Benchmarks.h"
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <random>
+#include <memory>
+#include <cstring>
+#include <thread>
+#include <stdexcept>
+#include <btBulletDynamicsCommon.h>
+
+#include "Logging.h"
+#include "Utils/StringUtils.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/ObjLoader.h"
+#include "Utils/TangentGenerator.h"
+#include "Utils/ThreadPool.h"
+#include "Gameplay/CrowdSystem.h"
+#include "Gameplay/FlowField.h"
+#include "Gameplay/Scene.h"
+#include "Gameplay/Scheduler.h"
+#include "Gameplay/SimulationClock.h"
+#include "Gameplay/Material.h"
+#include "Gameplay/MeshResource.h"
+#include "Gameplay/Components/RenderComponent.h"
+#include "Gameplay/Components/RotatingBehaviour.h"
+#include "Gameplay/Components/TriggerVolumeEnterBehaviour.h"
+#include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/Colliders/CylinderCollider.h"
+#include "Graphics/Texture2D.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Animations/AnimationSampler.h"
+#include "Animations/SkeletonPose.h"
+#include "Animations/Skinning.h"
+#include "Animations/BlendTree.h"
+#include "Animations/GLTFCache.h"
+#include "Graphics/Font.h"
+#include "Graphics/TextLayout.h"
+#include "Utils/Utf8.h"
+#include <locale>
+#include <codecvt>
+
+bool Benchmarks::_failed = false;
+
+Benchmarks::Result Benchmarks::Measure(const std::string& name, int iterations, const std::function<void()>& func) {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// Warm up caches and the thread pool before we start timing
+	func();
+
+	Result result = { name, iterations, std::numeric_limits<double>::max(), 0.0, 0.0 };
+	for (int ix = 0; ix < iterations; ix++) {
+		auto start = Clock::now();
+		func();
+		double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		result.MinMs = std::min(result.MinMs, elapsed);
+		result.MaxMs = std::max(result.MaxMs, elapsed);
+		result.AvgMs += elapsed;
+	}
+	result.AvgMs /= std::max(iterations, 1);
+
+	LOG_INFO("[Benchmark] {:<32} avg {:8.3f}ms  min {:8.3f}ms  max {:8.3f}ms  ({} runs)", name, result.AvgMs, result.MinMs, result.MaxMs, iterations);
+	return result;
+}
+
+bool Benchmarks::Run(const std::string& name) {
+	// Benchmark name -> function, add new benchmarks here
+	static const std::vector<std::pair<std::string, std::function<void()>>> benchmarks = {
+		{ "tbn", &Benchmarks::TangentGeneration },
+		{ "physics", &Benchmarks::PhysicsStep },
+		{ "crowd", &Benchmarks::CrowdSteering },
+		{ "flowfield", &Benchmarks::FlowFieldBuild },
+		{ "clone", &Benchmarks::ObjectCloning },
+		{ "anim", &Benchmarks::AnimationSampling },
+		{ "fk", &Benchmarks::ForwardKinematics },
+		{ "skin", &Benchmarks::CpuSkinning },
+		{ "blend", &Benchmarks::AnimationBlending },
+		{ "gltfcache", &Benchmarks::GltfCacheLoad },
+		{ "hudtext", &Benchmarks::HudText },
+		{ "scheduler", &Benchmarks::SchedulerTasks },
+	};
+
+	bool found = false;
+	_failed = false;
+	for (const auto& [benchName, func] : benchmarks) {
+		if (name == "all" || name == benchName) {
+			LOG_INFO("Running benchmark \"{}\"", benchName);
+			func();
+			found = true;
+		}
+	}
+	if (!found) {
+		LOG_WARN("No benchmark named \"{}\"", name);
+	}
+	return found && !_failed;
+}
+
+void Benchmarks::TangentGeneration() {
+	const std::string filename = _FindLargestFile(".obj");
+	if (filename.empty()) {
+		LOG_WARN("No OBJ files found in the working directory, skipping");
+		return;
+	}
+
+	MeshBuilder<VertexPosNormTexColTangents> mesh = ObjLoader::LoadMeshBuilder<VertexPosNormTexColTangents>(filename, false);
+	LOG_INFO("Generating tangents for \"{}\" ({} vertices, {} triangles), {} workers, SIMD {}",
+		filename, mesh.GetVertexCount(), mesh.GetIndexCount() / 3, ThreadPool::GetWorkerCount(), TangentGenerator::IsSimdSupported() ? "on" : "off");
+
+	VertexPosNormTexColTangents* vertices = const_cast<VertexPosNormTexColTangents*>(mesh.GetVertexDataPtr());
+	const uint32_t* indices = mesh.GetIndexDataPtr();
+	const size_t stride = sizeof(VertexPosNormTexColTangents);
+
+	auto run = [&](bool simd, bool threaded) {
+		TangentGenerator::Options options;
+		options.UseSimd = simd;
+		options.MultiThreaded = threaded;
+		TangentGenerator::Generate(
+			StridedView<glm::vec3>(&vertices[0].Position, stride),
+			StridedView<glm::vec3>(&vertices[0].Normal, stride),
+			StridedView<glm::vec2>(&vertices[0].UV, stride),
+			mesh.GetVertexCount(), indices, mesh.GetIndexCount(),
+			StridedView<glm::vec3>(&vertices[0].Tangent, stride),
+			StridedView<glm::vec3>(&vertices[0].BiTangent, stride),
+			options);
+	};
+
+	const int iterations = 20;
+	Result scalar   = Measure("TBN scalar, 1 thread", iterations, [&]() { run(false, false); });
+	Result simd     = Measure("TBN SIMD, 1 thread", iterations, [&]() { run(true, false); });
+	Result parallel = Measure("TBN SIMD, thread pool", iterations, [&]() { run(true, true); });
+	Measure("MeshFactory::CalculateTBN", iterations, [&]() { MeshFactory::CalculateTBN(mesh); });
+
+	LOG_INFO("[Benchmark] SIMD speedup {:.2f}x, SIMD + threads speedup {:.2f}x", scalar.AvgMs / simd.AvgMs, scalar.AvgMs / parallel.AvgMs);
+}
+
+namespace {
+	// A standalone bullet world for the physics benchmark, set up the same way as Scene::_InitPhysics
+	// but without needing a window or any game objects
+	struct StressWorld {
+		std::unique_ptr<btDefaultCollisionConfiguration> Config;
+		std::unique_ptr<btCollisionDispatcher>           Dispatcher;
+		std::unique_ptr<btBroadphaseInterface>           Broadphase;
+		std::unique_ptr<btConstraintSolver>              Solver;
+		std::unique_ptr<btDiscreteDynamicsWorld>         World;
+		std::vector<std::unique_ptr<btCollisionShape>>   Shapes;
+		std::vector<std::unique_ptr<btMotionState>>      MotionStates;
+		std::vector<std::unique_ptr<btRigidBody>>        Bodies;
+
+		StressWorld(int numEnemies) {
+			Config = std::make_unique<btDefaultCollisionConfiguration>();
+			Broadphase = std::make_unique<btDbvtBroadphase>();
+			Dispatcher = std::make_unique<btCollisionDispatcher>(Config.get());
+			Solver = std::make_unique<btSequentialImpulseConstraintSolver>();
+			World = std::make_unique<btDiscreteDynamicsWorld>(Dispatcher.get(), Broadphase.get(), Solver.get(), Config.get());
+			World->setGravity(btVector3(0.0f, 0.0f, -9.81f));
+
+			// Floor and walls of a room, roughly the size of the ones in the game
+			btCollisionShape* floor = _AddShape(new btBoxShape(btVector3(20.0f, 20.0f, 0.5f)));
+			btCollisionShape* wall = _AddShape(new btBoxShape(btVector3(20.0f, 0.5f, 5.0f)));
+			_AddBody(floor, 0.0f, btVector3(0.0f, 0.0f, -0.5f), 0.0f);
+			_AddBody(wall, 0.0f, btVector3(0.0f,  20.0f, 5.0f), 0.0f);
+			_AddBody(wall, 0.0f, btVector3(0.0f, -20.0f, 5.0f), 0.0f);
+			_AddBody(wall, 0.0f, btVector3( 20.0f, 0.0f, 5.0f), SIMD_HALF_PI);
+			_AddBody(wall, 0.0f, btVector3(-20.0f, 0.0f, 5.0f), SIMD_HALF_PI);
+
+			// Slimes are spheres and goblins are capsules, dropped in a grid so they pile up
+			btCollisionShape* slime = _AddShape(new btSphereShape(0.5f));
+			btCollisionShape* goblin = _AddShape(new btCapsuleShapeZ(0.4f, 1.0f));
+			const int perRow = 16;
+			for (int ix = 0; ix < numEnemies; ix++) {
+				const int column = ix % perRow;
+				const int row = (ix / perRow) % perRow;
+				const int layer = ix / (perRow * perRow);
+				btVector3 position(-15.0f + column * 2.0f, -15.0f + row * 2.0f, 1.0f + layer * 2.0f);
+				_AddBody(ix % 2 == 0 ? slime : goblin, 1.0f, position, 0.0f);
+			}
+		}
+
+		~StressWorld() {
+			// Bodies have to leave the world before it goes away
+			for (auto& body : Bodies) {
+				World->removeRigidBody(body.get());
+			}
+			Bodies.clear();
+			World.reset();
+		}
+
+		btCollisionShape* _AddShape(btCollisionShape* shape) {
+			Shapes.emplace_back(shape);
+			return shape;
+		}
+
+		void _AddBody(btCollisionShape* shape, float mass, const btVector3& position, float yaw) {
+			btVector3 inertia(0.0f, 0.0f, 0.0f);
+			if (mass > 0.0f) {
+				shape->calculateLocalInertia(mass, inertia);
+			}
+			btTransform transform(btQuaternion(btVector3(0.0f, 0.0f, 1.0f), yaw), position);
+			btMotionState* motionState = MotionStates.emplace_back(new btDefaultMotionState(transform)).get();
+			btRigidBody* body = Bodies.emplace_back(new btRigidBody(mass, motionState, shape, inertia)).get();
+			World->addRigidBody(body);
+		}
+	};
+}
+
+void Benchmarks::PhysicsStep() {
+	const int numEnemies = 800;
+	const int settleSteps = 60;
+	const int iterations = 240;
+	const float timestep = 1.0f / 60.0f;
+
+	// Let the bodies fall and pile up first, so we're timing the contact heavy steps
+	StressWorld world(numEnemies);
+	for (int ix = 0; ix < settleSteps; ix++) {
+		world.World->stepSimulation(timestep, 0);
+	}
+
+	LOG_INFO("Stepping {} dynamic bodies", numEnemies);
+	Measure("Physics world step", iterations, [&]() { world.World->stepSimulation(timestep, 0); });
+}
+
+void Benchmarks::CrowdSteering() {
+	const int agentCounts[] = { 1000, 2500, 5000, 10000 };
+	const int settleSteps = 60;
+	const int iterations = 120;
+	const float timestep = 1.0f / 60.0f;
+
+	LOG_INFO("Steering crowds, {} workers, SIMD {}", ThreadPool::GetWorkerCount(), Gameplay::CrowdSystem::IsSimdSupported() ? "on" : "off");
+
+	// Agents start in a grid with the same spacing no matter how many there are, around a target
+	// in the middle of a walled off square. Every fourth agent flees so the crowd keeps churning
+	auto measure = [&](const std::string& name, int numAgents, bool simd, bool threaded) {
+		Gameplay::CrowdSystem crowd;
+		crowd.GetSettings().SenseRadius = 0.0f;
+		crowd.GetSettings().UseSimd = simd;
+		crowd.GetSettings().MultiThreaded = threaded;
+
+		const int perRow = (int)std::ceil(std::sqrt((float)numAgents));
+		const float spacing = 1.2f;
+		const float halfSize = perRow * spacing * 0.5f;
+		for (int ix = 0; ix < numAgents; ix++) {
+			glm::vec3 position = glm::vec3((ix % perRow) * spacing - halfSize, (ix / perRow) * spacing - halfSize, 0.0f);
+			crowd.AddAgent(position, ix % 4 == 0 ? Gameplay::SteeringBehaviour::Flee : Gameplay::SteeringBehaviour::Arrive);
+		}
+		crowd.SetTarget(glm::vec3(0.0f));
+		crowd.AddObstacle(glm::vec2(-halfSize - 3.0f), glm::vec2(-halfSize - 1.0f, halfSize + 3.0f));
+		crowd.AddObstacle(glm::vec2(halfSize + 1.0f, -halfSize - 3.0f), glm::vec2(halfSize + 3.0f));
+		crowd.AddObstacle(glm::vec2(-halfSize - 3.0f), glm::vec2(halfSize + 3.0f, -halfSize - 1.0f));
+		crowd.AddObstacle(glm::vec2(-halfSize - 3.0f, halfSize + 1.0f), glm::vec2(halfSize + 3.0f));
+
+		for (int ix = 0; ix < settleSteps; ix++) {
+			crowd.Update(timestep);
+		}
+		return Measure(name, iterations, [&]() { crowd.Update(timestep); });
+	};
+
+	for (int numAgents : agentCounts) {
+		const std::string suffix = ", " + std::to_string(numAgents) + " agents";
+		Result scalar   = measure("Crowd scalar, 1 thread" + suffix, numAgents, false, false);
+		Result simd     = measure("Crowd SIMD, 1 thread" + suffix, numAgents, true, false);
+		Result parallel = measure("Crowd SIMD, thread pool" + suffix, numAgents, true, true);
+		LOG_INFO("[Benchmark] {} agents, SIMD speedup {:.2f}x, SIMD + threads speedup {:.2f}x", numAgents, scalar.AvgMs / simd.AvgMs, scalar.AvgMs / parallel.AvgMs);
+	}
+}
+
+void Benchmarks::FlowFieldBuild() {
+	const int gridSizes[] = { 256, 512, 1024 };
+	const int numSamples = 10000;
+	const int iterations = 10;
+
+	LOG_INFO("Building flow fields, {} workers", ThreadPool::GetWorkerCount());
+	for (int size : gridSizes) {
+		// Scatter boxes over about a quarter of the grid, seeded so every run sees the same level
+		Gameplay::FlowField field(glm::vec2(0.0f), glm::vec2((float)size), 1.0f);
+		field.Async = false;
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<float> position(0.0f, (float)size);
+		std::uniform_real_distribution<float> extents(1.0f, 6.0f);
+		for (int ix = 0; ix < size * size / 80; ix++) {
+			const glm::vec2 min = glm::vec2(position(engine), position(engine));
+			field.FillCost(min, min + glm::vec2(extents(engine), extents(engine)), Gameplay::FlowField::BLOCKED);
+		}
+		field.SetGoal(glm::vec3(size * 0.5f, size * 0.5f, 0.0f));
+
+		const std::string suffix = ", " + std::to_string(size) + "x" + std::to_string(size);
+		Result single   = Measure("Flow field, 1 thread" + suffix, iterations, [&]() { field.Build(false); });
+		Result parallel = Measure("Flow field, thread pool" + suffix, iterations, [&]() { field.Build(true); });
+		LOG_INFO("[Benchmark] {}x{} thread pool speedup {:.2f}x", size, size, single.AvgMs / parallel.AvgMs);
+
+		std::vector<glm::vec2> agents(numSamples);
+		for (glm::vec2& agent : agents) {
+			agent = glm::vec2(position(engine), position(engine));
+		}
+		Measure("Flow field, sample " + std::to_string(numSamples) + " agents" + suffix, iterations * 10, [&]() {
+			glm::vec2 direction = glm::vec2(0.0f), total = glm::vec2(0.0f);
+			for (const glm::vec2& agent : agents) {
+				if (field.Sample(agent, direction)) {
+					total += direction;
+				}
+			}
+			// Keep the compiler from throwing the loop away
+			volatile float sink = total.x + total.y;
+			(void)sink;
+		});
+	}
+}
+
+void Benchmarks::ObjectCloning() {
+	using namespace Gameplay;
+	using namespace Gameplay::Physics;
+
+	const int numClones = 10000;
+	const int iterations = 5;
+
+	Shader::Sptr shader = ResourceManager::CreateAsset<Shader>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic.glsl" }, { ShaderPartType::Fragment, "shaders/fragment_shaders/frag_blinn_phong_textured.glsl" } });
+	Material::Sptr material = ResourceManager::CreateAsset<Material>(shader);
+	material->Name = "Enemy";
+	material->Set("u_Material.Diffuse", ResourceManager::CreateAsset<Texture2D>("textures/green.png"));
+	material->Set("u_Material.Shininess", 0.1f);
+
+	MeshResource::Sptr mesh = ResourceManager::CreateAsset<MeshResource>();
+	mesh->AddParam(MeshBuilderParam::CreateCube(glm::vec3(0.0f), glm::vec3(1.0f)));
+	mesh->GenerateMesh();
+
+	// Set up an enemy like the ones in the game, with a child object to exercise the hierarchy
+	Scene::Sptr scene = std::make_shared<Scene>();
+	GameObject::Sptr enemy = scene->CreateGameObject("Enemy");
+	{
+		enemy->SetPostion(glm::vec3(1.0f, 2.0f, 1.0f));
+		enemy->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+		enemy->SetScale(glm::vec3(0.5f));
+		enemy->SetHealth(20.0f);
+
+		RenderComponent::Sptr renderer = enemy->Add<RenderComponent>();
+		renderer->SetMesh(mesh);
+		renderer->SetMaterial(material);
+
+		TriggerVolume::Sptr trigger = enemy->Add<TriggerVolume>();
+		CylinderCollider::Sptr cylinder = CylinderCollider::Create(glm::vec3(3.0f, 3.0f, 1.0f));
+		cylinder->SetPosition(glm::vec3(0.0f, 1.0f, 0.0f));
+		trigger->AddCollider(cylinder);
+
+		enemy->Add<TriggerVolumeEnterBehaviour>();
+		enemy->Add<RotatingBehaviour>()->RotationSpeed = glm::vec3(0.0f, 0.0f, 90.0f);
+	}
+	GameObject::Sptr shadow = scene->CreateGameObject("Shadow");
+	{
+		shadow->SetPostion(glm::vec3(0.0f, 0.0f, -0.5f));
+		RenderComponent::Sptr renderer = shadow->Add<RenderComponent>();
+		renderer->SetMesh(mesh);
+		renderer->SetMaterial(material);
+		enemy->AddChild(shadow);
+	}
+
+	LOG_INFO("Cloning {} enemies with {} components and 1 child each", numClones, 4);
+
+	// Both paths add their copies to the scene, which also keeps their destruction out of the timings
+	Result json = Measure("Clone " + std::to_string(numClones) + " objects, JSON", iterations, [&]() {
+		for (int ix = 0; ix < numClones; ix++) {
+			scene->AddGameObject(GameObject::FromJson(enemy->ToJson()));
+			scene->AddGameObject(GameObject::FromJson(shadow->ToJson()));
+		}
+	});
+	Result direct = Measure("Clone " + std::to_string(numClones) + " objects, direct", iterations, [&]() {
+		for (int ix = 0; ix < numClones; ix++) {
+			enemy->Clone();
+		}
+	});
+	LOG_INFO("[Benchmark] Direct object clone speedup {:.2f}x", json.AvgMs / direct.AvgMs);
+
+	std::vector<Material::Sptr> materials;
+	materials.reserve((size_t)numClones * 2 * (iterations + 1));
+	Result materialJson = Measure("Clone " + std::to_string(numClones) + " materials, JSON", iterations, [&]() {
+		for (int ix = 0; ix < numClones; ix++) {
+			materials.push_back(Material::FromJson(material->ToJson()));
+		}
+	});
+	Result materialDirect = Measure("Clone " + std::to_string(numClones) + " materials, direct", iterations, [&]() {
+		for (int ix = 0; ix < numClones; ix++) {
+			materials.push_back(material->Clone());
+		}
+	});
+	LOG_INFO("[Benchmark] Direct material clone speedup {:.2f}x", materialJson.AvgMs / materialDirect.AvgMs);
+}
+
+void Benchmarks::AnimationSampling() {
+	const int numJoints = 64;
+	const int numKeys = 121;
+	const float duration = 4.0f;
+	const int numInstances = 200;
+	const int numFrames = 60;
+	const int iterations = 10;
+
+	// Every joint gets a rotation and position track, keyed at 30fps with some wobble so the
+	// keys aren't all the same
+	nou::Skeleton skeleton;
+	skeleton.m_joints.resize(numJoints);
+	nou::SkeletalAnim anim;
+	anim.duration = duration;
+	for (int joint = 0; joint < numJoints; joint++) {
+		nou::JointAnim track;
+		track.jointInd = joint;
+		track.rotFrames = numKeys;
+		track.posFrames = numKeys;
+		for (int key = 0; key < numKeys; key++) {
+			const float time = duration * key / (numKeys - 1);
+			track.rotTimes.push_back(time);
+			track.rotKeys.push_back(glm::normalize(glm::quat(1.0f, 0.5f * std::sin(time * 2.0f + joint), 0.3f * std::cos(time * 3.0f), 0.1f * joint / numJoints)));
+			track.posTimes.push_back(time);
+			track.posKeys.push_back(glm::vec3(0.1f * std::sin(time + joint), 0.05f * std::cos(time * 2.0f), 0.25f));
+		}
+		anim.data.push_back(track);
+	}
+
+	size_t rawBytes = sizeof(nou::SkeletalAnim) + anim.data.capacity() * sizeof(nou::JointAnim);
+	for (const nou::JointAnim& track : anim.data) {
+		rawBytes += track.rotTimes.capacity() * sizeof(float) + track.rotKeys.capacity() * sizeof(glm::quat);
+		rawBytes += track.posTimes.capacity() * sizeof(float) + track.posKeys.capacity() * sizeof(glm::vec3);
+	}
+	nou::CompressedAnim compressed(anim);
+	LOG_INFO("[Benchmark] Clip memory, SkeletalAnim: {} bytes, compressed: {} bytes ({:.2f}x smaller)",
+		rawBytes, compressed.GetMemoryUsage(), (double)rawBytes / compressed.GetMemoryUsage());
+
+	std::vector<std::unique_ptr<nou::SkeletalAnimClip>> clips;
+	std::vector<std::unique_ptr<nou::AnimSampler>> samplers;
+	for (int ix = 0; ix < numInstances; ix++) {
+		clips.push_back(std::make_unique<nou::SkeletalAnimClip>(anim, skeleton));
+		samplers.push_back(std::make_unique<nou::AnimSampler>(compressed, skeleton));
+	}
+
+	const float frameTime = 1.0f / 60.0f;
+	const std::string suffix = ", " + std::to_string(numInstances) + " skeletons x " + std::to_string(numFrames) + " frames";
+	// Note that SkeletalAnimClip only samples rotations, it takes every position from the first key
+	Result clip = Measure("SkeletalAnimClip, forward" + suffix, iterations, [&]() {
+		for (int frame = 0; frame < numFrames; frame++) {
+			for (auto& instance : clips) {
+				instance->Update(frameTime, skeleton);
+			}
+		}
+	});
+	Result sampler = Measure("AnimSampler, forward" + suffix, iterations, [&]() {
+		for (int frame = 0; frame < numFrames; frame++) {
+			for (auto& instance : samplers) {
+				instance->Update(frameTime);
+			}
+		}
+	});
+	Measure("AnimSampler, reverse" + suffix, iterations, [&]() {
+		for (int frame = 0; frame < numFrames; frame++) {
+			for (auto& instance : samplers) {
+				instance->Update(-frameTime);
+			}
+		}
+	});
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> seekTime(0.0f, duration);
+	Measure("AnimSampler, random seeks" + suffix, iterations, [&]() {
+		for (int frame = 0; frame < numFrames; frame++) {
+			for (auto& instance : samplers) {
+				instance->Seek(seekTime(engine));
+			}
+		}
+	});
+	LOG_INFO("[Benchmark] Forward sampling speedup {:.2f}x", clip.AvgMs / sampler.AvgMs);
+}
+
+void Benchmarks::ForwardKinematics() {
+	const int numJoints = 64;
+	const int numCharacters = 1000;
+	const int iterations = 20;
+
+	// A random tree with the joints shuffled, so parents aren't always listed before their children
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> range(-1.0f, 1.0f);
+	std::vector<int> order(numJoints);
+	for (int ix = 0; ix < numJoints; ix++) {
+		order[ix] = ix;
+	}
+	std::shuffle(order.begin(), order.end(), engine);
+
+	nou::Skeleton skeleton;
+	skeleton.m_joints.resize(numJoints, nou::Joint(&skeleton));
+	skeleton.m_rootInd = order[0];
+	for (int ix = 0; ix < numJoints; ix++) {
+		nou::Joint& joint = skeleton.m_joints[order[ix]];
+		if (ix > 0) {
+			const int parent = order[engine() % ix];
+			joint.m_parent = true;
+			joint.m_parentInd = parent;
+			skeleton.m_joints[parent].m_childrenInd.push_back(order[ix]);
+		}
+		joint.m_pos = joint.m_basePos = glm::vec3(range(engine), range(engine), range(engine));
+		joint.m_rotation = joint.m_baseRotation = glm::normalize(glm::quat(range(engine), range(engine), range(engine), range(engine)));
+		joint.m_invBind[3] = glm::vec4(range(engine), range(engine), range(engine), 1.0f);
+	}
+
+	std::vector<nou::Skeleton> skeletons(numCharacters);
+	for (nou::Skeleton& copy : skeletons) {
+		copy = skeleton;
+	}
+
+	nou::SkeletonLayout layout(skeleton);
+	std::vector<nou::SkeletonPose> poses(numCharacters, nou::SkeletonPose(layout));
+	std::vector<nou::SkeletonPose*> posePtrs;
+	for (nou::SkeletonPose& pose : poses) {
+		posePtrs.push_back(&pose);
+	}
+
+	const std::string suffix = ", " + std::to_string(numCharacters) + " characters";
+	// DoFK doesn't build the skinning palette, so we do that after to keep the comparison fair
+	std::vector<glm::mat4> palette(numJoints);
+	Result recursive = Measure("Recursive FK + palette" + suffix, iterations, [&]() {
+		for (nou::Skeleton& copy : skeletons) {
+			copy.DoFK();
+			for (int ix = 0; ix < numJoints; ix++) {
+				palette[ix] = copy.m_joints[ix].m_global * copy.m_joints[ix].m_invBind;
+			}
+		}
+	});
+	Result flat = Measure("Flattened FK" + suffix, iterations, [&]() {
+		for (nou::SkeletonPose& pose : poses) {
+			nou::FK::Solve(layout, pose);
+		}
+	});
+	Result batch = Measure("Flattened FK, thread pool" + suffix, iterations, [&]() {
+		nou::FK::SolveBatch(layout, posePtrs.data(), posePtrs.size());
+	});
+	LOG_INFO("[Benchmark] Flattened FK speedup {:.2f}x, {:.2f}x on {} workers", recursive.AvgMs / flat.AvgMs, recursive.AvgMs / batch.AvgMs, ThreadPool::GetWorkerCount());
+}
+
+void Benchmarks::CpuSkinning() {
+	const int numJoints = 64;
+	const int numVertices = 4000;
+	const int numCharacters = 100;
+	const int iterations = 20;
+
+	// Random vertices, each influenced by 4 random joints with weights that add up to 1
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> range(-1.0f, 1.0f);
+	std::vector<glm::vec3> positions(numVertices), normals(numVertices);
+	std::vector<glm::vec4> joints(numVertices), weights(numVertices);
+	for (int ix = 0; ix < numVertices; ix++) {
+		positions[ix] = glm::vec3(range(engine), range(engine), range(engine));
+		normals[ix] = glm::normalize(glm::vec3(range(engine), range(engine), range(engine)) + glm::vec3(0.0f, 0.0f, 2.0f));
+		joints[ix] = glm::vec4((float)(engine() % numJoints), (float)(engine() % numJoints), (float)(engine() % numJoints), (float)(engine() % numJoints));
+		glm::vec4 weight = glm::abs(glm::vec4(range(engine), range(engine), range(engine), range(engine))) + glm::vec4(0.01f);
+		weights[ix] = weight / (weight.x + weight.y + weight.z + weight.w);
+	}
+
+	// Every character gets its own palette
+	std::vector<glm::mat4> palettes(numJoints * numCharacters);
+	for (glm::mat4& matrix : palettes) {
+		matrix = glm::toMat4(glm::normalize(glm::quat(range(engine), range(engine), range(engine), range(engine))));
+		matrix[3] = glm::vec4(range(engine), range(engine), range(engine), 1.0f);
+	}
+
+	std::vector<glm::vec3> outPositions(numVertices * numCharacters), outNormals(numVertices * numCharacters);
+	auto skin = [&](size_t begin, size_t end, bool simd) {
+		for (size_t ix = begin; ix < end; ix++) {
+			auto func = simd ? &nou::Skinning::SkinVertices : &nou::Skinning::SkinVerticesScalar;
+			func(&palettes[ix * numJoints], positions.data(), normals.data(), joints.data(), weights.data(), numVertices,
+				&outPositions[ix * numVertices], &outNormals[ix * numVertices]);
+		}
+	};
+
+	const std::string suffix = ", " + std::to_string(numCharacters) + " x " + std::to_string(numVertices) + " vertices";
+	Result scalar = Measure("CPU skinning scalar" + suffix, iterations, [&]() { skin(0, numCharacters, false); });
+	std::vector<glm::vec3> expectedPositions = outPositions, expectedNormals = outNormals;
+	Result simd = Measure("CPU skinning SIMD" + suffix, iterations, [&]() { skin(0, numCharacters, true); });
+	Result parallel = Measure("CPU skinning SIMD, thread pool" + suffix, iterations, [&]() {
+		ThreadPool::ParallelFor(numCharacters, 4, [&](size_t begin, size_t end) { skin(begin, end, true); });
+	});
+
+	// The fallback is meant to match the shader exactly, so the two kernels shouldn't differ by a single bit
+	const bool identical =
+		std::memcmp(expectedPositions.data(), outPositions.data(), outPositions.size() * sizeof(glm::vec3)) == 0 &&
+		std::memcmp(expectedNormals.data(), outNormals.data(), outNormals.size() * sizeof(glm::vec3)) == 0;
+	LOG_INFO("[Benchmark] SIMD skinning speedup {:.2f}x, {:.2f}x on {} workers, results {}",
+		scalar.AvgMs / simd.AvgMs, scalar.AvgMs / parallel.AvgMs, ThreadPool::GetWorkerCount(), identical ? "identical" : "DIFFERENT");
+}
+
+void Benchmarks::AnimationBlending() {
+	const int numJoints = 64;
+	const int numKeys = 61;
+	const float duration = 2.0f;
+	const int numCharacters = 500;
+	const int numFrames = 60;
+	const int iterations = 5;
+
+	// A random tree, so that the layout's depth sort (and so joint LOD) has something to do
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> range(-1.0f, 1.0f);
+	nou::Skeleton skeleton;
+	skeleton.m_joints.resize(numJoints, nou::Joint(&skeleton));
+	skeleton.m_rootInd = 0;
+	for (int ix = 1; ix < numJoints; ix++) {
+		const int parent = engine() % ix;
+		skeleton.m_joints[ix].m_parent = true;
+		skeleton.m_joints[ix].m_parentInd = parent;
+		skeleton.m_joints[parent].m_childrenInd.push_back(ix);
+		skeleton.m_joints[ix].m_basePos = skeleton.m_joints[ix].m_pos = glm::vec3(0.0f, 0.25f, 0.0f);
+	}
+	nou::SkeletonLayout layout(skeleton);
+
+	// Idle, walk and run are the same wobble at increasing speeds, plus an additive lean
+	auto makeClip = [&](float speed, float lean) {
+		nou::SkeletalAnim anim;
+		anim.duration = duration;
+		for (int joint = 0; joint < numJoints; joint++) {
+			nou::JointAnim track;
+			track.jointInd = joint;
+			track.rotFrames = numKeys;
+			track.posFrames = numKeys;
+			for (int key = 0; key < numKeys; key++) {
+				const float time = duration * key / (numKeys - 1);
+				const float phase = time * speed * 6.2831853f / duration + joint;
+				track.rotTimes.push_back(time);
+				track.rotKeys.push_back(glm::normalize(glm::quat(1.0f, 0.3f * std::sin(phase), lean, 0.2f * std::cos(phase))));
+				track.posTimes.push_back(time);
+				track.posKeys.push_back(glm::vec3(0.0f, 0.25f, 0.05f * std::sin(phase)));
+			}
+			anim.data.push_back(track);
+		}
+		return std::make_unique<nou::CompressedAnim>(anim);
+	};
+	std::unique_ptr<nou::CompressedAnim> idle = makeClip(1.0f, 0.0f);
+	std::unique_ptr<nou::CompressedAnim> walk = makeClip(2.0f, 0.0f);
+	std::unique_ptr<nou::CompressedAnim> run = makeClip(4.0f, 0.0f);
+	std::unique_ptr<nou::CompressedAnim> lean = makeClip(0.5f, 0.3f);
+
+	// Characters spread out from 0 to 100m from the camera, each running a locomotion blend
+	// with the lean added on top
+	std::vector<std::unique_ptr<nou::AnimPlayer>> players;
+	std::vector<nou::SkeletonPose> poses(numCharacters, nou::SkeletonPose(layout));
+	std::vector<float> distances;
+	for (int ix = 0; ix < numCharacters; ix++) {
+		auto locomotion = std::make_unique<nou::Blend1DNode>();
+		locomotion->AddChild(0.0f, std::make_unique<nou::ClipNode>(*idle, skeleton));
+		locomotion->AddChild(2.0f, std::make_unique<nou::ClipNode>(*walk, skeleton));
+		locomotion->AddChild(6.0f, std::make_unique<nou::ClipNode>(*run, skeleton));
+		locomotion->SetParameter(6.0f * ix / numCharacters);
+		auto layered = std::make_unique<nou::LayerNode>(std::move(locomotion),
+			std::make_unique<nou::ClipNode>(*lean, skeleton), nou::LayerNode::Mode::ADDITIVE);
+		layered->SetWeight(0.5f);
+		players.push_back(std::make_unique<nou::AnimPlayer>(std::move(layered)));
+		distances.push_back(100.0f * ix / numCharacters);
+	}
+
+	const float frameTime = 1.0f / 60.0f;
+	nou::AnimFrameStats totals = {};
+	auto runFrames = [&](bool lod) {
+		totals = {};
+		nou::AnimPlayer::CollectFrameStats();
+		for (int frame = 0; frame < numFrames; frame++) {
+			for (int ix = 0; ix < numCharacters; ix++) {
+				if (lod) {
+					players[ix]->SetLODFromView(distances[ix], true);
+				} else {
+					players[ix]->SetLOD(1, 1.0f, false);
+				}
+				players[ix]->Update(frameTime, layout, poses[ix]);
+			}
+			nou::AnimFrameStats stats = nou::AnimPlayer::CollectFrameStats();
+			totals.posesEvaluated += stats.posesEvaluated;
+			totals.posesInterpolated += stats.posesInterpolated;
+			totals.clipsSampled += stats.clipsSampled;
+			totals.blends += stats.blends;
+			totals.jointsEvaluated += stats.jointsEvaluated;
+		}
+	};
+	auto logStats = [&](const char* label) {
+		LOG_INFO("[Benchmark] {} per frame: {} poses evaluated, {} interpolated, {} clips sampled, {} blends, {} joints",
+			label, totals.posesEvaluated / numFrames, totals.posesInterpolated / numFrames, totals.clipsSampled / numFrames,
+			totals.blends / numFrames, totals.jointsEvaluated / numFrames);
+	};
+
+	const std::string suffix = ", " + std::to_string(numCharacters) + " characters x " + std::to_string(numFrames) + " frames";
+	Result full = Measure("Blend tree, no LOD" + suffix, iterations, [&]() { runFrames(false); });
+	logStats("No LOD");
+	Result lod = Measure("Blend tree, distance LOD" + suffix, iterations, [&]() { runFrames(true); });
+	logStats("Distance LOD");
+
+	// The blend kernel on its own
+	nou::LocalPose a, b, out;
+	a.Resize(numJoints);
+	b.Resize(numJoints);
+	out.Resize(numJoints);
+	for (int ix = 0; ix < numJoints; ix++) {
+		a.pos[ix] = glm::vec3(range(engine), range(engine), range(engine));
+		b.pos[ix] = glm::vec3(range(engine), range(engine), range(engine));
+		a.rotation[ix] = glm::normalize(glm::quat(range(engine), range(engine), range(engine), range(engine)));
+		b.rotation[ix] = glm::normalize(glm::quat(range(engine), range(engine), range(engine), range(engine)));
+	}
+	const int numBlends = 20000;
+	Result scalar = Measure("Pose blend scalar, " + std::to_string(numBlends) + " blends", iterations, [&]() {
+		for (int ix = 0; ix < numBlends; ix++) {
+			nou::PoseOps::BlendScalar(a, b, 0.3f, nullptr, out, numJoints);
+		}
+	});
+	Result simd = Measure("Pose blend SIMD, " + std::to_string(numBlends) + " blends", iterations, [&]() {
+		for (int ix = 0; ix < numBlends; ix++) {
+			nou::PoseOps::Blend(a, b, 0.3f, nullptr, out, numJoints);
+		}
+	});
+
+	LOG_INFO("[Benchmark] Distance LOD speedup {:.2f}x, SIMD blend speedup {:.2f}x", full.AvgMs / lod.AvgMs, scalar.AvgMs / simd.AvgMs);
+}
+
+void Benchmarks::GltfCacheLoad() {
+	std::string filename = _FindLargestFile(".glb");
+	if (filename.empty()) {
+		filename = _FindLargestFile(".gltf");
+	}
+	if (filename.empty()) {
+		LOG_WARN("No glTF files found in the working directory, skipping");
+		return;
+	}
+
+	// Cook up front, so the cached runs never have to fall back to importing
+	if (!nou::GLTF::Cook(filename)) {
+		LOG_WARN("Nothing to cook in \"{}\", skipping", filename);
+		return;
+	}
+	nou::CompressedAnim probe;
+	const bool hasAnim = nou::GLTF::LoadAnimationCached(filename, probe);
+	LOG_INFO("Loading \"{}\" ({} bytes), cooked copy is {} bytes, animation {}", filename,
+		std::filesystem::file_size(filename), std::filesystem::file_size(nou::GLTF::GetCookedPath(filename)), hasAnim ? "yes" : "no");
+
+	// Both paths end up with a skinned mesh and a compressed clip, so the import also has to compress
+	const int iterations = 10;
+	Result import = Measure("glTF import, tinygltf", iterations, [&]() {
+		nou::SkinnedMesh mesh;
+		nou::GLTF::LoadSkinnedMesh(filename, mesh);
+		if (hasAnim) {
+			nou::SkeletalAnim anim;
+			nou::GLTF::LoadAnimation(filename, anim);
+			nou::CompressedAnim compressed(anim);
+		}
+	});
+	Result cooked = Measure("glTF load, cooked and mapped", iterations, [&]() {
+		nou::SkinnedMesh mesh;
+		nou::GLTF::LoadSkinnedMeshCached(filename, mesh);
+		if (hasAnim) {
+			nou::CompressedAnim anim;
+			nou::GLTF::LoadAnimationCached(filename, anim);
+		}
+	});
+
+	LOG_INFO("[Benchmark] Cooked load speedup {:.2f}x", import.AvgMs / cooked.AvgMs);
+}
+
+void Benchmarks::HudText() {
+	Font::Sptr font = std::make_shared<Font>("fonts/Roboto-Medium.ttf", 32.0f);
+	if (font->GetLineHeight() == 0.0f) {
+		LOG_WARN("Could not load fonts/Roboto-Medium.ttf, skipping");
+		return;
+	}
+	font->Bake();
+
+	// Wait for the workers to rasterize the glyphs, so every run draws the same thing. The revision
+	// changes as finished glyphs are uploaded, so we're done once it has changed and then held still
+	{
+		typedef std::chrono::steady_clock Clock;
+		const Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+		uint32_t revision = font->GetRevision();
+		bool changed = false;
+		Clock::time_point lastChange = Clock::now();
+		while (Clock::now() < deadline && (!changed || Clock::now() - lastChange < std::chrono::milliseconds(50))) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			uint32_t current = font->GetRevision();
+			if (current != revision) {
+				revision = current;
+				changed = true;
+				lastChange = Clock::now();
+			}
+		}
+		if (!changed) {
+			LOG_WARN("[Benchmark] Font glyphs did not finish baking, results may include rasterizing");
+		}
+	}
+
+	// A typical HUD: the health and timer change every frame, the rest now and then
+	const int frames = 1000;
+	std::vector<std::string> texts(8);
+	auto updateHud = [&](int frame) {
+		texts[0] = std::to_string(100 - (frame / 3) % 100);
+		texts[1] = "Wave " + std::to_string(1 + frame / 250);
+		texts[2] = "Score: " + std::to_string(frame * 10);
+		texts[3] = "Time " + std::to_string(frame / 60) + ":" + std::to_string(frame % 60);
+		texts[4] = "Enemies Remaining: " + std::to_string(50 - frame / 20);
+		texts[5] = "Press Space To Start";
+		texts[6] = "Paused";
+		texts[7] = "Mouse Left Click - Attack\nSpacebar - Absorb\nEscape - Pause";
+	};
+	LOG_INFO("Updating {} HUD strings for {} frames", texts.size(), frames);
+
+	// What GuiText and GuiBatcher used to do: convert to a wide string, measure, then convert
+	// again and lay the glyphs out while drawing, for every string every frame
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+	float sink = 0.0f;
+	Result legacy = Measure("HUD, convert + measure every frame", 10, [&]() {
+		for (int frame = 0; frame < frames; frame++) {
+			updateHud(frame);
+			for (const std::string& text : texts) {
+				std::wstring unicode = converter.from_bytes(text);
+				sink += font->MeausureString(unicode).x;
+				std::wstring drawn = converter.from_bytes(text);
+				float pen = 0.0f;
+				for (size_t ix = 0; ix < drawn.size(); ix++) {
+					GlyphInfo glyph = font->GetGlyph(drawn[ix], pen, 0.0f);
+					sink += glyph.Positions[0].x;
+					pen = glyph.OffsetX;
+					if (ix + 1 < drawn.size()) {
+						pen += font->GetKerning(drawn[ix], drawn[ix + 1]);
+					}
+				}
+			}
+		}
+	});
+
+	// Decoding straight from UTF-8 into a re-used layout, still every string every frame
+	TextLayout layout;
+	Result uncached = Measure("HUD, UTF-8 layout every frame", 10, [&]() {
+		for (int frame = 0; frame < frames; frame++) {
+			updateHud(frame);
+			for (const std::string& text : texts) {
+				layout.Build(*font, text, 1.0f);
+				sink += layout.Size.x;
+			}
+		}
+	});
+
+	// What GuiText does now, strings that didn't change are skipped, and the rest hit the
+	// cache whenever a value comes back around. Cold runs start from an empty cache like the
+	// first time through a level, warm runs keep the layouts from the previous run
+	std::vector<std::string> previous(texts.size());
+	size_t builds = 0;
+	size_t updates = 0;
+	auto runCached = [&](bool cold) {
+		if (cold) {
+			TextLayoutCache::Clear();
+		}
+		std::fill(previous.begin(), previous.end(), std::string());
+		const size_t buildsBefore = TextLayoutCache::GetBuildCount();
+		updates = 0;
+		for (int frame = 0; frame < frames; frame++) {
+			updateHud(frame);
+			for (size_t ix = 0; ix < texts.size(); ix++) {
+				if (texts[ix] != previous[ix]) {
+					previous[ix] = texts[ix];
+					updates++;
+					sink += TextLayoutCache::Get(font, texts[ix]).Size.x;
+				}
+			}
+		}
+		builds = TextLayoutCache::GetBuildCount() - buildsBefore;
+	};
+	Result cold = Measure("HUD, layout cache on change, cold", 10, [&]() { runCached(true); });
+	LOG_INFO("[Benchmark] Cold: {} layouts built for {} changed strings", builds, updates);
+	Result warm = Measure("HUD, layout cache on change, warm", 10, [&]() { runCached(false); });
+	LOG_INFO("[Benchmark] Warm: {} layouts built for {} changed strings, {} cached", builds, updates, TextLayoutCache::GetCount());
+	LOG_INFO("[Benchmark] Cold layout cache speedup {:.2f}x over converting every frame, {:.2f}x over laying out every frame",
+		legacy.AvgMs / cold.AvgMs, uncached.AvgMs / cold.AvgMs);
+	LOG_INFO("[Benchmark] Warm layout cache speedup {:.2f}x over converting every frame, {:.2f}x over laying out every frame",
+		legacy.AvgMs / warm.AvgMs, uncached.AvgMs / warm.AvgMs);
+
+	// Raw decoding speed, on a string with a mix of 1 to 4 byte characters
+	std::string mixed;
+	for (int ix = 0; ix < 10000; ix++) {
+		mixed += "Health: 100 \xC3\xA9\xE2\x82\xAC\xF0\x9F\x99\x82 ";
+	}
+	Result convert = Measure("UTF-8, std::wstring_convert", 20, [&]() {
+		std::wstring unicode = converter.from_bytes(mixed);
+		sink += (float)unicode.size();
+	});
+	Result decode = Measure("UTF-8, Utf8::Next", 20, [&]() {
+		uint32_t sum = 0;
+		size_t index = 0;
+		while (index < mixed.size()) {
+			sum += Utf8::Next(mixed, index);
+		}
+		sink += (float)sum;
+	});
+	LOG_INFO("[Benchmark] UTF-8 decode speedup {:.2f}x ({} bytes)", convert.AvgMs / decode.AvgMs, mixed.size());
+	volatile float result = sink;
+	(void)result;
+}
+
+namespace {
+	// Tasks for the scheduler benchmark, these are free functions so the coroutine frames never
+	// hold references into a lambda that has gone out of scope
+	Gameplay::Task CountAfter(float seconds, int* counter) {
+		co_await Gameplay::Seconds(seconds);
+		(*counter)++;
+	}
+
+	Gameplay::Task CountOnSignal(Gameplay::Signal* signal, int* counter) {
+		co_await *signal;
+		(*counter)++;
+	}
+
+	Gameplay::Task ThrowAfter(float seconds) {
+		co_await Gameplay::Seconds(seconds);
+		throw std::runtime_error("Expected exception from the scheduler benchmark");
+	}
+
+	Gameplay::Task Cooldown(float seconds, int* counter) {
+		while (true) {
+			co_await Gameplay::Seconds(seconds);
+			(*counter)++;
+		}
+	}
+}
+
+void Benchmarks::SchedulerTasks() {
+	Gameplay::SimulationClock clock;
+	clock.SetFixedRate(60.0f);
+	const int ticksPerSecond = 60;
+
+	bool passed = true;
+	auto check = [&](bool condition, const char* description) {
+		if (!condition) {
+			LOG_ERROR("[Benchmark] Scheduler check failed: {}", description);
+			passed = false;
+		}
+	};
+
+	{
+		Gameplay::Scheduler scheduler(clock);
+		int count = 0;
+
+		// Timers
+		scheduler.Start(CountAfter(0.5f, &count));
+		for (int ix = 0; ix < ticksPerSecond / 2 - 1; ix++) {
+			scheduler.Tick();
+		}
+		check(count == 0, "Seconds woke up early");
+		scheduler.Tick();
+		check(count == 1, "Seconds did not wake up on time");
+
+		// Cancelling a waiting task
+		Gameplay::Scheduler::TaskHandle cancelled = scheduler.Start(CountAfter(0.25f, &count));
+		scheduler.Cancel(cancelled);
+		check(!scheduler.IsPending(cancelled), "Cancelled task is still pending");
+		for (int ix = 0; ix < ticksPerSecond; ix++) {
+			scheduler.Tick();
+		}
+		check(count == 1, "Cancelled task still ran");
+
+		// Trigger signals wake their waiters on the next tick
+		TriggerVolumeEnterBehaviour trigger;
+		scheduler.Start(CountOnSignal(&trigger.TriggerEntered(), &count));
+		check(trigger.TriggerEntered().GetWaitingCount() == 1, "Task is not waiting on TriggerEntered");
+		trigger.OnTriggerVolumeEntered(nullptr);
+		scheduler.Tick();
+		check(count == 2, "TriggerEntered did not wake its task");
+
+		// A throwing task is logged and freed instead of leaking
+		scheduler.Start(ThrowAfter(0.1f));
+		for (int ix = 0; ix < ticksPerSecond; ix++) {
+			scheduler.Tick();
+		}
+		check(scheduler.GetPendingCount() == 0, "Throwing task was not cleaned up");
+	}
+
+	{
+		// A signal that outlives the scheduler of the task waiting on it
+		Gameplay::Signal signal;
+		int count = 0;
+		{
+			Gameplay::Scheduler scheduler(clock);
+			scheduler.Start(CountOnSignal(&signal, &count));
+		}
+		signal.Fire();
+		check(count == 0, "Signal woke a task of a destroyed scheduler");
+	}
+
+	LOG_INFO("[Benchmark] Scheduler checks {}", passed ? "passed" : "FAILED");
+	_failed |= !passed;
+
+	// 10k tasks with cooldowns spread between 0.1 and 5 seconds, so every tick has some work due
+	const int numTasks = 10000;
+	Gameplay::Scheduler scheduler(clock);
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> cooldown(0.1f, 5.0f);
+	int fired = 0;
+	for (int ix = 0; ix < numTasks; ix++) {
+		scheduler.Start(Cooldown(cooldown(engine), &fired));
+	}
+
+	Result result = Measure("Scheduler, 10k cooldown tasks", 10, [&]() {
+		for (int ix = 0; ix < ticksPerSecond; ix++) {
+			scheduler.Tick();
+		}
+	});
+	LOG_INFO("[Benchmark] {:.3f}us per tick, {} wakeups", result.AvgMs * 1000.0 / ticksPerSecond, fired);
+}
+
+std::string Benchmarks::_FindLargestFile(const std::string& extension) {
+	std::string result;
+	uintmax_t largest = 0;
+	for (const auto& item : std::filesystem::directory_iterator(".")) {
+		std::string itemExtension = item.path().extension().string();
+		StringTools::ToLower(itemExtension);
+		if (item.is_regular_file() && itemExtension == extension && item.file_size() > largest) {
+			largest = item.file_size();
+			result = item.path().string();
+		}
+	}
+	return result;
+}
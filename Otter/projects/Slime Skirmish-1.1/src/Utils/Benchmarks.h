@@ -0,0 +1,124 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+
+/// <summary>
+/// Micro benchmarks for the engine's hot paths. These are run from the command line
+/// with "--bench [name]" (see main.cpp), and log their results
+/// </summary>
+class Benchmarks {
+public:
+	Benchmarks() = delete;
+
+	/// <summary>
+	/// The results of timing a single function
+	/// </summary>
+	struct Result {
+		std::string Name;
+		int         Iterations;
+		double      MinMs;
+		double      AvgMs;
+		double      MaxMs;
+	};
+
+	/// <summary>
+	/// Times a function over a number of iterations, after a single warmup run
+	/// </summary>
+	/// <param name="name">The name to log the results under</param>
+	/// <param name="iterations">The number of times to run the function</param>
+	/// <param name="func">The function to time</param>
+	static Result Measure(const std::string& name, int iterations, const std::function<void()>& func);
+
+	/// <summary>
+	/// Runs the benchmark with the given name, or all benchmarks if name is "all"
+	/// </summary>
+	/// <returns>True if a benchmark with the given name exists and none of the run benchmarks failed their checks</returns>
+	static bool Run(const std::string& name);
+
+	/// <summary>
+	/// Compares tangent generation on the largest OBJ in the working directory, single threaded
+	/// scalar vs SIMD vs SIMD + thread pool
+	/// </summary>
+	static void TangentGeneration();
+
+	/// <summary>
+	/// Steps a bullet world full of slimes, goblins and walls, set up the same way as a scene's world
+	/// </summary>
+	static void PhysicsStep();
+
+	/// <summary>
+	/// Steers crowds of up to 10k agents around a target, comparing the scalar and SIMD kernels
+	/// single threaded against the SIMD kernel on the thread pool
+	/// </summary>
+	static void CrowdSteering();
+
+	/// <summary>
+	/// Builds flow fields over large grids scattered with obstacles, with the flow directions
+	/// on one thread and on the thread pool, and times sampling the field for a crowd of agents
+	/// </summary>
+	static void FlowFieldBuild();
+
+	/// <summary>
+	/// Clones 10k enemies and their materials through JSON and through Clone. Needs a GL
+	/// context for the scene and shader, see main.cpp
+	/// </summary>
+	static void ObjectCloning();
+
+	/// <summary>
+	/// Plays a synthetic 64 joint clip on 200 skeletons, comparing the memory and sample time of
+	/// the SkeletalAnim layout against the compressed clip and cursor sampler
+	/// </summary>
+	static void AnimationSampling();
+
+	/// <summary>
+	/// Runs forward kinematics for 1000 characters with 64 joint skeletons, comparing the recursive
+	/// Skeleton::DoFK against the flattened single pass, on one thread and on the thread pool
+	/// </summary>
+	static void ForwardKinematics();
+
+	/// <summary>
+	/// Skins 100 characters with 4000 vertex meshes and 64 joint palettes on the CPU, comparing the
+	/// scalar and SIMD fallbacks on one thread and the SIMD fallback on the thread pool, and checks
+	/// that the two give the same vertices
+	/// </summary>
+	static void CpuSkinning();
+
+	/// <summary>
+	/// Runs a locomotion blend space with an additive layer for 500 characters, with and without
+	/// distance based animation LOD, logging the per frame stats of each, and compares the scalar
+	/// and SIMD pose blends
+	/// </summary>
+	static void AnimationBlending();
+
+	/// <summary>
+	/// Loads the largest glTF file in the working directory as a skinned mesh and compressed clip,
+	/// comparing a tinygltf import against memory mapping its cooked copy. Needs a GL context for
+	/// the mesh's buffers, see main.cpp
+	/// </summary>
+	static void GltfCacheLoad();
+
+	/// <summary>
+	/// Updates a HUD of 8 text elements for 1000 frames, with a few changing each frame, comparing
+	/// converting, measuring and laying out every frame against the text layout cache, both cold and
+	/// warm. Also compares std::wstring_convert against the UTF-8 decoder. Needs a GL context for the
+	/// font atlas, see main.cpp
+	/// </summary>
+	static void HudText();
+
+	/// <summary>
+	/// Checks that scheduler tasks wake from timers and signals (including a trigger's TriggerEntered),
+	/// can be cancelled, are cleaned up when they throw, and that signals can outlive their scheduler.
+	/// Then times ticking 10k tasks with staggered cooldowns. Runs headless
+	/// </summary>
+	static void SchedulerTasks();
+
+private:
+	// Set by benchmarks whose correctness checks fail, so that Run can report it
+	static bool _failed;
+
+	/// <summary>
+	/// Finds the largest file with the given extension in the working directory
+	/// </summary>
+	static std::string _FindLargestFile(const std::string& extension);
+};
@@ -4,31 +4,15 @@
 #include <Logging.h>
 
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 
 std::string FileHelpers::ReadFile(const std::string& filename) {
-	std::string result;
-	std::ifstream in(filename, std::ios::in | std::ios::binary); // ifstream closes itself due to RAII
-
-	if (in) {
-		// Determine how long the file is
-		in.seekg(0, std::ios::end);
-		size_t size = in.tellg();
-
-		// As long as we have a size, we can read it!
-		if (size != -1) {
-			// Resize our string to be able to fit all the data
-			result.resize(size);
-			// Seek to beginning of file, then read contents to string
-			in.seekg(0, std::ios::beg);
-			in.read(&result[0], size);
-		} else {
-			LOG_ERROR("Could not read from file '{}'", filename);
-		}
-	} else {
+	// Goes through the VFS so that files in mounted asset packs are found first
+	FileView view = VirtualFileSystem::Open(filename);
+	if (!view) {
 		LOG_ERROR("Could not open file '{}'", filename);
 	}
-
-	return result;
+	return view.ToString();
 }
 
 std::string FileHelpers::ReadResolveIncludes(const std::string& filename, std::vector<std::string> resolvedPaths) {
@@ -76,7 +60,7 @@ std::string FileHelpers::ReadResolveIncludes(const std::string& filename, std::v
 		if (std::find(resolvedPaths.begin(), resolvedPaths.end(), target.string()) == resolvedPaths.end()) {
 
 			// Make sure file exists, then load and resolve it's includes
-			LOG_ASSERT(std::filesystem::exists(target), "File does not exist");
+			LOG_ASSERT(VirtualFileSystem::Exists(target.string()), "File does not exist");
 			std::string replacement = FileHelpers::ReadResolveIncludes(target.string(), resolvedPaths);
 
 			// Inject result into our string
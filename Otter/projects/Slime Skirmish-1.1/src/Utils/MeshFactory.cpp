@@ -1,4 +1,5 @@
 #include "Utils/MeshFactory.h"
+#include <algorithm>
 
 MeshBuilderParam MeshBuilderParam::CreateCube(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& eulerDeg /*= glm::vec3(0.0f)*/, const glm::vec4& col /*= glm::vec4(1.0f)*/) {
 	MeshBuilderParam result;
@@ -78,4 +79,43 @@ nlohmann::json MeshBuilderParam::ToJson() const {
 		result["params"][key] = GlmToJson(value);
 	}
 	return result;
-}
\ No newline at end of file
+}
+
+// Feeds raw bytes into a 64 bit FNV-1a hash
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	for (size_t ix = 0; ix < size; ix++) {
+		hash ^= bytes[ix];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t MeshBuilderParam::Hash(uint64_t seed) const {
+	uint64_t hash = seed;
+	int type = *Type;
+	hash = HashBytes(hash, &type, sizeof(int));
+	hash = HashBytes(hash, &Color, sizeof(glm::vec4));
+
+	// Unordered maps have no stable iteration order, so sort the keys first
+	std::vector<const std::pair<const std::string, glm::vec3>*> entries;
+	entries.reserve(Params.size());
+	for (const auto& entry : Params) {
+		entries.push_back(&entry);
+	}
+	std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+	for (const auto* entry : entries) {
+		hash = HashBytes(hash, entry->first.data(), entry->first.size());
+		hash = HashBytes(hash, &entry->second, sizeof(glm::vec3));
+	}
+	return hash;
+}
+
+uint64_t MeshBuilderParam::Hash(const std::vector<MeshBuilderParam>& params) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const auto& param : params) {
+		hash = param.Hash(hash);
+	}
+	return hash;
+}
@@ -37,6 +37,18 @@ struct MeshBuilderParam {
 
 	static MeshBuilderParam FromJson(const nlohmann::json& blob);
 	nlohmann::json   ToJson() const;
+
+	/// <summary>
+	/// Hashes the contents of this parameter (type, color and all params), such that
+	/// two parameters that will generate the same geometry have the same hash
+	/// </summary>
+	/// <param name="seed">The hash to continue from, for hashing lists of params</param>
+	uint64_t Hash(uint64_t seed = 0xcbf29ce484222325ull) const;
+	/// <summary>
+	/// Hashes a list of mesh builder params, order matters since later params
+	/// (ex: FaceInvert) can modify the results of earlier params
+	/// </summary>
+	static uint64_t Hash(const std::vector<MeshBuilderParam>& params);
 };
 
 
@@ -149,12 +161,13 @@ public:
 	static void InvertFaces(MeshBuilder<Vertex>& mesh);
 
 	/// <summary>
-	/// Calculates the tangents and bitangents from the normal and UV coords
+	/// Calculates the tangents and bitangents from the normal and UV coords, see TangentGenerator
 	/// </summary>
 	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
 	/// <param name="mesh">The mesh to manipulate</param>
+	/// <param name="multiThreaded">True to split large meshes across the thread pool</param>
 	template <typename Vertex>
-	static void CalculateTBN(MeshBuilder<Vertex>& mesh);
+	static void CalculateTBN(MeshBuilder<Vertex>& mesh, bool multiThreaded = true);
 
 protected:	
 	MeshFactory() = default;
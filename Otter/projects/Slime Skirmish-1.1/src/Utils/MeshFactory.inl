@@ -9,7 +9,9 @@
 #include "Logging.h"
 #include "MeshFactory.h"
 #include "Utils/JsonGlmHelpers.h"
-#include "Graphics/VertexParamMap.h"
+#include "Graphics/VertexTraits.h"
+#include "Utils/TangentGenerator.h"
+#include "Utils/ThreadPool.h"
 
 #define M_PI 3.14159265359f
 
@@ -25,26 +27,6 @@ struct RGBA_Helper {
 	};
 };
 
-/// <summary>
-/// Helper function for creating a vertx and setting all fields if they exist
-/// </summary>
-/// <typeparam name="Vertex">The type of vertex to create</typeparam>
-/// <param name="pos">The position for the new vertex</param>
-/// <param name="norm">The normal for the new vertex</param>
-/// <param name="uv">The UV coordinates for the new vertex</param>
-/// <param name="col">The color for the new vertex</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
-/// <returns>A new vertex with the given properties</returns>
-template <typename Vertex>
-Vertex Create(glm::vec3 pos, glm::vec3 norm, glm::vec2 uv, glm::vec4 col, const VertexParamMap& vMap) {
-	Vertex result;
-	vMap.SetPosition(result, pos);
-	vMap.SetNormal(result, norm);
-	vMap.SetTexture(result, uv);
-	vMap.SetColor(result, col);
-	return result;
-}
-
 /// <summary>
 /// Adds a mid point between two points on an ico sphere to the list of vertices, or optionally gets it from a cache of existing midpoints
 /// </summary>
@@ -55,10 +37,9 @@ Vertex Create(glm::vec3 pos, glm::vec3 norm, glm::vec2 uv, glm::vec4 col, const
 /// <param name="b">The index of the second vertex</param>
 /// <param name="vertices">The collection of vertices to work in</param>
 /// <param name="midpointCache">A map to use for caching existing vertices</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
 /// <returns>The index of the vertex in the vertices list</returns>
 template <typename Vertex>
-uint32_t AddMiddlePoint(glm::vec3 scale, glm::vec3 center, uint32_t a, uint32_t b, std::vector<Vertex>& vertices, std::unordered_map<uint64_t, uint32_t>& midpointCache, const VertexParamMap& vMap)
+uint32_t AddMiddlePoint(glm::vec3 scale, glm::vec3 center, uint32_t a, uint32_t b, std::vector<Vertex>& vertices, std::unordered_map<uint64_t, uint32_t>& midpointCache)
 {
 	// We calculate a unique 64 bit key for each index combination (order independent)
 	uint64_t key = 0;
@@ -83,22 +64,22 @@ uint32_t AddMiddlePoint(glm::vec3 scale, glm::vec3 center, uint32_t a, uint32_t
 		Vertex interpolated;
 
 		// Calculate position based on the average between the two normals and store
-		glm::vec3 p1Norm = glm::normalize(vMap.GetPosition(p1) - center);
-		glm::vec3 p2Norm = glm::normalize(vMap.GetPosition(p2) - center);
+		glm::vec3 p1Norm = glm::normalize(VertexTraits<Vertex>::GetPosition(p1) - center);
+		glm::vec3 p2Norm = glm::normalize(VertexTraits<Vertex>::GetPosition(p2) - center);
 		glm::vec3 pos = glm::normalize((p1Norm + p2Norm) / 2.0f);
-		vMap.SetPosition(interpolated, center + (pos * scale));
+		VertexTraits<Vertex>::SetPosition(interpolated, center + (pos * scale));
 
 		// The normal is just the position
-		vMap.SetNormal(interpolated, pos);
+		VertexTraits<Vertex>::SetNormal(interpolated, pos);
 		
 		// Calculate the UV coordinates for the point and store them
 		float u = atan2f(pos.y, pos.x) / (2.0f * M_PI);
 		float v = (asinf(pos.z) / M_PI) + 0.5f;
-		vMap.SetTexture(interpolated, glm::vec2(u, v));
+		VertexTraits<Vertex>::SetTexture(interpolated, glm::vec2(u, v));
 
 		// If the vertex has a color, interpolate the color and store it
-		if (vMap.ColorOffset != -1) {
-			vMap.SetColor(interpolated, (vMap.GetColor(p1) + vMap.GetColor(p2)) / 2.0f);
+		if constexpr (VertexTraits<Vertex>::HasColor) {
+			VertexTraits<Vertex>::SetColor(interpolated, (VertexTraits<Vertex>::GetColor(p1) + VertexTraits<Vertex>::GetColor(p2)) / 2.0f);
 		}
 
 		// Get the index of the new vertex, store it in the cache
@@ -118,18 +99,17 @@ uint32_t AddMiddlePoint(glm::vec3 scale, glm::vec3 center, uint32_t a, uint32_t
 /// <param name="verts">The vertices to work on</param>
 /// <param name="indices">The indices of the triangles in the mesh</param>
 /// <param name="offset">The offset into the index buffer to start modifying from, should be a multiple of 3</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
 template <typename Vertex>
-void CorrectUVSeams(std::vector<Vertex>& verts, std::vector<uint32_t>& indices, size_t offset, const VertexParamMap& vMap) {
+void CorrectUVSeams(std::vector<Vertex>& verts, std::vector<uint32_t>& indices, size_t offset) {
 	// Early bail if the vertex type does not have a texture attribute
-	if (vMap.TextureOffset == -1) return;
+	if constexpr (!VertexTraits<Vertex>::HasUV) return;
 
 	// lambda closure to easily add a vertex with unique texture coordinate to our mesh
 	auto addVertex = [&](size_t ix, const glm::vec2& uv) {
 		const uint32_t index = indices[ix];
 		indices[ix] = (uint32_t)verts.size();
 		Vertex vert = verts[index];
-		vMap.SetTexture(vert, uv);
+		VertexTraits<Vertex>::SetTexture(vert, uv);
 		verts.push_back(vert);
 	};
 
@@ -139,9 +119,9 @@ void CorrectUVSeams(std::vector<Vertex>& verts, std::vector<uint32_t>& indices,
 	// Iterate over all the triangles we added 
 	for (size_t i = current_tris; i < current_tris + numTriangles; ++i) {
 		// Get the UV coordinates
-		const glm::vec2& uv0 = vMap.GetTexture(verts[indices[i * 3 + 0]]);
-		const glm::vec2& uv1 = vMap.GetTexture(verts[indices[i * 3 + 1]]);
-		const glm::vec2& uv2 = vMap.GetTexture(verts[indices[i * 3 + 2]]);
+		const glm::vec2& uv0 = VertexTraits<Vertex>::GetTexture(verts[indices[i * 3 + 0]]);
+		const glm::vec2& uv1 = VertexTraits<Vertex>::GetTexture(verts[indices[i * 3 + 1]]);
+		const glm::vec2& uv2 = VertexTraits<Vertex>::GetTexture(verts[indices[i * 3 + 2]]);
 
 		const float d1 = uv1.x - uv0.x;
 		const float d2 = uv2.x - uv0.x;
@@ -163,18 +143,17 @@ void CorrectUVSeams(std::vector<Vertex>& verts, std::vector<uint32_t>& indices,
 /// <param name="scale">The scale of the sphere</param>
 /// <param name="center">The center point of the sphere</param>
 /// <param name="color">The color of the sphere vertex</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
 /// <returns>A vertex with the position, normal, and UV components set</returns>
 template <typename Vertex>
-Vertex CalculateSphereVert(glm::vec3 norm, glm::vec3 scale, glm::vec3 center, const VertexParamMap& vMap, glm::vec4 color = glm::vec4(1.0f)) {
+Vertex CalculateSphereVert(glm::vec3 norm, glm::vec3 scale, glm::vec3 center, glm::vec4 color = glm::vec4(1.0f)) {
 	Vertex vert;
 	glm::vec3 pos = glm::normalize(norm);
 	float u = atan2f(pos.y, pos.x) / (2.0f * M_PI);
 	float v = (asinf(pos.z) / M_PI) + 0.5f;
-	vMap.SetPosition(vert, center + (pos * scale));
-	vMap.SetNormal(vert, pos);
-	vMap.SetTexture(vert, glm::vec2(u, v));
-	vMap.SetColor(vert, color);
+	VertexTraits<Vertex>::SetPosition(vert, center + (pos * scale));
+	VertexTraits<Vertex>::SetNormal(vert, pos);
+	VertexTraits<Vertex>::SetTexture(vert, glm::vec2(u, v));
+	VertexTraits<Vertex>::SetColor(vert, color);
 	return vert;
 }
 
@@ -187,8 +166,7 @@ template <typename Vertex>
 void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
 	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
 
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
+	if constexpr (!VertexTraits<Vertex>::HasPosition) {
 		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
 		return;
 	}
@@ -201,20 +179,20 @@ void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& cente
 
 	float t = (1.0f + sqrtf(5.0f)) / 2.0f;
 
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-1, t, 0),  radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(1, t, 0),   radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-1, -t, 0), radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(1, -t, 0),  radii, center, vMap, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-1, t, 0),  radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(1, t, 0),   radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-1, -t, 0), radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(1, -t, 0),  radii, center, col));
 
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, -1, t),  radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, 1, t),   radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, -1, -t), radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, 1, -t),  radii, center, vMap, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, -1, t),  radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, 1, t),   radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, -1, -t), radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, 1, -t),  radii, center, col));
 
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(t, 0, -1),  radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(t, 0, 1),   radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-t, 0, -1), radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-t, 0, 1),  radii, center, vMap, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(t, 0, -1),  radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(t, 0, 1),   radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-t, 0, -1), radii, center, col));
+	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-t, 0, 1),  radii, center, col));
 
 	glm::ivec3 iOff = glm::ivec3(indexOffset);
 
@@ -254,9 +232,9 @@ void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& cente
 		std::vector<glm::ivec3> tempFaces;
 		for (auto& indices : faces)
 		{
-			uint32_t a = AddMiddlePoint(radii, center, indices[0], indices[1], data._vertices, midPointCache, vMap);
-			uint32_t b = AddMiddlePoint(radii, center, indices[1], indices[2], data._vertices, midPointCache, vMap);
-			uint32_t c = AddMiddlePoint(radii, center, indices[2], indices[0], data._vertices, midPointCache, vMap);
+			uint32_t a = AddMiddlePoint(radii, center, indices[0], indices[1], data._vertices, midPointCache);
+			uint32_t b = AddMiddlePoint(radii, center, indices[1], indices[2], data._vertices, midPointCache);
+			uint32_t c = AddMiddlePoint(radii, center, indices[2], indices[0], data._vertices, midPointCache);
 
 			tempFaces.emplace_back(glm::ivec3(indices[0], a, c));
 			tempFaces.emplace_back(glm::ivec3(indices[1], b, a));
@@ -272,7 +250,7 @@ void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& cente
 		data._indices.push_back(face[2]);
 	}
 
-	CorrectUVSeams(data._vertices, data._indices, initialIndex, vMap);
+	CorrectUVSeams(data._vertices, data._indices, initialIndex);
 
 }
 
@@ -285,8 +263,7 @@ template <typename Vertex>
 void MeshFactory::AddUvSphere(MeshBuilder<Vertex>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
 	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
 
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
+	if constexpr (!VertexTraits<Vertex>::HasPosition) {
 		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
 		return;
 	}
@@ -322,15 +299,15 @@ void MeshFactory::AddUvSphere(MeshBuilder<Vertex>& data, const glm::vec3& center
 			glm::vec2 uv = glm::vec2((float)j / slices, 1.0f - (float)i / stacks);
 
 			Vertex vert;
-			vMap.SetNormal(vert, normal);
-			vMap.SetPosition(vert, center + (normal * radii));
-			vMap.SetTexture(vert, uv);
-			vMap.SetColor(vert, col);
+			VertexTraits<Vertex>::SetNormal(vert, normal);
+			VertexTraits<Vertex>::SetPosition(vert, center + (normal * radii));
+			VertexTraits<Vertex>::SetTexture(vert, uv);
+			VertexTraits<Vertex>::SetColor(vert, col);
 			verts.push_back(vert);
 		}
 	}
-	vMap.SetTexture(verts[offset], { 0.5f, 1.0f });
-	vMap.SetTexture(verts[verts.size() - 1], { 0.5f, 0.0f });
+	VertexTraits<Vertex>::SetTexture(verts[offset], { 0.5f, 1.0f });
+	VertexTraits<Vertex>::SetTexture(verts[verts.size() - 1], { 0.5f, 0.0f });
 		
 	int numIndices = (slices - 1) * slices * 6;
 	data._indices.reserve(data._indices.size() + numIndices);
@@ -364,8 +341,7 @@ template <typename Vertex>
 void MeshFactory::AddPlane(MeshBuilder<Vertex>& mesh, const glm::vec3& pos, const glm::vec3& normal,
 	const glm::vec3& tangent, const glm::vec2& scale, const glm::vec2& uvScale, const glm::vec4& col)
 {
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
+	if constexpr (!VertexTraits<Vertex>::HasPosition) {
 		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
 		return;
 	}
@@ -390,10 +366,10 @@ void MeshFactory::AddPlane(MeshBuilder<Vertex>& mesh, const glm::vec3& pos, cons
 
 	Vertex verts[4];
 	for(int ix = 0; ix < 4; ix++) {
-		vMap.SetPosition(verts[ix], positions[ix]);
-		vMap.SetNormal(verts[ix], nNorm);
-		vMap.SetTexture(verts[ix], uvs[ix]);
-		vMap.SetColor(verts[ix], col);
+		VertexTraits<Vertex>::SetPosition(verts[ix], positions[ix]);
+		VertexTraits<Vertex>::SetNormal(verts[ix], nNorm);
+		VertexTraits<Vertex>::SetTexture(verts[ix], uvs[ix]);
+		VertexTraits<Vertex>::SetColor(verts[ix], col);
 	}
 
 
@@ -415,8 +391,7 @@ void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::vec3& pos, const
 template <typename Vertex>
 void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::mat4& transform, const glm::vec4& col) {
 
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
+	if constexpr (!VertexTraits<Vertex>::HasPosition) {
 		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
 		return;
 	}
@@ -463,37 +438,37 @@ void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::mat4& transform,
 	mesh.ReserveVertexSpace(24);
 
 	// Bottom
-	indices[0] = mesh.AddVertex(Create<Vertex>(positions[0], normals[4], uvs[0], col, vMap));
-	indices[1] = mesh.AddVertex(Create<Vertex>(positions[2], normals[4], uvs[1], col, vMap));
-	indices[2] = mesh.AddVertex(Create<Vertex>(positions[3], normals[4], uvs[2], col, vMap));
-	indices[3] = mesh.AddVertex(Create<Vertex>(positions[1], normals[4], uvs[3], col, vMap));
+	indices[0] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[0], normals[4], uvs[0], col));
+	indices[1] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[2], normals[4], uvs[1], col));
+	indices[2] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[3], normals[4], uvs[2], col));
+	indices[3] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[1], normals[4], uvs[3], col));
 	// Top
-	indices[4] = mesh.AddVertex(Create<Vertex>(positions[6], normals[5], uvs[0], col, vMap));
-	indices[5] = mesh.AddVertex(Create<Vertex>(positions[4], normals[5], uvs[1], col, vMap));
-	indices[6] = mesh.AddVertex(Create<Vertex>(positions[5], normals[5], uvs[2], col, vMap));
-	indices[7] = mesh.AddVertex(Create<Vertex>(positions[7], normals[5], uvs[3], col, vMap));
+	indices[4] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[6], normals[5], uvs[0], col));
+	indices[5] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[4], normals[5], uvs[1], col));
+	indices[6] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[5], normals[5], uvs[2], col));
+	indices[7] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[7], normals[5], uvs[3], col));
 
 	// Left
-	indices[8]  = mesh.AddVertex(Create<Vertex>(positions[0], normals[0], uvs[0], col, vMap));
-	indices[9]  = mesh.AddVertex(Create<Vertex>(positions[4], normals[0], uvs[1], col, vMap));
-	indices[10] = mesh.AddVertex(Create<Vertex>(positions[6], normals[0], uvs[2], col, vMap));
-	indices[11] = mesh.AddVertex(Create<Vertex>(positions[2], normals[0], uvs[3], col, vMap));
+	indices[8]  = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[0], normals[0], uvs[0], col));
+	indices[9]  = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[4], normals[0], uvs[1], col));
+	indices[10] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[6], normals[0], uvs[2], col));
+	indices[11] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[2], normals[0], uvs[3], col));
 	// Right
-	indices[12] = mesh.AddVertex(Create<Vertex>(positions[3], normals[1], uvs[0], col, vMap));
-	indices[13] = mesh.AddVertex(Create<Vertex>(positions[7], normals[1], uvs[1], col, vMap));
-	indices[14] = mesh.AddVertex(Create<Vertex>(positions[5], normals[1], uvs[2], col, vMap));
-	indices[15] = mesh.AddVertex(Create<Vertex>(positions[1], normals[1], uvs[3], col, vMap));
+	indices[12] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[3], normals[1], uvs[0], col));
+	indices[13] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[7], normals[1], uvs[1], col));
+	indices[14] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[5], normals[1], uvs[2], col));
+	indices[15] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[1], normals[1], uvs[3], col));
 
 	// Front
-	indices[16] = mesh.AddVertex(Create<Vertex>(positions[2], normals[3], uvs[0], col, vMap));
-	indices[17] = mesh.AddVertex(Create<Vertex>(positions[6], normals[3], uvs[1], col, vMap));
-	indices[18] = mesh.AddVertex(Create<Vertex>(positions[7], normals[3], uvs[2], col, vMap));
-	indices[19] = mesh.AddVertex(Create<Vertex>(positions[3], normals[3], uvs[3], col, vMap));
+	indices[16] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[2], normals[3], uvs[0], col));
+	indices[17] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[6], normals[3], uvs[1], col));
+	indices[18] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[7], normals[3], uvs[2], col));
+	indices[19] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[3], normals[3], uvs[3], col));
 	// Back
-	indices[20] = mesh.AddVertex(Create<Vertex>(positions[1], normals[2], uvs[0], col, vMap));
-	indices[21] = mesh.AddVertex(Create<Vertex>(positions[5], normals[2], uvs[1], col, vMap));
-	indices[22] = mesh.AddVertex(Create<Vertex>(positions[4], normals[2], uvs[2], col, vMap));
-	indices[23] = mesh.AddVertex(Create<Vertex>(positions[0], normals[2], uvs[3], col, vMap));
+	indices[20] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[1], normals[2], uvs[0], col));
+	indices[21] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[5], normals[2], uvs[1], col));
+	indices[22] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[4], normals[2], uvs[2], col));
+	indices[23] = mesh.AddVertex(VertexTraits<Vertex>::Create(positions[0], normals[2], uvs[3], col));
 
 	#pragma endregion
 
@@ -554,66 +529,41 @@ void MeshFactory::InvertFaces(MeshBuilder<Vertex>& mesh)
 
 
 template <typename Vertex>
-void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh)
+void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh, bool multiThreaded)
 {
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.TangentOffset == -1 && vMap.BiTangentOffset == -1) {
+	typedef VertexTraits<Vertex> Traits;
+
+	if constexpr (!Traits::HasTangent && !Traits::HasBiTangent) {
 		LOG_WARN("Vertex type does not have tangent or bitangent attribute, aborting CalculateTBN");
-		return;
 	}
-	if (vMap.PositionOffset == -1 || vMap.TextureOffset == -1) {
+	else if constexpr (!Traits::HasPosition || !Traits::HasUV) {
 		LOG_WARN("Vertex type does not required position and texture attributes, aborting CalculateTBN");
-		return;
-	}
-	if ( mesh._indices.size() == 0) {
-		LOG_WARN("Mesh does not have indices, aborting CalculateTBN");
-		return;
-	}
-
-	for (size_t i = 0; i < mesh._vertices.size(); i++) {
-		vMap.SetTangent(mesh._vertices[i], glm::vec3(0.0f));
-		vMap.SetBiTangent(mesh._vertices[i], glm::vec3(0.0f));
 	}
+	else {
+		if (mesh._indices.size() == 0 || mesh._vertices.size() == 0) {
+			LOG_WARN("Mesh does not have indices, aborting CalculateTBN");
+			return;
+		}
 
-	// Iterate over all indices in the mesh, we'll assume that the mesh is indexed
-	for (size_t i = 0; i < mesh._indices.size(); i += 3) {
-		Vertex& v1 = mesh._vertices[mesh._indices[i + 0u]];
-		Vertex& v2 = mesh._vertices[mesh._indices[i + 1u]];
-		Vertex& v3 = mesh._vertices[mesh._indices[i + 2u]];
-
-		// Extract the positions from the mesh
-		glm::vec3 pos[3];
-		pos[0] = vMap.GetPosition(v1);
-		pos[1] = vMap.GetPosition(v2);
-		pos[2] = vMap.GetPosition(v3);
-
-		// Extract the UVs from the mesh
-		glm::vec2 uvs[3];
-		uvs[0] = vMap.GetTexture(v1);
-		uvs[1] = vMap.GetTexture(v2);
-		uvs[2] = vMap.GetTexture(v3);
-
-		// Calculate 2 corner vectors
-		glm::vec3 deltaP1 = pos[1] - pos[0];
-		glm::vec3 deltaP2 = pos[2] - pos[0];
-
-		// Calculate UV deltas
-		glm::vec2 deltaT1 = uvs[1] - uvs[0];
-		glm::vec2 deltaT2 = uvs[2] - uvs[0];
-
-		// Use the deltas in position and UV to calculate the tangent and bitangent
-		// https://learnopengl.com/Advanced-Lighting/Normal-Mapping
-		float r = 1.0f / (deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x);
-		glm::vec3 tangent = glm::normalize((deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r);
-		glm::vec3 bitangent = glm::normalize((deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r);
-
-		// Set attributes in the vertex
-		vMap.SetTangent(v1, glm::normalize((vMap.GetTangent(v1) + tangent) / 2.0f));
-		vMap.SetTangent(v2, glm::normalize((vMap.GetTangent(v2) + tangent) / 2.0f));
-		vMap.SetTangent(v3, glm::normalize((vMap.GetTangent(v3) + tangent) / 2.0f));
-
-		vMap.SetBiTangent(v1, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
-		vMap.SetBiTangent(v2, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
-		vMap.SetBiTangent(v3, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+		// Point the generator directly at the attributes within our vertices, no copies needed
+		Vertex* vertices = mesh._vertices.data();
+		StridedView<glm::vec3> normals, tangents, bitangents;
+		if constexpr (Traits::HasNormal)    { normals    = StridedView<glm::vec3>(&vertices[0].Normal, sizeof(Vertex)); }
+		if constexpr (Traits::HasTangent)   { tangents   = StridedView<glm::vec3>(&vertices[0].Tangent, sizeof(Vertex)); }
+		if constexpr (Traits::HasBiTangent) { bitangents = StridedView<glm::vec3>(&vertices[0].BiTangent, sizeof(Vertex)); }
+
+		TangentGenerator::Options options;
+		options.MultiThreaded = multiThreaded;
+
+		TangentGenerator::Generate(
+			StridedView<glm::vec3>(&vertices[0].Position, sizeof(Vertex)),
+			normals,
+			StridedView<glm::vec2>(&vertices[0].UV, sizeof(Vertex)),
+			mesh._vertices.size(),
+			mesh._indices.data(),
+			mesh._indices.size(),
+			tangents,
+			bitangents,
+			options);
 	}
-}
\ No newline at end of file
+}
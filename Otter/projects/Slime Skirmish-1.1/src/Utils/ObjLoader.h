@@ -10,7 +10,9 @@
 #include "MeshBuilder.h"
 #include "MeshFactory.h"
 #include "Graphics/VertexTypes.h"
+#include "Graphics/VertexTraits.h"
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 
 class ObjLoader
 {
@@ -18,6 +20,14 @@ public:
 	template <typename VertexType = VertexPosNormTexColTangents>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, bool calcTangents = true);
 
+	/// <summary>
+	/// Loads an OBJ file into a mesh builder without uploading it to the GPU
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="calcTangents">True to generate tangents and bitangents for the mesh</param>
+	template <typename VertexType = VertexPosNormTexColTangents>
+	static MeshBuilder<VertexType> LoadMeshBuilder(const std::string& filename, bool calcTangents = true);
+
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
@@ -26,20 +36,26 @@ protected:
 
 template <typename VertexType>
 VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, bool calcTangents) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	// Move our data into a VAO and return it
+	return LoadMeshBuilder<VertexType>(filename, calcTangents).Bake();
+}
+
+template <typename VertexType>
+MeshBuilder<VertexType> ObjLoader::LoadMeshBuilder(const std::string& filename, bool calcTangents) {
+	// Open our file, this may come from disk or a mounted asset pack
+	std::unique_ptr<std::istream> stream = VirtualFileSystem::OpenStream(filename);
 
 	// If our file fails to open, we will throw an error
-	if (!file) {
+	if (stream == nullptr) {
 		throw std::runtime_error("Failed to open file");
 	}
+	std::istream& file = *stream;
 
 	// Could also take this in as a parameter
 	glm::vec4 color = glm::vec4(1.0f);
 
-	// We'll use a vertex param mapper for our attributes
-	VertexParamMap vMap = VertexParamMap(VertexType::V_DECL);
+	// Attributes are set via the vertex traits, so missing attributes are skipped at compile time
+	typedef VertexTraits<VertexType> Traits;
 
 	// Our attributes
 	std::vector<glm::vec3>  positions;
@@ -165,10 +181,10 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, boo
 	for (const auto& vertexIndices : vertices) {
 		// Construct a new vertex using the indices for the vertex
 		VertexType vertex;
-		vMap.SetPosition(vertex, positions[vertexIndices.x]);
-		vMap.SetTexture(vertex, vertexIndices.y != 0 ? uvs[vertexIndices.y] : glm::vec2(0.0f));
-		vMap.SetNormal(vertex, vertexIndices.z != 0 ? normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f));
-		vMap.SetColor(vertex, color);
+		Traits::SetPosition(vertex, positions[vertexIndices.x]);
+		Traits::SetTexture(vertex, vertexIndices.y != 0 ? uvs[vertexIndices.y] : glm::vec2(0.0f));
+		Traits::SetNormal(vertex, vertexIndices.z != 0 ? normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f));
+		Traits::SetColor(vertex, color);
 
 		// Add to the mesh, get index of the added vertex
 		mesh.AddVertex(vertex);
@@ -186,6 +202,5 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, boo
 	float endTime = glfwGetTime();
 	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, mesh.GetVertexCount(), mesh.GetIndexCount());
 
-	// Move our data into a VAO and return it
-	return mesh.Bake();
+	return mesh;
 }
\ No newline at end of file
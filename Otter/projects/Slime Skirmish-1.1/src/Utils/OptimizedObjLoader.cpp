@@ -7,8 +7,11 @@
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <cstring>
+#include <algorithm>
 
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
@@ -28,7 +31,7 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 		// Get the binary path
 		fs::path binPath = filePath.replace_extension(binaryExtension);
 		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
+		if (!VirtualFileSystem::Exists(binPath.string())) {
 			ConvertToBinary(filename, binPath.string());
 		}
 		// Load the corresponding binary file
@@ -45,6 +48,102 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	}
 }
 
+bool OptimizedObjLoader::LoadPositions(const std::string& filename, std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices) {
+	// Resolve OBJ files to their binary version, the same way LoadFromFile does
+	fs::path binPath = fs::path(filename);
+	std::string extension = binPath.extension().string();
+	StringTools::ToLower(extension);
+	if (extension == ".obj") {
+		binPath.replace_extension(binaryExtension);
+		if (!VirtualFileSystem::Exists(binPath.string())) {
+			ConvertToBinary(filename, binPath.string());
+		}
+	} else if (extension != ".bin") {
+		LOG_WARN("Cannot load model from \"{}\"", filename);
+		return false;
+	}
+
+	FileView file = VirtualFileSystem::Open(binPath.string());
+	if (!file) {
+		return false;
+	}
+
+	const uint8_t* seek = file.GetData();
+	BinaryHeader header = BinaryHeader();
+	if (!_CanRead(file, seek, sizeof(BinaryHeader))) {
+		LOG_ERROR("Not enough data in the file!");
+		return _LoadPositionsFromObjFallback(binPath.string(), outPositions, outIndices);
+	}
+	memcpy(&header, seek, sizeof(BinaryHeader));
+	seek += sizeof(BinaryHeader);
+
+	if (header.Version != 0x01) {
+		return _LoadPositionsFromObjFallback(binPath.string(), outPositions, outIndices);
+	}
+
+	// Find where the positions live in each vertex
+	const size_t attribBytes = header.NumAttributes * sizeof(BufferAttribute);
+	if (!_CanRead(file, seek, attribBytes)) {
+		LOG_ERROR("Attribute table in \"{}\" runs past the end of the file", binPath.string());
+		return _LoadPositionsFromObjFallback(binPath.string(), outPositions, outIndices);
+	}
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	memcpy(vertexDeclaration.data(), seek, attribBytes);
+	seek += attribBytes;
+
+	auto it = std::find_if(vertexDeclaration.begin(), vertexDeclaration.end(), [](const BufferAttribute& attrib) {
+		return attrib.Usage == AttribUsage::Position;
+	});
+	if (it == vertexDeclaration.end()) {
+		LOG_WARN("Mesh \"{}\" does not have a position element", filename);
+		return false;
+	}
+	const size_t positionOffset = it->Offset;
+	if (positionOffset + sizeof(glm::vec3) > header.VertexStride) {
+		LOG_ERROR("Position element in \"{}\" does not fit in the vertex stride", binPath.string());
+		return _LoadPositionsFromObjFallback(binPath.string(), outPositions, outIndices);
+	}
+
+	// Widen the indices out to 32 bit
+	const size_t indexSize = GetIndexTypeSize(header.IndicesType);
+	const size_t indexBytes = header.NumIndices * indexSize;
+	if ((header.NumIndices > 0 && indexSize == 0) || !_CanRead(file, seek, indexBytes)) {
+		LOG_ERROR("Index data in \"{}\" is invalid or runs past the end of the file", binPath.string());
+		return _LoadPositionsFromObjFallback(binPath.string(), outPositions, outIndices);
+	}
+	outIndices.resize(header.NumIndices);
+	for (uint32_t ix = 0; ix < header.NumIndices; ix++) {
+		switch (header.IndicesType) {
+			case IndexType::UByte:  outIndices[ix] = seek[ix]; break;
+			case IndexType::UShort: { uint16_t value; memcpy(&value, seek + ix * 2, 2); outIndices[ix] = value; break; }
+			case IndexType::UInt:   memcpy(&outIndices[ix], seek + ix * 4, 4); break;
+			default:                outIndices[ix] = 0; break;
+		}
+	}
+	seek += indexBytes;
+
+	if (!_CanRead(file, seek, header.VertexStride * (size_t)header.NumVertices)) {
+		LOG_ERROR("Vertex data in \"{}\" runs past the end of the file", binPath.string());
+		outIndices.clear();
+		return _LoadPositionsFromObjFallback(binPath.string(), outPositions, outIndices);
+	}
+	outPositions.resize(header.NumVertices);
+	for (uint32_t ix = 0; ix < header.NumVertices; ix++) {
+		memcpy(&outPositions[ix], seek + ix * header.VertexStride + positionOffset, sizeof(glm::vec3));
+	}
+
+	// Non indexed meshes are just sequential triangles
+	if (outIndices.empty()) {
+		outIndices.resize(outPositions.size() - (outPositions.size() % 3));
+		for (uint32_t ix = 0; ix < outIndices.size(); ix++) {
+			outIndices[ix] = ix;
+		}
+	}
+
+	return true;
+}
+
 void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
 	// Load in the input file
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(inFile);
@@ -73,14 +172,14 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 }
 
 MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	// Open our file, this may come from disk or a mounted asset pack
+	std::unique_ptr<std::istream> stream = VirtualFileSystem::OpenStream(filename);
 
 	// If our file fails to open, we will throw an error
-	if (!file) {
+	if (stream == nullptr) {
 		throw std::runtime_error("Failed to open file");
 	}
+	std::istream& file = *stream;
 
 	// Could also take this in as a parameter
 	glm::vec4 color = glm::vec4(1.0f);
@@ -235,50 +334,45 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 
 VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
 
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
+	// Open the file, if it's in a mounted asset pack this is a view straight into the mapped pack
+	FileView file = VirtualFileSystem::Open(filename);
 	// If our file fails to open, we will throw an error
 	if (!file) { throw std::runtime_error("Failed to open file"); }
 
 	float startTime = glfwGetTime();
 
 	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	size_t size = file.GetSize();
+	const uint8_t* seek = file.GetData();
 
 	// Read the header from the file
 	BinaryHeader header = BinaryHeader();
-	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+	if (_CanRead(file, seek, sizeof(BinaryHeader))) {
+		memcpy(&header, seek, sizeof(BinaryHeader));
+		seek += sizeof(BinaryHeader);
 	} else {
 		LOG_ERROR("Not enough data in the file!");
-		return nullptr;
+		return _LoadFromObjFallback(filename);
 	}
 
-	// TODO: validate header
-
 	// Handle our version
 	if (header.Version == 0x01) {
-		// Determine how many bytes we need in the file
-		size_t requiredBytes =
-			sizeof(BinaryHeader) +
-			(header.NumAttributes * sizeof(BufferAttribute)) +
-			(header.VertexStride * (size_t)header.NumVertices) +
-			(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-
-		// Make sure there's enough data in the file
-		if (size < requiredBytes) {
-			LOG_ERROR("Not enough data in the file!");
-			return nullptr;
-		}
+		// Every block is checked against what is left in the view before we touch it, a truncated
+		// cache file or pack entry should never have us reading past the end of the mapping
+		const size_t attribBytes = header.NumAttributes * sizeof(BufferAttribute);
+		const size_t indexSize   = GetIndexTypeSize(header.IndicesType);
+		const size_t indexBytes  = header.NumIndices * indexSize;
+		const size_t vertexBytes = header.VertexStride * (size_t)header.NumVertices;
 
 		// Read all attributes from the file, this is basically our VDECL
+		if (!_CanRead(file, seek, attribBytes)) {
+			LOG_ERROR("Attribute table in \"{}\" runs past the end of the file", filename);
+			return _LoadFromObjFallback(filename);
+		}
 		std::vector<BufferAttribute> vertexDeclaration;
 		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
-		}
+		memcpy(vertexDeclaration.data(), seek, attribBytes);
+		seek += attribBytes;
 
 		// These will have the buffer pointers
 		IndexBuffer::Sptr indices = nullptr;
@@ -286,28 +380,23 @@ VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string&
 
 		// If we have index data, load it
 		if (header.NumIndices > 0) {
-			// Create index buffer
+			if (indexSize == 0 || !_CanRead(file, seek, indexBytes)) {
+				LOG_ERROR("Index data in \"{}\" is invalid or runs past the end of the file", filename);
+				return _LoadFromObjFallback(filename);
+			}
+			// Create index buffer and upload directly from the file data, no need for a CPU copy
 			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
-
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+			indices->LoadData(seek, indexSize, header.NumIndices, header.IndicesType);
+			seek += indexBytes;
 		}
 
-		// Create a new VBO
+		// Create a new VBO and upload directly from the file data
+		if (header.VertexStride == 0 || !_CanRead(file, seek, vertexBytes)) {
+			LOG_ERROR("Vertex data in \"{}\" is invalid or runs past the end of the file", filename);
+			return _LoadFromObjFallback(filename);
+		}
 		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
-
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
-
-		// Load data into OpenGL and free the CPU copy
-		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
+		vertices->LoadData(seek, header.VertexStride, header.NumVertices);
 
 		// Create the VAO and attach our index and vertex buffers
 		VertexArrayObject::Sptr result = VertexArrayObject::Create();
@@ -324,5 +413,62 @@ VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string&
 		return result;
 	}
 
-	return nullptr;
+	return _LoadFromObjFallback(filename);
+}
+
+bool OptimizedObjLoader::_CanRead(const FileView& file, const uint8_t* seek, size_t bytes) {
+	const size_t offset = static_cast<size_t>(seek - file.GetData());
+	return offset <= file.GetSize() && bytes <= file.GetSize() - offset;
+}
+
+MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_RebuildFromObj(const std::string& binFilename) {
+	// Binary files sit next to the OBJ they were converted from
+	fs::path objPath = fs::path(binFilename).replace_extension(".obj");
+	if (!VirtualFileSystem::Exists(objPath.string())) {
+		LOG_ERROR("Binary mesh \"{}\" is corrupt and there is no OBJ to rebuild it from", binFilename);
+		return nullptr;
+	}
+
+	LOG_WARN("Binary mesh \"{}\" is corrupt, rebuilding it from \"{}\"", binFilename, objPath.string());
+	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(objPath.string());
+
+	// Overwrite the bad cache file so the next run takes the fast path again
+	SaveBinaryFile(*mesh, binFilename);
+	return mesh;
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromObjFallback(const std::string& binFilename) {
+	MeshBuilder<VertexPosNormTexColTangents>* mesh = _RebuildFromObj(binFilename);
+	if (mesh == nullptr) {
+		return nullptr;
+	}
+
+	VertexArrayObject::Sptr result = mesh->Bake();
+	delete mesh;
+	return result;
+}
+
+bool OptimizedObjLoader::_LoadPositionsFromObjFallback(const std::string& binFilename, std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices) {
+	MeshBuilder<VertexPosNormTexColTangents>* mesh = _RebuildFromObj(binFilename);
+	if (mesh == nullptr) {
+		return false;
+	}
+
+	const VertexPosNormTexColTangents* verts = mesh->GetVertexDataPtr();
+	outPositions.resize(mesh->GetVertexCount());
+	for (size_t ix = 0; ix < outPositions.size(); ix++) {
+		outPositions[ix] = verts[ix].Position;
+	}
+	outIndices.assign(mesh->GetIndexDataPtr(), mesh->GetIndexDataPtr() + mesh->GetIndexCount());
+
+	// Non indexed meshes are just sequential triangles
+	if (outIndices.empty()) {
+		outIndices.resize(outPositions.size() - (outPositions.size() % 3));
+		for (uint32_t ix = 0; ix < outIndices.size(); ix++) {
+			outIndices[ix] = ix;
+		}
+	}
+
+	delete mesh;
+	return true;
 }
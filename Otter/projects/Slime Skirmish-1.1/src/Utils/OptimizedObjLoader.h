@@ -12,6 +12,7 @@
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/VirtualFileSystem.h"
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -42,6 +43,17 @@ public:
 	template <typename VertexType>
 	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
 
+	/// <summary>
+	/// Reads only the positions and triangle indices from a binary mesh file into CPU memory,
+	/// for tools that need the geometry but not a VAO (for instance collision cooking).
+	/// OBJ files are converted to binary first, same as LoadFromFile
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="outPositions">Will be filled with the vertex positions</param>
+	/// <param name="outIndices">Will be filled with the triangle list indices, generated if the mesh is not indexed</param>
+	/// <returns>True if the positions were loaded</returns>
+	static bool LoadPositions(const std::string& filename, std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices);
+
 protected:
 	// Will be put at the start of the binary file, contains info about the contents of the file
 	struct BinaryHeader {
@@ -66,6 +78,13 @@ protected:
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
 	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+
+	// True if there are at least bytes left in the file view past seek
+	static bool _CanRead(const FileView& file, const uint8_t* seek, size_t bytes);
+	// Reloads the OBJ next to a corrupt binary file and rewrites the binary, or nullptr if there is no OBJ
+	static MeshBuilder<VertexPosNormTexColTangents>* _RebuildFromObj(const std::string& binFilename);
+	static VertexArrayObject::Sptr _LoadFromObjFallback(const std::string& binFilename);
+	static bool _LoadPositionsFromObjFallback(const std::string& binFilename, std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices);
 };
 
 template <typename VertexType>
@@ -0,0 +1,202 @@
+#include "Utils/TangentGenerator.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include "Utils/ThreadPool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TANGENT_GENERATOR_SSE
+#include <immintrin.h>
+#endif
+
+// Below this many items it's not worth waking up the thread pool
+#define PARALLEL_GRAIN_SIZE 4096
+// UV determinants smaller than this are treated as degenerate
+#define DETERMINANT_EPSILON 1e-12f
+
+// The per-face results, stored as SoA so the SIMD kernel can write full lanes
+struct FaceTangents {
+	std::vector<float> TX, TY, TZ;
+	std::vector<float> BX, BY, BZ;
+
+	void Resize(size_t count) {
+		TX.resize(count); TY.resize(count); TZ.resize(count);
+		BX.resize(count); BY.resize(count); BZ.resize(count);
+	}
+};
+
+/// <summary>
+/// Calculates the unnormalized tangent and bitangent for a single face. Leaving them
+/// unnormalized means larger faces contribute more to the shared vertices
+/// </summary>
+static void ComputeFaceScalar(size_t face, StridedView<glm::vec3> positions, StridedView<glm::vec2> uvs, const uint32_t* indices, FaceTangents& out) {
+	const uint32_t i0 = indices[face * 3 + 0], i1 = indices[face * 3 + 1], i2 = indices[face * 3 + 2];
+
+	// https://learnopengl.com/Advanced-Lighting/Normal-Mapping
+	const glm::vec3 deltaP1 = positions[i1] - positions[i0];
+	const glm::vec3 deltaP2 = positions[i2] - positions[i0];
+	const glm::vec2 deltaT1 = uvs[i1] - uvs[i0];
+	const glm::vec2 deltaT2 = uvs[i2] - uvs[i0];
+
+	const float det = deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x;
+	const float r = std::abs(det) > DETERMINANT_EPSILON ? 1.0f / det : 0.0f;
+
+	const glm::vec3 tangent   = (deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r;
+	const glm::vec3 bitangent = (deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r;
+
+	out.TX[face] = tangent.x;   out.TY[face] = tangent.y;   out.TZ[face] = tangent.z;
+	out.BX[face] = bitangent.x; out.BY[face] = bitangent.y; out.BZ[face] = bitangent.z;
+}
+
+#ifdef TANGENT_GENERATOR_SSE
+/// <summary>
+/// Calculates face tangents for 4 faces at once, faces [first, first + 4) must be valid
+/// </summary>
+static void ComputeFacesSse(size_t first, StridedView<glm::vec3> positions, StridedView<glm::vec2> uvs, const uint32_t* indices, FaceTangents& out) {
+	// Gather the vertex data for our 4 faces into SoA lanes
+	alignas(16) float p[3][3][4]; // [corner][axis][lane]
+	alignas(16) float t[3][2][4]; // [corner][axis][lane]
+	for (int lane = 0; lane < 4; lane++) {
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t index = indices[(first + lane) * 3 + corner];
+			const glm::vec3& pos = positions[index];
+			const glm::vec2& uv = uvs[index];
+			p[corner][0][lane] = pos.x; p[corner][1][lane] = pos.y; p[corner][2][lane] = pos.z;
+			t[corner][0][lane] = uv.x;  t[corner][1][lane] = uv.y;
+		}
+	}
+
+	const __m128 p0x = _mm_load_ps(p[0][0]), p0y = _mm_load_ps(p[0][1]), p0z = _mm_load_ps(p[0][2]);
+	const __m128 e1x = _mm_sub_ps(_mm_load_ps(p[1][0]), p0x);
+	const __m128 e1y = _mm_sub_ps(_mm_load_ps(p[1][1]), p0y);
+	const __m128 e1z = _mm_sub_ps(_mm_load_ps(p[1][2]), p0z);
+	const __m128 e2x = _mm_sub_ps(_mm_load_ps(p[2][0]), p0x);
+	const __m128 e2y = _mm_sub_ps(_mm_load_ps(p[2][1]), p0y);
+	const __m128 e2z = _mm_sub_ps(_mm_load_ps(p[2][2]), p0z);
+
+	const __m128 t0u = _mm_load_ps(t[0][0]), t0v = _mm_load_ps(t[0][1]);
+	const __m128 du1 = _mm_sub_ps(_mm_load_ps(t[1][0]), t0u);
+	const __m128 dv1 = _mm_sub_ps(_mm_load_ps(t[1][1]), t0v);
+	const __m128 du2 = _mm_sub_ps(_mm_load_ps(t[2][0]), t0u);
+	const __m128 dv2 = _mm_sub_ps(_mm_load_ps(t[2][1]), t0v);
+
+	// r = 1 / det, or 0 for faces with degenerate UVs
+	const __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(dv1, du2));
+	const __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+	const __m128 valid = _mm_cmpgt_ps(absDet, _mm_set1_ps(DETERMINANT_EPSILON));
+	const __m128 r = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), det), valid);
+
+	// tangent = (e1 * dv2 - e2 * dv1) * r
+	_mm_storeu_ps(&out.TX[first], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1x, dv2), _mm_mul_ps(e2x, dv1)), r));
+	_mm_storeu_ps(&out.TY[first], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1y, dv2), _mm_mul_ps(e2y, dv1)), r));
+	_mm_storeu_ps(&out.TZ[first], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1z, dv2), _mm_mul_ps(e2z, dv1)), r));
+	// bitangent = (e2 * du1 - e1 * du2) * r
+	_mm_storeu_ps(&out.BX[first], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2x, du1), _mm_mul_ps(e1x, du2)), r));
+	_mm_storeu_ps(&out.BY[first], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2y, du1), _mm_mul_ps(e1y, du2)), r));
+	_mm_storeu_ps(&out.BZ[first], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2z, du1), _mm_mul_ps(e1z, du2)), r));
+}
+#endif
+
+bool TangentGenerator::IsSimdSupported() {
+	#ifdef TANGENT_GENERATOR_SSE
+	return true;
+	#else
+	return false;
+	#endif
+}
+
+void TangentGenerator::Generate(
+	StridedView<glm::vec3> positions,
+	StridedView<glm::vec3> normals,
+	StridedView<glm::vec2> uvs,
+	size_t numVertices,
+	const uint32_t* indices,
+	size_t numIndices,
+	StridedView<glm::vec3> outTangents,
+	StridedView<glm::vec3> outBiTangents,
+	const Options& options)
+{
+	const size_t numFaces = numIndices / 3;
+	if (numFaces == 0 || numVertices == 0) {
+		return;
+	}
+
+	auto parallelFor = [&](size_t count, const std::function<void(size_t, size_t)>& body) {
+		if (options.MultiThreaded) {
+			ThreadPool::ParallelFor(count, PARALLEL_GRAIN_SIZE, body);
+		} else {
+			body(0, count);
+		}
+	};
+
+	// Pass 1: face tangents, these are independent so we can split them however we like
+	FaceTangents faces;
+	faces.Resize(numFaces);
+	parallelFor(numFaces, [&](size_t begin, size_t end) {
+		size_t face = begin;
+		#ifdef TANGENT_GENERATOR_SSE
+		if (options.UseSimd) {
+			for (; face + 4 <= end; face += 4) {
+				ComputeFacesSse(face, positions, uvs, indices, faces);
+			}
+		}
+		#endif
+		for (; face < end; face++) {
+			ComputeFaceScalar(face, positions, uvs, indices, faces);
+		}
+	});
+
+	// Build a vertex -> face adjacency list (CSR layout), so that each vertex can gather its
+	// faces without multiple threads writing to the same vertex
+	std::vector<uint32_t> faceOffsets(numVertices + 1, 0);
+	for (size_t ix = 0; ix < numFaces * 3; ix++) {
+		faceOffsets[indices[ix] + 1]++;
+	}
+	for (size_t ix = 0; ix < numVertices; ix++) {
+		faceOffsets[ix + 1] += faceOffsets[ix];
+	}
+	std::vector<uint32_t> adjacentFaces(numFaces * 3);
+	{
+		std::vector<uint32_t> cursor(faceOffsets.begin(), faceOffsets.end() - 1);
+		for (size_t ix = 0; ix < numFaces * 3; ix++) {
+			adjacentFaces[cursor[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+	}
+
+	// Pass 2: accumulate and orthonormalize per vertex
+	parallelFor(numVertices, [&](size_t begin, size_t end) {
+		for (size_t vert = begin; vert < end; vert++) {
+			glm::vec3 tangent = glm::vec3(0.0f), bitangent = glm::vec3(0.0f);
+			for (uint32_t ix = faceOffsets[vert]; ix < faceOffsets[vert + 1]; ix++) {
+				const uint32_t face = adjacentFaces[ix];
+				tangent   += glm::vec3(faces.TX[face], faces.TY[face], faces.TZ[face]);
+				bitangent += glm::vec3(faces.BX[face], faces.BY[face], faces.BZ[face]);
+			}
+
+			const glm::vec3 normal = normals.IsValid() ? normals[vert] : glm::vec3(0.0f);
+			const float normalLen2 = glm::dot(normal, normal);
+
+			if (normalLen2 > 0.0f) {
+				const glm::vec3 n = normal / std::sqrt(normalLen2);
+				// Gram-Schmidt, remove the normal component from the tangent
+				tangent = tangent - n * glm::dot(n, tangent);
+				if (glm::dot(tangent, tangent) < 1e-20f) {
+					// No usable UV gradient, pick any vector perpendicular to the normal
+					tangent = std::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1, 0, 0)) : glm::cross(n, glm::vec3(0, 1, 0));
+				}
+				tangent = glm::normalize(tangent);
+				// The bitangent is fully determined by N and T, we only need the handedness
+				const glm::vec3 ortho = glm::cross(n, tangent);
+				bitangent = glm::dot(ortho, bitangent) < 0.0f ? -ortho : ortho;
+			} else {
+				tangent   = glm::dot(tangent, tangent) > 0.0f ? glm::normalize(tangent) : tangent;
+				bitangent = glm::dot(bitangent, bitangent) > 0.0f ? glm::normalize(bitangent) : bitangent;
+			}
+
+			if (outTangents.IsValid())   { outTangents[vert] = tangent; }
+			if (outBiTangents.IsValid()) { outBiTangents[vert] = bitangent; }
+		}
+	});
+}
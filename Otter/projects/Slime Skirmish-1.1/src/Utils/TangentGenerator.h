@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// A view over one attribute of an array of interleaved vertices, allowing the
+/// tangent generator to read and write vertex data in place without knowing the vertex type
+/// </summary>
+template <typename T>
+struct StridedView {
+	uint8_t* Base   = nullptr;
+	size_t   Stride = sizeof(T);
+
+	StridedView() = default;
+	StridedView(T* first, size_t stride) : Base(reinterpret_cast<uint8_t*>(first)), Stride(stride) {}
+
+	inline T& operator[](size_t index) const { return *reinterpret_cast<T*>(Base + index * Stride); }
+	inline bool IsValid() const { return Base != nullptr; }
+};
+
+/// <summary>
+/// Options for controlling how TangentGenerator splits up its work
+/// </summary>
+struct TangentGeneratorOptions {
+	// True to split the work across the thread pool
+	bool MultiThreaded = true;
+	// True to use the SIMD face kernel if the platform supports it
+	bool UseSimd = true;
+};
+
+/// <summary>
+/// Generates per-vertex tangents and bitangents for indexed triangle meshes.
+/// Face tangents are calculated 4 triangles at a time using SSE where available, then each
+/// vertex gathers the faces that touch it via an adjacency list, so both passes can be split
+/// across the thread pool without any atomics. Results are orthonormalized against the vertex
+/// normal (Gram-Schmidt) when normals are provided.
+///
+/// Use MeshFactory::CalculateTBN for MeshBuilders, this is the type-erased kernel behind it
+/// </summary>
+class TangentGenerator {
+public:
+	TangentGenerator() = delete;
+
+	typedef TangentGeneratorOptions Options;
+
+	/// <summary>
+	/// Generates tangents and bitangents for a mesh
+	/// </summary>
+	/// <param name="positions">The vertex positions</param>
+	/// <param name="normals">The vertex normals, may be an invalid view if the vertex has no normal</param>
+	/// <param name="uvs">The vertex texture coordinates</param>
+	/// <param name="numVertices">The number of vertices in the mesh</param>
+	/// <param name="indices">The triangle list indices for the mesh</param>
+	/// <param name="numIndices">The number of indices, should be a multiple of 3</param>
+	/// <param name="outTangents">The location to store tangents, may be invalid to skip</param>
+	/// <param name="outBiTangents">The location to store bitangents, may be invalid to skip</param>
+	/// <param name="options">Controls threading and SIMD use</param>
+	static void Generate(
+		StridedView<glm::vec3> positions,
+		StridedView<glm::vec3> normals,
+		StridedView<glm::vec2> uvs,
+		size_t numVertices,
+		const uint32_t* indices,
+		size_t numIndices,
+		StridedView<glm::vec3> outTangents,
+		StridedView<glm::vec3> outBiTangents,
+		const Options& options = Options());
+
+	/// <summary>
+	/// Returns true if this build was compiled with the SIMD face kernel
+	/// </summary>
+	static bool IsSimdSupported();
+};
@@ -0,0 +1,144 @@
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include "Logging.h"
+
+std::vector<std::thread>          ThreadPool::_workers;
+std::deque<std::function<void()>> ThreadPool::_queue;
+std::mutex                        ThreadPool::_queueMutex;
+std::condition_variable           ThreadPool::_queueSignal;
+bool                              ThreadPool::_isRunning = false;
+std::once_flag                    ThreadPool::_lazyInit;
+
+// Set on worker threads so we can detect nested parallel work
+static thread_local bool IsPoolWorker = false;
+
+void ThreadPool::Init(uint32_t numWorkers) {
+	Shutdown();
+
+	if (numWorkers == 0) {
+		// Leave the main thread a core to itself. hardware_concurrency can return 0 if it
+		// doesn't know, so clamp before subtracting
+		numWorkers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_queueMutex);
+		_isRunning = true;
+	}
+	_workers.reserve(numWorkers);
+	for (uint32_t ix = 0; ix < numWorkers; ix++) {
+		_workers.emplace_back(&ThreadPool::_WorkerMain);
+	}
+	LOG_INFO("Started thread pool with {} workers", numWorkers);
+}
+
+void ThreadPool::Shutdown() {
+	if (_workers.empty()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_queueMutex);
+		_isRunning = false;
+	}
+	_queueSignal.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+}
+
+uint32_t ThreadPool::GetWorkerCount() {
+	_EnsureStarted();
+	return static_cast<uint32_t>(_workers.size());
+}
+
+bool ThreadPool::IsWorkerThread() {
+	return IsPoolWorker;
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+	if (count == 0) {
+		return;
+	}
+	grainSize = std::max<size_t>(grainSize, 1);
+
+	// Small workloads, or nested calls from a worker, just run inline
+	const size_t maxChunks = (size_t)GetWorkerCount() + 1;
+	const size_t numChunks = std::min((count + grainSize - 1) / grainSize, maxChunks);
+	if (numChunks <= 1 || IsPoolWorker) {
+		body(0, count);
+		return;
+	}
+
+	// Workers pull chunk indices off a shared counter, so faster threads pick up more work
+	struct Context {
+		std::atomic<size_t>     NextChunk{ 0 };
+		std::atomic<size_t>     Remaining;
+		std::mutex              DoneMutex;
+		std::condition_variable DoneSignal;
+	};
+	auto context = std::make_shared<Context>();
+	context->Remaining = numChunks;
+
+	const size_t chunkSize = (count + numChunks - 1) / numChunks;
+	auto runChunks = [context, chunkSize, count, numChunks, &body]() {
+		for (size_t chunk = context->NextChunk++; chunk < numChunks; chunk = context->NextChunk++) {
+			const size_t begin = chunk * chunkSize;
+			const size_t end = std::min(begin + chunkSize, count);
+			if (begin < end) {
+				body(begin, end);
+			}
+			if (--context->Remaining == 0) {
+				std::lock_guard<std::mutex> lock(context->DoneMutex);
+				context->DoneSignal.notify_all();
+			}
+		}
+	};
+
+	for (size_t ix = 1; ix < numChunks; ix++) {
+		_Enqueue(runChunks);
+	}
+	runChunks();
+
+	// Every chunk has been claimed once runChunks returns, so all that's left is waiting for the
+	// workers to finish theirs. We don't pick up other queued work here, a long Submit job
+	// (ex: a flow field build) would stall the caller well past the end of this loop
+	std::unique_lock<std::mutex> lock(context->DoneMutex);
+	context->DoneSignal.wait(lock, [&]() { return context->Remaining == 0; });
+}
+
+void ThreadPool::_EnsureStarted() {
+	// Two threads can hit this at the same time on first use, only one of them may start the pool
+	std::call_once(_lazyInit, []() {
+		if (_workers.empty()) {
+			Init();
+		}
+	});
+}
+
+void ThreadPool::_Enqueue(std::function<void()>&& task) {
+	_EnsureStarted();
+	{
+		std::lock_guard<std::mutex> lock(_queueMutex);
+		_queue.push_back(std::move(task));
+	}
+	_queueSignal.notify_one();
+}
+
+void ThreadPool::_WorkerMain() {
+	IsPoolWorker = true;
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_queueMutex);
+			_queueSignal.wait(lock, []() { return !_isRunning || !_queue.empty(); });
+			// Drain any remaining work before shutting down
+			if (_queue.empty()) {
+				return;
+			}
+			task = std::move(_queue.front());
+			_queue.pop_front();
+		}
+		task();
+	}
+}
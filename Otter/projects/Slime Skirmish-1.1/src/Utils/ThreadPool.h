@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+/// <summary>
+/// A fixed size pool of worker threads shared by the whole engine. Work can be
+/// submitted as individual tasks (with a future for the result), or split across
+/// the workers with ParallelFor. The pool is created lazily on first use, but
+/// Init should be called at startup to control the number of workers. Init and
+/// Shutdown are not thread safe, call them from the main thread while no other
+/// threads are using the pool
+/// </summary>
+class ThreadPool {
+public:
+	ThreadPool() = delete;
+
+	/// <summary>
+	/// Starts the worker threads. If the pool is already running, it will be restarted
+	/// </summary>
+	/// <param name="numWorkers">The number of workers to start, or 0 to use one less than the hardware thread count</param>
+	static void Init(uint32_t numWorkers = 0);
+	/// <summary>
+	/// Waits for all queued work to finish, then stops the worker threads
+	/// </summary>
+	static void Shutdown();
+
+	/// <summary>
+	/// Gets the number of worker threads in the pool (not including the calling thread)
+	/// </summary>
+	static uint32_t GetWorkerCount();
+	/// <summary>
+	/// Returns true if the calling thread is one of the pool's workers
+	/// </summary>
+	static bool IsWorkerThread();
+
+	/// <summary>
+	/// Queues a task to run on a worker thread
+	/// </summary>
+	/// <param name="task">The callable to invoke</param>
+	/// <returns>A future that will contain the result of the task</returns>
+	template <typename Func>
+	static std::future<std::invoke_result_t<Func>> Submit(Func&& task) {
+		typedef std::invoke_result_t<Func> Result;
+		auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(task));
+		std::future<Result> result = packaged->get_future();
+		_Enqueue([packaged]() { (*packaged)(); });
+		return result;
+	}
+
+	/// <summary>
+	/// Splits the range [0, count) into chunks of at least grainSize, and invokes
+	/// body(begin, end) for each chunk across the workers. The calling thread helps
+	/// out with this loop's chunks (but no other queued work), and this will not return
+	/// until all chunks are complete. Calls from a worker
+	/// thread run inline, so nested parallel loops cannot deadlock
+	/// </summary>
+	/// <param name="count">The number of items to process</param>
+	/// <param name="grainSize">The minimum number of items per chunk</param>
+	/// <param name="body">The function to invoke per chunk, as body(size_t begin, size_t end)</param>
+	static void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+private:
+	static void _Enqueue(std::function<void()>&& task);
+	static void _EnsureStarted();
+	static void _WorkerMain();
+
+	static std::vector<std::thread>          _workers;
+	static std::deque<std::function<void()>> _queue;
+	static std::mutex                        _queueMutex;
+	static std::condition_variable           _queueSignal;
+	static bool                              _isRunning;
+	static std::once_flag                    _lazyInit;
+};
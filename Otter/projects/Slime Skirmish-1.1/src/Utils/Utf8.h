@@ -0,0 +1,132 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+/// <summary>
+/// Helpers for reading and writing UTF-8 without going through std::wstring_convert.
+/// Decoding works directly on the string's bytes and never allocates
+/// </summary>
+class Utf8 {
+public:
+	Utf8() = delete;
+
+	// Stands in for any byte sequence that isn't valid UTF-8
+	static constexpr uint32_t REPLACEMENT_CHAR = 0xFFFD;
+
+	/// <summary>
+	/// Decodes the codepoint starting at index, and moves index past it. Invalid
+	/// sequences decode to REPLACEMENT_CHAR and skip a single byte
+	/// </summary>
+	/// <param name="text">The UTF-8 string to decode from</param>
+	/// <param name="index">The byte offset of the codepoint, must be less than text.size()</param>
+	static inline uint32_t Next(std::string_view text, size_t& index) {
+		const uint8_t lead = (uint8_t)text[index];
+
+		// ASCII is the common case, so get it out of the way first
+		if (lead < 0x80) {
+			index++;
+			return lead;
+		}
+
+		// Work out the length of the sequence, and the bits the lead byte holds
+		size_t length;
+		uint32_t result;
+		uint32_t minimum;
+		if ((lead & 0xE0) == 0xC0) {
+			length = 2; result = lead & 0x1F; minimum = 0x80;
+		} else if ((lead & 0xF0) == 0xE0) {
+			length = 3; result = lead & 0x0F; minimum = 0x800;
+		} else if ((lead & 0xF8) == 0xF0) {
+			length = 4; result = lead & 0x07; minimum = 0x10000;
+		} else {
+			index++;
+			return REPLACEMENT_CHAR;
+		}
+
+		if (index + length > text.size()) {
+			index++;
+			return REPLACEMENT_CHAR;
+		}
+		for (size_t ix = 1; ix < length; ix++) {
+			const uint8_t next = (uint8_t)text[index + ix];
+			if ((next & 0xC0) != 0x80) {
+				index++;
+				return REPLACEMENT_CHAR;
+			}
+			result = (result << 6) | (next & 0x3F);
+		}
+
+		// Overlong encodings, UTF-16 surrogates and anything past the end of unicode aren't allowed
+		if (result < minimum || result > 0x10FFFF || (result >= 0xD800 && result <= 0xDFFF)) {
+			index++;
+			return REPLACEMENT_CHAR;
+		}
+
+		index += length;
+		return result;
+	}
+
+	/// <summary>
+	/// Appends the UTF-8 encoding of a codepoint to a string
+	/// </summary>
+	static inline void Append(std::string& result, uint32_t codePoint) {
+		if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+			codePoint = REPLACEMENT_CHAR;
+		}
+
+		if (codePoint < 0x80) {
+			result.push_back((char)codePoint);
+		} else if (codePoint < 0x800) {
+			result.push_back((char)(0xC0 | (codePoint >> 6)));
+			result.push_back((char)(0x80 | (codePoint & 0x3F)));
+		} else if (codePoint < 0x10000) {
+			result.push_back((char)(0xE0 | (codePoint >> 12)));
+			result.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back((char)(0x80 | (codePoint & 0x3F)));
+		} else {
+			result.push_back((char)(0xF0 | (codePoint >> 18)));
+			result.push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+			result.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back((char)(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	/// <summary>
+	/// Appends a wide string to a UTF-8 string. On platforms where wchar_t is 16 bits
+	/// (Windows), the wide string is treated as UTF-16
+	/// </summary>
+	static inline void Append(std::string& result, std::wstring_view text) {
+		for (size_t ix = 0; ix < text.size(); ix++) {
+			uint32_t codePoint = (uint32_t)text[ix];
+
+			// Join surrogate pairs back into a single codepoint
+			if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint <= 0xDBFF && ix + 1 < text.size()) {
+				uint32_t low = (uint32_t)text[ix + 1];
+				if (low >= 0xDC00 && low <= 0xDFFF) {
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					ix++;
+				}
+			}
+			Append(result, codePoint);
+		}
+	}
+
+	/// <summary>
+	/// Appends a UTF-8 string to a wide string, splitting codepoints into surrogate
+	/// pairs if wchar_t is 16 bits
+	/// </summary>
+	static inline void AppendWide(std::wstring& result, std::string_view text) {
+		size_t index = 0;
+		while (index < text.size()) {
+			uint32_t codePoint = Next(text, index);
+			if (sizeof(wchar_t) == 2 && codePoint >= 0x10000) {
+				codePoint -= 0x10000;
+				result.push_back((wchar_t)(0xD800 + (codePoint >> 10)));
+				result.push_back((wchar_t)(0xDC00 + (codePoint & 0x3FF)));
+			} else {
+				result.push_back((wchar_t)codePoint);
+			}
+		}
+	}
+};
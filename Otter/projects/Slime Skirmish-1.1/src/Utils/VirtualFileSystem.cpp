@@ -0,0 +1,164 @@
+#include "Utils/VirtualFileSystem.h"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#include "Logging.h"
+
+std::vector<AssetPack::Sptr> VirtualFileSystem::_packs;
+bool VirtualFileSystem::PreferLooseFiles = false;
+
+// Finds the newest mounted pack containing the given file
+static const AssetPack::PackEntry* FindPacked(const std::vector<AssetPack::Sptr>& packs, const std::string& filename, AssetPack::Sptr* outPack = nullptr) {
+	if (packs.empty()) {
+		return nullptr;
+	}
+	const std::string normalized = AssetPack::NormalizePath(filename);
+	for (auto it = packs.rbegin(); it != packs.rend(); it++) {
+		const AssetPack::PackEntry* entry = (*it)->Find(normalized);
+		if (entry != nullptr) {
+			if (outPack != nullptr) {
+				*outPack = *it;
+			}
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+// Reads a loose file from disk into an owning view
+static FileView ReadLooseFile(const std::string& filename) {
+	std::ifstream in(filename, std::ios::in | std::ios::binary);
+	if (!in) {
+		return FileView();
+	}
+
+	in.seekg(0, std::ios::end);
+	std::streamoff size = in.tellg();
+	if (size < 0) {
+		LOG_ERROR("Could not read from file '{}'", filename);
+		return FileView();
+	}
+
+	std::string contents;
+	contents.resize(static_cast<size_t>(size));
+	in.seekg(0, std::ios::beg);
+	in.read(&contents[0], size);
+	return FileView(std::move(contents));
+}
+
+#pragma region FileViewStream
+
+FileViewStreamBuf::FileViewStreamBuf(const FileView& view) :
+	std::streambuf(),
+	_view(view)
+{
+	// The get area is the whole file, we never modify it
+	char* begin = const_cast<char*>(_view.GetChars());
+	setg(begin, begin, begin + _view.GetSize());
+}
+
+FileViewStreamBuf::pos_type FileViewStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	if (!(which & std::ios_base::in)) {
+		return pos_type(off_type(-1));
+	}
+
+	off_type target = off;
+	if (dir == std::ios_base::cur) {
+		target += gptr() - eback();
+	} else if (dir == std::ios_base::end) {
+		target += egptr() - eback();
+	}
+
+	if (target < 0 || target > egptr() - eback()) {
+		return pos_type(off_type(-1));
+	}
+	setg(eback(), eback() + target, egptr());
+	return pos_type(target);
+}
+
+FileViewStreamBuf::pos_type FileViewStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+FileViewStream::FileViewStream(const FileView& view) :
+	std::istream(nullptr),
+	_buffer(view)
+{
+	rdbuf(&_buffer);
+}
+
+#pragma endregion
+
+bool VirtualFileSystem::Mount(const std::string& packFile) {
+	AssetPack::Sptr pack = AssetPack::Load(packFile);
+	if (pack == nullptr) {
+		return false;
+	}
+	Unmount(packFile);
+	_packs.push_back(pack);
+	return true;
+}
+
+void VirtualFileSystem::Unmount(const std::string& packFile) {
+	_packs.erase(std::remove_if(_packs.begin(), _packs.end(), [&](const AssetPack::Sptr& pack) {
+		return pack->GetFilename() == packFile;
+	}), _packs.end());
+}
+
+void VirtualFileSystem::UnmountAll() {
+	_packs.clear();
+}
+
+bool VirtualFileSystem::Exists(const std::string& filename) {
+	return IsPacked(filename) || std::filesystem::exists(filename);
+}
+
+bool VirtualFileSystem::IsPacked(const std::string& filename) {
+	return FindPacked(_packs, filename) != nullptr;
+}
+
+uint64_t VirtualFileSystem::GetFileSize(const std::string& filename) {
+	// Same lookup order as Open, so the size matches what we'd read
+	const AssetPack::PackEntry* entry = PreferLooseFiles ? nullptr : FindPacked(_packs, filename);
+	if (entry != nullptr) {
+		return entry->Size;
+	}
+
+	std::error_code error;
+	uintmax_t size = std::filesystem::file_size(filename, error);
+	if (!error) {
+		return static_cast<uint64_t>(size);
+	}
+
+	entry = PreferLooseFiles ? FindPacked(_packs, filename) : nullptr;
+	return entry != nullptr ? entry->Size : 0;
+}
+
+FileView VirtualFileSystem::Open(const std::string& filename) {
+	// The pack is cooked from the same tree that ships beside it, so look there first and only
+	// touch the disk for files that weren't packed (saved scenes, generated caches and the like)
+	AssetPack::Sptr pack;
+	const AssetPack::PackEntry* entry = PreferLooseFiles ? nullptr : FindPacked(_packs, filename, &pack);
+	if (entry != nullptr) {
+		return pack->Open(entry);
+	}
+
+	FileView result = ReadLooseFile(filename);
+	if (result) {
+		return result;
+	}
+
+	// During development loose files win, but packed files are still there as a fallback
+	entry = PreferLooseFiles ? FindPacked(_packs, filename, &pack) : nullptr;
+	return entry != nullptr ? pack->Open(entry) : FileView();
+}
+
+std::unique_ptr<std::istream> VirtualFileSystem::OpenStream(const std::string& filename) {
+	FileView view = Open(filename);
+	if (!view) {
+		return nullptr;
+	}
+	return std::make_unique<FileViewStream>(view);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <streambuf>
+#include <istream>
+#include <memory>
+
+#include "Utils/AssetPack.h"
+
+/// <summary>
+/// A stream buffer that reads directly out of a file view, so that stream based
+/// loaders can consume packed files without copying them into a stringstream
+/// </summary>
+class FileViewStreamBuf : public std::streambuf {
+public:
+	FileViewStreamBuf(const FileView& view);
+
+protected:
+	virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+	virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+
+private:
+	FileView _view;
+};
+
+/// <summary>
+/// An input stream over a file view, see VirtualFileSystem::OpenStream
+/// </summary>
+class FileViewStream : public std::istream {
+public:
+	FileViewStream(const FileView& view);
+
+private:
+	FileViewStreamBuf _buffer;
+};
+
+/// <summary>
+/// Layers mounted asset packs on top of the regular filesystem. All of our loaders
+/// go through here, so packed assets are picked up without the loaders knowing
+/// where the data came from. Mounted packs are searched first (newest first, so patches
+/// can be mounted over the base pack), and loose files on disk are only used for files
+/// that are not packed, unless PreferLooseFiles is set
+/// </summary>
+class VirtualFileSystem {
+public:
+	VirtualFileSystem() = delete;
+
+	/// <summary>
+	/// When true, loose files on disk override packed ones so that edits show up without
+	/// re-cooking the pack. Only meant for development, as every lookup then costs a file
+	/// open on top of the pack lookup
+	/// </summary>
+	static bool PreferLooseFiles;
+
+	/// <summary>
+	/// Mounts an asset pack
+	/// </summary>
+	/// <param name="packFile">The path to the pack to mount</param>
+	/// <returns>True if the pack was mounted</returns>
+	static bool Mount(const std::string& packFile);
+	/// <summary>
+	/// Unmounts a previously mounted pack. Any views opened from the pack remain valid
+	/// </summary>
+	/// <param name="packFile">The path that was passed to Mount</param>
+	static void Unmount(const std::string& packFile);
+	/// <summary>
+	/// Unmounts all packs
+	/// </summary>
+	static void UnmountAll();
+
+	/// <summary>
+	/// Checks whether a file exists in any mounted pack, or on disk
+	/// </summary>
+	/// <param name="filename">The path of the file to check</param>
+	static bool Exists(const std::string& filename);
+	/// <summary>
+	/// Checks whether a file exists in one of the mounted packs
+	/// </summary>
+	/// <param name="filename">The path of the file to check</param>
+	static bool IsPacked(const std::string& filename);
+	/// <summary>
+	/// Gets the uncompressed size of a file without reading it
+	/// </summary>
+	/// <param name="filename">The path of the file to check</param>
+	/// <returns>The size of the file in bytes, or 0 if it does not exist</returns>
+	static uint64_t GetFileSize(const std::string& filename);
+
+	/// <summary>
+	/// Opens a file from the mounted packs, falling back to loose files on disk. Returns an
+	/// invalid view if the file could not be found
+	/// </summary>
+	/// <param name="filename">The path of the file to open</param>
+	static FileView Open(const std::string& filename);
+	/// <summary>
+	/// Opens a file as an input stream, useful for loaders that parse text
+	/// </summary>
+	/// <param name="filename">The path of the file to open</param>
+	/// <returns>A stream over the file, or nullptr if it could not be found</returns>
+	static std::unique_ptr<std::istream> OpenStream(const std::string& filename);
+
+private:
+	static std::vector<AssetPack::Sptr> _packs;
+};
@@ -41,11 +41,20 @@
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
 #include "Utils/GlmDefines.h"
+#include "Utils/AssetPack.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Benchmarks.h"
 
 // Gameplay
 #include "Gameplay/Material.h"
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Scene.h"
+#include "Gameplay/LevelStreamer.h"
+#include "Gameplay/CrowdSystem.h"
+#include "Gameplay/FlowField.h"
+#include "Gameplay/ObjectPool.h"
+#include "Gameplay/Scheduler.h"
 
 // Components
 #include "Gameplay/Components/IComponent.h"
@@ -63,6 +72,7 @@
 #include "Gameplay/Physics/Colliders/PlaneCollider.h"
 #include "Gameplay/Physics/Colliders/SphereCollider.h"
 #include "Gameplay/Physics/Colliders/ConvexMeshCollider.h"
+#include "Gameplay/Physics/Colliders/ConcaveMeshCollider.h"
 #include "Gameplay/Physics/TriggerVolume.h"
 #include "Graphics/DebugDraw.h"
 #include "Gameplay/Components/TriggerVolumeEnterBehaviour.h"
@@ -78,6 +88,7 @@
 // Animations
 #include "Animations/CAnimator.h"
 #include "Animations/CSkinnedMeshRenderer.h"
+#include "Animations/Skinning.h"
 #include "Animations/GLTFLoaderSkinning.h"
 
 //#define LOG_GL_NOTIFICATIONS 
@@ -122,17 +133,21 @@ glm::ivec2 windowSize = glm::ivec2(800, 800);
 std::string windowTitle = "Slime Skirmish";
 
 int waveLevel = 1;
-bool planeSwitch = false;
 int spawnRange = 15;
 float planeDifference = 50.0f;
 float slimeDamage = 10.0f, enemyDamage = 10.0f;
-float t = 0.0f;
+// How long a cleared room's door takes to slide open, in seconds
+float doorOpenTime = 1.5f;
 
 using namespace Gameplay;
 using namespace Gameplay::Physics;
 
 Scene::Sptr scene = nullptr;
 
+// Defined with the rest of the gameplay code below, called whenever the scene is replaced
+void ResetCooldowns();
+void RegisterSteering();
+
 int monitorVec[4];
 GLFWmonitor* monitor; 
 
@@ -152,8 +167,9 @@ void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height)
 /// Handles intializing GLFW, should be called before initGLAD, but after Logger::Init()
 /// Also handles creating the GLFW window
 /// </summary>
+/// <param name="visible">False to keep the window hidden, for when we only need a GL context</param>
 /// <returns>True if GLFW was initialized, false if otherwise</returns>
-bool initGLFW() 
+bool initGLFW(bool visible = true) 
 {
 	if (glfwInit() == GLFW_FALSE) 
 	{
@@ -161,6 +177,8 @@ bool initGLFW()
 		return false;
 	}
 
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+
 	window = glfwCreateWindow(windowSize.x, windowSize.y, windowTitle.c_str(), nullptr, nullptr);
 	glfwMakeContextCurrent(window);
 
@@ -223,6 +241,9 @@ bool DrawSaveLoadImGui(Scene::Sptr& scene, std::string& path)
 		std::string newFilename = std::filesystem::path(path).stem().string() + "-manifest.json";
 		ResourceManager::LoadManifest(newFilename);
 		scene = Scene::Load(path);
+		MeshResource::PruneGeneratedMeshes();
+		ResetCooldowns();
+		RegisterSteering();
 
 		return true;
 	}
@@ -284,17 +305,29 @@ float cameraHeight = 10.0f;
 float cameraDistance = 5.0f;
 void TopDownCamera(GameObject* camera, GameObject::Sptr player)
 {
+	// Follow where the slime is drawn, which is blended between physics steps
+	glm::vec3 playerPosition = glm::vec3(player->GetRenderTransform()[3]);
+
 	glm::vec3 cameraPosition = (glm::vec3(0.0f, -cameraDistance, 0.0f)) + (glm::vec3(0.0f, 0.0f, cameraHeight));
-	camera->SetPostion(player->GetPosition() + cameraPosition);
-	camera->LookAt(player->GetPosition());
+	camera->SetPostion(playerPosition + cameraPosition);
+	camera->LookAt(playerPosition);
 }
 
-// Slime uses attack and absorb
+// Enemies the slime has absorbed this frame, they go back to the pool once we're done looping over the room
+std::vector<GameObject::Sptr> absorbedEnemies;
+
+// Slime uses attack and absorb. Cooldowns run on the scene's scheduler, so they pause with the game
 float abilityCooldown = 1.0f;
-float nextAbility = 0.0f;
-void UseAbility(GameObject::Sptr player, GameObject::Sptr enemy, double time)
+bool abilityReady = true;
+void StartAbilityCooldown()
+{
+	abilityReady = false;
+	scene->GetScheduler().After(abilityCooldown, []() { abilityReady = true; });
+}
+
+void UseAbility(GameObject::Sptr player, GameObject::Sptr enemy)
 {
-	if (time > nextAbility)
+	if (abilityReady)
 	{
 		if (enemy->GetHealth() <= 0.0f)
 		{
@@ -314,13 +347,13 @@ void UseAbility(GameObject::Sptr player, GameObject::Sptr enemy, double time)
 				// Do ability
 				player->SetScale(player->GetScale() + glm::vec3(0.1));
 				player->SetHealth(player->GetHealth() + 5.0f);
-				scene->RemoveGameObject(enemy->SelfRef());
-				nextAbility = glfwGetTime() + abilityCooldown;
+				absorbedEnemies.push_back(enemy);
+				StartAbilityCooldown();
 			}
 		}
 	}
 
-	if (time > nextAbility)
+	if (abilityReady)
 	{
 
 		if (enemy->Get<TriggerVolumeEnterBehaviour>()->GetTrigger())
@@ -331,360 +364,266 @@ void UseAbility(GameObject::Sptr player, GameObject::Sptr enemy, double time)
 			{
 				// Do attack
 				enemy->SetHealth(enemy->GetHealth() - slimeDamage);
-				nextAbility = glfwGetTime() + abilityCooldown;
+				StartAbilityCooldown();
 			}
 		}
 	}
 }
 
-// Enemies AI movement
-glm::vec3 movementVector;
-float desiredVelocity;
-void EnemySteeringBehaviour(GameObject::Sptr player, GameObject::Sptr enemy, float dt)
-{
-	if (enemy->GetHealth() >= 1.0f)
-	{
-		const int safeDistance = 10;
-		glm::vec3 desiredDirection = player->GetPosition() - enemy->GetPosition();
-
-		if (glm::length(desiredDirection) < safeDistance / 2)
-		{
-			desiredVelocity = glm::distance(enemy->GetPosition(), player->GetPosition());
-			enemy->LookAt(2.0f * enemy->GetPosition() - player->GetPosition());
-			movementVector = glm::normalize(desiredDirection);
-		}
-		else if (glm::length(desiredDirection) < safeDistance)
-		{
-			desiredVelocity = 2;
-			enemy->LookAt(2.0f * enemy->GetPosition() - player->GetPosition());
-			movementVector = glm::normalize(desiredDirection);
-		}
-
-		movementVector *= desiredVelocity * dt;
-		enemy->SetPostion(enemy->GetPosition() + movementVector);
-	}
-	else
-	{
-		enemy->SetPostion(enemy->GetPosition());
-	}
-}
-
 // Enemies damaging slime
-float nextAttack = 0.0f;
 float enemyCooldown = 3.0f;
-void TakeDamage(GameObject::Sptr player, GameObject::Sptr enemy, double time)
+bool enemyAttackReady = true;
+void TakeDamage(GameObject::Sptr player, GameObject::Sptr enemy)
 {
-	if (time > nextAttack)
+	if (enemyAttackReady)
 	{
 		if (enemy->GetHealth() > 0)
 		{
 			if ((enemy->Get<TriggerVolumeEnterBehaviour>()->GetTrigger()))
 			{
 				player->SetHealth(player->GetHealth() - enemyDamage);
-				nextAttack = glfwGetTime() + enemyCooldown;
+				enemyAttackReady = false;
+				scene->GetScheduler().After(enemyCooldown, []() { enemyAttackReady = true; });
 			}
 		}
 	}
 }
 
-// Create walls around plane
-void CreateWalls(int index, GameObject::Sptr plane, MeshResource::Sptr wallMesh, Material::Sptr boxMaterial)
+// The cooldowns are ended by callbacks on the scene's scheduler, which are thrown away with the
+// scene. Anything that replaces the scene needs to call this, or a cooldown that was running
+// would never end
+void ResetCooldowns()
 {
-	GameObject::Sptr topWallLeft = scene->CreateGameObject("Top Wall Left" + std::to_string(index));
-	{
-		topWallLeft->SetPostion(glm::vec3(plane->GetPosition().x - 15, plane->GetPosition().y + 25, 10.0f));
-
-		RenderComponent::Sptr renderer = topWallLeft->Add<RenderComponent>();
-		renderer->SetMesh(wallMesh);
-		renderer->SetMaterial(boxMaterial);
-
-		RigidBody::Sptr physics = topWallLeft->Add<RigidBody>(RigidBodyType::Kinematic);
-		physics->AddCollider(BoxCollider::Create(glm::vec3(10.0f, 1.0f, 10.0f)));
-	}
+	abilityReady = true;
+	enemyAttackReady = true;
+}
 
-	GameObject::Sptr topWallRight = scene->CreateGameObject("Top Wall Right" + std::to_string(index));
+// Slides a cleared room's door open, at the same speed no matter the frame rate
+Task OpenDoor(GameObject::Sptr door, glm::vec3 closed, glm::vec3 open)
+{
+	float t = 0.0f;
+	while (t < 1.0f)
 	{
-		topWallRight->SetPostion(glm::vec3(plane->GetPosition().x + 15, plane->GetPosition().y + 25, 10.0f));
-
-		RenderComponent::Sptr renderer = topWallRight->Add<RenderComponent>();
-		renderer->SetMesh(wallMesh);
-		renderer->SetMaterial(boxMaterial);
-
-		RigidBody::Sptr physics = topWallRight->Add<RigidBody>(RigidBodyType::Kinematic);
-		physics->AddCollider(BoxCollider::Create(glm::vec3(10.0f, 1.0f, 10.0f)));
+		const float dt = co_await NextFrame;
+		t = glm::min(t + dt / doorOpenTime, 1.0f);
+		door->SetPostion(LERP(closed, open, t));
 	}
+}
 
-	GameObject::Sptr wallRight = scene->CreateGameObject("Wall Right" + std::to_string(index));
-	{
-		wallRight->SetPostion(glm::vec3(plane->GetPosition().x + 24.0f, plane->GetPosition().y, 10.0f));
-		wallRight->SetRotation(glm::vec3(0.0f, 0.0f, 90.0f));
-		wallRight->SetScale(glm::vec3(2.5f, 1.0f, 1.0f));
-
-		RenderComponent::Sptr renderer = wallRight->Add<RenderComponent>();
-		renderer->SetMesh(wallMesh);
-		renderer->SetMaterial(boxMaterial);
-
-		RigidBody::Sptr physics = wallRight->Add<RigidBody>(RigidBodyType::Kinematic);
-		physics->AddCollider(BoxCollider::Create(glm::vec3(25.0f, 1.0f, 10.0f)));
-	}
+// Level streaming, the rooms leapfrog each other ahead of the player as they clear waves
+LevelStreamer::Sptr levelStreamer = nullptr;
+int roomFloor = -1;
+int roomDoor = -1;
+// The number of the last room whose door we started opening
+int openedRoom = -1;
 
-	GameObject::Sptr wallLeft = scene->CreateGameObject("Wall Left" + std::to_string(index));
-	{
-		wallLeft->SetPostion(glm::vec3(plane->GetPosition().x - 24.0f, plane->GetPosition().y, 10.0f));
-		wallLeft->SetRotation(glm::vec3(0.0f, 0.0f, 90.0f));
-		wallLeft->SetScale(glm::vec3(2.5f, 1.0f, 1.0f));
+// Enemies inside the rooms
+MeshResource::Sptr enemyMesh;
+Material::Sptr enemyMaterial;
+int enemyCount = 0;
+// Every enemy is made up front and recycled from wave to wave, so spawning a wave doesn't create anything
+ObjectPool::Sptr enemyPool = nullptr;
+
+// Steers the enemies in the room the player is in, towards the player and around each other
+CrowdSystem::Sptr crowd = nullptr;
+int crowdRoom = -1;
+// Leads the enemies around the walls of their room to the player
+FlowField::Sptr roomField = nullptr;
+
+// Keeps the crowd's obstacles in line with the colliders the room's field is blocking out, so that
+// editing the room prefab moves both. Cheap enough to run every step, which also picks up the door
+void SyncCrowdObstacles(btCollisionWorld* world)
+{
+	const glm::vec2 fieldMin = roomField->GetMin();
+	const glm::vec2 fieldMax = fieldMin + glm::vec2(roomField->GetWidth(), roomField->GetHeight()) * roomField->GetCellSize();
+	crowd->SyncObstacles(world, fieldMin - roomField->AgentRadius, fieldMax + roomField->AgentRadius, roomField->MinHeight, roomField->MaxHeight);
+}
 
-		RenderComponent::Sptr renderer = wallLeft->Add<RenderComponent>();
-		renderer->SetMesh(wallMesh);
-		renderer->SetMaterial(boxMaterial);
+// Hands the enemies in a room over to the crowd, along with the room's walls to keep them inside
+void FillCrowd(const LevelSection::Sptr& room, btCollisionWorld* world)
+{
+	crowd->Clear();
 
-		RigidBody::Sptr physics = wallLeft->Add<RigidBody>(RigidBodyType::Kinematic);
-		physics->AddCollider(BoxCollider::Create(glm::vec3(25.0f, 1.0f, 10.0f)));
-	}
+	const glm::vec2 origin = glm::vec2(room->Origin);
+	roomField = std::make_shared<FlowField>(origin - glm::vec2(25.0f), origin + glm::vec2(25.0f), 0.5f);
+	crowd->SetFlowField(roomField);
+	SyncCrowdObstacles(world);
 
-	GameObject::Sptr bottomWallLeft = scene->CreateGameObject("Bottom Wall Left" + std::to_string(index));
+	for (const GameObject::WeakRef& ref : room->Spawned)
 	{
-		bottomWallLeft->SetPostion(glm::vec3(plane->GetPosition().x - 15, plane->GetPosition().y - 25, 10.0f));
-
-		RenderComponent::Sptr renderer = bottomWallLeft->Add<RenderComponent>();
-		renderer->SetMesh(wallMesh);
-		renderer->SetMaterial(boxMaterial);
-
-		RigidBody::Sptr physics = bottomWallLeft->Add<RigidBody>(RigidBodyType::Kinematic);
-		physics->AddCollider(BoxCollider::Create(glm::vec3(10.0f, 1.0f, 10.0f)));
+		GameObject::Sptr enemy = ref.Resolve();
+		if (enemy != nullptr && enemy->GetHealth() > 0.0f)
+		{
+			crowd->AddAgent(enemy, SteeringBehaviour::Arrive);
+		}
 	}
+	crowdRoom = room->Number;
+}
 
-	GameObject::Sptr bottomWallRight = scene->CreateGameObject("Bottom Wall Right" + std::to_string(index));
-	{
-		bottomWallRight->SetPostion(glm::vec3(plane->GetPosition().x + 15, plane->GetPosition().y - 25, 10.0f));
+// Steers the crowd on the scene's fixed ticks. The tick lives on the scene's clock, so this needs
+// to be called again whenever the scene is replaced
+void RegisterSteering()
+{
+	// Anything the crowd had came from the old scene, refill it from the new one on the next step
+	crowdRoom = -1;
 
-		RenderComponent::Sptr renderer = bottomWallRight->Add<RenderComponent>();
-		renderer->SetMesh(wallMesh);
-		renderer->SetMaterial(boxMaterial);
+	std::weak_ptr<GameObject> steeringTarget = scene->FindObjectByName("Player");
+	scene->GetClock().AddFixedTick([steeringTarget](float step)
+	{
+		GameObject::Sptr player = steeringTarget.lock();
+		if (player == nullptr) return;
+
+		// The crowd follows the player from room to room
+		LevelSection::Sptr room = levelStreamer->GetCurrent();
+		if (room->Number != crowdRoom) FillCrowd(room, scene->GetPhysicsWorld());
+
+		// The field only rebuilds when the player moves to another cell, or the walls or door move
+		roomField->SyncObstacles(scene->GetPhysicsWorld());
+		SyncCrowdObstacles(scene->GetPhysicsWorld());
+		roomField->SetGoal(player->GetPosition());
+		roomField->Update();
+
+		crowd->SetTarget(player->GetPosition());
+		crowd->Update(step);
+	});
+}
 
-		RigidBody::Sptr physics = bottomWallRight->Add<RigidBody>(RigidBodyType::Kinematic);
-		physics->AddCollider(BoxCollider::Create(glm::vec3(10.0f, 1.0f, 10.0f)));
+// Picks where the enemies in a room will spawn, relative to the room. This runs on a worker thread, so it can't touch the scene
+void PlanEnemies(int wave, std::vector<glm::vec3>& positions)
+{
+	static thread_local std::default_random_engine engine(std::random_device{}());
+	std::uniform_int_distribution<int> amount(3, 7);
+	std::uniform_int_distribution<int> distributeX(-spawnRange, -1);
+	std::uniform_int_distribution<int> distributeY(-spawnRange, spawnRange);
+
+	int enemyAmount = amount(engine) * wave;
+	positions.reserve(enemyAmount);
+	for (int i = 0; i < enemyAmount; i++)
+	{
+		positions.push_back(glm::vec3(distributeX(engine), distributeY(engine), 1.0f));
 	}
 }
 
-// Create enemies inside the plane
-MeshResource::Sptr enemyMesh;
-Material::Sptr enemyMaterial;
-int enemyAmount = 5;
-int enemyCount = 0;
-void CreateEnemies(GameObject::Sptr respawnPlane)
+// Builds an enemy for the pool, ResetEnemy sets it up each time it's spawned
+GameObject::Sptr CreateEnemy(Scene* scene, int index)
 {
-	enemyAmount = (rand() % 5 + 3) * waveLevel;
-
-	std::vector<GameObject::Sptr> enemy;
-	enemy.resize(enemyAmount);
-
-	for (size_t i = 0; i < enemyAmount; i++)
+	GameObject::Sptr enemy = scene->CreateGameObject("Enemy" + std::to_string(index));
 	{
-		int randX = rand() % spawnRange + -spawnRange;
-
-		std::random_device device;
-		std::default_random_engine engine(device());
-		std::uniform_int_distribution<int> distribute(((int)respawnPlane->GetPosition().y - spawnRange), ((int)respawnPlane->GetPosition().y + spawnRange));
-		int randY = distribute(engine);
-
-		enemy[i] = scene->CreateGameObject("Enemy" + std::to_string(i));
-
-		enemy[i]->SetPostion(glm::vec3(randX, randY, 1.0f));
-		enemy[i]->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
-		enemy[i]->SetScale(glm::vec3(0.5f));
-
-		RenderComponent::Sptr renderer = enemy[i]->Add<RenderComponent>();
+		RenderComponent::Sptr renderer = enemy->Add<RenderComponent>();
 		renderer->SetMesh(enemyMesh);
 		renderer->SetMaterial(enemyMaterial);
 
-		enemy[i]->SetHealth(20.0f);
-
-		TriggerVolume::Sptr trigger = enemy[i]->Add<TriggerVolume>();
+		TriggerVolume::Sptr trigger = enemy->Add<TriggerVolume>();
 		CylinderCollider::Sptr cylinder = CylinderCollider::Create(glm::vec3(3.0f, 3.0f, 1.0f));
 		cylinder->SetPosition(glm::vec3(0.0f, 1.0f, 0.0f));
 		cylinder->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
 		trigger->SetFlags(TriggerTypeFlags::Dynamics);
 		trigger->AddCollider(cylinder);
 
-		TriggerVolumeEnterBehaviour::Sptr test = enemy[i]->Add<TriggerVolumeEnterBehaviour>();
+		TriggerVolumeEnterBehaviour::Sptr test = enemy->Add<TriggerVolumeEnterBehaviour>();
 		test->SetTrigger(false);
 	}
+	return enemy;
 }
 
-void CreateTorches(GameObject::Sptr plane, float distance, int index, MeshResource::Sptr mesh, Material::Sptr material)
+// Puts a pooled enemy back to full health at a new spawn point
+void ResetEnemy(const GameObject::Sptr& enemy, const glm::vec3& position)
 {
-	GameObject::Sptr torch01 = scene->CreateGameObject("Torch" + std::to_string(index) + "1");
-	{
-		torch01->SetPostion(glm::vec3(distance, plane->GetPosition().y, 2.5f));
-		torch01->SetScale(glm::vec3(0.1f));
-		torch01->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
-
-		RenderComponent::Sptr renderer = torch01->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
-
-	GameObject::Sptr torch02 = scene->CreateGameObject("Torch" + std::to_string(index) + "2");
-	{
-		torch02->SetPostion(glm::vec3(distance, plane->GetPosition().y + 5.0f, 2.5f));
-		torch02->SetScale(glm::vec3(0.1f));
-		torch02->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
-
-		RenderComponent::Sptr renderer = torch02->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
-
-	GameObject::Sptr torch03 = scene->CreateGameObject("Torch" + std::to_string(index) + "3");
-	{
-		torch03->SetPostion(glm::vec3(distance, plane->GetPosition().y + 10.0f, 2.5f));
-		torch03->SetScale(glm::vec3(0.1f));
-		torch03->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+	enemy->SetPostion(position);
+	enemy->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+	enemy->SetScale(glm::vec3(0.5f));
+	enemy->SetHealth(20.0f);
+	enemy->Get<TriggerVolumeEnterBehaviour>()->SetTrigger(false);
+}
 
-		RenderComponent::Sptr renderer = torch03->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
+// Describes everything in a room relative to its center, the level streamer stamps out copies of it
+SectionPrefab CreateRoomPrefab(MeshResource::Sptr floorMesh, MeshResource::Sptr gateMesh, MeshResource::Sptr wallMesh,
+	MeshResource::Sptr torchMesh, MeshResource::Sptr barrelMesh, MeshResource::Sptr webMesh, MeshResource::Sptr chainMesh,
+	Material::Sptr groundMaterial, Material::Sptr doorMaterial, Material::Sptr wallMaterial)
+{
+	SectionPrefab room;
+	room.Stride = glm::vec3(0.0f, planeDifference, 0.0f);
+	room.PlanSpawns = PlanEnemies;
+	// Enemies come out of the pool parked, the streamer turns them on when the player reaches their room
+	room.CreateSpawn = [](Scene* scene, int index, const glm::vec3& position) {
+		return enemyPool->Spawn(position, false);
+	};
+	room.DestroySpawn = [](const GameObject::Sptr& enemy) {
+		if (crowd != nullptr) crowd->RemoveAgent(enemy.get());
+		enemyPool->Despawn(enemy.get());
+	};
 
-	GameObject::Sptr torch04 = scene->CreateGameObject("Torch" + std::to_string(index) + "4");
+	// Every element in the room is rendered, setup adds anything else it needs
+	auto addElement = [&](const std::string& name, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale,
+		MeshResource::Sptr mesh, Material::Sptr material, std::function<void(const GameObject::Sptr&)> setup)
 	{
-		torch04->SetPostion(glm::vec3(distance, plane->GetPosition().y + 15.0f, 2.5f));
-		torch04->SetScale(glm::vec3(0.1f));
-		torch04->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+		SectionPrefab::Element element;
+		element.Name = name;
+		element.Position = position;
+		element.Rotation = rotation;
+		element.Scale = scale;
+		element.Setup = [mesh, material, setup](const GameObject::Sptr& object)
+		{
+			RenderComponent::Sptr renderer = object->Add<RenderComponent>();
+			renderer->SetMesh(mesh);
+			renderer->SetMaterial(material);
 
-		RenderComponent::Sptr renderer = torch04->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
+			if (setup) setup(object);
+		};
+		room.Elements.push_back(element);
+	};
 
-	GameObject::Sptr torch044 = scene->CreateGameObject("Torch" + std::to_string(index) + "5");
+	auto kinematicBox = [](const glm::vec3& size)
 	{
-		torch044->SetPostion(glm::vec3(distance, plane->GetPosition().y + 20.0f, 2.5f));
-		torch044->SetScale(glm::vec3(0.1f));
-		torch044->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
-
-		RenderComponent::Sptr renderer = torch044->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
+		return [size](const GameObject::Sptr& object)
+		{
+			RigidBody::Sptr physics = object->Add<RigidBody>(RigidBodyType::Kinematic);
+			physics->AddCollider(BoxCollider::Create(size));
+		};
+	};
 
-	GameObject::Sptr torch05 = scene->CreateGameObject("Torch" + std::to_string(index) + "6");
+	// Floor, the trigger at the entrance tells us when the player has moved into the room. It collides
+	// with its own mesh, cooked once into a BVH and shared by every room
+	addElement("Plane", ZERO_3, ZERO_3, glm::vec3(1.0f), floorMesh, groundMaterial, [](const GameObject::Sptr& plane)
 	{
-		torch05->SetPostion(glm::vec3(distance, plane->GetPosition().y - 5.0f, 2.5f));
-		torch05->SetScale(glm::vec3(0.1f));
-		torch05->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+		RigidBody::Sptr physics = plane->Add<RigidBody>(RigidBodyType::Kinematic);
+		physics->AddCollider(ConcaveMeshCollider::Create());
 
-		RenderComponent::Sptr renderer = torch05->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
+		TriggerVolume::Sptr volume = plane->Add<TriggerVolume>();
 
-	GameObject::Sptr torch06 = scene->CreateGameObject("Torch" + std::to_string(index) + "7");
-	{
-		torch06->SetPostion(glm::vec3(distance, plane->GetPosition().y - 10.0f, 2.5f));
-		torch06->SetScale(glm::vec3(0.1f));
-		torch06->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+		BoxCollider::Sptr box = BoxCollider::Create(glm::vec3(22.0f, 1.0f, 1.0f));
+		box->SetPosition(glm::vec3(0.0f, -20.0f, 3.0f));
+		volume->SetFlags(TriggerTypeFlags::Dynamics);
+		volume->AddCollider(box);
 
-		RenderComponent::Sptr renderer = torch06->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
+		TriggerVolumeEnterBehaviour::Sptr test = plane->Add<TriggerVolumeEnterBehaviour>();
+		test->SetTrigger(false);
+	});
 
-	GameObject::Sptr torch07 = scene->CreateGameObject("Torch" + std::to_string(index) + "8");
-	{
-		torch07->SetPostion(glm::vec3(distance, plane->GetPosition().y - 15.0f, 2.5f));
-		torch07->SetScale(glm::vec3(0.1f));
-		torch07->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+	addElement("Door", glm::vec3(0.0f, 25.0f, 5.0f), glm::vec3(90.0f, 0.0f, 90.0f), glm::vec3(0.4f), gateMesh, doorMaterial, kinematicBox(glm::vec3(1.0f, 5.0f, 5.0f)));
 
-		RenderComponent::Sptr renderer = torch07->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
-	}
+	// Walls around the floor
+	addElement("Top Wall Left", glm::vec3(-15.0f, 25.0f, 10.0f), ZERO_3, glm::vec3(1.0f), wallMesh, wallMaterial, kinematicBox(glm::vec3(10.0f, 1.0f, 10.0f)));
+	addElement("Top Wall Right", glm::vec3(15.0f, 25.0f, 10.0f), ZERO_3, glm::vec3(1.0f), wallMesh, wallMaterial, kinematicBox(glm::vec3(10.0f, 1.0f, 10.0f)));
+	addElement("Wall Right", glm::vec3(24.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, 90.0f), glm::vec3(2.5f, 1.0f, 1.0f), wallMesh, wallMaterial, kinematicBox(glm::vec3(25.0f, 1.0f, 10.0f)));
+	addElement("Wall Left", glm::vec3(-24.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, 90.0f), glm::vec3(2.5f, 1.0f, 1.0f), wallMesh, wallMaterial, kinematicBox(glm::vec3(25.0f, 1.0f, 10.0f)));
+	addElement("Bottom Wall Left", glm::vec3(-15.0f, -25.0f, 10.0f), ZERO_3, glm::vec3(1.0f), wallMesh, wallMaterial, kinematicBox(glm::vec3(10.0f, 1.0f, 10.0f)));
+	addElement("Bottom Wall Right", glm::vec3(15.0f, -25.0f, 10.0f), ZERO_3, glm::vec3(1.0f), wallMesh, wallMaterial, kinematicBox(glm::vec3(10.0f, 1.0f, 10.0f)));
 
-	GameObject::Sptr torch08 = scene->CreateGameObject("Torch" + std::to_string(index) + "9");
+	// Torches down both sides of the room
+	const float torchOffsets[] = { 0.0f, 5.0f, 10.0f, 15.0f, 20.0f, -5.0f, -10.0f, -15.0f, -20.0f };
+	for (int i = 0; i < 9; i++)
 	{
-		torch08->SetPostion(glm::vec3(distance, plane->GetPosition().y - 20.0f, 2.5f));
-		torch08->SetScale(glm::vec3(0.1f));
-		torch08->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
-
-		RenderComponent::Sptr renderer = torch08->Add<RenderComponent>();
-		renderer->SetMesh(mesh);
-		renderer->SetMaterial(material);
+		addElement("Torch Right " + std::to_string(i + 1), glm::vec3(22.5f, torchOffsets[i], 2.5f), glm::vec3(90.0f, 0.0f, 0.0f), glm::vec3(0.1f), torchMesh, doorMaterial, nullptr);
+		addElement("Torch Left " + std::to_string(i + 1), glm::vec3(-22.5f, torchOffsets[i], 2.5f), glm::vec3(90.0f, 0.0f, 0.0f), glm::vec3(0.1f), torchMesh, doorMaterial, nullptr);
 	}
-}
 
-void GetTorches(int index, GameObject::Sptr& torch01, 
-	GameObject::Sptr& torch02, GameObject::Sptr& torch03, 
-	GameObject::Sptr& torch04, GameObject::Sptr& torch05, 
-	GameObject::Sptr& torch06, GameObject::Sptr& torch07, 
-	GameObject::Sptr& torch08, GameObject::Sptr& torch09)
-{
-	torch01 = scene->FindObjectByName("Torch" + std::to_string(index) + "1");
-	torch02 = scene->FindObjectByName("Torch" + std::to_string(index) + "2");
-	torch03 = scene->FindObjectByName("Torch" + std::to_string(index) + "3");
-	torch04 = scene->FindObjectByName("Torch" + std::to_string(index) + "4");
-	torch05 = scene->FindObjectByName("Torch" + std::to_string(index) + "5");
-	torch06 = scene->FindObjectByName("Torch" + std::to_string(index) + "6");
-	torch07 = scene->FindObjectByName("Torch" + std::to_string(index) + "7");
-	torch08 = scene->FindObjectByName("Torch" + std::to_string(index) + "8");
-	torch09 = scene->FindObjectByName("Torch" + std::to_string(index) + "9");
-}
+	// Props
+	addElement("Barrel", glm::vec3(20.0f, 20.0f, 1.0f), glm::vec3(90.0f, 0.0f, 90.0f), glm::vec3(0.7f), barrelMesh, doorMaterial, nullptr);
+	addElement("Web", glm::vec3(-20.0f, 22.0f, 2.0f), glm::vec3(90.0f, -60.0f, 90.0f), glm::vec3(0.3f), webMesh, wallMaterial, nullptr);
+	addElement("Chain", glm::vec3(20.0f, -20.0f, 10.0f), glm::vec3(90.0f, 0.0f, 0.0f), glm::vec3(0.5f), chainMesh, doorMaterial, nullptr);
 
-void MoveTorches(int index, float distance, 
-	GameObject::Sptr plane, GameObject::Sptr torch01,
-	GameObject::Sptr torch02, GameObject::Sptr torch03,
-	GameObject::Sptr torch04, GameObject::Sptr torch05,
-	GameObject::Sptr torch06, GameObject::Sptr torch07,
-	GameObject::Sptr torch08, GameObject::Sptr torch09)
-{
-	torch01->SetPostion(glm::vec3(distance, plane->GetPosition().y, 2.5f));
-	torch02->SetPostion(glm::vec3(distance, plane->GetPosition().y + 5.0f, 2.5f));
-	torch03->SetPostion(glm::vec3(distance, plane->GetPosition().y + 10.0f, 2.5f));
-	torch04->SetPostion(glm::vec3(distance, plane->GetPosition().y + 15.0f, 2.5f));
-	torch05->SetPostion(glm::vec3(distance, plane->GetPosition().y + 20.0f, 2.5f));
-	torch06->SetPostion(glm::vec3(distance, plane->GetPosition().y - 5.0f, 2.5f));
-	torch07->SetPostion(glm::vec3(distance, plane->GetPosition().y - 10.0f, 2.5f));
-	torch08->SetPostion(glm::vec3(distance, plane->GetPosition().y - 15.0f, 2.5f));
-	torch09->SetPostion(glm::vec3(distance, plane->GetPosition().y - 20.0f, 2.5f));
-}
-
-void CreateOtherAssets(GameObject::Sptr plane, int index, 
-	MeshResource::Sptr barrelMesh, MeshResource::Sptr webMesh, MeshResource::Sptr chainMesh,
-	Material::Sptr doorMaterial, Material::Sptr wallMaterial)
-{
-	GameObject::Sptr barrel = scene->CreateGameObject("Barrel" + std::to_string(index));
-	{
-		barrel->SetPostion(glm::vec3(plane->GetPosition().x + 20.0f, plane->GetPosition().y + 20, 1.0f));
-		barrel->SetScale(glm::vec3(0.7));
-		barrel->SetRotation(glm::vec3(90.0f, 0.0f, 90.0f));
-
-		RenderComponent::Sptr renderer = barrel->Add<RenderComponent>();
-		renderer->SetMesh(barrelMesh);
-		renderer->SetMaterial(doorMaterial);
-	}
-
-	GameObject::Sptr web = scene->CreateGameObject("Web" + std::to_string(index));
-	{
-		web->SetPostion(glm::vec3(plane->GetPosition().x - 20.0f, plane->GetPosition().y + 22, 2.0f));
-		web->SetScale(glm::vec3(0.3));
-		web->SetRotation(glm::vec3(90.0f, -60.0f, 90.0f));
-
-		RenderComponent::Sptr renderer = web->Add<RenderComponent>();
-		renderer->SetMesh(webMesh);
-		renderer->SetMaterial(wallMaterial);
-	}
-
-	GameObject::Sptr chain = scene->CreateGameObject("Chain" + std::to_string(index));
-	{
-		chain->SetPostion(glm::vec3(plane->GetPosition().x + 20.0f, plane->GetPosition().y - 20, 10.0f));
-		chain->SetScale(glm::vec3(0.5));
-		chain->SetRotation(glm::vec3(90.0f, 0.0f, 0.0f));
-
-		RenderComponent::Sptr renderer = chain->Add<RenderComponent>();
-		renderer->SetMesh(chainMesh);
-		renderer->SetMaterial(doorMaterial);
-	}
+	return room;
 }
 
 /// <summary>
@@ -697,6 +636,7 @@ void CreateScene()
 	{
 		ResourceManager::LoadManifest("manifest.json");
 		scene = Scene::Load("scene.json");
+		ResetCooldowns();
 
 		scene->Window = window;
 		scene->Awake();
@@ -834,99 +774,21 @@ void CreateScene()
 			test->SetTrigger(false);
 		}
 
-		GameObject::Sptr plane1 = scene->CreateGameObject("Plane1");
-		{
-			RenderComponent::Sptr renderer = plane1->Add<RenderComponent>();
-			renderer->SetMesh(tiledMesh);
-			renderer->SetMaterial(groundMaterial);
-
-			RigidBody::Sptr physics = plane1->Add<RigidBody>(RigidBodyType::Kinematic);
-			physics->AddCollider(BoxCollider::Create(glm::vec3(25.0f, 25.0f, 1.0f)))->SetPosition({ 0, 0, -1 });
-
-			TriggerVolume::Sptr volume = plane1->Add<TriggerVolume>();
-
-			BoxCollider::Sptr box = BoxCollider::Create(glm::vec3(22.0f, 1.0f, 1.0f));
-			box->SetPosition(glm::vec3(0.0f, -20.0f, 3.0f));
-			volume->SetFlags(TriggerTypeFlags::Dynamics);
-			volume->AddCollider(box);
-
-			TriggerVolumeEnterBehaviour::Sptr test = plane1->Add<TriggerVolumeEnterBehaviour>();
-			test->SetTrigger(false);
-		}
-
-		GameObject::Sptr door1 = scene->CreateGameObject("Door1");
-		{
-			door1->SetPostion(glm::vec3(0.0f, plane1->GetPosition().y + 25, 5.0f));
-			door1->SetScale(glm::vec3(0.4));
-			door1->SetRotation(glm::vec3(90.0f, 0.0f, 90.0f));
+		// Create the rooms, the first is loaded right away and the next streams in while the player is busy
+		SectionPrefab room = CreateRoomPrefab(tiledMesh, gateMesh, wallMesh, torchMesh, barrelMesh, webMesh, shieldMesh, groundMaterial, doorMaterial, wallMaterial);
+		roomFloor = room.FindElement("Plane");
+		roomDoor = room.FindElement("Door");
 
-			//RenderComponent::Sptr renderer = door1->Add<RenderComponent>();
-			//renderer->SetMesh(doorMesh);
-			//renderer->SetMaterial(doorMaterial);
-
-			RenderComponent::Sptr renderer = door1->Add<RenderComponent>();
-			renderer->SetMesh(gateMesh);
-			renderer->SetMaterial(doorMaterial);
+		// Enough enemies for the first few waves, the pool grows if a wave needs more
+		enemyPool = std::make_shared<ObjectPool>(scene.get(), CreateEnemy, ResetEnemy);
+		enemyPool->Prewarm(64);
 
-			RigidBody::Sptr physics = door1->Add<RigidBody>(RigidBodyType::Kinematic);
-			physics->AddCollider(BoxCollider::Create(glm::vec3(1.0f, 5.0f, 5.0f)));
-		}
-
-		CreateTorches(plane1, 22.5f, 0, torchMesh, doorMaterial);
-		CreateTorches(plane1, -22.5f, 1, torchMesh, doorMaterial);
-		CreateOtherAssets(plane1, 1, barrelMesh, webMesh, shieldMesh, doorMaterial, wallMaterial);
-
-		CreateWalls(1, plane1, wallMesh, wallMaterial);
-
-		GameObject::Sptr plane2 = scene->CreateGameObject("Plane2");
-		{
-			plane2->SetPostion(plane1->GetPosition() + glm::vec3(0, planeDifference, 0));
-
-			RenderComponent::Sptr renderer = plane2->Add<RenderComponent>();
-			renderer->SetMesh(tiledMesh);
-			renderer->SetMaterial(groundMaterial);
-
-			RigidBody::Sptr physics = plane2->Add<RigidBody>(RigidBodyType::Kinematic);
-			physics->AddCollider(BoxCollider::Create(glm::vec3(25.0f, 25.0f, 1.0f)))->SetPosition({ 0, 0, -1 });
-
-			TriggerVolume::Sptr volume = plane2->Add<TriggerVolume>();
-
-			BoxCollider::Sptr box = BoxCollider::Create(glm::vec3(22.0f, 1.0f, 1.0f));
-			box->SetPosition(glm::vec3(0.0f, -20.0f, 3.0f));
-			volume->SetFlags(TriggerTypeFlags::Dynamics);
-			volume->AddCollider(box);
-
-			TriggerVolumeEnterBehaviour::Sptr test = plane2->Add<TriggerVolumeEnterBehaviour>();
-			test->SetTrigger(false);
-		}
-
-		GameObject::Sptr door2 = scene->CreateGameObject("Door2");
-		{
-			door2->SetPostion(glm::vec3(0.0f, plane2->GetPosition().y + 25, 5.0f));
-			door2->SetScale(glm::vec3(0.4));
-			door2->SetRotation(glm::vec3(90.0f, 0.0f, 90.0f));
-
-			//RenderComponent::Sptr renderer = door1->Add<RenderComponent>();
-			//renderer->SetMesh(doorMesh);
-			//renderer->SetMaterial(doorMaterial);
-
-			RenderComponent::Sptr renderer = door2->Add<RenderComponent>();
-			renderer->SetMesh(gateMesh);
-			renderer->SetMaterial(doorMaterial);
-
-			RigidBody::Sptr physics = door2->Add<RigidBody>(RigidBodyType::Kinematic);
-			physics->AddCollider(BoxCollider::Create(glm::vec3(1.0f, 5.0f, 5.0f)));
-		}
-
-		CreateTorches(plane2, 22.5f, 2, torchMesh, doorMaterial);
-		CreateTorches(plane2, -22.5f, 3, torchMesh, doorMaterial);
-		CreateOtherAssets(plane2, 2, barrelMesh, webMesh, shieldMesh, doorMaterial, wallMaterial);
-
-		CreateWalls(2, plane2, wallMesh, wallMaterial);
+		levelStreamer = std::make_shared<LevelStreamer>(scene.get(), room, ZERO_3);
+		levelStreamer->Init();
 
 		GameObject::Sptr backDoor = scene->CreateGameObject("Back Door");
 		{
-			backDoor->SetPostion(glm::vec3(0.0f, plane1->GetPosition().y - 25, 5.0f));
+			backDoor->SetPostion(glm::vec3(0.0f, levelStreamer->GetCurrent()->Origin.y - 25, 5.0f));
 			backDoor->SetScale(glm::vec3(0.4));
 			backDoor->SetRotation(glm::vec3(90.0f, 0.0f, 90.0f));
 
@@ -942,8 +804,6 @@ void CreateScene()
 			physics->AddCollider(BoxCollider::Create(glm::vec3(1.0f, 5.0f, 5.0f)));
 		}
 
-		CreateEnemies(plane1);
-
 		// Create UI panels
 		GameObject::Sptr startPanel = scene->CreateGameObject("Start Panel");
 		{
@@ -1039,11 +899,68 @@ void CreateScene()
 	}
 }
 
-int main() 
+/// <summary>
+/// Cooks all of our runtime assets into a single pack, run with "--pack [output]"
+/// from the resource directory
+/// </summary>
+bool CookAssetPack(const std::string& outFile)
+{
+	AssetPackBuilder builder;
+	for (const char* folder : { "shaders", "textures", "cubemaps", "fonts", "mesh_cache" })
+	{
+		if (std::filesystem::exists(folder))
+		{
+			builder.AddDirectory(folder, folder);
+		}
+	}
+
+	// Loose models, their binary caches, and our manifest/scene files live in the root
+	const std::vector<std::string> compressed = AssetPackBuilder::DefaultCompressedExtensions();
+	for (const auto& item : std::filesystem::directory_iterator("."))
+	{
+		std::string extension = item.path().extension().string();
+		StringTools::ToLower(extension);
+		if (item.is_regular_file() && (extension == ".obj" || extension == ".bin" || extension == ".json"))
+		{
+			builder.AddFile(item.path().string(), item.path().filename().string(), std::find(compressed.begin(), compressed.end(), extension) != compressed.end());
+		}
+	}
+
+	return builder.Write(outFile);
+}
+
+int main(int argc, char** argv) 
 {
 	Logger::Init();
 
-	if (!initGLFW()) return 1;
+	// Asset cooking mode, build the pack and bail before we open a window
+	if (argc > 1 && std::string(argv[1]) == "--pack")
+	{
+		return CookAssetPack(argc > 2 ? argv[2] : "assets.pak") ? 0 : 1;
+	}
+
+	ThreadPool::Init();
+
+	// Benchmark mode, some benchmarks need a GL context and our registered types, so we go
+	// through the usual setup with the window hidden and run them once that's done
+	const bool benchmarking = argc > 1 && std::string(argv[1]) == "--bench";
+
+	// If we have a cooked asset pack, mount it so loaders read from it instead of loose files
+	if (std::filesystem::exists("assets.pak"))
+	{
+		VirtualFileSystem::Mount("assets.pak");
+	}
+
+	// When editing, let loose files override the pack so changes show up without re-cooking it
+	for (int ix = 1; ix < argc; ix++)
+	{
+		if (std::string(argv[ix]) == "--loose-assets")
+		{
+			VirtualFileSystem::PreferLooseFiles = true;
+		}
+	}
+
+	if (!initGLFW(!benchmarking)) return 1;
 	if (!initGLAD()) return 1;
 
 	glEnable(GL_DEBUG_OUTPUT);
@@ -1076,6 +993,15 @@ int main()
 	ComponentManager::RegisterType<GuiPanel>();
 	ComponentManager::RegisterType<GuiText>();
 
+	if (benchmarking)
+	{
+		bool success = Benchmarks::Run(argc > 2 ? argv[2] : "all");
+		ImGuiHelper::Cleanup();
+		ResourceManager::Cleanup();
+		ThreadPool::Shutdown();
+		return success ? 0 : 1;
+	}
+
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
@@ -1103,6 +1029,15 @@ int main()
 
 	CreateScene();
 
+	// Enemies steer at the fixed rate, so they move the same no matter the frame rate. They close in
+	// on the slime once it gets within 10 units, and slow down to stop just short of it
+	crowd = std::make_shared<CrowdSystem>();
+	crowd->GetSettings().MaxSpeed = 3.0f;
+	crowd->GetSettings().SenseRadius = 10.0f;
+	crowd->GetSettings().SlowingRadius = 3.0f;
+	crowd->GetSettings().StopDistance = 1.5f;
+	RegisterSteering();
+
 	std::string scenePath = "scene.json"; 
 	scenePath.reserve(256); 
 
@@ -1129,44 +1064,6 @@ int main()
 		// Player object
 		GameObject::Sptr player = scene->FindObjectByName("Player");
 
-		// Plane 1 objects
-		GameObject::Sptr plane1 = scene->FindObjectByName("Plane1");
-		GameObject::Sptr topWallLeft1 = scene->FindObjectByName("Top Wall Left1");
-		GameObject::Sptr topWallRight1 = scene->FindObjectByName("Top Wall Right1");
-		GameObject::Sptr wallRight1 = scene->FindObjectByName("Wall Right1");
-		GameObject::Sptr wallLeft1 = scene->FindObjectByName("Wall Left1");
-		GameObject::Sptr bottomWallLeft1 = scene->FindObjectByName("Bottom Wall Left1");
-		GameObject::Sptr bottomWallRight1 = scene->FindObjectByName("Bottom Wall Right1");
-		GameObject::Sptr door1 = scene->FindObjectByName("Door1");
-
-		GameObject::Sptr torch01, torch02, torch03, torch04, torch05, torch06, torch07, torch08, torch09;
-		GetTorches(0, torch01, torch02, torch03, torch04, torch05, torch06, torch07, torch08, torch09);
-		GameObject::Sptr torch11, torch12, torch13, torch14, torch15, torch16, torch17, torch18, torch19;
-		GetTorches(1, torch11, torch12, torch13, torch14, torch15, torch16, torch17, torch18, torch19);
-
-		GameObject::Sptr barrel1 = scene->FindObjectByName("Barrel1");
-		GameObject::Sptr web1 = scene->FindObjectByName("Web1");
-		GameObject::Sptr chain1 = scene->FindObjectByName("Chain1");
-
-		// Plane 2 objects
-		GameObject::Sptr plane2 = scene->FindObjectByName("Plane2");
-		GameObject::Sptr topWallLeft2 = scene->FindObjectByName("Top Wall Left2");
-		GameObject::Sptr topWallRight2 = scene->FindObjectByName("Top Wall Right2");
-		GameObject::Sptr wallRight2 = scene->FindObjectByName("Wall Right2");
-		GameObject::Sptr wallLeft2 = scene->FindObjectByName("Wall Left2");
-		GameObject::Sptr bottomWallLeft2 = scene->FindObjectByName("Bottom Wall Left2");
-		GameObject::Sptr bottomWallRight2 = scene->FindObjectByName("Bottom Wall Right2");
-		GameObject::Sptr door2 = scene->FindObjectByName("Door2");
-
-		GameObject::Sptr torch21, torch22, torch23, torch24, torch25, torch26, torch27, torch28, torch29;
-		GetTorches(2, torch21, torch22, torch23, torch24, torch25, torch26, torch27, torch28, torch29);
-		GameObject::Sptr torch31, torch32, torch33, torch34, torch35, torch36, torch37, torch38, torch39;
-		GetTorches(3, torch31, torch32, torch33, torch34, torch35, torch36, torch37, torch38, torch39);
-
-		GameObject::Sptr barrel2 = scene->FindObjectByName("Barrel2");
-		GameObject::Sptr web2 = scene->FindObjectByName("Web2");
-		GameObject::Sptr chain2 = scene->FindObjectByName("Chain2");
-
 		// Back door object
 		GameObject::Sptr backDoor = scene->FindObjectByName("Back Door");
 
@@ -1201,124 +1098,65 @@ int main()
 		if (isPaused && scene->IsPlaying) startPanel->Get<GuiText>()->SetText("Paused");
 		if (!isPaused && scene->IsPlaying && player->GetHealth() > 0) startPanel->Get<GuiText>()->SetText("");
 
-		// Resets everything when level is complete
-		if (plane1->Get<TriggerVolumeEnterBehaviour>()->GetTrigger() && planeSwitch)
-		{
-			player->SetScale(glm::vec3(1.0f));
-			plane2->SetPostion(plane1->GetPosition() + glm::vec3(0, planeDifference, 0));
-
-			CreateEnemies(plane1);
-
-			door1->SetPostion(glm::vec3(0.0f, plane1->GetPosition().y + 25.0f, 5.0f));
-			topWallLeft1->SetPostion(glm::vec3(plane1->GetPosition().x - 15, plane1->GetPosition().y + 25, 10.0f));
-			topWallRight1->SetPostion(glm::vec3(plane1->GetPosition().x + 15, plane1->GetPosition().y + 25, 10.0f));
-			wallRight1->SetPostion(glm::vec3(plane1->GetPosition().x + 24.0f, plane1->GetPosition().y, 10.0f));
-			wallLeft1->SetPostion(glm::vec3(plane1->GetPosition().x - 24.0f, plane1->GetPosition().y, 10.0f));
-			bottomWallLeft1->SetPostion(glm::vec3(plane1->GetPosition().x - 15, plane1->GetPosition().y - 25, 10.0f));
-			bottomWallRight1->SetPostion(glm::vec3(plane1->GetPosition().x + 15, plane1->GetPosition().y - 25, 10.0f));
-
-			MoveTorches(0, 22.5f, plane1, torch01, torch02, torch03, torch04, torch05, torch06, torch07, torch08, torch09);
-			MoveTorches(1, -22.5f, plane1, torch11, torch12, torch13, torch14, torch15, torch16, torch17, torch18, torch19);
-
-			barrel1->SetPostion(glm::vec3(plane1->GetPosition().x + 20.0f, plane1->GetPosition().y + 20, 1.0f));
-			web1->SetPostion(glm::vec3(plane1->GetPosition().x - 20.0f, plane1->GetPosition().y + 22, 2.0f));
-			chain1->SetPostion(glm::vec3(plane1->GetPosition().x + 20.0f, plane1->GetPosition().y - 20, 10.0f));
-
-			door2->SetPostion(glm::vec3(0.0f, plane2->GetPosition().y + 25.0f, 5.0f));
-			topWallLeft2->SetPostion(glm::vec3(plane2->GetPosition().x - 15, plane2->GetPosition().y + 25, 10.0f));
-			topWallRight2->SetPostion(glm::vec3(plane2->GetPosition().x + 15, plane2->GetPosition().y + 25, 10.0f));
-			wallRight2->SetPostion(glm::vec3(plane2->GetPosition().x + 24.0f, plane2->GetPosition().y, 10.0f));
-			wallLeft2->SetPostion(glm::vec3(plane2->GetPosition().x - 24.0f, plane2->GetPosition().y, 10.0f));
-			bottomWallLeft2->SetPostion(glm::vec3(plane2->GetPosition().x - 15, plane2->GetPosition().y - 25, 10.0f));
-			bottomWallRight2->SetPostion(glm::vec3(plane2->GetPosition().x + 15, plane2->GetPosition().y - 25, 10.0f));
-
-			MoveTorches(2, 22.5f, plane2, torch21, torch22, torch23, torch24, torch25, torch26, torch27, torch28, torch29);
-			MoveTorches(3, -22.5f, plane2, torch31, torch32, torch33, torch34, torch35, torch36, torch37, torch38, torch39);
-
-			barrel2->SetPostion(glm::vec3(plane2->GetPosition().x + 20.0f, plane2->GetPosition().y + 20, 1.0f));
-			web2->SetPostion(glm::vec3(plane2->GetPosition().x - 20.0f, plane2->GetPosition().y + 22, 2.0f));
-			chain2->SetPostion(glm::vec3(plane2->GetPosition().x + 20.0f, plane2->GetPosition().y - 20, 10.0f));
-
-			backDoor->SetPostion(glm::vec3(0.0f, plane1->GetPosition().y - 25, 5.0f));
-
-			waveLevel++;
-			t = 0.0f;
-			planeSwitch = !planeSwitch;
-			
-		}
-		
-		if (plane2->Get<TriggerVolumeEnterBehaviour>()->GetTrigger() && !planeSwitch)
+		// Stream in the room ahead of the player
+		levelStreamer->Update(dt);
+		LevelSection::Sptr nextRoom = levelStreamer->GetNext();
+
+		// Moves into the next room when the player reaches it's entrance
+		TriggerVolumeEnterBehaviour::Sptr nextFloor = levelStreamer->GetElement(nextRoom, roomFloor)->Get<TriggerVolumeEnterBehaviour>();
+		if (nextFloor->GetTrigger())
 		{
-			//player->SetScale(glm::vec3(1.0f));
-			plane1->SetPostion(plane2->GetPosition() + glm::vec3(0, planeDifference, 0));
-
-			CreateEnemies(plane2);
-
-			door1->SetPostion(glm::vec3(0.0f, plane1->GetPosition().y + 25.0f, 5.0f));
-			topWallLeft1->SetPostion(glm::vec3(plane1->GetPosition().x - 15, plane1->GetPosition().y + 25, 10.0f));
-			topWallRight1->SetPostion(glm::vec3(plane1->GetPosition().x + 15, plane1->GetPosition().y + 25, 10.0f));
-			wallRight1->SetPostion(glm::vec3(plane1->GetPosition().x + 24.0f, plane1->GetPosition().y, 10.0f));
-			wallLeft1->SetPostion(glm::vec3(plane1->GetPosition().x - 24.0f, plane1->GetPosition().y, 10.0f));
-			bottomWallLeft1->SetPostion(glm::vec3(plane1->GetPosition().x - 15, plane1->GetPosition().y - 25, 10.0f));
-			bottomWallRight1->SetPostion(glm::vec3(plane1->GetPosition().x + 15, plane1->GetPosition().y - 25, 10.0f));
-
-			MoveTorches(0, 22.5f, plane1, torch01, torch02, torch03, torch04, torch05, torch06, torch07, torch08, torch09);
-			MoveTorches(1, -22.5f, plane1, torch11, torch12, torch13, torch14, torch15, torch16, torch17, torch18, torch19);
-
-			barrel1->SetPostion(glm::vec3(plane1->GetPosition().x + 20.0f, plane1->GetPosition().y + 20, 1.0f));
-			web1->SetPostion(glm::vec3(plane1->GetPosition().x - 20.0f, plane1->GetPosition().y + 22, 2.0f));
-			chain1->SetPostion(glm::vec3(plane1->GetPosition().x + 20.0f, plane1->GetPosition().y - 20, 10.0f));
-
-			door2->SetPostion(glm::vec3(0.0f, plane2->GetPosition().y + 25.0f, 5.0f));
-			topWallLeft2->SetPostion(glm::vec3(plane2->GetPosition().x - 15, plane2->GetPosition().y + 25, 10.0f));
-			topWallRight2->SetPostion(glm::vec3(plane2->GetPosition().x + 15, plane2->GetPosition().y + 25, 10.0f));
-			wallRight2->SetPostion(glm::vec3(plane2->GetPosition().x + 24.0f, plane2->GetPosition().y, 10.0f));
-			wallLeft2->SetPostion(glm::vec3(plane2->GetPosition().x - 24.0f, plane2->GetPosition().y, 10.0f));
-			bottomWallLeft2->SetPostion(glm::vec3(plane2->GetPosition().x - 15, plane2->GetPosition().y - 25, 10.0f));
-			bottomWallRight2->SetPostion(glm::vec3(plane2->GetPosition().x + 15, plane2->GetPosition().y - 25, 10.0f));
-
-			MoveTorches(2, 22.5f, plane2, torch21, torch22, torch23, torch24, torch25, torch26, torch27, torch28, torch29);
-			MoveTorches(3, -22.5f, plane2, torch31, torch32, torch33, torch34, torch35, torch36, torch37, torch38, torch39);
-
-			barrel2->SetPostion(glm::vec3(plane2->GetPosition().x + 20.0f, plane2->GetPosition().y + 20, 1.0f));
-			web2->SetPostion(glm::vec3(plane2->GetPosition().x - 20.0f, plane2->GetPosition().y + 22, 2.0f));
-			chain2->SetPostion(glm::vec3(plane2->GetPosition().x + 20.0f, plane2->GetPosition().y - 20, 10.0f));
-
-			backDoor->SetPostion(glm::vec3(0.0f, plane2->GetPosition().y - 25, 5.0f));
-
-			waveLevel++;
-			t = 0.0f;
-			planeSwitch = !planeSwitch;
+			// The slime only shrinks back down when entering the first room of the pair
+			if (nextRoom->Slot == 0) player->SetScale(glm::vec3(1.0f));
+
+			// The room we're leaving gets recycled ahead of us, so make sure it doesn't trip straight away
+			levelStreamer->GetElement(levelStreamer->GetCurrent(), roomFloor)->Get<TriggerVolumeEnterBehaviour>()->SetTrigger(false);
+			levelStreamer->Advance();
+
+			backDoor->SetPostion(glm::vec3(0.0f, levelStreamer->GetCurrent()->Origin.y - 25, 5.0f));
+
+			waveLevel = levelStreamer->GetCurrent()->Number;
+
+			// Anything created here means the pool was too small, and the wave cost us allocations
+			const ObjectPool::Stats& poolStats = enemyPool->GetStats();
+			LOG_INFO("Wave {}: {} enemies reused, {} created, {} despawned, {} in pool", waveLevel, poolStats.Reused, poolStats.Created, poolStats.Despawned, enemyPool->GetSize());
+			enemyPool->ResetStats();
 		}
 
-		// Create enemy objects and make them move, attack and take damage
-		std::vector<GameObject::Sptr> enemy;
-		enemy.resize(enemyAmount);
-		enemyCount = enemyAmount;
-		for (size_t i = 0; i < enemyAmount; i++)
+		// Make the enemies in the current room attack and take damage, they move in the fixed tick
+		LevelSection::Sptr currentRoom = levelStreamer->GetCurrent();
+		for (const GameObject::WeakRef& ref : currentRoom->Spawned)
 		{
-			enemy[i] = scene->FindObjectByName("Enemy" + std::to_string(i));
-			if (enemy[i] != nullptr && enemy[i]->Get<TriggerVolumeEnterBehaviour>() != nullptr)
+			GameObject::Sptr enemy = ref.Resolve();
+			if (enemy != nullptr && enemy->Get<TriggerVolumeEnterBehaviour>() != nullptr)
 			{
 				if (scene->IsPlaying && playbackSpeed == 1.0f)
 				{
-					UseAbility(player, enemy[i], glfwGetTime());
-					EnemySteeringBehaviour(player, enemy[i], dt);
-					TakeDamage(player, enemy[i], glfwGetTime());
+					UseAbility(player, enemy);
+					TakeDamage(player, enemy);
 				}
-			}
 
-			if (scene->FindObjectByName("Enemy" + std::to_string(i)) == nullptr)
-			{
-				enemyCount--;
-				if (enemyCount == 0)
+				// Dead enemies stay where they fell
+				if (enemy->GetHealth() <= 0.0f)
 				{
-					if (t < 1.0f) { t += 0.01;  }
-					door1->SetPostion(LERP(glm::vec3(0.0f, plane1->GetPosition().y + 25.0f, 5.0f), glm::vec3(0.0f, plane1->GetPosition().y + 25.0f, 15.0f), t));
-					door2->SetPostion(LERP(glm::vec3(0.0f, plane2->GetPosition().y + 25.0f, 5.0f), glm::vec3(0.0f, plane2->GetPosition().y + 25.0f, 15.0f), t));
+					crowd->RemoveAgent(enemy.get());
 				}
 			}
 		}
+		for (const GameObject::Sptr& enemy : absorbedEnemies)
+		{
+			levelStreamer->RemoveSpawn(enemy);
+		}
+		absorbedEnemies.clear();
+
+		// Open the door once the room is cleared
+		enemyCount = currentRoom->GetAliveCount();
+		if (enemyCount == 0 && openedRoom != currentRoom->Number)
+		{
+			openedRoom = currentRoom->Number;
+			GameObject::Sptr door = levelStreamer->GetElement(currentRoom, roomDoor);
+			scene->GetScheduler().Start(OpenDoor(door, glm::vec3(0.0f, currentRoom->Origin.y + 25.0f, 5.0f), glm::vec3(0.0f, currentRoom->Origin.y + 25.0f, 15.0f)));
+		}
 
 		// Wave panel update
 		const std::string newText = "Wave " + std::to_string(waveLevel);
@@ -1360,6 +1198,9 @@ int main()
 
 		scene->Update(dt);
 
+		// Physics runs before the camera moves so the camera can follow the blended player position
+		scene->DoPhysics(dt);
+
 		Camera::Sptr camera = scene->MainCamera;
 
 		// Top down camera angle
@@ -1368,8 +1209,7 @@ int main()
 
 		glm::mat4 viewProj = camera->GetViewProjection();
 		DebugDrawer::Get().SetViewProjection(viewProj);
-
-		scene->DoPhysics(dt);
+		DebugDrawer::Get().Update(dt);
 		
 		Material::Sptr currentMat = nullptr;
 		Shader::Sptr shader = nullptr;
@@ -1423,9 +1263,10 @@ int main()
 			GameObject* object = renderable->GetGameObject();
 			 
 			auto& instanceData = instanceUniforms->GetData();
-			instanceData.u_Model = object->GetTransform();
-			instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-			instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
+			const glm::mat4& transform = object->GetRenderTransform();
+			instanceData.u_Model = transform;
+			instanceData.u_ModelViewProjection = viewProj * transform;
+			instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(transform)));
 			instanceUniforms->Update();  
 
 			renderable->GetMesh()->Draw();
@@ -1433,6 +1274,9 @@ int main()
 
 		scene->DrawSkybox();
 
+		// Draw everything that was queued for debug drawing this frame, while we still have depth testing
+		DebugDrawer::Get().FlushAll();
+
 		glDisable(GL_CULL_FACE);
 		glDisable(GL_DEPTH_TEST);
 		glDepthMask(GL_FALSE);
@@ -1461,8 +1305,16 @@ int main()
 		glfwSwapBuffers(window);
 	}
 
+	levelStreamer->SaveTrace("streaming_trace.csv");
+	levelStreamer = nullptr;
+	enemyPool = nullptr;
+	crowd = nullptr;
+	roomField = nullptr;
+
+	nou::PaletteRing::Release();
 	ImGuiHelper::Cleanup();
 	ResourceManager::Cleanup();
+	ThreadPool::Shutdown();
 	Logger::Uninitialize();
 	return 0;
 }
\ No newline at end of file